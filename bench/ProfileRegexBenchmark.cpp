@@ -0,0 +1,247 @@
+// Benchmark dei pattern dei profili: ProfileRegex (motore lineare) contro
+// std::wregex. Per ogni pattern misura il tempo di ricerca sulle righe del
+// corpus e verifica che i due motori diano lo stesso risultato; poi misura
+// un pattern con quantificatori annidati su righe malformate di lunghezza
+// crescente, dove il backtracking di std::wregex cresce in modo esponenziale.
+//
+// Uso: ProfileRegexBenchmark [testo.txt]   (UTF-8, una riga per riga di referto)
+#include "ProfileRegex.h"
+#include "ReportProfile.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <locale>
+#include <codecvt>
+
+namespace {
+
+// Righe tipiche di un referto, usate se non viene indicato un file
+const wchar_t* SAMPLE_LINES[] = {
+    L"Istituto Scientifico di Lumezzane",
+    L"Servizio di Diagnostica per Immagini  Primario: Dott. Mario Bianchi",
+    L"Tel. 030 8253111  Fax. 030 8253112  Email: radiologia@example.it",
+    L"Sig./Sig.ra: ROSSI MARIO          ID Paziente: PK-123456",
+    L"Data di Nascita: 01/02/1950  Codice Fiscale: RSSMRA50B01F205X",
+    L"N. di accesso: 2023004567  Provenienza: ESTERNO",
+    L"Prestazione eseguita: RX TORACE IN DUE PROIEZIONI",
+    L"Schedulazione: 12/03/2024 08:15  Esecuzione: 12/03/2024 08:40  Classe dose: I",
+    L"Non lesioni pleuroparenchimali in atto. Cuore nei limiti per dimensioni.",
+    L"Seni costofrenici liberi. Ili vascolari nella norma. Non versamento pleurico.",
+    L"Paziente: VERDI GIUSEPPE Anni: 74  Sesso: Maschio",
+    L"Descrizione Esame: ECOCOLORDOPPLER TRONCHI SOVRAORTICI",
+    L"DISTRETTO CAROTIDEO SIN: ispessimento medio-intimale diffuso senza stenosi emodinamiche.",
+    L"ARTERIE VERTEBRALI: pervie con flusso anterogrado. ARTERIE SUCCLAVIE: regolari.",
+    L"CONCLUSIONI: quadro ateromasico iniziale. FOLLOW UP a 12 mesi.",
+    L"Medico Radiologo: Dott.ssa Anna Neri   TSRM: Luca Gialli",
+    L"Referto firmato digitalmente da: Dott.ssa Anna Neri il 12/03/24 alle 09:10",
+    L"Documento informatico firmato digitalmente ai sensi del D.Lgs. 82/2005",
+    L"la stampa costituisce copia analogica   Pag 1 di 1",
+};
+
+// Casi limite confrontati sempre, anche con un file in ingresso: asserzioni
+// e ancore dopo spazi opzionali, con inizi scartati dal prefiltro prima
+// della posizione giusta
+struct EdgeCase {
+    const wchar_t* pattern;
+    const wchar_t* line;
+};
+
+const EdgeCase EDGE_CASES[] = {
+    { L"\\s?\\bDott", L"  .Dott" },
+    { L" ?\\bDott", L"  (Dott" },
+    { L" ?\\b[A-Z]", L"   :Z: B" },
+    { L"\\s*\\bPag\\b", L"..  Pag 1 di 1" },
+    { L"\\s?\\b\\d+$", L"  .. Pag 1 di 12" },
+    { L" ?\\bfirmato\\b", L"  -Referto firmato digitalmente" },
+    { L"^\\s*Dott", L"  Dott. Rossi" },
+    { L"^ ?[A-Z]+:", L"x  CONCLUSIONI: quadro nella norma" },
+    { L"\\s?$", L"  ..  " },
+};
+
+struct Pattern {
+    std::wstring source;
+    std::wregex standard;
+    ProfileRegex linear;
+};
+
+std::string Narrow(const std::wstring& text) {
+    std::string result;
+    for (wchar_t c : text) {
+        result += (c > 0 && c < 128) ? static_cast<char>(c) : '?';
+    }
+    return result;
+}
+
+double ElapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Stesso esito, stessa posizione e stesso gruppo 1 (quello del nome paziente)
+bool SameResult(const std::wstring& line, bool found, const std::wsmatch& standard,
+                bool linearFound, const ProfileRegex::Match& linear) {
+    if (found != linearFound) {
+        return false;
+    }
+    if (!found) {
+        return true;
+    }
+    if (static_cast<size_t>(standard.position(0)) != linear.position ||
+        static_cast<size_t>(standard.length(0)) != linear.length) {
+        return false;
+    }
+    if (standard.size() > 1) {
+        std::wstring group = standard[1].matched ? standard[1].str() : std::wstring();
+        return group == linear.Str(line, 1);
+    }
+    return true;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::wstring> lines;
+    if (argc > 1) {
+        std::ifstream file(argv[1], std::ios::binary);
+        if (!file) {
+            std::printf("Impossibile aprire %s\n", argv[1]);
+            return 1;
+        }
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
+        std::wistringstream stream(converter.from_bytes(buffer.str()));
+        std::wstring line;
+        while (std::getline(stream, line)) {
+            lines.push_back(line);
+        }
+    } else {
+        for (const wchar_t* line : SAMPLE_LINES) {
+            lines.push_back(line);
+        }
+    }
+
+    // Tutti i pattern regex dei profili (gli identificativi sono sottostringhe)
+    std::shared_ptr<const ReportProfileSet> profileSet = ProfileManager::GetSnapshot();
+    std::vector<const ReportProfile*> profiles;
+    for (const auto& profile : profileSet->profiles) {
+        profiles.push_back(&profile);
+    }
+    profiles.push_back(&profileSet->defaultProfile);
+
+    std::vector<Pattern> patterns;
+    for (const ReportProfile* profile : profiles) {
+        for (const auto* list : { &profile->patientNamePatterns, &profile->excludePatterns,
+                                  &profile->keepPatterns, &profile->newlineBeforePatterns }) {
+            for (const auto& source : *list) {
+                Pattern pattern;
+                pattern.source = source;
+                try {
+                    pattern.standard = std::wregex(source, std::regex::icase | std::regex::optimize);
+                } catch (const std::regex_error&) {
+                    continue;
+                }
+                if (pattern.linear.Compile(source)) {
+                    patterns.push_back(std::move(pattern));
+                }
+            }
+        }
+    }
+
+    const int ROUNDS = 200;
+    double totalStandard = 0;
+    double totalLinear = 0;
+    size_t mismatches = 0;
+
+    std::printf("%-60s %12s %12s %8s\n", "pattern", "wregex ms", "lineare ms", "diversi");
+    for (const auto& pattern : patterns) {
+        auto start = std::chrono::steady_clock::now();
+        size_t found = 0;
+        for (int round = 0; round < ROUNDS; round++) {
+            for (const auto& line : lines) {
+                found += std::regex_search(line, pattern.standard) ? 1 : 0;
+            }
+        }
+        double standardMs = ElapsedMs(start);
+
+        start = std::chrono::steady_clock::now();
+        ProfileRegex::Match match;
+        for (int round = 0; round < ROUNDS; round++) {
+            for (const auto& line : lines) {
+                found += pattern.linear.Search(line, match) ? 1 : 0;
+            }
+        }
+        double linearMs = ElapsedMs(start);
+
+        size_t different = 0;
+        for (const auto& line : lines) {
+            std::wsmatch standard;
+            bool standardFound = std::regex_search(line, standard, pattern.standard);
+            bool linearFound = pattern.linear.Search(line, match);
+            if (!SameResult(line, standardFound, standard, linearFound, match)) {
+                different++;
+            }
+        }
+
+        totalStandard += standardMs;
+        totalLinear += linearMs;
+        mismatches += different;
+        std::printf("%-60s %12.2f %12.2f %8zu%s\n", Narrow(pattern.source).substr(0, 60).c_str(),
+                    standardMs, linearMs, different, pattern.linear.IsLinear() ? "" : " (wregex)");
+    }
+    std::printf("%-60s %12.2f %12.2f %8zu\n\n", "TOTALE", totalStandard, totalLinear, mismatches);
+
+    std::printf("%-30s %-36s %8s\n", "caso limite", "riga", "esito");
+    for (const auto& edge : EDGE_CASES) {
+        std::wstring line = edge.line;
+        std::wregex standardEdge(edge.pattern, std::regex::icase | std::regex::optimize);
+        ProfileRegex linearEdge;
+        linearEdge.Compile(edge.pattern);
+
+        std::wsmatch standard;
+        ProfileRegex::Match match;
+        bool standardFound = std::regex_search(line, standard, standardEdge);
+        bool linearFound = linearEdge.Search(line, match);
+        bool same = SameResult(line, standardFound, standard, linearFound, match);
+        mismatches += same ? 0 : 1;
+        std::printf("%-30s %-36s %8s\n", Narrow(edge.pattern).c_str(), ("\"" + Narrow(line) + "\"").c_str(),
+                    same ? "ok" : "DIVERSO");
+    }
+    std::printf("\n");
+
+    // Righe malformate: un pattern con quantificatori annidati (come puo'
+    // scriverlo chi definisce un profilo) su un nome senza ':' finale.
+    // Con il backtracking il costo raddoppia a ogni lettera
+    const std::wstring nestedPattern = L"Paziente:\\s+([A-Za-z]+\\s?)+:";
+    std::wregex standardNested(nestedPattern, std::regex::icase | std::regex::optimize);
+    ProfileRegex linearNested;
+    linearNested.Compile(nestedPattern);
+
+    std::printf("%s\n%-12s %14s %14s\n", Narrow(nestedPattern).c_str(), "caratteri", "wregex ms", "lineare ms");
+    bool standardTooSlow = false;
+    for (size_t letters = 12; letters <= 28; letters += 2) {
+        std::wstring line = L"Paziente: " + std::wstring(letters, L'A');
+
+        std::string standardResult = "-";
+        if (!standardTooSlow) {
+            auto start = std::chrono::steady_clock::now();
+            try {
+                std::regex_search(line, standardNested);
+                double standardMs = ElapsedMs(start);
+                standardResult = std::to_string(standardMs);
+                standardTooSlow = standardMs > 2000;
+            } catch (const std::regex_error&) {
+                standardResult = "errore";
+            }
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        linearNested.Search(line);
+        double linearMs = ElapsedMs(start);
+        std::printf("%-12zu %14s %14.3f\n", line.size(), standardResult.c_str(), linearMs);
+    }
+
+    return mismatches == 0 ? 0 : 1;
+}
@@ -6,8 +6,14 @@ Chiamato dal programma C++ MedicalReportMonitor.
 
 Uso: python extract_zones.py <pdf_path> <profile_json_path>
 Output: testo estratto su stdout (UTF-8)
+
+     python extract_zones.py --server
+Server persistente: richieste e risposte con prefisso di lunghezza su
+stdin/stdout (vedi serve()), per evitare avvio dell'interprete e import
+di fitz a ogni PDF.
 """
 
+import os
 import sys
 import json
 import re
@@ -249,9 +255,92 @@ def zone_applies_to_page(zone, page_num):
     return False
 
 
+def extract_profile_zones(pdf_path, profile):
+    """Estrae e formatta il testo di tutte le zone del profilo"""
+    doc = fitz.open(pdf_path)
+
+    # Estrai testo da tutte le zone
+    all_texts = []
+
+    try:
+        for page_num in range(len(doc)):
+            page = doc[page_num]
+
+            for zone in profile.get('zones', []):
+                if zone_applies_to_page(zone, page_num):
+                    text = extract_text_from_zone(page, zone)
+                    if text:
+                        all_texts.append(text)
+    finally:
+        doc.close()
+
+    # Unisci testi e applica formattazione
+    result = '\n'.join(all_texts)
+    return format_text(result)
+
+
+def load_profile(profile_path):
+    with open(profile_path, 'r', encoding='utf-8') as f:
+        return json.load(f)
+
+
+def read_exact(stream, size):
+    """Legge esattamente size byte, None a fine stream"""
+    data = b''
+    while len(data) < size:
+        chunk = stream.read(size - len(data))
+        if not chunk:
+            return None
+        data += chunk
+    return data
+
+
+def serve():
+    """
+    Modalita' server: un processo resta attivo ed elabora piu' PDF.
+    Richiesta:  lunghezza (4 byte little-endian) + "pdf_path\0profile_path" UTF-8
+    Risposta:   lunghezza (4 byte little-endian) + 'O' o 'E' + testo UTF-8
+    I profili restano in cache finche' il file non cambia.
+    """
+    stdin = sys.stdin.buffer
+    stdout = sys.stdout.buffer
+    # stdout e' riservato al protocollo: eventuali print finiscono su stderr
+    sys.stdout = sys.stderr
+
+    profiles = {}
+
+    while True:
+        header = read_exact(stdin, 4)
+        if header is None:
+            break
+        payload = read_exact(stdin, int.from_bytes(header, 'little'))
+        if payload is None:
+            break
+
+        try:
+            pdf_path, profile_path = payload.decode('utf-8').split('\0')
+            mtime = os.path.getmtime(profile_path)
+            cached = profiles.get(profile_path)
+            if cached is None or cached[0] != mtime:
+                cached = (mtime, load_profile(profile_path))
+                profiles[profile_path] = cached
+            response = b'O' + extract_profile_zones(pdf_path, cached[1]).encode('utf-8')
+        except Exception as e:
+            response = b'E' + str(e).encode('utf-8')
+
+        stdout.write(len(response).to_bytes(4, 'little'))
+        stdout.write(response)
+        stdout.flush()
+
+
 def main():
+    if len(sys.argv) == 2 and sys.argv[1] == '--server':
+        serve()
+        return
+
     if len(sys.argv) < 3:
         print("Uso: python extract_zones.py <pdf_path> <profile_json_path>", file=sys.stderr)
+        print("     python extract_zones.py --server", file=sys.stderr)
         sys.exit(1)
 
     pdf_path = sys.argv[1]
@@ -259,37 +348,18 @@ def main():
 
     # Carica profilo
     try:
-        with open(profile_path, 'r', encoding='utf-8') as f:
-            profile = json.load(f)
+        profile = load_profile(profile_path)
     except Exception as e:
         print(f"Errore caricamento profilo: {e}", file=sys.stderr)
         sys.exit(2)
 
-    # Apri PDF
+    # Apri PDF ed estrai le zone
     try:
-        doc = fitz.open(pdf_path)
+        result = extract_profile_zones(pdf_path, profile)
     except Exception as e:
         print(f"Errore apertura PDF: {e}", file=sys.stderr)
         sys.exit(3)
 
-    # Estrai testo da tutte le zone
-    all_texts = []
-
-    for page_num in range(len(doc)):
-        page = doc[page_num]
-
-        for zone in profile.get('zones', []):
-            if zone_applies_to_page(zone, page_num):
-                text = extract_text_from_zone(page, zone)
-                if text:
-                    all_texts.append(text)
-
-    doc.close()
-
-    # Unisci testi e applica formattazione
-    result = '\n'.join(all_texts)
-    result = format_text(result)
-
     # Stampa in UTF-8
     sys.stdout.reconfigure(encoding='utf-8')
     print(result)
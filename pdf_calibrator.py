@@ -13,6 +13,7 @@ class PDFZoneCalibrator:
         self.doc = fitz.open(pdf_path)
         self.current_page = 0
         self.zones = []
+        self.identifier_patterns = []  # Pattern di riconoscimento, scritti a mano nel JSON
         self.zone_label = "zona_1"  # Nome default incrementale
         self.zone_pages_mode = "current"
         self.unsaved_changes = False
@@ -444,6 +445,26 @@ class PDFZoneCalibrator:
                 print(f"   Coord: ({zone['x']}, {zone['y']}) - {zone['width']}×{zone['height']}")
         print("="*60 + "\n")
     
+    def _layout_fingerprint(self, columns=24, rows=32):
+        """Impronta dell'impaginazione della prima pagina (vedi LayoutFingerprint.h):
+        celle della griglia coperte da almeno una parola, in esadecimale"""
+        page = self.doc[0]
+        width, height = page.rect.width, page.rect.height
+        bits = [0] * (columns * rows)
+
+        def cell(value, n):
+            return max(0, min(n - 1, int(value * n // 1)))
+
+        for x0, y0, x1, y1, *_ in page.get_text("words"):
+            if x1 < x0 or y1 < y0 or x1 < 0 or y1 < 0 or x0 > width or y0 > height:
+                continue
+            for row in range(cell(y0 / height, rows), cell(y1 / height, rows) + 1):
+                for column in range(cell(x0 / width, columns), cell(x1 / width, columns) + 1):
+                    bits[row * columns + column] = 1
+
+        cells = "".join("%x" % int("".join(map(str, bits[i:i + 4])), 2) for i in range(0, len(bits), 4))
+        return {"columns": columns, "rows": rows, "cells": cells}
+
     def save_profile(self, event, silent=False):
         profile = {
             "profile_name": self.profile_name,
@@ -453,8 +474,11 @@ class PDFZoneCalibrator:
                 "width": self.page_width,
                 "height": self.page_height
             },
-            "zones": self.zones
+            "zones": self.zones,
+            "layout": self._layout_fingerprint()
         }
+        if self.identifier_patterns:
+            profile["identifier_patterns"] = self.identifier_patterns
         
         filename = f"profile_{self.profile_name}.json"
         with open(filename, 'w', encoding='utf-8') as f:
@@ -486,6 +510,7 @@ class PDFZoneCalibrator:
             profile = json.load(f)
         
         self.zones = profile.get('zones', [])
+        self.identifier_patterns = profile.get('identifier_patterns', [])
         
         # Aggiorna contatore per suggerimenti
         if self.zones:
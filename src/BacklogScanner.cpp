@@ -0,0 +1,204 @@
+#include "BacklogScanner.h"
+#include "ContentHash.h"
+#include "ProcessedLedger.h"
+#include <filesystem>
+#include <algorithm>
+#include <vector>
+#include <cwctype>
+
+BacklogScanner::BacklogScanner()
+    : progressInterval(5), quietPeriod(1000), pool(nullptr), maxPending(1), running(false),
+      found(0), skipped(0), queued(0), completed(0), scanDone(false) {
+}
+
+BacklogScanner::~BacklogScanner() {
+    Stop();
+}
+
+void BacklogScanner::SetHandler(Handler h) {
+    handler = h;
+}
+
+void BacklogScanner::SetProgressCallback(ProgressCallback callback, std::chrono::seconds interval) {
+    progressCallback = callback;
+    progressInterval = interval;
+}
+
+void BacklogScanner::SetQuietPeriod(std::chrono::milliseconds quiet) {
+    quietPeriod = quiet;
+}
+
+bool BacklogScanner::Start(const std::wstring& dir, IngestPool& ingestPool, size_t pending) {
+    if (running) {
+        return true;
+    }
+
+    directory = dir;
+    pool = &ingestPool;
+    maxPending = pending > 0 ? pending : std::max<size_t>(1, ingestPool.GetWorkerCount());
+    found = skipped = queued = completed = 0;
+    scanDone = false;
+
+    running = true;
+    scanThread = std::thread(&BacklogScanner::ScanThread, this);
+    return true;
+}
+
+void BacklogScanner::Stop() {
+    if (!running && !scanThread.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(waitMutex);
+        running = false;
+    }
+    waitStop.notify_all();
+
+    if (scanThread.joinable()) {
+        scanThread.join();
+    }
+}
+
+BacklogScanner::Progress BacklogScanner::GetProgress() const {
+    Progress p;
+    p.found = found;
+    p.skipped = skipped;
+    p.queued = queued;
+    p.completed = completed;
+    p.elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    p.perMinute = p.elapsedSeconds > 0 ? p.completed * 60.0 / p.elapsedSeconds : 0.0;
+    p.scanDone = scanDone;
+    p.finished = scanDone && p.completed >= p.queued;
+    return p;
+}
+
+void BacklogScanner::OnItemDone(const std::wstring& path, bool processed) {
+    if (processed && handler) {
+        try {
+            handler(path);
+        } catch (...) {
+            // Conta comunque come elaborato: l'errore e' gia' del singolo PDF
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(waitMutex);
+        if (processed) {
+            completed++;
+        } else {
+            queued--;   // Non elaborato: verra' ripreso al prossimo avvio
+        }
+    }
+    waitStop.notify_all();
+}
+
+void BacklogScanner::ReportProgress(bool force) {
+    auto now = std::chrono::steady_clock::now();
+    if (!force && now - lastReport < progressInterval) {
+        return;
+    }
+    lastReport = now;
+
+    if (progressCallback) {
+        progressCallback(GetProgress());
+    }
+}
+
+void BacklogScanner::ScanThread() {
+    startTime = std::chrono::steady_clock::now();
+    lastReport = startTime;
+
+    // Elenca i PDF con la data di modifica
+    struct Candidate {
+        std::filesystem::file_time_type mtime;
+        std::wstring path;
+    };
+    std::vector<Candidate> candidates;
+
+    std::error_code ec;
+    for (std::filesystem::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)) {
+        std::wstring ext = it->path().extension().wstring();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::towlower);
+        if (ext != L".pdf" || !it->is_regular_file(ec)) {
+            continue;
+        }
+
+        std::error_code timeEc;
+        auto mtime = it->last_write_time(timeEc);
+        if (!timeEc) {
+            candidates.push_back({ mtime, it->path().wstring() });
+        }
+    }
+
+    // Dal piu' vecchio al piu' recente
+    std::sort(candidates.begin(), candidates.end(),
+              [](const Candidate& a, const Candidate& b) { return a.mtime < b.mtime; });
+    found = candidates.size();
+
+    for (const auto& candidate : candidates) {
+        if (!running) {
+            return;
+        }
+
+        // Un file appena scritto potrebbe essere ancora incompleto: attendi il
+        // periodo di quiete prima di calcolarne l'hash
+        auto age = std::filesystem::file_time_type::clock::now() - candidate.mtime;
+        if (age < quietPeriod) {
+            std::unique_lock<std::mutex> lock(waitMutex);
+            waitStop.wait_for(lock, quietPeriod - age, [this] { return !running; });
+        }
+
+        // Il registro si aggiorna solo a elaborazione riuscita (dai worker)
+        uint64_t hash;
+        if (!ContentHash::HashFile(candidate.path, hash) || ProcessedLedger::Contains(hash)) {
+            skipped++;
+            continue;
+        }
+
+        // Al massimo maxPending PDF dell'arretrato nel pool: l'ordine per
+        // data viene rispettato e le notifiche live non restano indietro
+        while (running && queued - completed >= maxPending) {
+            std::unique_lock<std::mutex> lock(waitMutex);
+            waitStop.wait_for(lock, std::chrono::seconds(1),
+                              [this] { return !running || queued - completed < maxPending; });
+            lock.unlock();
+            ReportProgress(false);
+        }
+        if (!running) {
+            return;
+        }
+
+        queued++;
+        SubmitResult result;
+        while ((result = pool->Submit(candidate.path,
+                    [this](const std::wstring& path) { OnItemDone(path, true); },
+                    [this](const std::wstring& path) { OnItemDone(path, false); })) == SubmitResult::Dropped) {
+            // Coda piena con drop-newest: si riprova quando si libera
+            std::unique_lock<std::mutex> lock(waitMutex);
+            if (waitStop.wait_for(lock, std::chrono::milliseconds(500), [this] { return !running; })) {
+                break;
+            }
+        }
+        if (result != SubmitResult::Accepted) {
+            queued--;
+            return;
+        }
+        ReportProgress(false);
+    }
+
+    scanDone = true;
+
+    // Attendi lo smaltimento, riportando l'avanzamento
+    while (running && completed < queued) {
+        std::unique_lock<std::mutex> lock(waitMutex);
+        waitStop.wait_for(lock, std::chrono::seconds(1),
+                          [this] { return !running || completed >= queued; });
+        lock.unlock();
+        ReportProgress(false);
+    }
+
+    if (running) {
+        ReportProgress(true);
+    }
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <string>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include "IngestPool.h"
+
+// Recupero all'avvio dei PDF arrivati mentre il monitor era spento.
+// Un thread elenca la directory, scarta i file gia' presenti in ProcessedLedger
+// e accoda gli altri in ordine di data di modifica nel pool di ingest, con un
+// proprio handler. I PDF dell'arretrato in coda o in elaborazione sono al
+// massimo maxPending, cosi' le notifiche live si alternano a quelli e non
+// attendono lo smaltimento di tutto l'arretrato. L'avanzamento viene
+// riportato periodicamente.
+class BacklogScanner {
+public:
+    using Handler = std::function<void(const std::wstring&)>;
+
+    struct Progress {
+        size_t found;           // PDF presenti nella directory
+        size_t skipped;         // Gia' elaborati (presenti nel registro)
+        size_t queued;          // Accodati per l'elaborazione
+        size_t completed;       // Elaborati
+        double elapsedSeconds;  // Tempo dall'avvio della scansione
+        double perMinute;       // PDF elaborati al minuto
+        bool scanDone;          // Elenco e accodamento terminati
+        bool finished;          // Tutti i PDF accodati sono stati elaborati
+    };
+
+    using ProgressCallback = std::function<void(const Progress&)>;
+
+    BacklogScanner();
+    ~BacklogScanner();
+
+    // Funzione che elabora un PDF dell'arretrato (eseguita sui worker del pool)
+    void SetHandler(Handler handler);
+
+    // Callback di avanzamento, invocata ogni 'interval' e al termine
+    void SetProgressCallback(ProgressCallback callback, std::chrono::seconds interval);
+
+    // I file modificati da meno di 'quiet' vengono attesi prima dell'hash
+    void SetQuietPeriod(std::chrono::milliseconds quiet);
+
+    // Avvia la scansione accodando nel pool. maxPending = 0 usa il numero
+    // di worker del pool
+    bool Start(const std::wstring& directory, IngestPool& pool, size_t maxPending);
+
+    // Interrompe la scansione. I PDF gia' accodati restano al pool: va
+    // fermato prima di distruggere lo scanner. Quelli non elaborati non sono
+    // registrati nel ProcessedLedger e verranno ripresi al prossimo avvio
+    void Stop();
+
+    Progress GetProgress() const;
+
+private:
+    void ScanThread();
+    void ReportProgress(bool force);
+
+    // Un PDF dell'arretrato lascia il pool: elaborato o scartato da drop-oldest
+    void OnItemDone(const std::wstring& path, bool processed);
+
+    std::wstring directory;
+    Handler handler;
+    ProgressCallback progressCallback;
+    std::chrono::seconds progressInterval;
+    std::chrono::milliseconds quietPeriod;
+
+    IngestPool* pool;
+    size_t maxPending;
+    std::thread scanThread;
+    std::atomic<bool> running;
+    std::mutex waitMutex;
+    std::condition_variable waitStop;
+
+    std::chrono::steady_clock::time_point startTime;
+    std::chrono::steady_clock::time_point lastReport;
+    std::atomic<size_t> found;
+    std::atomic<size_t> skipped;
+    std::atomic<size_t> queued;
+    std::atomic<size_t> completed;
+    std::atomic<bool> scanDone;
+};
@@ -1,20 +1,10 @@
 #include "ClaudeAnalyzer.h"
 #include "Config.h"
+#include "Subprocess.h"
 #include <Windows.h>
-#include <fstream>
-#include <sstream>
 #include <vector>
 
-std::wstring ClaudeAnalyzer::lastError;
-
-// Converte UTF-8 in wstring usando API Windows
-static std::wstring Utf8ToWstring(const std::string& utf8) {
-    if (utf8.empty()) return std::wstring();
-    int size = MultiByteToWideChar(CP_UTF8, 0, utf8.c_str(), (int)utf8.size(), NULL, 0);
-    std::wstring result(size, 0);
-    MultiByteToWideChar(CP_UTF8, 0, utf8.c_str(), (int)utf8.size(), &result[0], size);
-    return result;
-}
+thread_local std::wstring ClaudeAnalyzer::lastError;
 
 // Converte wstring in UTF-8
 static std::string WstringToUtf8(const std::wstring& wide) {
@@ -83,47 +73,10 @@ static std::string BuildPrompt(const std::wstring& reportText) {
     return prompt;
 }
 
-// Scrive il prompt in un file temporaneo UTF-8, ritorna il percorso
-static std::wstring WriteTempPromptFile(const std::string& prompt) {
-    wchar_t tempPath[MAX_PATH];
-    wchar_t tempFile[MAX_PATH];
-    GetTempPathW(MAX_PATH, tempPath);
-    GetTempFileNameW(tempPath, L"clp", 0, tempFile);
-
-    // Scrivi come UTF-8
-    std::ofstream file(tempFile, std::ios::binary);
-    if (!file.is_open()) return L"";
-
-    file.write(prompt.c_str(), prompt.size());
-    file.close();
-
-    return std::wstring(tempFile);
-}
-
 bool ClaudeAnalyzer::IsAvailable() {
-    STARTUPINFOW si = { sizeof(si) };
-    si.dwFlags = STARTF_USESHOWWINDOW;
-    si.wShowWindow = SW_HIDE;
-
-    PROCESS_INFORMATION pi;
-    std::wstring cmdLine = L"claude --version";
-    std::vector<wchar_t> cmdBuffer(cmdLine.begin(), cmdLine.end());
-    cmdBuffer.push_back(0);
-
-    BOOL success = CreateProcessW(
-        NULL, cmdBuffer.data(), NULL, NULL, FALSE,
-        CREATE_NO_WINDOW, NULL, NULL, &si, &pi
-    );
-
-    if (!success) return false;
-
-    WaitForSingleObject(pi.hProcess, 10000);
-    DWORD exitCode;
-    GetExitCodeProcess(pi.hProcess, &exitCode);
-    CloseHandle(pi.hProcess);
-    CloseHandle(pi.hThread);
-
-    return exitCode == 0;
+    Subprocess::Result run = Subprocess::Run(L"claude", { L"--version" }, std::string(),
+                                             std::chrono::milliseconds(10000), 256);
+    return run.started && !run.timedOut && run.exitCode == 0;
 }
 
 std::wstring ClaudeAnalyzer::GetLastError() {
@@ -138,85 +91,28 @@ std::wstring ClaudeAnalyzer::Analyze(const std::wstring& reportText) {
         return L"";
     }
 
-    // Costruisci e scrivi il prompt su file temp
+    // Prompt su stdin e risposta dallo stdout di claude --print, con timeout configurabile
     std::string prompt = BuildPrompt(reportText);
-    std::wstring promptFile = WriteTempPromptFile(prompt);
-    if (promptFile.empty()) {
-        lastError = L"Impossibile creare file temporaneo per il prompt";
-        return L"";
-    }
-
-    // File temporaneo per l'output
-    wchar_t tempPath[MAX_PATH];
-    wchar_t tempFile[MAX_PATH];
-    GetTempPathW(MAX_PATH, tempPath);
-    GetTempFileNameW(tempPath, L"clo", 0, tempFile);
-    std::wstring outputFile = std::wstring(tempFile);
-
-    // Comando: type prompt | claude --print > output
-    std::wstring cmdLine = L"cmd /c type \"" + promptFile + L"\" | claude --print > \"" + outputFile + L"\"";
-
-    STARTUPINFOW si = { sizeof(si) };
-    si.dwFlags = STARTF_USESHOWWINDOW;
-    si.wShowWindow = SW_HIDE;
+    DWORD timeoutMs = Config::Get()->claudeTimeoutMs;
+    Subprocess::Result run = Subprocess::Run(L"claude", { L"--print" }, prompt,
+                                             std::chrono::milliseconds(timeoutMs));
 
-    PROCESS_INFORMATION pi;
-    std::vector<wchar_t> cmdBuffer(cmdLine.begin(), cmdLine.end());
-    cmdBuffer.push_back(0);
-
-    BOOL success = CreateProcessW(
-        NULL, cmdBuffer.data(), NULL, NULL, FALSE,
-        CREATE_NO_WINDOW, NULL, NULL, &si, &pi
-    );
-
-    if (!success) {
+    if (!run.started) {
         lastError = L"Impossibile avviare Claude CLI";
-        DeleteFileW(promptFile.c_str());
-        DeleteFileW(outputFile.c_str());
         return L"";
     }
 
-    // Attendi completamento con timeout configurabile
-    DWORD waitResult = WaitForSingleObject(pi.hProcess, Config::claudeTimeoutMs);
-
-    if (waitResult == WAIT_TIMEOUT) {
-        TerminateProcess(pi.hProcess, 1);
-        CloseHandle(pi.hProcess);
-        CloseHandle(pi.hThread);
-        DeleteFileW(promptFile.c_str());
-        DeleteFileW(outputFile.c_str());
-        lastError = L"Timeout analisi Claude (" + std::to_wstring(Config::claudeTimeoutMs / 1000) + L"s)";
+    if (run.timedOut) {
+        lastError = L"Timeout analisi Claude (" + std::to_wstring(timeoutMs / 1000) + L"s)";
         return L"";
     }
 
-    DWORD exitCode;
-    GetExitCodeProcess(pi.hProcess, &exitCode);
-    CloseHandle(pi.hProcess);
-    CloseHandle(pi.hThread);
-
-    // Cleanup prompt temp
-    DeleteFileW(promptFile.c_str());
-
-    if (exitCode != 0) {
-        lastError = L"Claude CLI ha restituito errore: " + std::to_wstring(exitCode);
-        DeleteFileW(outputFile.c_str());
-        return L"";
-    }
-
-    // Leggi output UTF-8
-    std::ifstream file(outputFile, std::ios::binary);
-    if (!file.is_open()) {
-        lastError = L"Impossibile leggere output Claude";
-        DeleteFileW(outputFile.c_str());
+    if (run.exitCode != 0) {
+        lastError = L"Claude CLI ha restituito errore: " + std::to_wstring(run.exitCode);
         return L"";
     }
 
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    file.close();
-    DeleteFileW(outputFile.c_str());
-
-    std::wstring result = Utf8ToWstring(buffer.str());
+    std::wstring result = run.output;
 
     // Verifica output troppo breve
     if (result.size() < 50) {
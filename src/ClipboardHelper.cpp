@@ -1,6 +1,6 @@
 #include "ClipboardHelper.h"
 
-std::wstring ClipboardHelper::lastError;
+thread_local std::wstring ClipboardHelper::lastError;
 
 bool ClipboardHelper::CopyToClipboard(const std::wstring& text) {
     lastError.clear();
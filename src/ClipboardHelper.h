@@ -11,5 +11,5 @@ public:
     static std::wstring GetLastError();
     
 private:
-    static std::wstring lastError;
+    static thread_local std::wstring lastError;
 };
@@ -0,0 +1,129 @@
+#include "CompiledProfile.h"
+#include "ReportProfile.h"
+#include <algorithm>
+
+CompiledProfile::CompiledProfile(const ReportProfile& profile) {
+    CompileSet(profile.keepPatterns, keep);
+    CompileSet(profile.excludePatterns, exclude);
+    CompileList(profile.patientNamePatterns, patientNamePatterns);
+    CompileNewlines(profile.newlineBeforePatterns);
+}
+
+void CompiledProfile::CompileList(const std::vector<std::wstring>& patterns, std::vector<ProfileRegex>& target) {
+    for (const auto& pattern : patterns) {
+        ProfileRegex re;
+        if (re.Compile(pattern)) {
+            target.push_back(std::move(re));
+        } else {
+            invalidPatterns.push_back(pattern);
+        }
+    }
+}
+
+void CompiledProfile::CompileNewlines(const std::vector<std::wstring>& patterns) {
+    std::vector<ProfileRegex> compiled;
+    CompileList(patterns, compiled);
+
+    // Un profilo dell'indice per marcatore: anche i duplicati contano
+    std::wstring literal;
+    for (auto& re : compiled) {
+        if (re.GetLiteral(literal)) {
+            newlineLiterals.AddProfile({ literal });
+        } else {
+            newlineBeforePatterns.push_back(std::move(re));
+        }
+    }
+    newlineLiterals.Build();
+}
+
+void CompiledProfile::CompileSet(const std::vector<std::wstring>& patterns, RuleSet& set) {
+    std::vector<std::wstring> linear;
+    for (size_t i = 0; i < patterns.size(); i++) {
+        ProfileRegex re;
+        if (!re.Compile(patterns[i])) {
+            invalidPatterns.push_back(patterns[i]);
+            continue;
+        }
+        if (re.IsLinear()) {
+            linear.push_back(patterns[i]);
+            set.combinedRules.push_back(static_cast<int>(i));
+        } else {
+            set.rules.push_back(std::move(re));
+            set.ruleIndex.push_back(static_cast<int>(i));
+        }
+    }
+
+    if (linear.empty() || set.combined.CompileSet(linear)) {
+        return;
+    }
+
+    // Programma unico troppo grande: regole lineari cercate una per una
+    for (size_t k = 0; k < linear.size(); k++) {
+        ProfileRegex re;
+        re.Compile(linear[k]);
+        set.rules.push_back(std::move(re));
+        set.ruleIndex.push_back(set.combinedRules[k]);
+    }
+    set.combinedRules.clear();
+}
+
+// Regola con il match piu' a sinistra; a parita' di posizione la prima del profilo
+int CompiledProfile::MatchSet(const RuleSet& set, std::wstring_view line) const {
+    int rule = -1;
+    size_t position = std::wstring::npos;
+    ProfileRegex::Match match;
+
+    if (set.combined.IsValid() && set.combined.Search(line, match)) {
+        rule = set.combinedRules[match.pattern];
+        position = match.position;
+    }
+    for (size_t k = 0; k < set.rules.size(); k++) {
+        if (set.rules[k].Search(line, match) &&
+            (match.position < position || (match.position == position && set.ruleIndex[k] < rule))) {
+            rule = set.ruleIndex[k];
+            position = match.position;
+        }
+    }
+    return rule;
+}
+
+CompiledProfile::LineMatch CompiledProfile::MatchLine(std::wstring_view line) const {
+    int rule = MatchSet(keep, line);
+    if (rule >= 0) {
+        return { LINE_KEEP, rule };
+    }
+    rule = MatchSet(exclude, line);
+    if (rule >= 0) {
+        return { LINE_EXCLUDE, rule };
+    }
+    return { LINE_DEFAULT, -1 };
+}
+
+void CompiledProfile::FindNewlineOffsets(std::wstring_view body, std::vector<size_t>& offsets) const {
+    offsets.clear();
+
+    // Marcatori letterali: una passata per tutti. Come regex_replace, le
+    // occorrenze dello stesso marcatore non si sovrappongono
+    if (newlineLiterals.GetProfileCount() > 0) {
+        std::vector<ProfileIndex::Occurrence> occurrences;
+        newlineLiterals.FindAll(body, occurrences);
+        std::vector<size_t> nextAllowed(newlineLiterals.GetProfileCount(), 0);
+        for (const auto& occurrence : occurrences) {
+            if (occurrence.position >= nextAllowed[occurrence.profile]) {
+                offsets.push_back(occurrence.position);
+                nextAllowed[occurrence.profile] = occurrence.position + occurrence.length;
+            }
+        }
+    }
+
+    ProfileRegex::Match match;
+    for (const auto& pattern : newlineBeforePatterns) {
+        // Come regex_replace con "\n$&": un match vuoto avanza di un carattere
+        size_t pos = 0;
+        while (pos <= body.size() && pattern.Search(body, match, pos)) {
+            offsets.push_back(match.position);
+            pos = match.position + (match.length > 0 ? match.length : 1);
+        }
+    }
+    std::sort(offsets.begin(), offsets.end());
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "ProfileRegex.h"
+#include "ProfileIndex.h"
+
+struct ReportProfile;
+
+// Regole di un profilo di parsing compilate una sola volta, quando
+// ProfileManager inizializza i profili: nessuna regex viene piu' costruita
+// per riga o per referto. I pattern girano sul motore lineare di
+// ProfileRegex; le regole keep ed exclude sono riunite ciascuna in un unico
+// programma, per cui una sola ricerca per insieme decide il destino della
+// riga e indica la regola scattata. Un'istanza e' immutabile e
+// condivisibile tra thread.
+class CompiledProfile {
+public:
+    enum LineAction {
+        LINE_DEFAULT,       // Nessuna regola: la riga resta
+        LINE_KEEP,          // Regola keep (prevale sulle exclude)
+        LINE_EXCLUDE        // Regola exclude
+    };
+
+    struct LineMatch {
+        LineAction action;
+        int rule;           // Indice in keepPatterns o excludePatterns, -1 se nessuna
+    };
+
+    explicit CompiledProfile(const ReportProfile& profile);
+
+    // Regola che decide la riga. Con piu' regole dello stesso insieme vince
+    // quella che corrisponde piu' a sinistra nella riga
+    LineMatch MatchLine(std::wstring_view line) const;
+
+    bool ShouldExcludeLine(std::wstring_view line) const {
+        return MatchLine(line).action == LINE_EXCLUDE;
+    }
+
+    // Pattern del nome paziente, nell'ordine del profilo
+    const std::vector<ProfileRegex>& GetPatientNamePatterns() const { return patientNamePatterns; }
+
+    // Posizioni del corpo prima delle quali va un '\n': ogni occorrenza di
+    // ogni pattern newlineBefore, in ordine (ripetute se piu' pattern
+    // iniziano nello stesso punto). Il corpo non viene copiato; i pattern
+    // letterali sono cercati tutti insieme in una sola passata
+    void FindNewlineOffsets(std::wstring_view body, std::vector<size_t>& offsets) const;
+
+    // Pattern non compilabili (ignorati, come in precedenza)
+    const std::vector<std::wstring>& GetInvalidPatterns() const { return invalidPatterns; }
+
+private:
+    // Insieme di regole keep o exclude
+    struct RuleSet {
+        ProfileRegex combined;              // Regole del motore lineare in un solo programma
+        std::vector<int> combinedRules;     // Pattern del programma -> indice nel profilo
+        std::vector<ProfileRegex> rules;    // Regole cercate singolarmente (std::wregex)
+        std::vector<int> ruleIndex;         // Posizione in rules -> indice nel profilo
+    };
+
+    void CompileSet(const std::vector<std::wstring>& patterns, RuleSet& set);
+    void CompileList(const std::vector<std::wstring>& patterns, std::vector<ProfileRegex>& target);
+    void CompileNewlines(const std::vector<std::wstring>& patterns);
+    int MatchSet(const RuleSet& set, std::wstring_view line) const;
+
+    RuleSet keep;
+    RuleSet exclude;
+    std::vector<ProfileRegex> patientNamePatterns;
+    ProfileIndex newlineLiterals;                       // Pattern newlineBefore letterali
+    std::vector<ProfileRegex> newlineBeforePatterns;    // Gli altri, cercati uno per uno
+    std::vector<std::wstring> invalidPatterns;
+};
@@ -1,9 +1,44 @@
 #include "Config.h"
 #include <fstream>
+#include <filesystem>
+#include <mutex>
 #include <shlobj.h>
 
 namespace Config {
 
+namespace {
+
+// Impostazioni pubblicate, lette e sostituite solo con std::atomic_load/atomic_store
+std::shared_ptr<const Settings> current = std::make_shared<Settings>();
+
+// Impostazioni fissate da Pin sul thread
+thread_local std::shared_ptr<const Settings> pinned;
+
+// Serializza le letture di config.ini; data di modifica dell'ultima letta
+std::mutex loadMutex;
+std::filesystem::file_time_type loadedWriteTime;
+
+}
+
+std::shared_ptr<const Settings> Get() {
+    if (pinned) {
+        return pinned;
+    }
+    return std::atomic_load(&current);
+}
+
+void Publish(const Settings& settings) {
+    std::atomic_store(&current, std::shared_ptr<const Settings>(std::make_shared<Settings>(settings)));
+}
+
+Pin::Pin() : previous(pinned) {
+    pinned = std::atomic_load(&current);
+}
+
+Pin::~Pin() {
+    pinned = previous;
+}
+
 std::wstring GetExecutableDir() {
     wchar_t path[MAX_PATH];
     GetModuleFileNameW(NULL, path, MAX_PATH);
@@ -12,8 +47,8 @@ std::wstring GetExecutableDir() {
     return fullPath.substr(0, pos);
 }
 
-bool LoadConfig() {
-    std::wstring configPath = GetExecutableDir() + L"\\" + CONFIG_FILE;
+// Legge config.ini sopra i valori di default
+static bool ReadConfigFile(const std::wstring& configPath, Settings& settings) {
     std::wifstream file(configPath);
     
     if (!file.is_open()) {
@@ -28,25 +63,124 @@ bool LoadConfig() {
             std::wstring value = line.substr(pos + 1);
             
             if (key == L"WatchDirectory") {
-                watchDirectory = value;
+                settings.watchDirectory = value;
             }
             else if (key == L"OutputDirectory") {
-                outputDirectory = value;
+                settings.outputDirectory = value;
             }
             else if (key == L"PdfToTextPath") {
-                pdftotextPath = value;
+                settings.pdftotextPath = value;
+            }
+            else if (key == L"PdfToPpmPath") {
+                settings.pdftoppmPath = value;
+            }
+            else if (key == L"TesseractPath") {
+                settings.tesseractPath = value;
+            }
+            else if (key == L"OcrLanguages") {
+                settings.ocrLanguages = value;
+            }
+            else if (key == L"OcrDpi") {
+                try { settings.ocrDpi = std::stoul(value); } catch (...) {}
+            }
+            else if (key == L"OcrMinTextChars") {
+                try { settings.ocrMinTextChars = std::stoul(value); } catch (...) {}
+            }
+            else if (key == L"NativePdfEngine") {
+                settings.nativePdfEngine = (value == L"1");
+            }
+            else if (key == L"ParallelPageThreshold") {
+                try { settings.parallelPageThreshold = std::stoul(value); } catch (...) {}
+            }
+            else if (key == L"ParallelPageThreads") {
+                try { settings.parallelPageThreads = std::stoul(value); } catch (...) {}
+            }
+            else if (key == L"SettleQuietMs") {
+                try { settings.settleQuietMs = std::stoul(value); } catch (...) {}
+            }
+            else if (key == L"WorkerThreads") {
+                try { settings.workerThreads = std::stoul(value); } catch (...) {}
+            }
+            else if (key == L"IngestQueueCapacity") {
+                try { settings.ingestQueueCapacity = std::stoul(value); } catch (...) {}
+            }
+            else if (key == L"IngestOverflowPolicy") {
+                settings.ingestOverflowPolicy = value;
+            }
+            else if (key == L"BacklogWorkers") {
+                try { settings.backlogWorkers = std::stoul(value); } catch (...) {}
+            }
+            else if (key == L"MaxProcesses") {
+                try { settings.maxProcesses = std::stoul(value); } catch (...) {}
+            }
+            else if (key == L"LedgerRetentionHours") {
+                try { settings.ledgerRetentionHours = std::stoul(value); } catch (...) {}
+            }
+            else if (key == L"PythonWorkers") {
+                try { settings.pythonWorkers = std::stoul(value); } catch (...) {}
+            }
+            else if (key == L"PythonRecycleAfter") {
+                try { settings.pythonRecycleAfter = std::stoul(value); } catch (...) {}
+            }
+            else if (key == L"CacheMaxMB") {
+                try { settings.cacheMaxMB = std::stoul(value); } catch (...) {}
+            }
+            else if (key == L"TextProfilesDirectory") {
+                settings.textProfilesDirectory = value;
+            }
+            else if (key == L"ZoneLayoutThreshold") {
+                try { settings.zoneLayoutThreshold = std::stoul(value); } catch (...) {}
+            }
+            else if (key == L"ProfileRefreshSeconds") {
+                try { settings.profileRefreshSeconds = std::stoul(value); } catch (...) {}
             }
             else if (key == L"ClaudeEnabled") {
-                claudeEnabled = (value == L"1");
+                settings.claudeEnabled = (value == L"1");
             }
             else if (key == L"ClaudeTimeoutMs") {
-                try { claudeTimeoutMs = std::stoul(value); } catch (...) {}
+                try { settings.claudeTimeoutMs = std::stoul(value); } catch (...) {}
             }
         }
     }
     
     file.close();
-    return !watchDirectory.empty();
+    return true;
+}
+
+bool LoadConfig() {
+    std::wstring configPath = GetExecutableDir() + L"\\" + CONFIG_FILE;
+    Settings settings;
+    bool found = ReadConfigFile(configPath, settings);
+
+    std::error_code ec;
+    std::lock_guard<std::mutex> lock(loadMutex);
+    loadedWriteTime = std::filesystem::last_write_time(configPath, ec);
+    Publish(settings);
+    return found && !settings.watchDirectory.empty();
+}
+
+bool ReloadConfigIfChanged() {
+    std::wstring configPath = GetExecutableDir() + L"\\" + CONFIG_FILE;
+    std::error_code ec;
+    auto writeTime = std::filesystem::last_write_time(configPath, ec);
+    if (ec) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(loadMutex);
+    if (writeTime == loadedWriteTime) {
+        return false;
+    }
+
+    // Nuova istanza costruita a parte: i worker non vedono mai un file letto a meta'
+    // (senza directory monitorata il file e' ancora in scrittura: si riprova)
+    Settings settings;
+    if (!ReadConfigFile(configPath, settings) || settings.watchDirectory.empty()) {
+        return false;
+    }
+    loadedWriteTime = writeTime;
+    Publish(settings);
+    return true;
 }
 
 bool SaveConfig() {
@@ -57,13 +191,39 @@ bool SaveConfig() {
         return false;
     }
     
-    file << L"WatchDirectory=" << watchDirectory << std::endl;
-    file << L"OutputDirectory=" << outputDirectory << std::endl;
-    file << L"PdfToTextPath=" << pdftotextPath << std::endl;
-    file << L"ClaudeEnabled=" << (claudeEnabled ? L"1" : L"0") << std::endl;
-    file << L"ClaudeTimeoutMs=" << claudeTimeoutMs << std::endl;
+    std::shared_ptr<const Settings> settings = Get();
+    file << L"WatchDirectory=" << settings->watchDirectory << std::endl;
+    file << L"OutputDirectory=" << settings->outputDirectory << std::endl;
+    file << L"PdfToTextPath=" << settings->pdftotextPath << std::endl;
+    file << L"PdfToPpmPath=" << settings->pdftoppmPath << std::endl;
+    file << L"TesseractPath=" << settings->tesseractPath << std::endl;
+    file << L"OcrLanguages=" << settings->ocrLanguages << std::endl;
+    file << L"OcrDpi=" << settings->ocrDpi << std::endl;
+    file << L"OcrMinTextChars=" << settings->ocrMinTextChars << std::endl;
+    file << L"NativePdfEngine=" << (settings->nativePdfEngine ? L"1" : L"0") << std::endl;
+    file << L"ParallelPageThreshold=" << settings->parallelPageThreshold << std::endl;
+    file << L"ParallelPageThreads=" << settings->parallelPageThreads << std::endl;
+    file << L"SettleQuietMs=" << settings->settleQuietMs << std::endl;
+    file << L"WorkerThreads=" << settings->workerThreads << std::endl;
+    file << L"IngestQueueCapacity=" << settings->ingestQueueCapacity << std::endl;
+    file << L"IngestOverflowPolicy=" << settings->ingestOverflowPolicy << std::endl;
+    file << L"BacklogWorkers=" << settings->backlogWorkers << std::endl;
+    file << L"MaxProcesses=" << settings->maxProcesses << std::endl;
+    file << L"LedgerRetentionHours=" << settings->ledgerRetentionHours << std::endl;
+    file << L"PythonWorkers=" << settings->pythonWorkers << std::endl;
+    file << L"PythonRecycleAfter=" << settings->pythonRecycleAfter << std::endl;
+    file << L"CacheMaxMB=" << settings->cacheMaxMB << std::endl;
+    file << L"TextProfilesDirectory=" << settings->textProfilesDirectory << std::endl;
+    file << L"ProfileRefreshSeconds=" << settings->profileRefreshSeconds << std::endl;
+    file << L"ZoneLayoutThreshold=" << settings->zoneLayoutThreshold << std::endl;
+    file << L"ClaudeEnabled=" << (settings->claudeEnabled ? L"1" : L"0") << std::endl;
+    file << L"ClaudeTimeoutMs=" << settings->claudeTimeoutMs << std::endl;
 
     file.close();
+
+    std::error_code ec;
+    std::lock_guard<std::mutex> lock(loadMutex);
+    loadedWriteTime = std::filesystem::last_write_time(configPath, ec);
     return true;
 }
 
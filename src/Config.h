@@ -1,30 +1,124 @@
 #pragma once
 #include <string>
+#include <memory>
 #include <Windows.h>
 
 namespace Config {
-    // Directory da monitorare (da configurare al primo avvio)
-    inline std::wstring watchDirectory = L"";
-    
-    // Directory di output per i file .txt
-    inline std::wstring outputDirectory = L"";
-    
-    // Percorso di pdftotext.exe
-    inline std::wstring pdftotextPath = L"pdftotext.exe";
+    // Impostazioni lette da config.ini. Un'istanza pubblicata non cambia
+    // piu': chi ne tiene un riferimento vede valori coerenti tra loro anche
+    // se nel frattempo config.ini viene ricaricato
+    struct Settings {
+        // Directory da monitorare (da configurare al primo avvio)
+        std::wstring watchDirectory = L"";
+
+        // Directory di output per i file .txt
+        std::wstring outputDirectory = L"";
+
+        // Percorso di pdftotext.exe
+        std::wstring pdftotextPath = L"pdftotext.exe";
+
+        // OCR dei PDF da scansione: rasterizzazione con pdftoppm (Poppler) e
+        // riconoscimento con Tesseract, lingue nel formato di tesseract -l
+        std::wstring pdftoppmPath = L"pdftoppm.exe";
+        std::wstring tesseractPath = L"tesseract.exe";
+        std::wstring ocrLanguages = L"ita+eng";
+        DWORD ocrDpi = 300;
+
+        // Sotto questo numero di caratteri (spazi esclusi) il testo estratto e'
+        // considerato insufficiente e il PDF passa all'OCR
+        DWORD ocrMinTextChars = 50;
+
+        // Estrazione con il motore PDF interno (pdftotext resta come fallback)
+        bool nativePdfEngine = true;
+
+        // Documenti da almeno parallelPageThreshold pagine vengono estratti a
+        // pagine in parallelo (0 = mai) su parallelPageThreads thread (0 = numero di core)
+        DWORD parallelPageThreshold = 8;
+        DWORD parallelPageThreads = 0;
+
+        // Periodo di quiete (ms) dopo il quale un PDF in scrittura e' considerato completo
+        DWORD settleQuietMs = 1000;
+
+        // Pool di elaborazione: worker (0 = numero di core), capacita' coda e
+        // politica di overflow (block, drop-newest, drop-oldest)
+        DWORD workerThreads = 0;
+        DWORD ingestQueueCapacity = 64;
+        std::wstring ingestOverflowPolicy = L"block";
+
+        // PDF arretrati recuperati all'avvio in elaborazione contemporanea sui
+        // worker del pool (0 = tutti i worker)
+        DWORD backlogWorkers = 0;
+
+        // Processi esterni (pdftotext, python, claude) in esecuzione contemporanea
+        // (0 = numero di core); gli altri attendono in coda
+        DWORD maxProcesses = 0;
+
+        // Ore per cui un PDF elaborato resta nel registro (processed.ledger)
+        DWORD ledgerRetentionHours = 24;
 
-    // Analisi AI con Claude CLI
-    inline bool claudeEnabled = false;
-    inline DWORD claudeTimeoutMs = 120000;  // 2 minuti default
+        // Processi extract_zones.py --server sempre attivi (0 = un processo per PDF)
+        // e numero di documenti dopo cui un processo viene riavviato (0 = mai)
+        DWORD pythonWorkers = 2;
+        DWORD pythonRecycleAfter = 200;
+
+        // Dimensione massima della cache dei risultati di estrazione (MB, 0 = disattivata)
+        DWORD cacheMaxMB = 64;
+
+        // Profili di parsing in formato testo (*.profile): directory (vuota =
+        // "profiles" nella directory dell'eseguibile) e intervallo in secondi
+        // del controllo delle modifiche (0 = solo all'avvio)
+        std::wstring textProfilesDirectory = L"";
+        DWORD profileRefreshSeconds = 2;
+
+        // Somiglianza minima (percentuale) tra l'impaginazione della prima
+        // pagina e quella di un profilo zone perche' il profilo venga usato
+        DWORD zoneLayoutThreshold = 60;
+
+        // Analisi AI con Claude CLI
+        bool claudeEnabled = false;
+        DWORD claudeTimeoutMs = 120000;  // 2 minuti default
+    };
+
+    // Impostazioni correnti, senza lock (quelle fissate da Pin, se presente)
+    std::shared_ptr<const Settings> Get();
+
+    // Pubblica nuove impostazioni: le letture successive vedono queste,
+    // chi tiene le precedenti continua a usarle
+    void Publish(const Settings& settings);
+
+    // Fissa le impostazioni correnti sul thread per la durata di un
+    // documento: ogni Get() del thread restituisce la stessa istanza
+    class Pin {
+    public:
+        Pin();
+        ~Pin();
+
+    private:
+        Pin(const Pin&) = delete;
+        Pin& operator=(const Pin&) = delete;
+
+        std::shared_ptr<const Settings> previous;
+    };
 
     // Nome applicazione per registro autostart
     inline const wchar_t* APP_NAME = L"MedicalReportMonitor";
     
     // File di configurazione
     inline const wchar_t* CONFIG_FILE = L"config.ini";
+
+    // Registro dei PDF elaborati (nella directory dell'eseguibile)
+    inline const wchar_t* LEDGER_FILE = L"processed.ledger";
+
+    // Cache dei risultati di estrazione (nella directory dell'eseguibile)
+    inline const wchar_t* CACHE_FILE = L"extraction.cache";
+
+    // Profili di parsing compilati (nella directory dell'eseguibile)
+    inline const wchar_t* PROFILES_COMPILED_FILE = L"profiles.bin";
     
     // Funzioni di utilità
     std::wstring GetExecutableDir();
     bool LoadConfig();
+    bool ReloadConfigIfChanged();   // true se config.ini e' cambiato ed e' stato ripubblicato
     bool SaveConfig();
     bool SetAutoStart(bool enable);
     bool IsAutoStartEnabled();
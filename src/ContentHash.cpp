@@ -0,0 +1,166 @@
+#include "ContentHash.h"
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+#include <vector>
+
+static const uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+static const uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+static const uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+static inline uint64_t RotL(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+// Lettura little-endian indipendente dall'allineamento
+static inline uint64_t Read64(const unsigned char* p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+static inline uint32_t Read32(const unsigned char* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+static inline uint64_t Round(uint64_t acc, uint64_t input) {
+    acc += input * PRIME64_2;
+    acc = RotL(acc, 31);
+    return acc * PRIME64_1;
+}
+
+static inline uint64_t MergeRound(uint64_t acc, uint64_t val) {
+    acc ^= Round(0, val);
+    return acc * PRIME64_1 + PRIME64_4;
+}
+
+ContentHash::Hasher::Hasher(uint64_t s) : totalLength(0), bufferSize(0), seed(s) {
+    v[0] = seed + PRIME64_1 + PRIME64_2;
+    v[1] = seed + PRIME64_2;
+    v[2] = seed;
+    v[3] = seed - PRIME64_1;
+}
+
+void ContentHash::Hasher::Update(const void* data, size_t length) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    const unsigned char* end = p + length;
+    totalLength += length;
+
+    // Completa il blocco rimasto in sospeso dalla chiamata precedente
+    if (bufferSize + length < 32) {
+        memcpy(buffer + bufferSize, p, length);
+        bufferSize += length;
+        return;
+    }
+
+    if (bufferSize > 0) {
+        size_t fill = 32 - bufferSize;
+        memcpy(buffer + bufferSize, p, fill);
+        v[0] = Round(v[0], Read64(buffer));
+        v[1] = Round(v[1], Read64(buffer + 8));
+        v[2] = Round(v[2], Read64(buffer + 16));
+        v[3] = Round(v[3], Read64(buffer + 24));
+        p += fill;
+        bufferSize = 0;
+    }
+
+    while (p + 32 <= end) {
+        v[0] = Round(v[0], Read64(p));
+        v[1] = Round(v[1], Read64(p + 8));
+        v[2] = Round(v[2], Read64(p + 16));
+        v[3] = Round(v[3], Read64(p + 24));
+        p += 32;
+    }
+
+    if (p < end) {
+        bufferSize = static_cast<size_t>(end - p);
+        memcpy(buffer, p, bufferSize);
+    }
+}
+
+uint64_t ContentHash::Hasher::Digest() const {
+    uint64_t h;
+
+    if (totalLength >= 32) {
+        h = RotL(v[0], 1) + RotL(v[1], 7) + RotL(v[2], 12) + RotL(v[3], 18);
+        h = MergeRound(h, v[0]);
+        h = MergeRound(h, v[1]);
+        h = MergeRound(h, v[2]);
+        h = MergeRound(h, v[3]);
+    } else {
+        h = seed + PRIME64_5;
+    }
+
+    h += totalLength;
+
+    const unsigned char* p = buffer;
+    const unsigned char* end = buffer + bufferSize;
+
+    while (p + 8 <= end) {
+        h ^= Round(0, Read64(p));
+        h = RotL(h, 27) * PRIME64_1 + PRIME64_4;
+        p += 8;
+    }
+
+    if (p + 4 <= end) {
+        h ^= static_cast<uint64_t>(Read32(p)) * PRIME64_1;
+        h = RotL(h, 23) * PRIME64_2 + PRIME64_3;
+        p += 4;
+    }
+
+    while (p < end) {
+        h ^= (*p) * PRIME64_5;
+        h = RotL(h, 11) * PRIME64_1;
+        p++;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME64_2;
+    h ^= h >> 29;
+    h *= PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+uint64_t ContentHash::Compute(const void* data, size_t length, uint64_t seed) {
+    Hasher hasher(seed);
+    hasher.Update(data, length);
+    return hasher.Digest();
+}
+
+bool ContentHash::HashFile(const std::wstring& path, uint64_t& hash) {
+    std::ifstream file(std::filesystem::path(path), std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    Hasher hasher;
+    std::vector<char> chunk(64 * 1024);
+    while (file) {
+        file.read(chunk.data(), chunk.size());
+        std::streamsize got = file.gcount();
+        if (got > 0) {
+            hasher.Update(chunk.data(), static_cast<size_t>(got));
+        }
+    }
+
+    if (file.bad()) {
+        return false;
+    }
+
+    hash = hasher.Digest();
+    return true;
+}
+
+std::wstring ContentHash::ToHex(uint64_t hash) {
+    static const wchar_t digits[] = L"0123456789abcdef";
+    std::wstring result(16, L'0');
+    for (int i = 15; i >= 0; i--) {
+        result[i] = digits[hash & 0xF];
+        hash >>= 4;
+    }
+    return result;
+}
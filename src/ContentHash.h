@@ -0,0 +1,33 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// Hash veloce del contenuto (XXH64) per riconoscere lo stesso PDF anche se
+// copiato con un altro nome. Implementazione compatibile con xxHash 64 bit.
+class ContentHash {
+public:
+    // Stato incrementale: Update() puo' essere chiamato piu' volte
+    class Hasher {
+    public:
+        explicit Hasher(uint64_t seed = 0);
+        void Update(const void* data, size_t length);
+        uint64_t Digest() const;
+
+    private:
+        uint64_t v[4];
+        uint64_t totalLength;
+        unsigned char buffer[32];
+        size_t bufferSize;
+        uint64_t seed;
+    };
+
+    // Hash di un blocco di memoria
+    static uint64_t Compute(const void* data, size_t length, uint64_t seed = 0);
+
+    // Hash dell'intero contenuto di un file. Restituisce false se il file non e' leggibile
+    static bool HashFile(const std::wstring& path, uint64_t& hash);
+
+    // Rappresentazione esadecimale (16 caratteri)
+    static std::wstring ToHex(uint64_t hash);
+};
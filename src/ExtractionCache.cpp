@@ -0,0 +1,363 @@
+#include "ExtractionCache.h"
+#include "ContentHash.h"
+#include "Subprocess.h"
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+
+std::wstring ExtractionCache::path;
+size_t ExtractionCache::capacity = 0;
+MappedFile ExtractionCache::file;
+uint64_t ExtractionCache::end = 0;
+std::unordered_map<ExtractionCache::Key, ExtractionCache::Slot, ExtractionCache::KeyHasher> ExtractionCache::index;
+std::list<ExtractionCache::Key> ExtractionCache::lru;
+std::mutex ExtractionCache::mutex;
+thread_local std::wstring ExtractionCache::lastError;
+
+namespace {
+
+// Formato su disco: intestazione (magic + fine dei record validi) seguita da
+// record allineati a 8 byte:
+//   u32 lunghezza, u32 backend, u64 hash contenuto, u64 versione profili,
+//   u64 checksum dei campi, u32 lunghezze dei 5 campi, campi UTF-8
+const char CACHE_MAGIC[8] = { 'M', 'R', 'M', 'C', 'A', 'C', 'H', '1' };
+const size_t HEADER_SIZE = 16;
+const size_t FIELD_COUNT = 5;
+const size_t RECORD_HEADER_SIZE = 32 + 4 * FIELD_COUNT;
+
+// Dimensione minima del file: sotto questa soglia la cache non serve
+const size_t MIN_CAPACITY = 1024 * 1024;
+
+void Put32(char* out, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        out[i] = static_cast<char>(value >> (i * 8));
+    }
+}
+
+void Put64(char* out, uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        out[i] = static_cast<char>(value >> (i * 8));
+    }
+}
+
+uint32_t Get32(const char* in) {
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; i--) {
+        value = (value << 8) | static_cast<unsigned char>(in[i]);
+    }
+    return value;
+}
+
+uint64_t Get64(const char* in) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; i--) {
+        value = (value << 8) | static_cast<unsigned char>(in[i]);
+    }
+    return value;
+}
+
+std::string ToUtf8(const std::wstring& text) {
+    std::string result;
+    result.reserve(text.size());
+    for (size_t i = 0; i < text.size(); i++) {
+        char32_t c = static_cast<char32_t>(text[i]);
+        // wchar_t a 16 bit: ricompone le coppie surrogate
+        if (sizeof(wchar_t) == 2 && c >= 0xD800 && c <= 0xDBFF && i + 1 < text.size()) {
+            c = 0x10000 + ((c - 0xD800) << 10) + (static_cast<char32_t>(text[++i]) - 0xDC00);
+        }
+        if (c < 0x80) {
+            result += static_cast<char>(c);
+        } else if (c < 0x800) {
+            result += static_cast<char>(0xC0 | (c >> 6));
+            result += static_cast<char>(0x80 | (c & 0x3F));
+        } else if (c < 0x10000) {
+            result += static_cast<char>(0xE0 | (c >> 12));
+            result += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            result += static_cast<char>(0x80 | (c & 0x3F));
+        } else {
+            result += static_cast<char>(0xF0 | (c >> 18));
+            result += static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+            result += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            result += static_cast<char>(0x80 | (c & 0x3F));
+        }
+    }
+    return result;
+}
+
+std::wstring FromUtf8(const char* data, size_t length) {
+    std::wstring result;
+    result.reserve(length);
+    Subprocess::Utf8Decoder decoder;
+    decoder.Feed(data, length, result);
+    decoder.Finish(result);
+    return result;
+}
+
+}
+
+bool ExtractionCache::Open(const std::wstring& cachePath, size_t maxBytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    lastError.clear();
+
+    file.Close();
+    index.clear();
+    lru.clear();
+    path = cachePath;
+    capacity = std::max(maxBytes, MIN_CAPACITY);
+
+    // Un file piu' grande del limite (limite ridotto in config.ini) viene
+    // letto per intero e poi compattato
+    std::error_code ec;
+    uintmax_t existing = std::filesystem::file_size(std::filesystem::path(path), ec);
+    size_t mapSize = ec ? capacity : std::max(capacity, static_cast<size_t>(existing));
+
+    if (!file.Open(path, mapSize)) {
+        lastError = file.GetLastError();
+        return false;
+    }
+
+    if (memcmp(file.Data(), CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0) {
+        memset(file.Data(), 0, HEADER_SIZE);
+        memcpy(file.Data(), CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        end = HEADER_SIZE;
+        Put64(file.Data() + 8, end);
+    } else {
+        end = LoadIndexLocked();
+    }
+
+    if (mapSize > capacity) {
+        return CompactLocked(capacity - HEADER_SIZE);
+    }
+    return true;
+}
+
+void ExtractionCache::Close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    file.Flush();
+    file.Close();
+    index.clear();
+    lru.clear();
+}
+
+bool ExtractionCache::IsOpen() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return file.IsOpen();
+}
+
+uint64_t ExtractionCache::LoadIndexLocked() {
+    index.clear();
+    lru.clear();
+
+    const char* data = file.Data();
+    uint64_t storedEnd = std::min<uint64_t>(Get64(data + 8), file.Size());
+    uint64_t offset = HEADER_SIZE;
+
+    while (offset + RECORD_HEADER_SIZE <= storedEnd) {
+        const char* record = data + offset;
+        uint32_t length = Get32(record);
+        if (length < RECORD_HEADER_SIZE || length % 8 != 0 || offset + length > storedEnd) {
+            break;
+        }
+
+        uint64_t fieldsLength = 0;
+        for (size_t i = 0; i < FIELD_COUNT; i++) {
+            fieldsLength += Get32(record + 32 + 4 * i);
+        }
+        if (RECORD_HEADER_SIZE + fieldsLength > length ||
+            ContentHash::Compute(record + 32, 4 * FIELD_COUNT + fieldsLength) != Get64(record + 24)) {
+            break;
+        }
+
+        // Una voce riscritta (es. arricchimento AI aggiunto) sostituisce la precedente
+        Key key = { Get64(record + 8), Get64(record + 16), Get32(record + 4) };
+        auto it = index.find(key);
+        if (it != index.end()) {
+            lru.erase(it->second.position);
+            index.erase(it);
+        }
+        lru.push_back(key);
+        index[key] = { offset, length, std::prev(lru.end()) };
+
+        offset += length;
+    }
+
+    Put64(file.Data() + 8, offset);
+    return offset;
+}
+
+bool ExtractionCache::CompactLocked(size_t budget) {
+    // Voci piu' recenti che stanno nel budget, riscritte dalla meno recente
+    std::vector<const Slot*> kept;
+    size_t total = 0;
+    for (auto it = lru.rbegin(); it != lru.rend(); ++it) {
+        const Slot& slot = index[*it];
+        if (total + slot.length > budget) {
+            break;
+        }
+        total += slot.length;
+        kept.push_back(&slot);
+    }
+
+    std::string content(HEADER_SIZE, '\0');
+    content.reserve(HEADER_SIZE + total);
+    memcpy(&content[0], CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    Put64(&content[8], HEADER_SIZE + total);
+    for (auto it = kept.rbegin(); it != kept.rend(); ++it) {
+        content.append(file.Data() + (*it)->offset, (*it)->length);
+    }
+
+    // Sostituzione atomica: file temporaneo e rinomina, con la mappa chiusa
+    file.Close();
+    index.clear();
+    lru.clear();
+
+    std::filesystem::path target(path);
+    std::filesystem::path tempPath = target;
+    tempPath += L".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        out.write(content.data(), content.size());
+        if (!out) {
+            lastError = L"Errore di scrittura della cache: " + tempPath.wstring();
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, target, ec);
+    if (ec) {
+        lastError = L"Impossibile sostituire la cache: " + path;
+        return false;
+    }
+
+    if (!file.Open(path, capacity)) {
+        lastError = file.GetLastError();
+        return false;
+    }
+    end = LoadIndexLocked();
+    return true;
+}
+
+void ExtractionCache::TouchLocked(Slot& slot) {
+    lru.splice(lru.end(), lru, slot.position);
+}
+
+bool ExtractionCache::Lookup(const Key& key, Entry& entry) {
+    std::lock_guard<std::mutex> lock(mutex);
+    lastError.clear();
+
+    auto it = index.find(key);
+    if (it == index.end() || !file.IsOpen()) {
+        return false;
+    }
+
+    const char* record = file.Data() + it->second.offset;
+    const char* field = record + RECORD_HEADER_SIZE;
+    std::wstring* targets[FIELD_COUNT] = {
+        &entry.rawText, &entry.report.patientName, &entry.report.reportBody,
+        &entry.report.profileUsed, &entry.enrichment
+    };
+    for (size_t i = 0; i < FIELD_COUNT; i++) {
+        uint32_t length = Get32(record + 32 + 4 * i);
+        *targets[i] = FromUtf8(field, length);
+        field += length;
+    }
+    entry.report.success = true;
+    entry.report.errorMessage.clear();
+
+    TouchLocked(it->second);
+    return true;
+}
+
+bool ExtractionCache::Store(const Key& key, const Entry& entry) {
+    std::string fields[FIELD_COUNT] = {
+        ToUtf8(entry.rawText), ToUtf8(entry.report.patientName), ToUtf8(entry.report.reportBody),
+        ToUtf8(entry.report.profileUsed), ToUtf8(entry.enrichment)
+    };
+
+    // Record composto fuori dal lock
+    size_t length = RECORD_HEADER_SIZE;
+    for (const auto& field : fields) {
+        length += field.size();
+    }
+    length = (length + 7) & ~static_cast<size_t>(7);
+
+    std::string record(length, '\0');
+    Put32(&record[0], static_cast<uint32_t>(length));
+    Put32(&record[4], key.backend);
+    Put64(&record[8], key.contentHash);
+    Put64(&record[16], key.profileVersion);
+    size_t offset = RECORD_HEADER_SIZE;
+    for (size_t i = 0; i < FIELD_COUNT; i++) {
+        Put32(&record[32 + 4 * i], static_cast<uint32_t>(fields[i].size()));
+        memcpy(&record[offset], fields[i].data(), fields[i].size());
+        offset += fields[i].size();
+    }
+    Put64(&record[24], ContentHash::Compute(&record[32], offset - 32));
+
+    std::lock_guard<std::mutex> lock(mutex);
+    lastError.clear();
+
+    if (!file.IsOpen()) {
+        lastError = L"Cache non aperta";
+        return false;
+    }
+    if (length > capacity / 4) {
+        lastError = L"Voce troppo grande per la cache";
+        return false;
+    }
+
+    // Spazio esaurito: compatta lasciando un quarto del file libero
+    if (end + length > file.Size()) {
+        auto existing = index.find(key);
+        if (existing != index.end()) {
+            lru.erase(existing->second.position);
+            index.erase(existing);
+        }
+        if (!CompactLocked(capacity * 3 / 4 - HEADER_SIZE)) {
+            return false;
+        }
+    }
+
+    memcpy(file.Data() + end, record.data(), length);
+
+    auto it = index.find(key);
+    if (it != index.end()) {
+        lru.erase(it->second.position);
+        index.erase(it);
+    }
+    lru.push_back(key);
+    index[key] = { end, static_cast<uint32_t>(length), std::prev(lru.end()) };
+
+    // La fine dei dati si aggiorna solo a record completo
+    end += length;
+    Put64(file.Data() + 8, end);
+    return true;
+}
+
+size_t ExtractionCache::GetCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return index.size();
+}
+
+uint64_t ExtractionCache::ComputeProfileVersion(const std::vector<std::wstring>& profileFiles, uint64_t extra) {
+    ContentHash::Hasher hasher;
+    uint32_t parserVersion = PARSER_VERSION;
+    hasher.Update(&parserVersion, sizeof(parserVersion));
+    hasher.Update(&extra, sizeof(extra));
+
+    std::vector<std::wstring> sorted = profileFiles;
+    std::sort(sorted.begin(), sorted.end());
+    for (const auto& profileFile : sorted) {
+        uint64_t hash = 0;
+        if (ContentHash::HashFile(profileFile, hash)) {
+            hasher.Update(&hash, sizeof(hash));
+        }
+    }
+    return hasher.Digest();
+}
+
+std::wstring ExtractionCache::GetLastError() {
+    return lastError;
+}
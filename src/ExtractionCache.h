@@ -0,0 +1,104 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+#include "MappedFile.h"
+#include "TextParser.h"
+
+// Cache su disco dei risultati di estrazione, indicizzata per contenuto:
+// lo stesso PDF rispedito (ristampa, riesportazione) non ripassa da
+// pdftotext, Python e parser. La chiave unisce hash del contenuto, backend
+// di estrazione e versione dei profili, cosi' un cambio di configurazione
+// o di profilo invalida da solo le voci vecchie.
+// Il file (extraction.cache) ha dimensione fissa ed e' mappato in memoria:
+// i record vengono aggiunti in coda e l'indice in memoria punta ai record
+// validi. Quando lo spazio finisce il file viene compattato tenendo le voci
+// usate piu' di recente (LRU); la compattazione riscrive i record in ordine
+// di utilizzo, per cui l'ordine LRU sopravvive anche ai riavvii.
+class ExtractionCache {
+public:
+    // Backend che ha prodotto il testo (combinabili)
+    static const uint32_t BACKEND_NATIVE = 1;       // Motore PDF interno (altrimenti pdftotext)
+    static const uint32_t BACKEND_PYTHON = 2;       // Zone estratte con PyMuPDF
+    static const uint32_t BACKEND_OCR = 4;          // OCR disponibile; da solo: testo di una pagina
+                                                    // (chiave: impronta della pagina)
+
+    // Da incrementare quando cambiano parser o profili interni (ReportProfile):
+    // entra nella versione dei profili e invalida le voci esistenti
+    static const uint32_t PARSER_VERSION = 1;
+
+    struct Key {
+        uint64_t contentHash;       // XXH64 del PDF
+        uint64_t profileVersion;    // Versione di profili e parser
+        uint32_t backend;           // Combinazione di BACKEND_*
+
+        bool operator==(const Key& other) const {
+            return contentHash == other.contentHash && profileVersion == other.profileVersion &&
+                   backend == other.backend;
+        }
+    };
+
+    struct Entry {
+        std::wstring rawText;       // Testo estratto dal PDF
+        ParsedReport report;        // Referto analizzato (prima dell'analisi AI)
+        std::wstring enrichment;    // Testo arricchito da Claude (vuoto se assente)
+    };
+
+    // Apre (o crea) la cache con la dimensione massima indicata e carica l'indice
+    static bool Open(const std::wstring& cachePath, size_t maxBytes);
+
+    // Chiude il file della cache
+    static void Close();
+
+    static bool IsOpen();
+
+    // Cerca una voce; in caso di successo la marca come usata di recente
+    static bool Lookup(const Key& key, Entry& entry);
+
+    // Registra (o sostituisce) la voce per la chiave
+    static bool Store(const Key& key, const Entry& entry);
+
+    // Numero di voci valide
+    static size_t GetCount();
+
+    // Versione dei profili: hash dei file dei profili, di PARSER_VERSION e
+    // di extra (impostazioni e altri dati che cambiano il testo prodotto)
+    static uint64_t ComputeProfileVersion(const std::vector<std::wstring>& profileFiles, uint64_t extra);
+
+    // Restituisce l'ultimo errore
+    static std::wstring GetLastError();
+
+private:
+    struct KeyHasher {
+        size_t operator()(const Key& key) const {
+            return static_cast<size_t>(key.contentHash ^ (key.profileVersion * 31) ^ key.backend);
+        }
+    };
+
+    struct Slot {
+        uint64_t offset;                    // Posizione del record nel file
+        uint32_t length;                    // Lunghezza del record
+        std::list<Key>::iterator position;  // Posizione nella lista LRU
+    };
+
+    // Scansiona i record dal file mappato. Si ferma al primo record non
+    // valido (scrittura interrotta) e restituisce la fine dei dati validi
+    static uint64_t LoadIndexLocked();
+
+    // Riscrive il file con le voci piu' recenti che stanno in budget byte
+    static bool CompactLocked(size_t budget);
+
+    static void TouchLocked(Slot& slot);
+
+    static std::wstring path;
+    static size_t capacity;
+    static MappedFile file;
+    static uint64_t end;                                    // Fine dei record validi
+    static std::unordered_map<Key, Slot, KeyHasher> index;
+    static std::list<Key> lru;                              // Dalla meno alla piu' recente
+    static std::mutex mutex;
+    static thread_local std::wstring lastError;
+};
@@ -1,16 +1,18 @@
 #include "FileWatcher.h"
 #include <algorithm>
 #include <filesystem>
-#include <map>
-#include <chrono>
 #include <mutex>
+#include <cwctype>
+#include <vector>
 
-// Mappa per tenere traccia dei file già processati (path -> timestamp)
-static std::map<std::wstring, std::chrono::steady_clock::time_point> processedFiles;
-static std::mutex processedFilesMutex;
-static const int DEDUP_SECONDS = 300; // Ignora stesso file per 5 minuti
-
-FileWatcher::FileWatcher() : running(false), stopEvent(NULL) {
+FileWatcher::FileWatcher() : running(false),
+    eventCount(0), overflowCount(0), rescanCount(0), recoveredCount(0), bufferSize(0),
+#ifdef _WIN32
+    stopEvent(NULL)
+#else
+    stopFd(-1)
+#endif
+{
 }
 
 FileWatcher::~FileWatcher() {
@@ -21,49 +23,56 @@ void FileWatcher::SetCallback(Callback cb) {
     callback = cb;
 }
 
+void FileWatcher::SetQuietPeriod(std::chrono::milliseconds quiet) {
+    settle.SetQuietPeriod(quiet);
+}
+
 bool FileWatcher::Start(const std::wstring& directory) {
     if (running) {
         return true;
     }
-    
+
     if (!std::filesystem::exists(directory) || !std::filesystem::is_directory(directory)) {
         lastError = L"Directory non valida: " + directory;
         return false;
     }
-    
+
     watchDirectory = directory;
-    stopEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
-    
-    if (!stopEvent) {
+
+    if (!OpenStopSignal()) {
         lastError = L"Impossibile creare l'evento di stop";
         return false;
     }
-    
+
+    // Fotografia iniziale: i PDF gia' presenti non vanno considerati persi
+    {
+        std::lock_guard<std::mutex> lock(snapshotMutex);
+        snapshot = ListPdfFiles();
+    }
+
+    settle.SetCallback([this](const std::wstring& path) { DispatchFile(path); });
+    settle.Start();
+
     running = true;
     watcherThread = std::thread(&FileWatcher::WatchThread, this);
-    
+
     return true;
 }
 
 void FileWatcher::Stop() {
-    if (!running) {
+    if (!running && !watcherThread.joinable()) {
         return;
     }
-    
+
     running = false;
-    
-    if (stopEvent) {
-        SetEvent(stopEvent);
-    }
-    
+    SignalStop();
+
     if (watcherThread.joinable()) {
         watcherThread.join();
     }
-    
-    if (stopEvent) {
-        CloseHandle(stopEvent);
-        stopEvent = NULL;
-    }
+
+    CloseStopSignal();
+    settle.Stop();
 }
 
 bool FileWatcher::IsRunning() const {
@@ -74,157 +83,109 @@ std::wstring FileWatcher::GetLastError() const {
     return lastError;
 }
 
-void FileWatcher::WatchThread() {
-    HANDLE hDir = CreateFileW(
-        watchDirectory.c_str(),
-        FILE_LIST_DIRECTORY,
-        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
-        NULL,
-        OPEN_EXISTING,
-        FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
-        NULL
-    );
-    
-    if (hDir == INVALID_HANDLE_VALUE) {
-        lastError = L"Impossibile aprire la directory per il monitoraggio";
-        running = false;
-        return;
-    }
-    
-    OVERLAPPED overlapped = { 0 };
-    overlapped.hEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
-    
-    if (!overlapped.hEvent) {
-        CloseHandle(hDir);
-        lastError = L"Impossibile creare l'evento overlapped";
-        running = false;
-        return;
+FileWatcher::Stats FileWatcher::GetStats() const {
+    return { eventCount.load(), overflowCount.load(), rescanCount.load(),
+             recoveredCount.load(), bufferSize.load() };
+}
+
+std::wstring FileWatcher::MakeFullPath(const std::wstring& fileName) const {
+#ifdef _WIN32
+    const wchar_t separator = L'\\';
+#else
+    const wchar_t separator = L'/';
+#endif
+    if (!watchDirectory.empty() &&
+        (watchDirectory.back() == L'\\' || watchDirectory.back() == L'/')) {
+        return watchDirectory + fileName;
     }
-    
-    const DWORD bufferSize = 4096;
-    std::vector<BYTE> buffer(bufferSize);
-    
-    while (running) {
-        ResetEvent(overlapped.hEvent);
-        
-        BOOL success = ReadDirectoryChangesW(
-            hDir,
-            buffer.data(),
-            bufferSize,
-            FALSE, // Non monitorare sottodirectory
-            FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE,
-            NULL,
-            &overlapped,
-            NULL
-        );
-        
-        if (!success) {
-            break;
-        }
-        
-        // Attendi evento o stop
-        HANDLE handles[] = { overlapped.hEvent, stopEvent };
-        DWORD waitResult = WaitForMultipleObjects(2, handles, FALSE, INFINITE);
-        
-        if (waitResult == WAIT_OBJECT_0 + 1) {
-            // Stop richiesto
-            CancelIo(hDir);
-            break;
-        }
-        
-        if (waitResult != WAIT_OBJECT_0) {
-            continue;
-        }
-        
-        DWORD bytesReturned;
-        if (!GetOverlappedResult(hDir, &overlapped, &bytesReturned, FALSE)) {
+    return watchDirectory + separator + fileName;
+}
+
+FileWatcher::Snapshot FileWatcher::ListPdfFiles() const {
+    Snapshot result;
+    std::error_code ec;
+
+    for (std::filesystem::directory_iterator it(watchDirectory, ec), end; !ec && it != end; it.increment(ec)) {
+        std::wstring fileName = it->path().filename().wstring();
+        if (!IsPdfFile(fileName) || !it->is_regular_file(ec)) {
             continue;
         }
-        
-        // Processa i risultati
-        FILE_NOTIFY_INFORMATION* pNotify = reinterpret_cast<FILE_NOTIFY_INFORMATION*>(buffer.data());
-        
-        do {
-            if (pNotify->Action == FILE_ACTION_ADDED || 
-                pNotify->Action == FILE_ACTION_MODIFIED) {
-                
-                std::wstring fileName(pNotify->FileName, pNotify->FileNameLength / sizeof(wchar_t));
-                
-                // Verifica se è un file PDF
-                std::wstring ext = fileName.substr(fileName.find_last_of(L'.') + 1);
-                std::transform(ext.begin(), ext.end(), ext.begin(), ::towlower);
-                
-                if (ext == L"pdf") {
-                    std::wstring fullPath = watchDirectory + L"\\" + fileName;
-                    auto now = std::chrono::steady_clock::now();
-                    bool skipFile = false;
-                    
-                    // Lock per thread safety
-                    {
-                        std::lock_guard<std::mutex> lock(processedFilesMutex);
-                        
-                        // Controlla se il file è stato processato di recente
-                        auto it = processedFiles.find(fullPath);
-                        if (it != processedFiles.end()) {
-                            auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - it->second).count();
-                            if (elapsed < DEDUP_SECONDS) {
-                                skipFile = true;
-                            }
-                        }
-                        
-                        // Registra SUBITO il file come in elaborazione (PRIMA della callback)
-                        if (!skipFile) {
-                            processedFiles[fullPath] = now;
-                            
-                            // Pulisci vecchie entry (più di 10 minuti)
-                            for (auto iter = processedFiles.begin(); iter != processedFiles.end(); ) {
-                                auto age = std::chrono::duration_cast<std::chrono::seconds>(now - iter->second).count();
-                                if (age > 600) {
-                                    iter = processedFiles.erase(iter);
-                                } else {
-                                    ++iter;
-                                }
-                            }
-                        }
-                    }
-                    
-                    if (!skipFile) {
-                        // Attendi che il file sia completamente scritto
-                        Sleep(1000);
-                        
-                        // Verifica che il file sia accessibile
-                        HANDLE hFile = CreateFileW(
-                            fullPath.c_str(),
-                            GENERIC_READ,
-                            FILE_SHARE_READ,
-                            NULL,
-                            OPEN_EXISTING,
-                            FILE_ATTRIBUTE_NORMAL,
-                            NULL
-                        );
-                        
-                        if (hFile != INVALID_HANDLE_VALUE) {
-                            CloseHandle(hFile);
-                            
-                            if (callback) {
-                                callback(fullPath);
-                            }
-                        }
-                    }
-                }
-            }
-            
-            if (pNotify->NextEntryOffset == 0) {
-                break;
+
+        FileState state;
+        state.size = it->file_size(ec);
+        if (ec) continue;
+        state.mtime = it->last_write_time(ec);
+        if (ec) continue;
+
+        result.emplace(MakeFullPath(fileName), state);
+    }
+
+    return result;
+}
+
+void FileWatcher::OnFileEvent(const std::wstring& fullPath) {
+    eventCount++;
+    settle.Touch(fullPath);
+}
+
+void FileWatcher::HandleOverflow() {
+    overflowCount++;
+    Rescan();
+}
+
+size_t FileWatcher::Rescan() {
+    rescanCount++;
+    Snapshot current = ListPdfFiles();
+
+    std::vector<std::wstring> missed;
+    {
+        std::lock_guard<std::mutex> lock(snapshotMutex);
+        for (const auto& entry : current) {
+            auto it = snapshot.find(entry.first);
+            if (it == snapshot.end() ||
+                it->second.size != entry.second.size ||
+                it->second.mtime != entry.second.mtime) {
+                missed.push_back(entry.first);
             }
-            
-            pNotify = reinterpret_cast<FILE_NOTIFY_INFORMATION*>(
-                reinterpret_cast<BYTE*>(pNotify) + pNotify->NextEntryOffset
-            );
-            
-        } while (true);
+        }
+        snapshot = std::move(current);
+    }
+
+    // Passano dallo scheduler: un file ancora in scrittura viene atteso;
+    // un PDF gia' elaborato viene scartato dai worker (ProcessedLedger)
+    for (const auto& path : missed) {
+        settle.Touch(path);
+    }
+
+    recoveredCount += missed.size();
+    return missed.size();
+}
+
+bool FileWatcher::IsPdfFile(const std::wstring& fileName) {
+    size_t dot = fileName.find_last_of(L'.');
+    if (dot == std::wstring::npos) {
+        return false;
+    }
+
+    std::wstring ext = fileName.substr(dot + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::towlower);
+    return ext == L"pdf";
+}
+
+void FileWatcher::DispatchFile(const std::wstring& fullPath) {
+    // Aggiorna la fotografia: una riscansione successiva non lo riconsegnera'
+    std::error_code ec;
+    FileState state;
+    state.size = std::filesystem::file_size(fullPath, ec);
+    if (!ec) {
+        state.mtime = std::filesystem::last_write_time(fullPath, ec);
+    }
+    if (!ec) {
+        std::lock_guard<std::mutex> lock(snapshotMutex);
+        snapshot[fullPath] = state;
+    }
+
+    if (callback) {
+        callback(fullPath);
     }
-    
-    CloseHandle(overlapped.hEvent);
-    CloseHandle(hDir);
 }
@@ -3,37 +3,121 @@
 #include <functional>
 #include <thread>
 #include <atomic>
+#include <chrono>
+#include <mutex>
+#include <unordered_map>
+#include <filesystem>
+#include <cstdint>
+#include "StabilityScheduler.h"
+#ifdef _WIN32
 #include <Windows.h>
+#endif
 
+// Monitoraggio di una directory per nuovi PDF.
+// Il backend dipende dalla piattaforma:
+//   - Windows: ReadDirectoryChangesW (FileWatcherWin32.cpp)
+//   - Linux:   inotify con IN_CLOSE_WRITE/IN_MOVED_TO (FileWatcherInotify.cpp)
+// Il contratto SetCallback/Start/Stop e' identico su entrambi.
+// Se il sistema perde notifiche (overflow del buffer) la directory viene
+// riscansionata e confrontata con l'ultimo stato noto: i PDF mancanti vengono
+// recuperati e accodati una sola volta.
+// La deduplicazione per contenuto (ProcessedLedger) e' compito di chi
+// elabora i file: il thread di notifica non legge il contenuto dei PDF.
 class FileWatcher {
 public:
     using Callback = std::function<void(const std::wstring&)>;
-    
+
+    // Contatori esposti per diagnostica
+    struct Stats {
+        uint64_t events;        // Notifiche PDF ricevute
+        uint64_t overflows;     // Overflow del buffer di notifica
+        uint64_t rescans;       // Riscansioni della directory
+        uint64_t recovered;     // PDF recuperati dalle riscansioni
+        uint32_t bufferSize;    // Dimensione attuale del buffer di notifica (byte)
+    };
+
     FileWatcher();
     ~FileWatcher();
-    
+
     // Imposta la callback da chiamare quando viene rilevato un nuovo PDF
     void SetCallback(Callback callback);
-    
+
+    // Periodo di quiete dopo il quale un file in scrittura e' considerato completo
+    // (usato dal backend Windows, dove non esiste una notifica di chiusura)
+    void SetQuietPeriod(std::chrono::milliseconds quiet);
+
     // Avvia il monitoraggio della directory specificata
     bool Start(const std::wstring& directory);
-    
+
     // Ferma il monitoraggio
     void Stop();
-    
+
     // Verifica se il watcher è attivo
     bool IsRunning() const;
-    
+
     // Restituisce l'ultimo errore
     std::wstring GetLastError() const;
-    
+
+    // Restituisce i contatori di notifiche, overflow e riscansioni
+    Stats GetStats() const;
+
 private:
+    // Stato di un file nell'ultima fotografia della directory
+    struct FileState {
+        std::uintmax_t size;
+        std::filesystem::file_time_type mtime;
+    };
+    using Snapshot = std::unordered_map<std::wstring, FileState>;
+
+    // Loop di notifica, implementato dal backend di piattaforma
     void WatchThread();
-    
+
+    // Primitive di stop, implementate dal backend di piattaforma
+    bool OpenStopSignal();
+    void SignalStop();
+    void CloseStopSignal();
+
+    // Inoltra un file completo alla callback
+    void DispatchFile(const std::wstring& fullPath);
+
+    // Segnala un PDF nuovo o modificato allo scheduler di stabilita'
+    void OnFileEvent(const std::wstring& fullPath);
+
+    // Gestisce la perdita di notifiche: conta l'overflow e riscansiona
+    void HandleOverflow();
+
+    // Confronta la directory con l'ultima fotografia e accoda i PDF mancanti
+    // Restituisce il numero di file recuperati
+    size_t Rescan();
+
+    // Elenca i PDF presenti nella directory monitorata
+    Snapshot ListPdfFiles() const;
+
+    // Compone il path completo nello stesso formato per notifiche e riscansioni
+    std::wstring MakeFullPath(const std::wstring& fileName) const;
+
+    // Verifica se il nome file ha estensione .pdf (case-insensitive)
+    static bool IsPdfFile(const std::wstring& fileName);
+
     std::wstring watchDirectory;
     std::wstring lastError;
     Callback callback;
     std::thread watcherThread;
     std::atomic<bool> running;
+    StabilityScheduler settle;
+
+    // Ultimo stato noto della directory (aggiornato da riscansioni e consegne)
+    Snapshot snapshot;
+    std::mutex snapshotMutex;
+
+    std::atomic<uint64_t> eventCount;
+    std::atomic<uint64_t> overflowCount;
+    std::atomic<uint64_t> rescanCount;
+    std::atomic<uint64_t> recoveredCount;
+    std::atomic<uint32_t> bufferSize;
+#ifdef _WIN32
     HANDLE stopEvent;
+#else
+    int stopFd;     // eventfd usato per svegliare poll() allo stop
+#endif
 };
@@ -0,0 +1,127 @@
+// Backend Linux del FileWatcher basato su inotify.
+// IN_CLOSE_WRITE segnala che lo scrittore ha chiuso il file, IN_MOVED_TO che il
+// file e' stato rinominato nella directory: in entrambi i casi il PDF e' completo
+// e viene consegnato subito, senza attese o tentativi di apertura.
+#include "FileWatcher.h"
+#include <filesystem>
+#include <vector>
+#include <cerrno>
+#include <cstdint>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+
+bool FileWatcher::OpenStopSignal() {
+    stopFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    return stopFd >= 0;
+}
+
+void FileWatcher::SignalStop() {
+    if (stopFd >= 0) {
+        uint64_t one = 1;
+        ssize_t written = write(stopFd, &one, sizeof(one));
+        (void)written;
+    }
+}
+
+void FileWatcher::CloseStopSignal() {
+    if (stopFd >= 0) {
+        close(stopFd);
+        stopFd = -1;
+    }
+}
+
+void FileWatcher::WatchThread() {
+    int inotifyFd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if (inotifyFd < 0) {
+        lastError = L"Impossibile inizializzare inotify";
+        running = false;
+        return;
+    }
+
+    std::string dirPath = std::filesystem::path(watchDirectory).string();
+    int watchFd = inotify_add_watch(inotifyFd, dirPath.c_str(),
+                                    IN_CLOSE_WRITE | IN_MOVED_TO | IN_ONLYDIR);
+    if (watchFd < 0) {
+        close(inotifyFd);
+        lastError = L"Impossibile aprire la directory per il monitoraggio";
+        running = false;
+        return;
+    }
+
+    // Allineato come richiesto da struct inotify_event. La coda degli eventi e'
+    // gestita dal kernel (fs.inotify.max_queued_events): qui basta un buffer fisso
+    alignas(struct inotify_event) char buffer[64 * 1024];
+    bufferSize = sizeof(buffer);
+
+    while (running) {
+        struct pollfd fds[2] = {
+            { inotifyFd, POLLIN, 0 },
+            { stopFd, POLLIN, 0 }
+        };
+
+        int ready = poll(fds, 2, -1);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            lastError = L"Errore in poll() sul descrittore inotify";
+            break;
+        }
+
+        if (fds[1].revents & POLLIN) {
+            // Stop richiesto
+            break;
+        }
+
+        if (!(fds[0].revents & POLLIN)) {
+            continue;
+        }
+
+        ssize_t len = read(inotifyFd, buffer, sizeof(buffer));
+        if (len <= 0) {
+            continue;
+        }
+
+        bool watchRemoved = false;
+        for (char* ptr = buffer; ptr < buffer + len; ) {
+            const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(ptr);
+            ptr += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                // Il kernel ha scartato eventi: riallinea lo stato dalla directory
+                HandleOverflow();
+                continue;
+            }
+
+            if (event->mask & IN_IGNORED) {
+                // La directory e' stata rimossa o smontata
+                watchRemoved = true;
+                continue;
+            }
+
+            if (event->len == 0 || (event->mask & IN_ISDIR)) {
+                continue;
+            }
+
+            std::wstring fileName = std::filesystem::u8path(event->name).wstring();
+            if (!IsPdfFile(fileName)) {
+                continue;
+            }
+
+            // Il file e' gia' completo: nessuna attesa di stabilita'
+            eventCount++;
+            DispatchFile(MakeFullPath(fileName));
+        }
+
+        if (watchRemoved) {
+            lastError = L"Directory monitorata non piu' disponibile";
+            break;
+        }
+    }
+
+    inotify_rm_watch(inotifyFd, watchFd);
+    close(inotifyFd);
+    running = false;
+}
@@ -0,0 +1,147 @@
+// Backend Windows del FileWatcher basato su ReadDirectoryChangesW
+#include "FileWatcher.h"
+#include <vector>
+#include <algorithm>
+
+// Buffer di notifica: parte da 64 KB (limite massimo per le share di rete)
+// e raddoppia a ogni overflow fino a 1 MB sui volumi locali
+static const DWORD INITIAL_BUFFER_SIZE = 64 * 1024;
+static const DWORD MAX_BUFFER_SIZE = 1024 * 1024;
+
+bool FileWatcher::OpenStopSignal() {
+    stopEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+    return stopEvent != NULL;
+}
+
+void FileWatcher::SignalStop() {
+    if (stopEvent) {
+        SetEvent(stopEvent);
+    }
+}
+
+void FileWatcher::CloseStopSignal() {
+    if (stopEvent) {
+        CloseHandle(stopEvent);
+        stopEvent = NULL;
+    }
+}
+
+void FileWatcher::WatchThread() {
+    HANDLE hDir = CreateFileW(
+        watchDirectory.c_str(),
+        FILE_LIST_DIRECTORY,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        NULL,
+        OPEN_EXISTING,
+        FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
+        NULL
+    );
+
+    if (hDir == INVALID_HANDLE_VALUE) {
+        lastError = L"Impossibile aprire la directory per il monitoraggio";
+        running = false;
+        return;
+    }
+
+    OVERLAPPED overlapped = { 0 };
+    overlapped.hEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+
+    if (!overlapped.hEvent) {
+        CloseHandle(hDir);
+        lastError = L"Impossibile creare l'evento overlapped";
+        running = false;
+        return;
+    }
+
+    DWORD currentSize = INITIAL_BUFFER_SIZE;
+    std::vector<BYTE> buffer(currentSize);
+    bufferSize = currentSize;
+
+    while (running) {
+        ResetEvent(overlapped.hEvent);
+
+        BOOL success = ReadDirectoryChangesW(
+            hDir,
+            buffer.data(),
+            currentSize,
+            FALSE, // Non monitorare sottodirectory
+            FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE,
+            NULL,
+            &overlapped,
+            NULL
+        );
+
+        if (!success) {
+            // Le share di rete rifiutano buffer oltre 64 KB: torna al limite
+            if (::GetLastError() == ERROR_INVALID_PARAMETER && currentSize > INITIAL_BUFFER_SIZE) {
+                currentSize = INITIAL_BUFFER_SIZE;
+                buffer.resize(currentSize);
+                bufferSize = currentSize;
+                continue;
+            }
+            break;
+        }
+
+        // Attendi evento o stop
+        HANDLE handles[] = { overlapped.hEvent, stopEvent };
+        DWORD waitResult = WaitForMultipleObjects(2, handles, FALSE, INFINITE);
+
+        if (waitResult == WAIT_OBJECT_0 + 1) {
+            // Stop richiesto
+            CancelIo(hDir);
+            break;
+        }
+
+        if (waitResult != WAIT_OBJECT_0) {
+            continue;
+        }
+
+        DWORD bytesReturned = 0;
+        BOOL completed = GetOverlappedResult(hDir, &overlapped, &bytesReturned, FALSE);
+        if (!completed && ::GetLastError() != ERROR_NOTIFY_ENUM_DIR) {
+            continue;
+        }
+
+        if (!completed || bytesReturned == 0) {
+            // Overflow: il sistema ha scartato le notifiche. Allarga il buffer
+            // e ricostruisci lo stato dalla directory
+            if (currentSize < MAX_BUFFER_SIZE) {
+                currentSize = std::min(currentSize * 2, MAX_BUFFER_SIZE);
+                buffer.resize(currentSize);
+                bufferSize = currentSize;
+            }
+            HandleOverflow();
+            continue;
+        }
+
+        // Processa i risultati
+        FILE_NOTIFY_INFORMATION* pNotify = reinterpret_cast<FILE_NOTIFY_INFORMATION*>(buffer.data());
+
+        do {
+            if (pNotify->Action == FILE_ACTION_ADDED ||
+                pNotify->Action == FILE_ACTION_MODIFIED ||
+                pNotify->Action == FILE_ACTION_RENAMED_NEW_NAME) {
+
+                std::wstring fileName(pNotify->FileName, pNotify->FileNameLength / sizeof(wchar_t));
+
+                if (IsPdfFile(fileName)) {
+                    // Il file diventa pronto quando size/mtime si stabilizzano:
+                    // nessuna attesa sul thread di notifica
+                    OnFileEvent(MakeFullPath(fileName));
+                }
+            }
+
+            if (pNotify->NextEntryOffset == 0) {
+                break;
+            }
+
+            pNotify = reinterpret_cast<FILE_NOTIFY_INFORMATION*>(
+                reinterpret_cast<BYTE*>(pNotify) + pNotify->NextEntryOffset
+            );
+
+        } while (true);
+    }
+
+    CloseHandle(overlapped.hEvent);
+    CloseHandle(hDir);
+}
@@ -0,0 +1,157 @@
+#include "IngestPool.h"
+#include <algorithm>
+#include <cwctype>
+
+IngestPool::IngestPool()
+    : capacity(1), policy(OverflowPolicy::Block), running(false),
+      active(0), submitted(0), completed(0), dropped(0) {
+}
+
+IngestPool::~IngestPool() {
+    Stop();
+}
+
+void IngestPool::SetHandler(Handler h) {
+    handler = h;
+}
+
+void IngestPool::SetDropHandler(Handler h) {
+    dropHandler = h;
+}
+
+OverflowPolicy IngestPool::ParsePolicy(const std::wstring& value) {
+    std::wstring lower = value;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::towlower);
+
+    if (lower == L"drop-newest") return OverflowPolicy::DropNewest;
+    if (lower == L"drop-oldest") return OverflowPolicy::DropOldest;
+    return OverflowPolicy::Block;
+}
+
+bool IngestPool::Start(size_t workerCount, size_t queueCapacity, OverflowPolicy overflowPolicy) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (running) {
+        return true;
+    }
+
+    if (workerCount == 0) {
+        workerCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    capacity = std::max<size_t>(1, queueCapacity);
+    policy = overflowPolicy;
+    running = true;
+
+    for (size_t i = 0; i < workerCount; i++) {
+        workers.emplace_back(&IngestPool::WorkerThread, this);
+    }
+
+    return true;
+}
+
+void IngestPool::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) {
+            return;
+        }
+        running = false;
+        queue.clear();
+    }
+    notEmpty.notify_all();
+    notFull.notify_all();
+
+    for (auto& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    workers.clear();
+}
+
+SubmitResult IngestPool::Submit(const std::wstring& path, Handler itemHandler, Handler evicted) {
+    Item oldest;
+    bool evictedOldest = false;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!running) {
+            return SubmitResult::Stopped;
+        }
+
+        if (queue.size() >= capacity) {
+            switch (policy) {
+            case OverflowPolicy::Block:
+                notFull.wait(lock, [this] { return !running || queue.size() < capacity; });
+                if (!running) {
+                    return SubmitResult::Stopped;
+                }
+                break;
+            case OverflowPolicy::DropNewest:
+                dropped++;
+                return SubmitResult::Dropped;
+            case OverflowPolicy::DropOldest:
+                oldest = std::move(queue.front());
+                queue.pop_front();
+                evictedOldest = true;
+                dropped++;
+                break;
+            }
+        }
+
+        queue.push_back({ path, std::move(itemHandler), std::move(evicted) });
+        submitted++;
+    }
+    notEmpty.notify_one();
+
+    if (evictedOldest) {
+        if (oldest.evicted) {
+            oldest.evicted(oldest.path);
+        }
+        if (dropHandler) {
+            dropHandler(oldest.path);
+        }
+    }
+    return SubmitResult::Accepted;
+}
+
+size_t IngestPool::GetWorkerCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return workers.size();
+}
+
+IngestPool::Stats IngestPool::GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return { queue.size(), active, submitted, completed, dropped };
+}
+
+void IngestPool::WorkerThread() {
+    while (true) {
+        Item item;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            notEmpty.wait(lock, [this] { return !running || !queue.empty(); });
+            if (!running) {
+                return;
+            }
+            item = std::move(queue.front());
+            queue.pop_front();
+            active++;
+        }
+        notFull.notify_one();
+
+        const Handler& itemHandler = item.handler ? item.handler : handler;
+        if (itemHandler) {
+            try {
+                itemHandler(item.path);
+            } catch (...) {
+                // Un errore su un documento non deve fermare il worker
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            active--;
+            completed++;
+        }
+    }
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <string>
+#include <deque>
+#include <vector>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+// Politica applicata quando la coda di ingest e' piena
+enum class OverflowPolicy {
+    Block,          // Il produttore attende che si liberi un posto
+    DropNewest,     // Il nuovo elemento viene scartato
+    DropOldest      // Viene scartato l'elemento piu' vecchio in coda
+};
+
+// Esito di IngestPool::Submit
+enum class SubmitResult {
+    Accepted,       // Accodato (con DropOldest l'elemento scartato va al drop handler)
+    Dropped,        // Coda piena con DropNewest
+    Stopped         // Pool fermo o in arresto
+};
+
+// Coda MPMC limitata + pool di worker che disaccoppia il FileWatcher
+// dall'elaborazione dei PDF. Submit() e' thread-safe e puo' essere chiamato
+// da piu' produttori; ogni worker estrae un path e invoca l'handler.
+class IngestPool {
+public:
+    using Handler = std::function<void(const std::wstring&)>;
+
+    struct Stats {
+        size_t queued;          // Elementi in coda
+        size_t active;          // Worker occupati
+        uint64_t submitted;     // Elementi accettati
+        uint64_t completed;     // Elementi elaborati
+        uint64_t dropped;       // Elementi scartati per overflow
+    };
+
+    IngestPool();
+    ~IngestPool();
+
+    // Funzione che elabora un path (eseguita sui worker)
+    void SetHandler(Handler handler);
+
+    // Notifica gli elementi scartati per overflow (opzionale)
+    void SetDropHandler(Handler handler);
+
+    // Avvia i worker. workerCount = 0 usa il numero di core disponibili
+    bool Start(size_t workerCount, size_t capacity, OverflowPolicy policy);
+
+    // Ferma i worker. Gli elementi ancora in coda vengono scartati
+    void Stop();
+
+    // Accoda un path. Con DropNewest e coda piena l'elemento e' scartato;
+    // a pool fermo non viene accodato. itemHandler, se indicato, sostituisce
+    // l'handler del pool per questo elemento; evicted viene chiamato se
+    // l'elemento e' poi scartato da DropOldest (oltre al drop handler)
+    SubmitResult Submit(const std::wstring& path, Handler itemHandler = nullptr, Handler evicted = nullptr);
+
+    // Numero di worker attivi
+    size_t GetWorkerCount() const;
+
+    Stats GetStats() const;
+
+    // Converte il valore di configurazione (block, drop-newest, drop-oldest)
+    static OverflowPolicy ParsePolicy(const std::wstring& value);
+
+private:
+    struct Item {
+        std::wstring path;
+        Handler handler;        // Vuoto: handler del pool
+        Handler evicted;
+    };
+
+    void WorkerThread();
+
+    Handler handler;
+    Handler dropHandler;
+    std::deque<Item> queue;
+    std::vector<std::thread> workers;
+    size_t capacity;
+    OverflowPolicy policy;
+
+    mutable std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    bool running;
+
+    size_t active;
+    uint64_t submitted;
+    uint64_t completed;
+    uint64_t dropped;
+};
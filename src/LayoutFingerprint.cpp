@@ -0,0 +1,132 @@
+#include "LayoutFingerprint.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Tolleranza relativa sulle dimensioni della pagina (arrotondamenti dei
+// generatori PDF, margini di stampa)
+const double PAGE_SIZE_TOLERANCE = 0.02;
+
+size_t PopCount(uint64_t value) {
+    value = value - ((value >> 1) & 0x5555555555555555ULL);
+    value = (value & 0x3333333333333333ULL) + ((value >> 2) & 0x3333333333333333ULL);
+    value = (value + (value >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return static_cast<size_t>((value * 0x0101010101010101ULL) >> 56);
+}
+
+// Cella della coordinata relativa (0..1) su una griglia di n celle
+int CellOf(double relative, int n) {
+    int cell = static_cast<int>(std::floor(relative * n));
+    return std::max(0, std::min(n - 1, cell));
+}
+
+} // namespace
+
+LayoutFingerprint::LayoutFingerprint() {
+    Clear();
+}
+
+void LayoutFingerprint::Clear() {
+    std::fill(cells, cells + WORDS, 0);
+    cellCount = 0;
+    pageWidth = 0.0;
+    pageHeight = 0.0;
+}
+
+void LayoutFingerprint::SetPageSize(double width, double height) {
+    pageWidth = width;
+    pageHeight = height;
+}
+
+void LayoutFingerprint::AddBox(double x0, double y0, double x1, double y1) {
+    if (pageWidth <= 0.0 || pageHeight <= 0.0 || x1 < x0 || y1 < y0) {
+        return;
+    }
+
+    // Parole fuori pagina (testo nascosto, marcatori) non fanno parte del modello
+    if (x1 < 0.0 || y1 < 0.0 || x0 > pageWidth || y0 > pageHeight) {
+        return;
+    }
+
+    int firstColumn = CellOf(x0 / pageWidth, COLUMNS);
+    int lastColumn = CellOf(x1 / pageWidth, COLUMNS);
+    int firstRow = CellOf(y0 / pageHeight, ROWS);
+    int lastRow = CellOf(y1 / pageHeight, ROWS);
+
+    for (int row = firstRow; row <= lastRow; row++) {
+        for (int column = firstColumn; column <= lastColumn; column++) {
+            size_t bit = static_cast<size_t>(row) * COLUMNS + column;
+            uint64_t mask = 1ULL << (bit & 63);
+            if (!(cells[bit >> 6] & mask)) {
+                cells[bit >> 6] |= mask;
+                cellCount++;
+            }
+        }
+    }
+}
+
+bool LayoutFingerprint::SamePageSize(const LayoutFingerprint& other) const {
+    if (pageWidth <= 0.0 || pageHeight <= 0.0 || other.pageWidth <= 0.0 || other.pageHeight <= 0.0) {
+        return true;
+    }
+    return std::fabs(pageWidth - other.pageWidth) <= PAGE_SIZE_TOLERANCE * pageWidth &&
+           std::fabs(pageHeight - other.pageHeight) <= PAGE_SIZE_TOLERANCE * pageHeight;
+}
+
+double LayoutFingerprint::Similarity(const LayoutFingerprint& other) const {
+    if (cellCount == 0 || other.cellCount == 0 || !SamePageSize(other)) {
+        return 0.0;
+    }
+
+    size_t common = 0;
+    for (size_t i = 0; i < WORDS; i++) {
+        common += PopCount(cells[i] & other.cells[i]);
+    }
+    return static_cast<double>(common) / static_cast<double>(cellCount + other.cellCount - common);
+}
+
+std::string LayoutFingerprint::ToHex() const {
+    static const char digits[] = "0123456789abcdef";
+
+    // Ogni cifra copre quattro celle consecutive, la prima nel bit alto
+    std::string hex;
+    hex.reserve(COLUMNS * ROWS / 4);
+    for (size_t bit = 0; bit < static_cast<size_t>(COLUMNS * ROWS); bit += 4) {
+        int digit = 0;
+        for (size_t k = 0; k < 4; k++) {
+            digit = (digit << 1) | static_cast<int>((cells[(bit + k) >> 6] >> ((bit + k) & 63)) & 1);
+        }
+        hex += digits[digit];
+    }
+    return hex;
+}
+
+bool LayoutFingerprint::FromHex(const std::string& hex) {
+    if (hex.size() != static_cast<size_t>(COLUMNS * ROWS / 4)) {
+        return false;
+    }
+
+    uint64_t parsed[WORDS] = {};
+    size_t count = 0;
+    for (size_t i = 0; i < hex.size(); i++) {
+        char c = hex[i];
+        int digit;
+        if (c >= '0' && c <= '9') digit = c - '0';
+        else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+        else return false;
+
+        for (size_t k = 0; k < 4; k++) {
+            if ((digit >> (3 - k)) & 1) {
+                size_t bit = i * 4 + k;
+                parsed[bit >> 6] |= 1ULL << (bit & 63);
+                count++;
+            }
+        }
+    }
+
+    std::copy(parsed, parsed + WORDS, cells);
+    cellCount = count;
+    return true;
+}
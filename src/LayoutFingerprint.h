@@ -0,0 +1,50 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// Impronta dell'impaginazione della prima pagina: la pagina e' divisa in una
+// griglia fissa (coordinate relative alle dimensioni) e ogni cella coperta
+// da almeno una parola vale 1. Due documenti dello stesso modello hanno
+// intestazioni, etichette e colonne negli stessi punti anche se il testo
+// cambia, per cui le griglie si sovrappongono in gran parte.
+// La somiglianza e' l'indice di Jaccard delle celle occupate (0..1), nulla
+// se le dimensioni della pagina sono diverse.
+class LayoutFingerprint {
+public:
+    static constexpr int COLUMNS = 24;
+    static constexpr int ROWS = 32;
+    static constexpr size_t WORDS = (COLUMNS * ROWS + 63) / 64;
+
+    LayoutFingerprint();
+
+    void Clear();
+
+    // Dimensioni della pagina in punti (0 = sconosciute, nessun confronto)
+    void SetPageSize(double width, double height);
+
+    // Segna le celle coperte da un riquadro in punti, origine in alto a sinistra
+    void AddBox(double x0, double y0, double x1, double y1);
+
+    // Somiglianza con un'altra impronta, 0..1
+    double Similarity(const LayoutFingerprint& other) const;
+
+    // Vero se le pagine hanno le stesse dimensioni (tolleranza 2%)
+    bool SamePageSize(const LayoutFingerprint& other) const;
+
+    // Celle come stringa esadecimale (COLUMNS * ROWS / 4 caratteri, riga per
+    // riga dall'alto) e lettura inversa; false se la stringa non e' valida
+    std::string ToHex() const;
+    bool FromHex(const std::string& hex);
+
+    bool IsEmpty() const { return cellCount == 0; }
+    size_t GetCellCount() const { return cellCount; }
+    double GetPageWidth() const { return pageWidth; }
+    double GetPageHeight() const { return pageHeight; }
+
+private:
+    uint64_t cells[WORDS];
+    size_t cellCount;
+    double pageWidth;
+    double pageHeight;
+};
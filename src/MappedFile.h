@@ -0,0 +1,53 @@
+#pragma once
+#include <string>
+#include <cstddef>
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+// File mappato in memoria in lettura/scrittura. Il file viene creato se non
+// esiste e portato esattamente alla dimensione richiesta (le parti nuove
+// sono azzerate). Le scritture nella mappa arrivano su disco tramite la
+// cache del sistema anche se il processo termina in modo anomalo.
+// In sola lettura il file esistente viene mappato con la sua dimensione.
+// Il backend dipende dalla piattaforma:
+//   - Windows: CreateFileMappingW + MapViewOfFile (MappedFileWin32.cpp)
+//   - POSIX:   ftruncate + mmap (MappedFilePosix.cpp)
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    // Apre (o crea) il file con la dimensione indicata e lo mappa per intero
+    bool Open(const std::wstring& path, size_t size);
+
+    // Mappa per intero un file esistente in sola lettura (file vuoto: errore)
+    bool OpenReadOnly(const std::wstring& path);
+
+    // Rimuove la mappatura e chiude il file
+    void Close();
+
+    // Scrive su disco le pagine modificate (solo per i file aperti con Open)
+    bool Flush();
+
+    bool IsOpen() const { return data != nullptr; }
+    char* Data() const { return data; }
+    size_t Size() const { return size; }
+
+    // Restituisce l'ultimo errore
+    std::wstring GetLastError() const { return lastError; }
+
+private:
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    char* data;
+    size_t size;
+    std::wstring lastError;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int fd;
+#endif
+};
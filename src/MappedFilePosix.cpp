@@ -0,0 +1,98 @@
+// Backend POSIX di MappedFile: ftruncate fissa la dimensione, mmap con
+// MAP_SHARED rende visibili sul file le scritture nella mappa
+#include "MappedFile.h"
+#include <filesystem>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+MappedFile::MappedFile() : data(nullptr), size(0), fd(-1) {
+}
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+bool MappedFile::Open(const std::wstring& path, size_t length) {
+    Close();
+    lastError.clear();
+
+    if (length == 0) {
+        lastError = L"Dimensione non valida per " + path;
+        return false;
+    }
+
+    fd = open(std::filesystem::path(path).c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        lastError = L"Impossibile aprire " + path + L": " + std::to_wstring(errno);
+        return false;
+    }
+
+    if (ftruncate(fd, static_cast<off_t>(length)) != 0) {
+        lastError = L"Impossibile ridimensionare " + path + L": " + std::to_wstring(errno);
+        Close();
+        return false;
+    }
+
+    void* view = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (view == MAP_FAILED) {
+        lastError = L"Impossibile mappare " + path + L": " + std::to_wstring(errno);
+        Close();
+        return false;
+    }
+
+    data = static_cast<char*>(view);
+    size = length;
+    return true;
+}
+
+bool MappedFile::OpenReadOnly(const std::wstring& path) {
+    Close();
+    lastError.clear();
+
+    fd = open(std::filesystem::path(path).c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        lastError = L"Impossibile aprire " + path + L": " + std::to_wstring(errno);
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        lastError = L"File vuoto o non leggibile: " + path;
+        Close();
+        return false;
+    }
+    size_t length = static_cast<size_t>(info.st_size);
+
+    void* view = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (view == MAP_FAILED) {
+        lastError = L"Impossibile mappare " + path + L": " + std::to_wstring(errno);
+        Close();
+        return false;
+    }
+
+    data = static_cast<char*>(view);
+    size = length;
+    return true;
+}
+
+void MappedFile::Close() {
+    if (data != nullptr) {
+        munmap(data, size);
+        data = nullptr;
+    }
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+    size = 0;
+}
+
+bool MappedFile::Flush() {
+    if (data == nullptr) {
+        return false;
+    }
+    return msync(data, size, MS_SYNC) == 0;
+}
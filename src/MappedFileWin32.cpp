@@ -0,0 +1,111 @@
+// Backend Windows di MappedFile: la dimensione del file viene fissata con
+// SetFilePointerEx + SetEndOfFile prima di creare la sezione
+#include "MappedFile.h"
+
+MappedFile::MappedFile() : data(nullptr), size(0), file(INVALID_HANDLE_VALUE), mapping(NULL) {
+}
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+bool MappedFile::Open(const std::wstring& path, size_t length) {
+    Close();
+    lastError.clear();
+
+    if (length == 0) {
+        lastError = L"Dimensione non valida per " + path;
+        return false;
+    }
+
+    file = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ,
+                       NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        lastError = L"Impossibile aprire " + path + L": " + std::to_wstring(::GetLastError());
+        return false;
+    }
+
+    LARGE_INTEGER end;
+    end.QuadPart = static_cast<LONGLONG>(length);
+    if (!SetFilePointerEx(file, end, NULL, FILE_BEGIN) || !SetEndOfFile(file)) {
+        lastError = L"Impossibile ridimensionare " + path + L": " + std::to_wstring(::GetLastError());
+        Close();
+        return false;
+    }
+
+    mapping = CreateFileMappingW(file, NULL, PAGE_READWRITE, 0, 0, NULL);
+    if (mapping == NULL) {
+        lastError = L"Impossibile mappare " + path + L": " + std::to_wstring(::GetLastError());
+        Close();
+        return false;
+    }
+
+    data = static_cast<char*>(MapViewOfFile(mapping, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, length));
+    if (data == nullptr) {
+        lastError = L"Impossibile mappare " + path + L": " + std::to_wstring(::GetLastError());
+        Close();
+        return false;
+    }
+
+    size = length;
+    return true;
+}
+
+bool MappedFile::OpenReadOnly(const std::wstring& path) {
+    Close();
+    lastError.clear();
+
+    file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                       NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        lastError = L"Impossibile aprire " + path + L": " + std::to_wstring(::GetLastError());
+        return false;
+    }
+
+    LARGE_INTEGER length;
+    if (!GetFileSizeEx(file, &length) || length.QuadPart <= 0) {
+        lastError = L"File vuoto o non leggibile: " + path;
+        Close();
+        return false;
+    }
+
+    mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL) {
+        lastError = L"Impossibile mappare " + path + L": " + std::to_wstring(::GetLastError());
+        Close();
+        return false;
+    }
+
+    data = static_cast<char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (data == nullptr) {
+        lastError = L"Impossibile mappare " + path + L": " + std::to_wstring(::GetLastError());
+        Close();
+        return false;
+    }
+
+    size = static_cast<size_t>(length.QuadPart);
+    return true;
+}
+
+void MappedFile::Close() {
+    if (data != nullptr) {
+        UnmapViewOfFile(data);
+        data = nullptr;
+    }
+    if (mapping != NULL) {
+        CloseHandle(mapping);
+        mapping = NULL;
+    }
+    if (file != INVALID_HANDLE_VALUE) {
+        CloseHandle(file);
+        file = INVALID_HANDLE_VALUE;
+    }
+    size = 0;
+}
+
+bool MappedFile::Flush() {
+    if (data == nullptr) {
+        return false;
+    }
+    return FlushViewOfFile(data, size) && FlushFileBuffers(file);
+}
@@ -0,0 +1,228 @@
+#include "OcrEngine.h"
+#include "PdfDocument.h"
+#include "PdfInfo.h"
+#include "ProcessExecutor.h"
+#include "ExtractionCache.h"
+#include "ContentHash.h"
+#include "Config.h"
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <atomic>
+#include <cwctype>
+
+thread_local std::wstring OcrEngine::lastError;
+
+namespace {
+
+// Tempo massimo di ciascuna fase (rasterizzazione, OCR) per una pagina
+const std::chrono::milliseconds STAGE_TIMEOUT(120000);
+
+// Pagina in lavorazione: l'immagine temporanea vive tra le due fasi
+struct PageJob {
+    std::wstring imageRoot;     // pdftoppm aggiunge l'estensione .png
+    std::promise<Subprocess::Result> done;
+};
+
+// Esito negativo di una fase: l'errore spiega quale strumento ha fallito
+bool StageFailed(Subprocess::Result& result, const wchar_t* tool) {
+    if (result.started && !result.timedOut && result.exitCode == 0) {
+        return false;
+    }
+    if (result.error.empty()) {
+        result.error = std::wstring(tool) + L" ha restituito errore: " + std::to_wstring(result.exitCode);
+    }
+    if (result.exitCode == 0) {
+        result.exitCode = -1;
+    }
+    return true;
+}
+
+// Impronta della pagina: byte grezzi del content stream e degli XObject
+// usati (le immagini della scansione), geometria e rotazione. Non dipende
+// dal resto del file: la stessa pagina in un altro PDF ha la stessa impronta
+uint64_t PageHash(PdfDocument& doc, const PdfPage& page) {
+    ContentHash::Hasher hasher;
+    std::string_view bytes = doc.GetBytes();
+    auto addStream = [&](const PdfObject& stream) {
+        if (stream.type == PdfObject::Stream && stream.streamOffset + stream.streamLength <= bytes.size()) {
+            hasher.Update(bytes.data() + stream.streamOffset, stream.streamLength);
+        }
+    };
+
+    const PdfObject& contents = doc.GetResolved(*page.dict, "Contents");
+    if (contents.type == PdfObject::Array) {
+        for (const auto& item : contents.items) {
+            addStream(doc.Resolve(item));
+        }
+    } else {
+        addStream(contents);
+    }
+
+    if (page.resources) {
+        const PdfObject& xobjects = doc.GetResolved(*page.resources, "XObject");
+        if (xobjects.IsDict()) {
+            for (const auto& value : xobjects.values) {
+                addStream(doc.Resolve(value));
+            }
+        }
+    }
+
+    hasher.Update(page.mediaBox, sizeof(page.mediaBox));
+    hasher.Update(&page.rotate, sizeof(page.rotate));
+    return hasher.Digest();
+}
+
+}
+
+bool OcrEngine::IsAvailable() {
+    std::shared_ptr<const Config::Settings> config = Config::Get();
+    return std::filesystem::exists(ResolveTool(config->pdftoppmPath)) &&
+           std::filesystem::exists(ResolveTool(config->tesseractPath));
+}
+
+bool OcrEngine::IsScanned(const std::wstring& pdfPath) {
+    PdfInfo::Info info;
+    return PdfInfo::Read(pdfPath, info) && !info.hasText;
+}
+
+bool OcrEngine::IsTextTooShort(const std::wstring& text) {
+    size_t minChars = Config::Get()->ocrMinTextChars;
+    size_t visible = 0;
+    for (wchar_t c : text) {
+        if (!iswspace(c) && ++visible >= minChars) {
+            return false;
+        }
+    }
+    return visible < minChars;
+}
+
+std::wstring OcrEngine::GetLastError() {
+    return lastError;
+}
+
+std::wstring OcrEngine::ResolveTool(const std::wstring& path) {
+    if (path.find(L'\\') == std::wstring::npos && path.find(L'/') == std::wstring::npos) {
+        return Config::GetExecutableDir() + L"\\" + path;
+    }
+    return path;
+}
+
+uint64_t OcrEngine::SettingsVersion(const std::wstring& languages, uint32_t dpi) {
+    std::wstring settings = languages + L"|" + std::to_wstring(dpi) + L"|psm6";
+    return ContentHash::Compute(settings.data(), settings.size() * sizeof(wchar_t));
+}
+
+std::wstring OcrEngine::ExtractText(const std::wstring& pdfPath) {
+    lastError.clear();
+
+    // Stesse impostazioni per tutte le pagine, anche nelle callback
+    // dell'esecutore che girano su altri thread
+    std::shared_ptr<const Config::Settings> config = Config::Get();
+    std::wstring pdftoppm = ResolveTool(config->pdftoppmPath);
+    std::wstring tesseract = ResolveTool(config->tesseractPath);
+    if (!std::filesystem::exists(pdftoppm) || !std::filesystem::exists(tesseract)) {
+        lastError = L"OCR non disponibile: pdftoppm o tesseract non trovati";
+        return L"";
+    }
+
+    PdfDocument doc;
+    if (!doc.Open(pdfPath)) {
+        lastError = doc.GetLastError();
+        return L"";
+    }
+
+    // Pagine gia' riconosciute dalla cache, le altre accodate all'esecutore:
+    // al termine della rasterizzazione la callback accoda subito l'OCR
+    int pageCount = doc.GetPageCount();
+    uint64_t settings = SettingsVersion(config->ocrLanguages, config->ocrDpi);
+    std::vector<ExtractionCache::Key> keys(pageCount);
+    std::vector<std::wstring> pageTexts(pageCount);
+    std::vector<std::future<Subprocess::Result>> runs(pageCount);
+    static std::atomic<uint64_t> imageCounter(0);
+
+    for (int i = 0; i < pageCount; i++) {
+        keys[i] = { PageHash(doc, doc.GetPages()[i]), settings, ExtractionCache::BACKEND_OCR };
+
+        ExtractionCache::Entry cached;
+        if (ExtractionCache::IsOpen() && ExtractionCache::Lookup(keys[i], cached)) {
+            pageTexts[i] = std::move(cached.rawText);
+            continue;
+        }
+
+        auto job = std::make_shared<PageJob>();
+        std::filesystem::path imageRoot = std::filesystem::temp_directory_path() /
+            (L"MedicalReportMonitor-ocr-" + ContentHash::ToHex(keys[i].contentHash) + L"-" +
+             std::to_wstring(imageCounter++));
+        job->imageRoot = imageRoot.wstring();
+        runs[i] = job->done.get_future();
+
+        std::wstring page = std::to_wstring(i + 1);
+        std::vector<std::wstring> rasterArgs = {
+            L"-r", std::to_wstring(config->ocrDpi), L"-gray", L"-png", L"-singlefile",
+            L"-f", page, L"-l", page, pdfPath, job->imageRoot
+        };
+
+        ProcessExecutor::Submit(pdftoppm, rasterArgs, std::string(), STAGE_TIMEOUT,
+            [job, tesseract, config](Subprocess::Result&& raster) {
+                std::wstring image = job->imageRoot + L".png";
+                if (StageFailed(raster, L"pdftoppm")) {
+                    std::error_code ec;
+                    std::filesystem::remove(image, ec);
+                    job->done.set_value(std::move(raster));
+                    return;
+                }
+
+                std::vector<std::wstring> ocrArgs = {
+                    image, L"stdout", L"-l", config->ocrLanguages, L"--psm", L"6"
+                };
+                ProcessExecutor::Submit(tesseract, ocrArgs, std::string(), STAGE_TIMEOUT,
+                    [job, image](Subprocess::Result&& ocr) {
+                        std::error_code ec;
+                        std::filesystem::remove(image, ec);
+                        StageFailed(ocr, L"tesseract");
+                        job->done.set_value(std::move(ocr));
+                    }, 16 * 1024);
+            }, 256);
+    }
+
+    // Raccolta in ordine di pagina: si attendono tutte le pagine anche dopo
+    // un errore, le immagini temporanee vengono rimosse dalle callback
+    std::wstring failure;
+    for (int i = 0; i < pageCount; i++) {
+        if (!runs[i].valid()) {
+            continue;
+        }
+        Subprocess::Result result = runs[i].get();
+        if (!result.error.empty() || result.exitCode != 0) {
+            if (failure.empty()) {
+                failure = L"OCR pagina " + std::to_wstring(i + 1) + L": " + result.error;
+            }
+            continue;
+        }
+
+        // Tesseract chiude ogni pagina con un form feed
+        while (!result.output.empty() && iswspace(result.output.back())) {
+            result.output.pop_back();
+        }
+        pageTexts[i] = std::move(result.output);
+
+        if (ExtractionCache::IsOpen()) {
+            ExtractionCache::Entry entry = {};
+            entry.rawText = pageTexts[i];
+            ExtractionCache::Store(keys[i], entry);
+        }
+    }
+
+    if (!failure.empty()) {
+        lastError = failure;
+        return L"";
+    }
+
+    std::wstring text;
+    for (const auto& pageText : pageTexts) {
+        text += pageText;
+        text += L'\f';
+    }
+    return text;
+}
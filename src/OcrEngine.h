@@ -0,0 +1,40 @@
+#pragma once
+#include <string>
+#include <cstdint>
+
+// OCR dei PDF da scansione (o fotografati): ogni pagina viene rasterizzata
+// da pdftoppm e riconosciuta da Tesseract. Le pagine procedono in parallelo
+// come job dell'esecutore dei processi, rasterizzazione e OCR in catena,
+// entro il limite globale di processi contemporanei.
+// Il testo di ogni pagina resta nella cache delle estrazioni con l'impronta
+// della pagina come chiave: una pagina gia' riconosciuta (ristampa, stesso
+// allegato in un altro referto) non ripassa dall'OCR.
+class OcrEngine {
+public:
+    // pdftoppm e tesseract presenti
+    static bool IsAvailable();
+
+    // PDF senza operatori di testo in nessuna pagina
+    static bool IsScanned(const std::wstring& pdfPath);
+
+    // Testo estratto troppo scarso per un referto (meno di
+    // Config::ocrMinTextChars caratteri esclusi gli spazi)
+    static bool IsTextTooShort(const std::wstring& text);
+
+    // OCR di tutte le pagine, separate da '\f' come nell'output di pdftotext.
+    // Restituisce una stringa vuota in caso di errore
+    static std::wstring ExtractText(const std::wstring& pdfPath);
+
+    // Restituisce l'ultimo errore
+    static std::wstring GetLastError();
+
+private:
+    // Percorso completo di uno strumento (relativo: directory dell'eseguibile)
+    static std::wstring ResolveTool(const std::wstring& path);
+
+    // Versione delle impostazioni OCR (lingue, risoluzione): parte della
+    // chiave della cache, un cambio invalida il testo gia' riconosciuto
+    static uint64_t SettingsVersion(const std::wstring& languages, uint32_t dpi);
+
+    static thread_local std::wstring lastError;  // Per thread: piu' worker elaborano in parallelo
+};
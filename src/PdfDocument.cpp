@@ -0,0 +1,1195 @@
+#include "PdfDocument.h"
+#include <zlib.h>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <cstring>
+
+static const PdfObject NULL_OBJECT;
+
+static const int MAX_NESTING = 64;
+
+const PdfObject* PdfObject::Get(const char* key) const {
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (keys[i] == key) {
+            return &values[i];
+        }
+    }
+    return nullptr;
+}
+
+// ============================================================================
+// PdfParser
+// ============================================================================
+
+static inline bool IsWhite(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\f' || c == '\0';
+}
+
+static inline bool IsDelimiter(char c) {
+    return c == '(' || c == ')' || c == '<' || c == '>' || c == '[' || c == ']' ||
+           c == '{' || c == '}' || c == '/' || c == '%';
+}
+
+static inline int HexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+PdfParser::PdfParser(const char* d, size_t s, size_t p)
+    : data(d), size(s), pos(p < s ? p : s), depth(0) {
+}
+
+void PdfParser::SkipWhitespace() {
+    while (pos < size) {
+        char c = data[pos];
+        if (IsWhite(c)) {
+            pos++;
+        } else if (c == '%') {
+            while (pos < size && data[pos] != '\n' && data[pos] != '\r') {
+                pos++;
+            }
+        } else {
+            break;
+        }
+    }
+}
+
+void PdfParser::ReadLiteralString(std::string& out) {
+    // pos e' subito dopo '('
+    int nesting = 1;
+    while (pos < size) {
+        char c = data[pos++];
+        if (c == '\\') {
+            if (pos >= size) break;
+            char e = data[pos++];
+            switch (e) {
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case '\r':
+                    // Continuazione di riga
+                    if (pos < size && data[pos] == '\n') pos++;
+                    break;
+                case '\n':
+                    break;
+                default:
+                    if (e >= '0' && e <= '7') {
+                        int value = e - '0';
+                        for (int i = 0; i < 2 && pos < size && data[pos] >= '0' && data[pos] <= '7'; i++) {
+                            value = value * 8 + (data[pos++] - '0');
+                        }
+                        out += static_cast<char>(value & 0xFF);
+                    } else {
+                        out += e;
+                    }
+                    break;
+            }
+        } else if (c == '(') {
+            nesting++;
+            out += c;
+        } else if (c == ')') {
+            if (--nesting == 0) break;
+            out += c;
+        } else {
+            out += c;
+        }
+    }
+}
+
+void PdfParser::ReadHexString(std::string& out) {
+    // pos e' subito dopo '<'
+    int high = -1;
+    while (pos < size) {
+        char c = data[pos++];
+        if (c == '>') break;
+        int v = HexValue(c);
+        if (v < 0) continue;
+        if (high < 0) {
+            high = v;
+        } else {
+            out += static_cast<char>((high << 4) | v);
+            high = -1;
+        }
+    }
+    if (high >= 0) {
+        out += static_cast<char>(high << 4);
+    }
+}
+
+void PdfParser::ReadName(std::string& out) {
+    // pos e' subito dopo '/'
+    while (pos < size) {
+        char c = data[pos];
+        if (IsWhite(c) || IsDelimiter(c)) break;
+        pos++;
+        if (c == '#' && pos + 1 < size && HexValue(data[pos]) >= 0 && HexValue(data[pos + 1]) >= 0) {
+            out += static_cast<char>((HexValue(data[pos]) << 4) | HexValue(data[pos + 1]));
+            pos += 2;
+        } else {
+            out += c;
+        }
+    }
+}
+
+bool PdfParser::ReadToken(PdfObject& token, bool& isDelimiter) {
+    isDelimiter = false;
+    token = PdfObject();
+
+    SkipWhitespace();
+    while (pos < size && data[pos] == ')') {
+        // Parentesi spaiata: ignorata
+        pos++;
+        SkipWhitespace();
+    }
+    if (pos >= size) {
+        return false;
+    }
+
+    char c = data[pos];
+
+    if (c == '(') {
+        pos++;
+        token.type = PdfObject::String;
+        ReadLiteralString(token.text);
+        return true;
+    }
+
+    if (c == '<') {
+        if (pos + 1 < size && data[pos + 1] == '<') {
+            pos += 2;
+            isDelimiter = true;
+            token.text = "<<";
+            return true;
+        }
+        pos++;
+        token.type = PdfObject::String;
+        ReadHexString(token.text);
+        return true;
+    }
+
+    if (c == '>') {
+        pos += (pos + 1 < size && data[pos + 1] == '>') ? 2 : 1;
+        isDelimiter = true;
+        token.text = ">>";
+        return true;
+    }
+
+    if (c == '[' || c == ']' || c == '{' || c == '}') {
+        pos++;
+        isDelimiter = true;
+        token.text = std::string(1, c);
+        return true;
+    }
+
+    if (c == '/') {
+        pos++;
+        token.type = PdfObject::Name;
+        ReadName(token.text);
+        return true;
+    }
+
+    // Numero
+    if ((c >= '0' && c <= '9') || c == '+' || c == '-' || c == '.') {
+        size_t start = pos;
+        bool negative = false;
+        while (pos < size && (data[pos] == '+' || data[pos] == '-')) {
+            negative = data[pos] == '-';
+            pos++;
+        }
+        double value = 0;
+        bool digits = false;
+        while (pos < size && data[pos] >= '0' && data[pos] <= '9') {
+            value = value * 10 + (data[pos++] - '0');
+            digits = true;
+        }
+        if (pos < size && data[pos] == '.') {
+            pos++;
+            double scale = 0.1;
+            while (pos < size && data[pos] >= '0' && data[pos] <= '9') {
+                value += (data[pos++] - '0') * scale;
+                scale *= 0.1;
+                digits = true;
+            }
+        }
+        if (digits && (pos >= size || IsWhite(data[pos]) || IsDelimiter(data[pos]))) {
+            token.type = PdfObject::Number;
+            token.number = negative ? -value : value;
+            return true;
+        }
+        // Non era un numero: prosegui come parola chiave
+        pos = start;
+    }
+
+    // Parola chiave / operatore
+    size_t start = pos;
+    while (pos < size && !IsWhite(data[pos]) && !IsDelimiter(data[pos])) {
+        pos++;
+    }
+    if (pos == start) {
+        // Delimitatore non gestito: restituito come operatore di un carattere
+        pos++;
+    }
+
+    token.text.assign(data + start, pos - start);
+    if (token.text == "true" || token.text == "false") {
+        token.type = PdfObject::Boolean;
+        token.number = token.text == "true" ? 1 : 0;
+        token.text.clear();
+    } else if (token.text == "null") {
+        token.type = PdfObject::Null;
+        token.text.clear();
+    } else {
+        token.type = PdfObject::Operator;
+    }
+    return true;
+}
+
+bool PdfParser::PeekReference(int& gen, size_t& after) const {
+    // Riconosce "<gen> R" dopo un intero, senza consumare input
+    size_t p = pos;
+    while (p < size && IsWhite(data[p])) p++;
+    size_t digitStart = p;
+    int value = 0;
+    while (p < size && data[p] >= '0' && data[p] <= '9' && p - digitStart < 6) {
+        value = value * 10 + (data[p++] - '0');
+    }
+    if (p == digitStart || p >= size || !IsWhite(data[p])) {
+        return false;
+    }
+    while (p < size && IsWhite(data[p])) p++;
+    if (p >= size || data[p] != 'R') {
+        return false;
+    }
+    p++;
+    if (p < size && !IsWhite(data[p]) && !IsDelimiter(data[p])) {
+        return false;
+    }
+    gen = value;
+    after = p;
+    return true;
+}
+
+bool PdfParser::ReadValue(PdfObject& obj, PdfObject& token, bool isDelimiter) {
+    if (!isDelimiter) {
+        if (token.type == PdfObject::Number && token.number >= 0 &&
+            token.number == static_cast<double>(static_cast<long long>(token.number))) {
+            int gen;
+            size_t after;
+            if (PeekReference(gen, after)) {
+                pos = after;
+                obj = PdfObject();
+                obj.type = PdfObject::Reference;
+                obj.objNum = static_cast<int>(token.number);
+                obj.genNum = gen;
+                return true;
+            }
+        }
+        obj = std::move(token);
+        return true;
+    }
+
+    if (depth >= MAX_NESTING) {
+        return false;
+    }
+
+    if (token.text == "[" || token.text == "{") {
+        const char* close = token.text == "[" ? "]" : "}";
+        obj = PdfObject();
+        obj.type = PdfObject::Array;
+        depth++;
+        PdfObject next;
+        bool delim;
+        while (ReadToken(next, delim)) {
+            if (delim && next.text == close) break;
+            if (delim && (next.text == "]" || next.text == "}")) continue;
+            obj.items.emplace_back();
+            if (!ReadValue(obj.items.back(), next, delim)) {
+                depth--;
+                return false;
+            }
+        }
+        depth--;
+        return true;
+    }
+
+    if (token.text == "<<") {
+        obj = PdfObject();
+        obj.type = PdfObject::Dictionary;
+        depth++;
+        PdfObject key;
+        bool delim;
+        while (ReadToken(key, delim)) {
+            if (delim && key.text == ">>") break;
+            if (key.type != PdfObject::Name) continue;
+
+            PdfObject valueToken;
+            if (!ReadToken(valueToken, delim)) break;
+            if (delim && valueToken.text == ">>") {
+                obj.keys.push_back(std::move(key.text));
+                obj.values.emplace_back();
+                break;
+            }
+            PdfObject value;
+            if (!ReadValue(value, valueToken, delim)) {
+                depth--;
+                return false;
+            }
+            obj.keys.push_back(std::move(key.text));
+            obj.values.push_back(std::move(value));
+        }
+        depth--;
+        return true;
+    }
+
+    // Delimitatore di chiusura fuori contesto
+    obj = PdfObject();
+    obj.type = PdfObject::Operator;
+    obj.text = token.text;
+    return true;
+}
+
+bool PdfParser::ReadObject(PdfObject& obj) {
+    PdfObject token;
+    bool delim;
+    if (!ReadToken(token, delim)) {
+        return false;
+    }
+    return ReadValue(obj, token, delim);
+}
+
+void PdfParser::SkipInlineImage() {
+    // Un solo carattere di spazio separa ID dai dati
+    if (pos < size && IsWhite(data[pos])) pos++;
+
+    while (pos + 1 < size) {
+        if (data[pos] == 'E' && data[pos + 1] == 'I' &&
+            (pos == 0 || IsWhite(data[pos - 1])) &&
+            (pos + 2 >= size || IsWhite(data[pos + 2]))) {
+            pos += 2;
+            return;
+        }
+        pos++;
+    }
+    pos = size;
+}
+
+// ============================================================================
+// Filtri di decodifica
+// ============================================================================
+
+static bool FlateDecode(const std::string& in, std::string& out) {
+    for (int attempt = 0; attempt < 2; attempt++) {
+        z_stream zs;
+        memset(&zs, 0, sizeof(zs));
+        // Secondo tentativo: deflate grezzo senza intestazione zlib
+        int init = attempt == 0 ? inflateInit(&zs) : inflateInit2(&zs, -MAX_WBITS);
+        if (init != Z_OK) {
+            return false;
+        }
+
+        zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+        zs.avail_in = static_cast<uInt>(in.size());
+
+        out.clear();
+        char buffer[16384];
+        int ret;
+        do {
+            zs.next_out = reinterpret_cast<Bytef*>(buffer);
+            zs.avail_out = sizeof(buffer);
+            ret = inflate(&zs, Z_NO_FLUSH);
+            out.append(buffer, sizeof(buffer) - zs.avail_out);
+        } while (ret == Z_OK && (zs.avail_in > 0 || zs.avail_out == 0));
+        inflateEnd(&zs);
+
+        // Stream troncati o con checksum errato: si tiene quanto decodificato
+        if (ret == Z_STREAM_END || !out.empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool AsciiHexDecode(const std::string& in, std::string& out) {
+    out.clear();
+    int high = -1;
+    for (char c : in) {
+        if (c == '>') break;
+        int v = HexValue(c);
+        if (v < 0) continue;
+        if (high < 0) {
+            high = v;
+        } else {
+            out += static_cast<char>((high << 4) | v);
+            high = -1;
+        }
+    }
+    if (high >= 0) {
+        out += static_cast<char>(high << 4);
+    }
+    return true;
+}
+
+static bool Ascii85Decode(const std::string& in, std::string& out) {
+    out.clear();
+    uint32_t tuple = 0;
+    int count = 0;
+    for (size_t i = 0; i < in.size(); i++) {
+        char c = in[i];
+        if (c == '~') break;
+        if (IsWhite(c)) continue;
+        if (c == 'z' && count == 0) {
+            out.append(4, '\0');
+            continue;
+        }
+        if (c < '!' || c > 'u') {
+            return false;
+        }
+        tuple = tuple * 85 + static_cast<uint32_t>(c - '!');
+        if (++count == 5) {
+            for (int s = 24; s >= 0; s -= 8) {
+                out += static_cast<char>((tuple >> s) & 0xFF);
+            }
+            tuple = 0;
+            count = 0;
+        }
+    }
+    if (count > 1) {
+        for (int i = count; i < 5; i++) {
+            tuple = tuple * 85 + 84;
+        }
+        for (int i = 0; i < count - 1; i++) {
+            out += static_cast<char>((tuple >> (24 - 8 * i)) & 0xFF);
+        }
+    }
+    return true;
+}
+
+static bool LzwDecode(const std::string& in, std::string& out, int earlyChange) {
+    out.clear();
+    std::vector<std::string> table;
+    auto reset = [&table]() {
+        table.clear();
+        for (int i = 0; i < 256; i++) table.push_back(std::string(1, static_cast<char>(i)));
+        table.emplace_back();   // 256: clear
+        table.emplace_back();   // 257: EOD
+    };
+    reset();
+
+    int codeLength = 9;
+    uint32_t bitBuffer = 0;
+    int bitCount = 0;
+    int previous = -1;
+
+    for (size_t i = 0; i < in.size(); i++) {
+        bitBuffer = (bitBuffer << 8) | static_cast<unsigned char>(in[i]);
+        bitCount += 8;
+        while (bitCount >= codeLength) {
+            int code = static_cast<int>((bitBuffer >> (bitCount - codeLength)) & ((1u << codeLength) - 1));
+            bitCount -= codeLength;
+
+            if (code == 256) {
+                reset();
+                codeLength = 9;
+                previous = -1;
+                continue;
+            }
+            if (code == 257) {
+                return true;
+            }
+
+            std::string entry;
+            if (code < static_cast<int>(table.size())) {
+                entry = table[code];
+                if (previous >= 0) {
+                    table.push_back(table[previous] + entry[0]);
+                }
+            } else if (previous >= 0) {
+                entry = table[previous] + table[previous][0];
+                table.push_back(entry);
+            } else {
+                return false;
+            }
+            out += entry;
+            previous = code;
+
+            if (table.size() > 4096) {
+                // Tabella piena senza codice di reset: flusso non valido
+                return true;
+            }
+
+            int next = static_cast<int>(table.size()) + earlyChange;
+            if (next >= 2048) {
+                codeLength = 12;
+            } else if (next >= 1024) {
+                codeLength = 11;
+            } else if (next >= 512) {
+                codeLength = 10;
+            }
+        }
+    }
+    return true;
+}
+
+static bool RunLengthDecode(const std::string& in, std::string& out) {
+    out.clear();
+    size_t i = 0;
+    while (i < in.size()) {
+        int length = static_cast<unsigned char>(in[i++]);
+        if (length == 128) break;
+        if (length < 128) {
+            size_t n = std::min<size_t>(length + 1, in.size() - i);
+            out.append(in, i, n);
+            i += n;
+        } else if (i < in.size()) {
+            out.append(257 - length, in[i++]);
+        }
+    }
+    return true;
+}
+
+// Predittori PNG (valori 10-15) usati soprattutto dagli xref stream
+static bool ApplyPredictor(std::string& data, const PdfObject* params) {
+    if (!params || !params->IsDict()) {
+        return true;
+    }
+
+    const PdfObject* predictorObj = params->Get("Predictor");
+    int predictor = predictorObj && predictorObj->IsNumber() ? predictorObj->AsInt() : 1;
+    if (predictor < 10) {
+        // 1 = nessuno; il predittore TIFF (2) non compare nei flussi di testo
+        return predictor == 1;
+    }
+
+    const PdfObject* colorsObj = params->Get("Colors");
+    const PdfObject* bitsObj = params->Get("BitsPerComponent");
+    const PdfObject* columnsObj = params->Get("Columns");
+    int colors = colorsObj && colorsObj->IsNumber() ? colorsObj->AsInt() : 1;
+    int bits = bitsObj && bitsObj->IsNumber() ? bitsObj->AsInt() : 8;
+    int columns = columnsObj && columnsObj->IsNumber() ? columnsObj->AsInt() : 1;
+
+    size_t bpp = std::max<size_t>(1, (colors * bits + 7) / 8);
+    size_t rowLength = (static_cast<size_t>(colors) * bits * columns + 7) / 8;
+    if (rowLength == 0) {
+        return false;
+    }
+
+    std::string out;
+    out.reserve(data.size());
+    std::vector<unsigned char> prior(rowLength, 0), row(rowLength);
+
+    size_t pos = 0;
+    while (pos < data.size()) {
+        int type = static_cast<unsigned char>(data[pos++]);
+        size_t n = std::min(rowLength, data.size() - pos);
+        std::fill(row.begin(), row.end(), 0);
+        memcpy(row.data(), data.data() + pos, n);
+        pos += n;
+
+        for (size_t i = 0; i < rowLength; i++) {
+            unsigned char left = i >= bpp ? row[i - bpp] : 0;
+            unsigned char up = prior[i];
+            unsigned char upLeft = i >= bpp ? prior[i - bpp] : 0;
+            switch (type) {
+                case 1: row[i] = static_cast<unsigned char>(row[i] + left); break;
+                case 2: row[i] = static_cast<unsigned char>(row[i] + up); break;
+                case 3: row[i] = static_cast<unsigned char>(row[i] + ((left + up) >> 1)); break;
+                case 4: {
+                    int p = left + up - upLeft;
+                    int pa = std::abs(p - left), pb = std::abs(p - up), pc = std::abs(p - upLeft);
+                    unsigned char pred = (pa <= pb && pa <= pc) ? left : (pb <= pc ? up : upLeft);
+                    row[i] = static_cast<unsigned char>(row[i] + pred);
+                    break;
+                }
+                default: break;
+            }
+        }
+        out.append(reinterpret_cast<const char*>(row.data()), n);
+        prior = row;
+    }
+
+    data.swap(out);
+    return true;
+}
+
+// ============================================================================
+// PdfDocument
+// ============================================================================
+
+PdfDocument::PdfDocument() {
+}
+
+bool PdfDocument::Open(const std::wstring& path) {
+    lastError.clear();
+
+    std::ifstream file(std::filesystem::path(path), std::ios::binary);
+    if (!file.is_open()) {
+        lastError = L"Impossibile aprire il PDF: " + path;
+        return false;
+    }
+
+    std::string bytes;
+    file.seekg(0, std::ios::end);
+    std::streamoff length = file.tellg();
+    file.seekg(0, std::ios::beg);
+    if (length > 0) {
+        bytes.resize(static_cast<size_t>(length));
+        file.read(&bytes[0], length);
+        bytes.resize(static_cast<size_t>(file.gcount()));
+    }
+
+    return Load(std::move(bytes));
+}
+
+bool PdfDocument::Load(std::string bytes) {
+    storage = std::move(bytes);
+    return Index(storage, true);
+}
+
+bool PdfDocument::LoadView(std::string_view bytes, bool collectPages) {
+    storage.clear();
+    storage.shrink_to_fit();
+    return Index(bytes, collectPages);
+}
+
+bool PdfDocument::Index(std::string_view bytes, bool collectPages) {
+    lastError.clear();
+    data = bytes;
+    xref.clear();
+    xrefSeen.clear();
+    trailer = PdfObject();
+    cache.clear();
+    objectStreams.clear();
+    pages.clear();
+
+    // L'intestazione puo' essere preceduta da qualche byte estraneo
+    if (data.substr(0, 1024 + 5).find("%PDF-") == std::string_view::npos) {
+        lastError = L"Il file non e' un PDF";
+        return false;
+    }
+
+    // startxref si trova negli ultimi byte del file
+    bool xrefOk = false;
+    size_t tail = data.size() > 2048 ? data.size() - 2048 : 0;
+    size_t startxref = data.rfind("startxref");
+    if (startxref != std::string::npos && startxref >= tail) {
+        PdfParser parser(data.data(), data.size(), startxref + 9);
+        PdfObject offset;
+        if (parser.ReadObject(offset) && offset.IsNumber() && offset.number > 0) {
+            xrefOk = ReadXref(static_cast<size_t>(offset.number));
+        }
+    }
+
+    bool rebuilt = false;
+    if (!xrefOk || !trailer.Get("Root")) {
+        if (!RebuildXref()) {
+            lastError = L"Struttura del PDF non valida";
+            return false;
+        }
+        rebuilt = true;
+    }
+
+    if (trailer.Get("Encrypt")) {
+        lastError = L"PDF cifrato: estrazione nativa non supportata";
+        return false;
+    }
+
+    if (!collectPages) {
+        return true;
+    }
+
+    const PdfObject& root = GetResolved(trailer, "Root");
+    const PdfObject& pageTree = GetResolved(root, "Pages");
+    static const double letter[4] = { 0, 0, 612, 792 };
+    CollectPages(pageTree, nullptr, letter, 0, 0);
+
+    // Tabella xref presente ma incoerente: ricostruisci e riprova
+    if (pages.empty() && !rebuilt && RebuildXref()) {
+        const PdfObject& rebuiltRoot = GetResolved(trailer, "Root");
+        CollectPages(GetResolved(rebuiltRoot, "Pages"), nullptr, letter, 0, 0);
+    }
+
+    if (pages.empty()) {
+        lastError = L"Nessuna pagina trovata nel PDF";
+        return false;
+    }
+
+    return true;
+}
+
+void PdfDocument::SetEntry(size_t num, const XrefEntry& entry) {
+    // Le sezioni piu' recenti vengono lette per prime: la prima voce vince
+    if (num > 10000000) {
+        return;
+    }
+    if (num >= xref.size()) {
+        xref.resize(num + 1, XrefEntry{ 0, 0, 0 });
+        xrefSeen.resize(num + 1, false);
+    }
+    if (!xrefSeen[num]) {
+        xref[num] = entry;
+        xrefSeen[num] = true;
+    }
+}
+
+bool PdfDocument::ReadXref(size_t offset) {
+    std::vector<size_t> visited;
+
+    while (offset > 0 && offset < data.size()) {
+        if (std::find(visited.begin(), visited.end(), offset) != visited.end()) {
+            break;
+        }
+        visited.push_back(offset);
+
+        PdfParser parser(data.data(), data.size(), offset);
+        parser.SkipWhitespace();
+        size_t start = parser.GetPosition();
+
+        PdfObject section;
+        if (data.compare(start, 4, "xref") == 0) {
+            parser.SetPosition(start + 4);
+            if (!ReadXrefTable(parser)) {
+                return false;
+            }
+            if (!parser.ReadObject(section) || !section.IsDict()) {
+                return false;
+            }
+
+            // File ibridi: le voci dello stream integrano la tabella
+            const PdfObject* xrefStm = section.Get("XRefStm");
+            if (xrefStm && xrefStm->IsNumber()) {
+                PdfObject stream;
+                if (ParseIndirect(static_cast<size_t>(xrefStm->number), stream)) {
+                    ReadXrefStream(stream);
+                }
+            }
+        } else {
+            if (!ParseIndirect(start, section) || section.type != PdfObject::Stream ||
+                !ReadXrefStream(section)) {
+                return false;
+            }
+        }
+
+        if (trailer.type == PdfObject::Null) {
+            trailer = section;
+            trailer.type = PdfObject::Dictionary;
+        }
+
+        const PdfObject* prev = section.Get("Prev");
+        offset = prev && prev->IsNumber() ? static_cast<size_t>(prev->number) : 0;
+    }
+
+    return trailer.type != PdfObject::Null;
+}
+
+bool PdfDocument::ReadXrefTable(PdfParser& parser) {
+    PdfObject first, count;
+    while (true) {
+        size_t mark = parser.GetPosition();
+        if (!parser.ReadObject(first)) {
+            return false;
+        }
+        if (first.type == PdfObject::Operator && first.text == "trailer") {
+            return true;
+        }
+        if (!first.IsNumber() || !parser.ReadObject(count) || !count.IsNumber()) {
+            parser.SetPosition(mark);
+            return false;
+        }
+
+        size_t start = static_cast<size_t>(first.number);
+        size_t n = static_cast<size_t>(count.number);
+        for (size_t i = 0; i < n; i++) {
+            PdfObject offset, gen, kind;
+            if (!parser.ReadObject(offset) || !parser.ReadObject(gen) || !parser.ReadObject(kind)) {
+                return false;
+            }
+            if (!offset.IsNumber() || kind.type != PdfObject::Operator) {
+                return false;
+            }
+            if (kind.text == "n") {
+                SetEntry(start + i, XrefEntry{ 1, static_cast<uint64_t>(offset.number), 0 });
+            } else {
+                SetEntry(start + i, XrefEntry{ 0, 0, 0 });
+            }
+        }
+    }
+}
+
+bool PdfDocument::ReadXrefStream(const PdfObject& stream) {
+    std::string content;
+    if (!GetStreamData(stream, content)) {
+        return false;
+    }
+
+    const PdfObject* w = stream.Get("W");
+    if (!w || w->type != PdfObject::Array || w->items.size() < 3) {
+        return false;
+    }
+    int widths[3];
+    for (int i = 0; i < 3; i++) {
+        widths[i] = w->items[i].AsInt();
+        if (widths[i] < 0 || widths[i] > 8) return false;
+    }
+    size_t entrySize = static_cast<size_t>(widths[0] + widths[1] + widths[2]);
+    if (entrySize == 0) {
+        return false;
+    }
+
+    std::vector<std::pair<size_t, size_t>> ranges;
+    const PdfObject* index = stream.Get("Index");
+    if (index && index->type == PdfObject::Array) {
+        for (size_t i = 0; i + 1 < index->items.size(); i += 2) {
+            ranges.push_back({ static_cast<size_t>(index->items[i].number),
+                               static_cast<size_t>(index->items[i + 1].number) });
+        }
+    } else {
+        const PdfObject* size = stream.Get("Size");
+        ranges.push_back({ 0, size && size->IsNumber() ? static_cast<size_t>(size->number) : 0 });
+    }
+
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(content.data());
+    size_t pos = 0;
+    for (const auto& range : ranges) {
+        for (size_t i = 0; i < range.second; i++) {
+            if (pos + entrySize > content.size()) {
+                return true;
+            }
+            uint64_t fields[3];
+            for (int f = 0; f < 3; f++) {
+                uint64_t v = 0;
+                for (int b = 0; b < widths[f]; b++) {
+                    v = (v << 8) | p[pos++];
+                }
+                fields[f] = v;
+            }
+            // Campo tipo assente: il default e' 1
+            uint8_t type = widths[0] == 0 ? 1 : static_cast<uint8_t>(fields[0]);
+            if (type == 1 || type == 2) {
+                SetEntry(range.first + i, XrefEntry{ type, fields[1], static_cast<uint32_t>(fields[2]) });
+            } else {
+                SetEntry(range.first + i, XrefEntry{ 0, 0, 0 });
+            }
+        }
+    }
+    return true;
+}
+
+bool PdfDocument::RebuildXref() {
+    // Ricostruzione: cerca tutte le intestazioni "N G obj" nel file
+    xref.clear();
+    xrefSeen.clear();
+    cache.clear();
+    objectStreams.clear();
+    pages.clear();
+
+    PdfObject rebuiltTrailer;
+    std::vector<size_t> numbers;
+
+    size_t pos = 0;
+    while ((pos = data.find("obj", pos)) != std::string::npos) {
+        size_t keywordEnd = pos + 3;
+        size_t p = pos;
+        pos = keywordEnd;
+
+        if (keywordEnd < data.size() && !IsWhite(data[keywordEnd]) && !IsDelimiter(data[keywordEnd])) {
+            continue;
+        }
+
+        // All'indietro: spazi, generazione, spazi, numero
+        if (p == 0 || !IsWhite(data[p - 1])) continue;
+        while (p > 0 && IsWhite(data[p - 1])) p--;
+        size_t genEnd = p;
+        while (p > 0 && data[p - 1] >= '0' && data[p - 1] <= '9') p--;
+        if (p == genEnd || p == 0 || !IsWhite(data[p - 1])) continue;
+        while (p > 0 && IsWhite(data[p - 1])) p--;
+        size_t numEnd = p;
+        while (p > 0 && data[p - 1] >= '0' && data[p - 1] <= '9') p--;
+        if (p == numEnd || (p > 0 && !IsWhite(data[p - 1]) && !IsDelimiter(data[p - 1]))) continue;
+
+        size_t num = static_cast<size_t>(std::strtoul(data.data() + p, nullptr, 10));
+        if (num == 0 || num > 10000000) continue;
+
+        // Le definizioni successive sostituiscono le precedenti
+        if (num < xrefSeen.size()) {
+            xrefSeen[num] = false;
+        }
+        SetEntry(num, XrefEntry{ 1, p, 0 });
+        numbers.push_back(num);
+    }
+
+    // Trailer: l'ultimo dizionario "trailer" con /Root
+    pos = 0;
+    while ((pos = data.find("trailer", pos)) != std::string::npos) {
+        PdfParser parser(data.data(), data.size(), pos + 7);
+        PdfObject dict;
+        if (parser.ReadObject(dict) && dict.IsDict() && dict.Get("Root")) {
+            rebuiltTrailer = dict;
+        }
+        pos += 7;
+    }
+
+    // Object stream e catalogo (anche per i file con soli xref stream)
+    for (size_t num : numbers) {
+        PdfObject ref;
+        ref.type = PdfObject::Reference;
+        ref.objNum = static_cast<int>(num);
+        const PdfObject& obj = Resolve(ref);
+        if (!obj.IsDict()) continue;
+
+        const PdfObject* type = obj.Get("Type");
+        if (type && type->IsName("ObjStm")) {
+            std::string content;
+            const PdfObject* count = obj.Get("N");
+            if (!count || !GetStreamData(obj, content)) continue;
+            PdfParser parser(content.data(), content.size());
+            for (int i = 0; i < count->AsInt(); i++) {
+                PdfObject objNum, offset;
+                if (!parser.ReadObject(objNum) || !parser.ReadObject(offset)) break;
+                size_t n = static_cast<size_t>(objNum.number);
+                if (n < xrefSeen.size() && xrefSeen[n]) continue;
+                SetEntry(n, XrefEntry{ 2, num, static_cast<uint32_t>(i) });
+            }
+        } else if (type && type->IsName("XRef") && obj.Get("Root") && !rebuiltTrailer.Get("Root")) {
+            rebuiltTrailer = obj;
+            rebuiltTrailer.type = PdfObject::Dictionary;
+        } else if (type && type->IsName("Catalog") && !rebuiltTrailer.Get("Root")) {
+            rebuiltTrailer.type = PdfObject::Dictionary;
+            rebuiltTrailer.keys.push_back("Root");
+            PdfObject ref;
+            ref.type = PdfObject::Reference;
+            ref.objNum = static_cast<int>(num);
+            rebuiltTrailer.values.push_back(ref);
+        }
+    }
+
+    cache.clear();
+    trailer = rebuiltTrailer;
+    return trailer.Get("Root") != nullptr;
+}
+
+bool PdfDocument::ParseIndirect(size_t offset, PdfObject& obj) {
+    PdfParser parser(data.data(), data.size(), offset);
+    PdfObject num, gen, keyword;
+    if (!parser.ReadObject(num) || !num.IsNumber() ||
+        !parser.ReadObject(gen) || !gen.IsNumber() ||
+        !parser.ReadObject(keyword) || keyword.type != PdfObject::Operator || keyword.text != "obj") {
+        return false;
+    }
+
+    if (!parser.ReadObject(obj)) {
+        return false;
+    }
+    if (obj.type != PdfObject::Dictionary) {
+        return true;
+    }
+
+    size_t mark = parser.GetPosition();
+    parser.SkipWhitespace();
+    if (data.compare(parser.GetPosition(), 6, "stream") != 0) {
+        parser.SetPosition(mark);
+        return true;
+    }
+
+    // I dati iniziano dopo il fine riga che segue "stream"
+    size_t start = parser.GetPosition() + 6;
+    if (start < data.size() && data[start] == '\r') start++;
+    if (start < data.size() && data[start] == '\n') start++;
+
+    size_t length = 0;
+    bool lengthOk = false;
+    const PdfObject* lengthObj = obj.Get("Length");
+    if (lengthObj) {
+        const PdfObject& resolved = lengthObj->type == PdfObject::Reference ? Resolve(*lengthObj) : *lengthObj;
+        if (resolved.IsNumber() && resolved.number >= 0 && start + static_cast<size_t>(resolved.number) <= data.size()) {
+            length = static_cast<size_t>(resolved.number);
+            PdfParser check(data.data(), data.size(), start + length);
+            check.SkipWhitespace();
+            lengthOk = data.compare(check.GetPosition(), 9, "endstream") == 0;
+        }
+    }
+
+    if (!lengthOk) {
+        // /Length mancante o errato: cerca endstream
+        size_t end = data.find("endstream", start);
+        if (end == std::string::npos) {
+            end = data.size();
+        }
+        if (end > start && data[end - 1] == '\n') end--;
+        if (end > start && data[end - 1] == '\r') end--;
+        length = end - start;
+    }
+
+    obj.type = PdfObject::Stream;
+    obj.streamOffset = start;
+    obj.streamLength = length;
+    return true;
+}
+
+bool PdfDocument::LoadFromObjectStream(int streamNum, uint32_t index, PdfObject& obj) {
+    auto it = objectStreams.find(streamNum);
+    if (it == objectStreams.end()) {
+        ObjectStream os;
+        PdfObject ref;
+        ref.type = PdfObject::Reference;
+        ref.objNum = streamNum;
+        const PdfObject& stream = Resolve(ref);
+        if (stream.type == PdfObject::Stream && GetStreamData(stream, os.data)) {
+            const PdfObject* count = stream.Get("N");
+            const PdfObject* first = stream.Get("First");
+            if (count && first && count->IsNumber() && first->IsNumber()) {
+                PdfParser parser(os.data.data(), os.data.size());
+                for (int i = 0; i < count->AsInt(); i++) {
+                    PdfObject num, offset;
+                    if (!parser.ReadObject(num) || !parser.ReadObject(offset)) break;
+                    os.offsets.push_back(static_cast<size_t>(first->number + offset.number));
+                }
+            }
+        }
+        it = objectStreams.emplace(streamNum, std::move(os)).first;
+    }
+
+    const ObjectStream& os = it->second;
+    if (index >= os.offsets.size()) {
+        return false;
+    }
+    PdfParser parser(os.data.data(), os.data.size(), os.offsets[index]);
+    return parser.ReadObject(obj);
+}
+
+const PdfObject& PdfDocument::Resolve(const PdfObject& obj) {
+    if (obj.type != PdfObject::Reference) {
+        return obj;
+    }
+
+    int num = obj.objNum;
+    if (num <= 0 || static_cast<size_t>(num) >= xref.size()) {
+        return NULL_OBJECT;
+    }
+
+    auto it = cache.find(num);
+    if (it != cache.end()) {
+        return it->second;
+    }
+
+    // Segnaposto: un riferimento ciclico durante il parsing risolve a Null
+    PdfObject& slot = cache[num];
+
+    PdfObject parsed;
+    const XrefEntry& entry = xref[num];
+    if (entry.type == 1) {
+        ParseIndirect(static_cast<size_t>(entry.offset), parsed);
+    } else if (entry.type == 2 && static_cast<int>(entry.offset) != num) {
+        LoadFromObjectStream(static_cast<int>(entry.offset), entry.index, parsed);
+    }
+
+    slot = std::move(parsed);
+    return slot;
+}
+
+const PdfObject& PdfDocument::GetResolved(const PdfObject& dict, const char* key) {
+    const PdfObject* value = dict.Get(key);
+    return value ? Resolve(*value) : NULL_OBJECT;
+}
+
+bool PdfDocument::GetStreamData(const PdfObject& stream, std::string& out) {
+    if (stream.type != PdfObject::Stream || stream.streamOffset + stream.streamLength > data.size()) {
+        return false;
+    }
+
+    out.assign(data, stream.streamOffset, stream.streamLength);
+
+    const PdfObject& filter = GetResolved(stream, "Filter");
+    const PdfObject& parms = GetResolved(stream, "DecodeParms");
+
+    std::vector<const PdfObject*> filters, params;
+    if (filter.type == PdfObject::Name) {
+        filters.push_back(&filter);
+        params.push_back(parms.IsDict() ? &parms : nullptr);
+    } else if (filter.type == PdfObject::Array) {
+        for (size_t i = 0; i < filter.items.size(); i++) {
+            filters.push_back(&Resolve(filter.items[i]));
+            const PdfObject* p = nullptr;
+            if (parms.type == PdfObject::Array && i < parms.items.size()) {
+                const PdfObject& item = Resolve(parms.items[i]);
+                p = item.IsDict() ? &item : nullptr;
+            }
+            params.push_back(p);
+        }
+    }
+
+    std::string decoded;
+    for (size_t i = 0; i < filters.size(); i++) {
+        const std::string& name = filters[i]->text;
+        bool ok;
+        if (name == "FlateDecode" || name == "Fl") {
+            ok = FlateDecode(out, decoded) && ApplyPredictor(decoded, params[i]);
+        } else if (name == "ASCIIHexDecode" || name == "AHx") {
+            ok = AsciiHexDecode(out, decoded);
+        } else if (name == "ASCII85Decode" || name == "A85") {
+            ok = Ascii85Decode(out, decoded);
+        } else if (name == "LZWDecode" || name == "LZW") {
+            const PdfObject* early = params[i] ? params[i]->Get("EarlyChange") : nullptr;
+            ok = LzwDecode(out, decoded, early && early->IsNumber() ? early->AsInt() : 1) &&
+                 ApplyPredictor(decoded, params[i]);
+        } else if (name == "RunLengthDecode" || name == "RL") {
+            ok = RunLengthDecode(out, decoded);
+        } else {
+            // Filtri per immagini (DCT, JBIG2, CCITT, ...): non servono per il testo
+            ok = false;
+        }
+        if (!ok) {
+            return false;
+        }
+        out.swap(decoded);
+    }
+
+    return true;
+}
+
+void PdfDocument::CollectPages(const PdfObject& node, const PdfObject* resources,
+                               const double* mediaBox, int rotate, int depth) {
+    if (!node.IsDict() || depth > MAX_NESTING) {
+        return;
+    }
+
+    const PdfObject& res = GetResolved(node, "Resources");
+    if (res.IsDict()) {
+        resources = &res;
+    }
+
+    double box[4] = { mediaBox[0], mediaBox[1], mediaBox[2], mediaBox[3] };
+    const PdfObject& mb = GetResolved(node, "MediaBox");
+    if (mb.type == PdfObject::Array && mb.items.size() >= 4) {
+        for (int i = 0; i < 4; i++) {
+            box[i] = Resolve(mb.items[i]).number;
+        }
+        if (box[0] > box[2]) std::swap(box[0], box[2]);
+        if (box[1] > box[3]) std::swap(box[1], box[3]);
+    }
+
+    const PdfObject& rot = GetResolved(node, "Rotate");
+    if (rot.IsNumber()) {
+        rotate = ((rot.AsInt() % 360) + 360) % 360;
+    }
+
+    const PdfObject& kids = GetResolved(node, "Kids");
+    const PdfObject* type = node.Get("Type");
+    if (kids.type == PdfObject::Array && !(type && type->IsName("Page"))) {
+        for (const auto& kid : kids.items) {
+            CollectPages(Resolve(kid), resources, box, rotate, depth + 1);
+        }
+        return;
+    }
+
+    PdfPage page;
+    page.dict = &node;
+    page.resources = resources;
+    memcpy(page.mediaBox, box, sizeof(box));
+    page.rotate = rotate;
+    pages.push_back(page);
+}
@@ -0,0 +1,144 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+// Oggetto PDF (ISO 32000-1, 7.3). Stringhe e nomi conservano i byte grezzi;
+// gli stream riferiscono i dati non decodificati all'interno del file.
+struct PdfObject {
+    enum Type { Null, Boolean, Number, String, Name, Array, Dictionary, Stream, Reference, Operator };
+
+    Type type = Null;
+    double number = 0;                  // Number, Boolean (0/1)
+    std::string text;                   // String, Name (senza '/'), Operator
+    std::vector<PdfObject> items;       // Array
+    std::vector<std::string> keys;      // Dictionary, Stream
+    std::vector<PdfObject> values;
+    int objNum = 0;                     // Reference
+    int genNum = 0;
+    size_t streamOffset = 0;            // Stream: posizione e lunghezza dei dati grezzi
+    size_t streamLength = 0;
+
+    // Voce del dizionario (senza risolvere i riferimenti), nullptr se assente
+    const PdfObject* Get(const char* key) const;
+
+    bool IsNumber() const { return type == Number; }
+    bool IsName(const char* name) const { return type == Name && text == name; }
+    bool IsDict() const { return type == Dictionary || type == Stream; }
+    int AsInt() const { return static_cast<int>(number); }
+};
+
+// Tokenizzatore e parser di oggetti su un buffer in memoria: usato per il
+// file, gli object stream, i content stream e le CMap
+class PdfParser {
+public:
+    PdfParser(const char* data, size_t size, size_t pos = 0);
+
+    // Legge il prossimo oggetto. Le parole chiave non riconosciute (operatori
+    // dei content stream, "obj", "stream", ...) vengono restituite come Operator.
+    // Restituisce false a fine buffer
+    bool ReadObject(PdfObject& obj);
+
+    // Salta i dati di un'immagine inline (dopo l'operatore ID) fino a EI
+    void SkipInlineImage();
+
+    void SkipWhitespace();
+    size_t GetPosition() const { return pos; }
+    void SetPosition(size_t p) { pos = p < size ? p : size; }
+
+private:
+    bool ReadToken(PdfObject& token, bool& isDelimiter);
+    bool ReadValue(PdfObject& obj, PdfObject& token, bool isDelimiter);
+    bool PeekReference(int& gen, size_t& after) const;
+    void ReadLiteralString(std::string& out);
+    void ReadHexString(std::string& out);
+    void ReadName(std::string& out);
+
+    const char* data;
+    size_t size;
+    size_t pos;
+    int depth;
+};
+
+// Pagina del documento con gli attributi ereditati dall'albero delle pagine
+struct PdfPage {
+    const PdfObject* dict;
+    const PdfObject* resources;
+    double mediaBox[4];     // x0, y0, x1, y1
+    int rotate;             // 0, 90, 180, 270
+};
+
+// Documento PDF in memoria: tabella xref (classica, stream e catene /Prev),
+// object stream, filtri di decodifica e albero delle pagine.
+// Un'istanza non e' condivisa tra thread.
+class PdfDocument {
+public:
+    PdfDocument();
+
+    // Carica e indicizza il file. Restituisce false se il file non e' leggibile,
+    // e' cifrato o la struttura non e' recuperabile
+    bool Open(const std::wstring& path);
+
+    // Come Open, su un buffer gia' in memoria
+    bool Load(std::string bytes);
+
+    // Come Load, senza copia: i byte (es. un file mappato) devono restare
+    // validi finche' l'istanza e' in uso. Con collectPages = false vengono
+    // letti solo xref e trailer, senza visitare l'albero delle pagine
+    bool LoadView(std::string_view bytes, bool collectPages = true);
+
+    // Risolve un riferimento indiretto (gli altri oggetti sono restituiti invariati)
+    const PdfObject& Resolve(const PdfObject& obj);
+
+    // Voce di dizionario con riferimento risolto (Null se assente)
+    const PdfObject& GetResolved(const PdfObject& dict, const char* key);
+
+    // Decodifica i dati di uno stream applicando i filtri dichiarati
+    bool GetStreamData(const PdfObject& stream, std::string& out);
+
+    const std::vector<PdfPage>& GetPages() const { return pages; }
+    int GetPageCount() const { return static_cast<int>(pages.size()); }
+
+    const PdfObject& GetTrailer() const { return trailer; }
+
+    // Byte del file, invariati dopo il caricamento: un'altra istanza puo'
+    // caricarli con LoadView per elaborare pagine in parallelo su un altro thread
+    std::string_view GetBytes() const { return data; }
+
+    std::wstring GetLastError() const { return lastError; }
+
+private:
+    struct XrefEntry {
+        uint8_t type;       // 0 = libero, 1 = nel file, 2 = in un object stream
+        uint64_t offset;    // tipo 1: posizione; tipo 2: numero dell'object stream
+        uint32_t index;     // tipo 2: indice nell'object stream
+    };
+
+    struct ObjectStream {
+        std::string data;
+        std::vector<size_t> offsets;    // Posizione di ogni oggetto nei dati decodificati
+    };
+
+    bool Index(std::string_view bytes, bool collectPages);
+    bool ReadXref(size_t offset);
+    bool ReadXrefTable(PdfParser& parser);
+    bool ReadXrefStream(const PdfObject& stream);
+    bool RebuildXref();
+    void SetEntry(size_t num, const XrefEntry& entry);
+    bool ParseIndirect(size_t offset, PdfObject& obj);
+    bool LoadFromObjectStream(int streamNum, uint32_t index, PdfObject& obj);
+    void CollectPages(const PdfObject& node, const PdfObject* resources,
+                      const double* mediaBox, int rotate, int depth);
+
+    std::string storage;        // Byte posseduti dall'istanza (Open, Load)
+    std::string_view data;      // Byte del file: storage o buffer esterno
+    std::vector<XrefEntry> xref;
+    std::vector<bool> xrefSeen;
+    PdfObject trailer;
+    std::unordered_map<int, PdfObject> cache;
+    std::unordered_map<int, ObjectStream> objectStreams;
+    std::vector<PdfPage> pages;
+    std::wstring lastError;
+};
@@ -1,15 +1,21 @@
 #include "PdfExtractor.h"
+#include "PdfTextEngine.h"
+#include "PdfInfo.h"
+#include "PositionedText.h"
+#include "Subprocess.h"
+#include "PythonWorkerPool.h"
+#include "ProcessExecutor.h"
 #include "Config.h"
-#include <Windows.h>
-#include <fstream>
 #include <sstream>
+#include <algorithm>
 #include <filesystem>
-#include <iomanip>
+#include <thread>
+#include <atomic>
 
-std::wstring PdfExtractor::lastError;
+thread_local std::wstring PdfExtractor::lastError;
 
 bool PdfExtractor::IsAvailable() {
-    std::wstring pdftotextPath = Config::pdftotextPath;
+    std::wstring pdftotextPath = Config::Get()->pdftotextPath;
 
     // Se e' un percorso relativo, cerca nella directory dell'eseguibile
     if (pdftotextPath.find(L'\\') == std::wstring::npos &&
@@ -24,144 +30,351 @@ std::wstring PdfExtractor::GetLastError() {
     return lastError;
 }
 
-// Converte UTF-8 in wstring usando API Windows
-static std::wstring Utf8ToWstring(const std::string& utf8) {
-    if (utf8.empty()) return std::wstring();
-    int size = MultiByteToWideChar(CP_UTF8, 0, utf8.c_str(), (int)utf8.size(), NULL, 0);
-    std::wstring result(size, 0);
-    MultiByteToWideChar(CP_UTF8, 0, utf8.c_str(), (int)utf8.size(), &result[0], size);
-    return result;
-}
-
-// Metodo privato per eseguire pdftotext con argomenti personalizzati
-std::wstring PdfExtractor::ExecutePdftotext(const std::wstring& pdfPath, const std::wstring& additionalArgs) {
+// Percorso di pdftotext e argomenti completi. L'output ("-" come file di
+// destinazione) arriva direttamente dalla pipe
+bool PdfExtractor::PreparePdftotext(const std::wstring& pdfPath, const std::vector<std::wstring>& additionalArgs,
+                                    std::wstring& program, std::vector<std::wstring>& args) {
     lastError.clear();
 
     // Verifica che il file PDF esista
     if (!std::filesystem::exists(pdfPath)) {
         lastError = L"File PDF non trovato: " + pdfPath;
-        return L"";
+        return false;
     }
 
     // Costruisci il percorso di pdftotext
-    std::wstring pdftotextPath = Config::pdftotextPath;
-    if (pdftotextPath.find(L'\\') == std::wstring::npos &&
-        pdftotextPath.find(L'/') == std::wstring::npos) {
-        pdftotextPath = Config::GetExecutableDir() + L"\\" + pdftotextPath;
+    program = Config::Get()->pdftotextPath;
+    if (program.find(L'\\') == std::wstring::npos &&
+        program.find(L'/') == std::wstring::npos) {
+        program = Config::GetExecutableDir() + L"\\" + program;
     }
 
-    if (!std::filesystem::exists(pdftotextPath)) {
+    if (!std::filesystem::exists(program)) {
         lastError = L"pdftotext.exe non trovato. Scaricarlo da https://www.xpdfreader.com/download.html";
+        return false;
+    }
+
+    args = { L"-enc", L"UTF-8" };
+    args.insert(args.end(), additionalArgs.begin(), additionalArgs.end());
+    args.push_back(pdfPath);
+    args.push_back(L"-");
+    return true;
+}
+
+std::wstring PdfExtractor::PdftotextOutput(Subprocess::Result& run) {
+    if (!run.started) {
+        lastError = L"Impossibile avviare pdftotext.exe";
         return L"";
     }
 
-    // File temporaneo per l'output
-    wchar_t tempPath[MAX_PATH];
-    wchar_t tempFile[MAX_PATH];
-    GetTempPathW(MAX_PATH, tempPath);
-    GetTempFileNameW(tempPath, L"mre", 0, tempFile);
+    if (run.timedOut) {
+        lastError = run.error;
+        return L"";
+    }
 
-    std::wstring outputFile = std::wstring(tempFile) + L".txt";
-    DeleteFileW(tempFile); // Rimuovi il file temp creato da GetTempFileName
+    if (run.exitCode != 0) {
+        lastError = L"pdftotext ha restituito errore: " + std::to_wstring(run.exitCode);
+        return L"";
+    }
 
-    // Costruisci il comando
-    std::wstring cmdLine = L"\"" + pdftotextPath + L"\" -enc UTF-8 " + additionalArgs +
-                          L" \"" + pdfPath + L"\" \"" + outputFile + L"\"";
+    return std::move(run.output);
+}
 
-    // Esegui pdftotext
-    STARTUPINFOW si = { sizeof(si) };
-    si.dwFlags = STARTF_USESHOWWINDOW;
-    si.wShowWindow = SW_HIDE;
+std::wstring PdfExtractor::ExecutePdftotext(const std::wstring& pdfPath, const std::vector<std::wstring>& additionalArgs) {
+    std::wstring program;
+    std::vector<std::wstring> args;
+    if (!PreparePdftotext(pdfPath, additionalArgs, program, args)) {
+        return L"";
+    }
 
-    PROCESS_INFORMATION pi;
+    // Esegui pdftotext (max 30 secondi)
+    Subprocess::Result run = Subprocess::Run(program, args, std::string(), std::chrono::milliseconds(30000));
+    return PdftotextOutput(run);
+}
 
-    std::vector<wchar_t> cmdBuffer(cmdLine.begin(), cmdLine.end());
-    cmdBuffer.push_back(0);
+// Thread per l'estrazione a pagine in parallelo di un documento di pageCount
+// pagine (1 = estrazione seriale)
+static unsigned PageWorkers(int pageCount) {
+    std::shared_ptr<const Config::Settings> config = Config::Get();
+    if (config->parallelPageThreshold == 0 || pageCount < static_cast<int>(config->parallelPageThreshold)) {
+        return 1;
+    }
+    unsigned workers = config->parallelPageThreads > 0 ? config->parallelPageThreads
+                                                       : std::thread::hardware_concurrency();
+    return std::max(1u, std::min(workers, static_cast<unsigned>(pageCount)));
+}
 
-    BOOL success = CreateProcessW(
-        NULL,
-        cmdBuffer.data(),
-        NULL,
-        NULL,
-        FALSE,
-        CREATE_NO_WINDOW,
-        NULL,
-        NULL,
-        &si,
-        &pi
-    );
+bool PdfExtractor::ExtractNative(const std::wstring& pdfPath, int firstPage, int lastPage, std::wstring& text) {
+    lastError.clear();
+    text.clear();
 
-    if (!success) {
-        lastError = L"Impossibile avviare pdftotext.exe";
-        return L"";
+    PdfDocument doc;
+    if (!doc.Open(pdfPath)) {
+        lastError = doc.GetLastError();
+        return false;
     }
 
-    // Attendi il completamento (max 30 secondi)
-    WaitForSingleObject(pi.hProcess, 30000);
+    int last = doc.GetPageCount();
+    if (lastPage > 0 && lastPage < last) {
+        last = lastPage;
+    }
+    int first = std::max(firstPage, 1) - 1;
+    int count = std::max(last - first, 0);
+
+    unsigned workers = PageWorkers(count);
+    if (workers <= 1) {
+        PdfTextEngine engine(doc);
+        for (int i = first; i < last; i++) {
+            PdfPageText page;
+            if (!engine.ExtractPage(i, page)) {
+                lastError = engine.GetLastError();
+                return false;
+            }
+            text += PdfTextEngine::Layout(page);
+            text += L'\f';
+        }
+        return true;
+    }
 
-    DWORD exitCode;
-    GetExitCodeProcess(pi.hProcess, &exitCode);
+    // Pagine in parallelo: PdfDocument non e' condivisibile, ogni thread
+    // indicizza la propria istanza sugli stessi byte, senza copiarli. Le pagine
+    // vengono prese una alla volta (costo molto variabile tra pagine) e
+    // ricomposte in ordine
+    std::vector<std::wstring> pageTexts(count);
+    std::vector<std::wstring> errors(workers);
+    std::atomic<int> next(0);
+
+    auto extractPages = [&](unsigned worker, PdfDocument& source) {
+        PdfTextEngine engine(source);
+        for (int i = next++; i < count; i = next++) {
+            PdfPageText page;
+            if (!engine.ExtractPage(first + i, page)) {
+                errors[worker] = engine.GetLastError();
+                next = count;
+                return;
+            }
+            pageTexts[i] = PdfTextEngine::Layout(page);
+            pageTexts[i] += L'\f';
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned w = 1; w < workers; w++) {
+        threads.emplace_back([&, w]() {
+            PdfDocument copy;
+            if (!copy.LoadView(doc.GetBytes())) {
+                errors[w] = copy.GetLastError();
+                next = count;
+                return;
+            }
+            extractPages(w, copy);
+        });
+    }
+    extractPages(0, doc);
+    for (auto& thread : threads) {
+        thread.join();
+    }
 
-    CloseHandle(pi.hProcess);
-    CloseHandle(pi.hThread);
+    for (const auto& error : errors) {
+        if (!error.empty()) {
+            lastError = error;
+            return false;
+        }
+    }
 
-    if (exitCode != 0) {
-        lastError = L"pdftotext ha restituito errore: " + std::to_wstring(exitCode);
-        DeleteFileW(outputFile.c_str());
-        return L"";
+    size_t length = 0;
+    for (const auto& pageText : pageTexts) {
+        length += pageText.size();
+    }
+    text.reserve(length);
+    for (const auto& pageText : pageTexts) {
+        text += pageText;
     }
+    return true;
+}
 
-    // Leggi il file di output come bytes UTF-8
-    std::ifstream file(outputFile, std::ios::binary);
-    if (!file.is_open()) {
-        lastError = L"Impossibile leggere il file di output";
-        DeleteFileW(outputFile.c_str());
-        return L"";
+bool PdfExtractor::ExtractZonesNative(const std::wstring& pdfPath, const std::vector<PdfZone>& zones,
+                                      std::vector<std::wstring>& texts) {
+    lastError.clear();
+    texts.assign(zones.size(), std::wstring());
+
+    PdfDocument doc;
+    if (!doc.Open(pdfPath)) {
+        lastError = doc.GetLastError();
+        return false;
     }
 
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    file.close();
+    int pageCount = doc.GetPageCount();
+    for (const auto& zone : zones) {
+        if (zone.page > pageCount) {
+            lastError = L"Pagina " + std::to_wstring(zone.page) + L" non presente nel PDF";
+            return false;
+        }
+    }
 
-    // Rimuovi il file temporaneo
-    DeleteFileW(outputFile.c_str());
+    // Parole per pagina, calcolate solo per le pagine richieste da almeno una zona
+    std::vector<std::vector<PdfWord>> pageWords(pageCount);
+    std::vector<bool> loaded(pageCount, false);
+    PdfTextEngine engine(doc);
+
+    for (size_t z = 0; z < zones.size(); z++) {
+        const PdfZone& zone = zones[z];
+
+        // Stessa convenzione di pdftotext: coordinate intere, origine in alto a sinistra
+        PdfCropBox crop = {
+            static_cast<double>(static_cast<int>(zone.x)),
+            static_cast<double>(static_cast<int>(zone.y)),
+            static_cast<double>(static_cast<int>(zone.width)),
+            static_cast<double>(static_cast<int>(zone.height))
+        };
+
+        int first = zone.page > 0 ? zone.page - 1 : 0;
+        int last = zone.page > 0 ? zone.page - 1 : pageCount - 1;
+        for (int i = first; i <= last; i++) {
+            if (!loaded[i]) {
+                PdfPageText page;
+                if (!engine.ExtractPage(i, page)) {
+                    lastError = engine.GetLastError();
+                    return false;
+                }
+                pageWords[i] = PdfTextEngine::BuildWords(page);
+                loaded[i] = true;
+            }
+            texts[z] += PdfTextEngine::Layout(pageWords[i], &crop);
+            texts[z] += L'\f';
+        }
+    }
 
-    // Converti UTF-8 in wstring
-    return Utf8ToWstring(buffer.str());
+    return true;
+}
+
+// Testo senza caratteri stampabili (solo spazi e separatori di pagina)
+static bool IsBlankText(const std::wstring& text) {
+    return text.find_first_not_of(L" \t\r\n\f") == std::wstring::npos;
 }
 
 std::wstring PdfExtractor::Extract(const std::wstring& pdfPath) {
+    return ExtractPages(pdfPath, 1, 0);
+}
+
+std::wstring PdfExtractor::ExtractPages(const std::wstring& pdfPath, int firstPage, int lastPage) {
+    if (Config::Get()->nativePdfEngine) {
+        std::wstring text;
+        // Testo vuoto: nessuna pagina nell'intervallo (un '\f' per ogni pagina estratta)
+        if (ExtractNative(pdfPath, firstPage, lastPage, text) &&
+            (text.empty() || !IsBlankText(text) || !IsAvailable())) {
+            return text;
+        }
+    }
+
+    // Documento lungo: intervalli di pagine su piu' processi pdftotext. Il
+    // numero di pagine viene dall'indice del PDF (nessun passaggio da pdfinfo)
+    PdfInfo::Info info;
+    int last = 0;
+    if (PdfInfo::Read(pdfPath, info)) {
+        last = info.pageCount;
+        if (lastPage > 0 && lastPage < last) {
+            last = lastPage;
+        }
+    }
+    int first = std::max(firstPage, 1);
+    int count = std::max(last - first + 1, 0);
+
+    // Intervallo oltre l'ultima pagina (es. pagine dalla 2 di un referto di
+    // una pagina): nessun testo, e pdftotext rifiuterebbe l'intervallo
+    if (last > 0 && count == 0) {
+        lastError.clear();
+        return L"";
+    }
+    unsigned workers = PageWorkers(count);
+
+    if (workers > 1) {
+        // Tutti gli intervalli vengono accodati all'esecutore dei processi e
+        // raccolti in ordine
+        std::vector<std::future<Subprocess::Result>> runs;
+        for (unsigned w = 0; w < workers; w++) {
+            int rangeFirst = first + static_cast<int>(static_cast<long long>(count) * w / workers);
+            int rangeLast = first + static_cast<int>(static_cast<long long>(count) * (w + 1) / workers) - 1;
+
+            std::wstring program;
+            std::vector<std::wstring> args;
+            if (!PreparePdftotext(pdfPath, { L"-layout", L"-f", std::to_wstring(rangeFirst),
+                                             L"-l", std::to_wstring(rangeLast) }, program, args)) {
+                break;
+            }
+            runs.push_back(ProcessExecutor::RunAsync(program, args, std::string(), std::chrono::milliseconds(30000)));
+        }
+
+        std::wstring text;
+        std::wstring error = lastError;
+        for (auto& pending : runs) {
+            Subprocess::Result run = pending.get();
+            text += PdftotextOutput(run);
+            if (error.empty()) {
+                error = lastError;
+            }
+        }
+        lastError = error;
+        return error.empty() ? text : std::wstring();
+    }
+
     // Usa -layout per mantenere il layout originale
-    return ExecutePdftotext(pdfPath, L"-layout");
+    std::vector<std::wstring> args = { L"-layout" };
+    if (firstPage > 1) {
+        args.insert(args.end(), { L"-f", std::to_wstring(firstPage) });
+    }
+    if (lastPage > 0) {
+        args.insert(args.end(), { L"-l", std::to_wstring(lastPage) });
+    }
+    return ExecutePdftotext(pdfPath, args);
 }
 
 std::wstring PdfExtractor::ExtractZone(const std::wstring& pdfPath, const PdfZone& zone) {
+    if (Config::Get()->nativePdfEngine) {
+        std::vector<std::wstring> texts;
+        if (ExtractZonesNative(pdfPath, { zone }, texts)) {
+            return texts[0];
+        }
+    }
+
+    return ExecuteZonePdftotext(pdfPath, zone);
+}
+
+std::wstring PdfExtractor::ExecuteZonePdftotext(const std::wstring& pdfPath, const PdfZone& zone) {
     // Costruisci gli argomenti per l'estrazione della zona
     // pdftotext usa: -x X -y Y -W width -H height -f firstPage -l lastPage
     // Le coordinate sono in punti PDF (72 punti = 1 pollice)
     // pdftotext usa origine in alto-sinistra
 
-    std::wostringstream args;
-    args << std::fixed << std::setprecision(0);
-    args << L"-x " << static_cast<int>(zone.x)
-         << L" -y " << static_cast<int>(zone.y)
-         << L" -W " << static_cast<int>(zone.width)
-         << L" -H " << static_cast<int>(zone.height);
+    std::vector<std::wstring> args = {
+        L"-x", std::to_wstring(static_cast<int>(zone.x)),
+        L"-y", std::to_wstring(static_cast<int>(zone.y)),
+        L"-W", std::to_wstring(static_cast<int>(zone.width)),
+        L"-H", std::to_wstring(static_cast<int>(zone.height))
+    };
 
     if (zone.page > 0) {
-        args << L" -f " << zone.page << L" -l " << zone.page;
+        args.insert(args.end(), { L"-f", std::to_wstring(zone.page), L"-l", std::to_wstring(zone.page) });
     }
 
-    args << L" -layout";
+    args.push_back(L"-layout");
 
-    return ExecutePdftotext(pdfPath, args.str());
+    return ExecutePdftotext(pdfPath, args);
 }
 
 std::wstring PdfExtractor::ExtractZones(const std::wstring& pdfPath, const std::vector<PdfZone>& zones) {
-    std::wstring result;
+    // Un solo passaggio sul PDF per tutte le zone; pdftotext (un processo per
+    // zona) solo se il motore nativo non gestisce il file
+    std::vector<std::wstring> texts;
+    if (!Config::Get()->nativePdfEngine || !ExtractZonesNative(pdfPath, zones, texts)) {
+        texts.clear();
+        for (const auto& zone : zones) {
+            texts.push_back(ExecuteZonePdftotext(pdfPath, zone));
+        }
+    }
 
-    for (size_t i = 0; i < zones.size(); i++) {
-        std::wstring zoneText = ExtractZone(pdfPath, zones[i]);
+    std::wstring result;
+    for (const auto& zoneText : texts) {
         if (!zoneText.empty()) {
             if (!result.empty()) {
                 result += L"\n";
@@ -173,31 +386,117 @@ std::wstring PdfExtractor::ExtractZones(const std::wstring& pdfPath, const std::
     return result;
 }
 
-bool PdfExtractor::IsPythonAvailable() {
-    // Verifica se Python è disponibile eseguendo "python --version"
-    STARTUPINFOW si = { sizeof(si) };
-    si.dwFlags = STARTF_USESHOWWINDOW;
-    si.wShowWindow = SW_HIDE;
+bool PdfExtractor::ExtractPositioned(const std::wstring& pdfPath, PositionedText& words, int lastPage,
+                                     std::wstring* layoutText) {
+    words.Clear();
+    if (!ExtractPositionedPages(pdfPath, words, 1, lastPage, layoutText)) {
+        words.Clear();
+        return false;
+    }
+    return true;
+}
 
-    PROCESS_INFORMATION pi;
-    std::wstring cmdLine = L"python --version";
-    std::vector<wchar_t> cmdBuffer(cmdLine.begin(), cmdLine.end());
-    cmdBuffer.push_back(0);
+bool PdfExtractor::ExtractPositionedPages(const std::wstring& pdfPath, PositionedText& words,
+                                          int firstPage, int lastPage, std::wstring* layoutText) {
+    int first = std::max(firstPage, 1);
+    if (layoutText) {
+        layoutText->clear();
+    }
 
-    BOOL success = CreateProcessW(
-        NULL, cmdBuffer.data(), NULL, NULL, FALSE,
-        CREATE_NO_WINDOW, NULL, NULL, &si, &pi
-    );
+    if (Config::Get()->nativePdfEngine) {
+        lastError.clear();
+
+        // Le parole passano in words solo a estrazione riuscita: in caso di
+        // errore si riprova con pdftotext sulle stesse pagine
+        struct Page {
+            double width;
+            double height;
+            std::vector<PdfWord> words;
+        };
+        std::vector<Page> extracted;
+
+        PdfDocument doc;
+        bool success = doc.Open(pdfPath);
+        if (success) {
+            PdfTextEngine engine(doc);
+            int pageCount = doc.GetPageCount();
+            if (lastPage > 0 && lastPage < pageCount) {
+                pageCount = lastPage;
+            }
+            for (int i = first - 1; i < pageCount; i++) {
+                PdfPageText page;
+                if (!engine.ExtractPage(i, page)) {
+                    lastError = engine.GetLastError();
+                    success = false;
+                    break;
+                }
+                extracted.push_back({ page.width, page.height, PdfTextEngine::BuildWords(page) });
+            }
+        } else {
+            lastError = doc.GetLastError();
+        }
 
-    if (!success) return false;
+        if (success) {
+            std::wstring text;
+            for (const auto& page : extracted) {
+                // Riquadro approssimato dalla linea di base e dal corpo
+                words.AddPage(page.width, page.height);
+                for (const auto& word : page.words) {
+                    words.AddWord(word.x0, word.baseline - 0.8 * word.fontSize,
+                                  word.x1, word.baseline + 0.2 * word.fontSize, word.text);
+                }
+                if (layoutText) {
+                    text += PdfTextEngine::Layout(page.words);
+                    text += L'\f';
+                }
+            }
+            words.BuildIndex();
+
+            // Stesso criterio di ExtractPages: il testo vuoto di un motore
+            // nativo si rilegge con pdftotext, quindi qui non vale
+            if (layoutText && (text.empty() || !IsBlankText(text) || !IsAvailable())) {
+                *layoutText = std::move(text);
+            }
+            return true;
+        }
+    }
 
-    WaitForSingleObject(pi.hProcess, 5000);
-    DWORD exitCode;
-    GetExitCodeProcess(pi.hProcess, &exitCode);
-    CloseHandle(pi.hProcess);
-    CloseHandle(pi.hThread);
+    // pdftotext rifiuta un intervallo che inizia oltre l'ultima pagina
+    if (first > 1) {
+        int pageCount = GetPageCount(pdfPath);
+        if (pageCount >= 0 && first > pageCount) {
+            lastError.clear();
+            return true;
+        }
+    }
 
-    return exitCode == 0;
+    std::vector<std::wstring> args = { L"-bbox-layout" };
+    if (first > 1) {
+        args.insert(args.end(), { L"-f", std::to_wstring(first) });
+    }
+    if (lastPage > 0) {
+        args.insert(args.end(), { L"-l", std::to_wstring(lastPage) });
+    }
+    // -bbox-layout esiste solo nel pdftotext di Poppler: quello di Xpdf
+    // rifiuta l'opzione e non produce pagine
+    std::wstring xhtml = ExecutePdftotext(pdfPath, args);
+    if (xhtml.find(L"<page ") == std::wstring::npos) {
+        std::wstring detail = lastError.empty() ? L"nessuna pagina nell'output" : lastError;
+        lastError = L"parole posizionate non disponibili, serve pdftotext di Poppler (-bbox-layout): " + detail;
+        return false;
+    }
+    if (!words.ParseBBoxLayout(xhtml)) {
+        lastError = L"Output di pdftotext -bbox-layout non valido";
+        return false;
+    }
+    return true;
+}
+
+bool PdfExtractor::IsPythonAvailable() {
+    // Verifica se Python è disponibile eseguendo "python --version"
+    Subprocess::Result run = Subprocess::Run(L"python", { L"--version" }, std::string(),
+                                             std::chrono::milliseconds(5000), 256);
+    return run.started && !run.timedOut && run.exitCode == 0;
 }
 
 std::wstring PdfExtractor::ExtractWithPython(const std::wstring& pdfPath, const std::wstring& profilePath) {
@@ -220,135 +519,71 @@ std::wstring PdfExtractor::ExtractWithPython(const std::wstring& pdfPath, const
         return L"";
     }
 
-    // File temporaneo per l'output
-    wchar_t tempPath[MAX_PATH];
-    wchar_t tempFile[MAX_PATH];
-    GetTempPathW(MAX_PATH, tempPath);
-    GetTempFileNameW(tempPath, L"pye", 0, tempFile);
-    std::wstring outputFile = std::wstring(tempFile);
-
-    // Costruisci il comando: python script.py pdf_path profile_path > output
-    std::wstring cmdLine = L"cmd /c python \"" + scriptPath + L"\" \"" + pdfPath +
-                          L"\" \"" + profilePath + L"\" > \"" + outputFile + L"\"";
-
-    STARTUPINFOW si = { sizeof(si) };
-    si.dwFlags = STARTF_USESHOWWINDOW;
-    si.wShowWindow = SW_HIDE;
-
-    PROCESS_INFORMATION pi;
-    std::vector<wchar_t> cmdBuffer(cmdLine.begin(), cmdLine.end());
-    cmdBuffer.push_back(0);
+    // Server persistenti gia' avviati: nessun avvio dell'interprete per PDF
+    if (PythonWorkerPool::IsRunning()) {
+        std::wstring text;
+        if (!PythonWorkerPool::Extract(pdfPath, profilePath, std::chrono::milliseconds(60000), text)) {
+            lastError = PythonWorkerPool::GetLastError();
+            return L"";
+        }
+        return text;
+    }
 
-    BOOL success = CreateProcessW(
-        NULL, cmdBuffer.data(), NULL, NULL, FALSE,
-        CREATE_NO_WINDOW, NULL, NULL, &si, &pi
-    );
+    // python script.py pdf_path profile_path, output dalla pipe (max 60 secondi per PDF grandi)
+    Subprocess::Result run = Subprocess::Run(L"python", { scriptPath, pdfPath, profilePath },
+                                             std::string(), std::chrono::milliseconds(60000));
 
-    if (!success) {
+    if (!run.started) {
         lastError = L"Impossibile avviare Python";
-        DeleteFileW(outputFile.c_str());
         return L"";
     }
 
-    // Attendi completamento (max 60 secondi per PDF grandi)
-    WaitForSingleObject(pi.hProcess, 60000);
-
-    DWORD exitCode;
-    GetExitCodeProcess(pi.hProcess, &exitCode);
-    CloseHandle(pi.hProcess);
-    CloseHandle(pi.hThread);
-
-    if (exitCode != 0) {
-        lastError = L"Script Python ha restituito errore: " + std::to_wstring(exitCode);
-        DeleteFileW(outputFile.c_str());
+    if (run.timedOut) {
+        lastError = Subprocess::GetLastError();
         return L"";
     }
 
-    // Leggi l'output
-    std::ifstream file(outputFile, std::ios::binary);
-    if (!file.is_open()) {
-        lastError = L"Impossibile leggere output Python";
-        DeleteFileW(outputFile.c_str());
+    if (run.exitCode != 0) {
+        lastError = L"Script Python ha restituito errore: " + std::to_wstring(run.exitCode);
         return L"";
     }
 
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    file.close();
-    DeleteFileW(outputFile.c_str());
-
-    return Utf8ToWstring(buffer.str());
+    return run.output;
 }
 
 int PdfExtractor::GetPageCount(const std::wstring& pdfPath) {
-    // pdftotext non ha un modo diretto per ottenere il numero di pagine
-    // Usiamo pdfinfo se disponibile, altrimenti proviamo a estrarre e contare i form feed
-    // Per ora restituiamo -1 se non disponibile
+    // Lettura diretta dell'indice del PDF; pdfinfo solo per i file che il
+    // lettore nativo non gestisce (es. cifrati), se distribuito
+    PdfInfo::Info info;
+    if (PdfInfo::Read(pdfPath, info)) {
+        return info.pageCount;
+    }
 
     std::wstring pdfinfoPath = Config::GetExecutableDir() + L"\\pdfinfo.exe";
     if (!std::filesystem::exists(pdfinfoPath)) {
-        // Fallback: non disponibile
+        lastError = PdfInfo::GetLastError();
         return -1;
     }
 
     // Esegui pdfinfo per ottenere il numero di pagine
-    wchar_t tempPath[MAX_PATH];
-    wchar_t tempFile[MAX_PATH];
-    GetTempPathW(MAX_PATH, tempPath);
-    GetTempFileNameW(tempPath, L"mpi", 0, tempFile);
-
-    std::wstring outputFile = std::wstring(tempFile);
-
-    std::wstring cmdLine = L"cmd /c \"\"" + pdfinfoPath + L"\" \"" + pdfPath + L"\" > \"" + outputFile + L"\"\"";
-
-    STARTUPINFOW si = { sizeof(si) };
-    si.dwFlags = STARTF_USESHOWWINDOW;
-    si.wShowWindow = SW_HIDE;
-
-    PROCESS_INFORMATION pi;
-
-    std::vector<wchar_t> cmdBuffer(cmdLine.begin(), cmdLine.end());
-    cmdBuffer.push_back(0);
-
-    BOOL success = CreateProcessW(
-        NULL,
-        cmdBuffer.data(),
-        NULL,
-        NULL,
-        FALSE,
-        CREATE_NO_WINDOW,
-        NULL,
-        NULL,
-        &si,
-        &pi
-    );
-
-    if (!success) {
-        DeleteFileW(outputFile.c_str());
+    Subprocess::Result run = Subprocess::Run(pdfinfoPath, { pdfPath }, std::string(),
+                                             std::chrono::milliseconds(10000), 4096);
+    if (!run.started || run.timedOut) {
         return -1;
     }
 
-    WaitForSingleObject(pi.hProcess, 10000);
-    CloseHandle(pi.hProcess);
-    CloseHandle(pi.hThread);
-
-    // Leggi l'output e cerca "Pages:"
-    std::ifstream file(outputFile);
-    if (!file.is_open()) {
-        DeleteFileW(outputFile.c_str());
-        return -1;
-    }
-
-    std::string line;
+    // Cerca "Pages:" nell'output
+    std::wistringstream output(run.output);
+    std::wstring line;
     int pageCount = -1;
-    while (std::getline(file, line)) {
-        if (line.find("Pages:") != std::string::npos) {
-            size_t colonPos = line.find(':');
-            if (colonPos != std::string::npos) {
-                std::string numStr = line.substr(colonPos + 1);
+    while (std::getline(output, line)) {
+        if (line.find(L"Pages:") != std::wstring::npos) {
+            size_t colonPos = line.find(L':');
+            if (colonPos != std::wstring::npos) {
+                std::wstring numStr = line.substr(colonPos + 1);
                 // Trim spaces
-                size_t start = numStr.find_first_not_of(" \t");
-                if (start != std::string::npos) {
+                size_t start = numStr.find_first_not_of(L" \t");
+                if (start != std::wstring::npos) {
                     numStr = numStr.substr(start);
                     try {
                         pageCount = std::stoi(numStr);
@@ -359,8 +594,5 @@ int PdfExtractor::GetPageCount(const std::wstring& pdfPath) {
         }
     }
 
-    file.close();
-    DeleteFileW(outputFile.c_str());
-
     return pageCount;
 }
@@ -1,6 +1,9 @@
 #pragma once
 #include <string>
 #include <vector>
+#include "Subprocess.h"
+
+class PositionedText;
 
 // Struttura per definire una zona di estrazione
 struct PdfZone {
@@ -13,10 +16,18 @@ struct PdfZone {
 
 class PdfExtractor {
 public:
-    // Estrae il testo da un file PDF usando pdftotext.exe (intero documento)
+    // Estrae il testo da un file PDF (intero documento, impaginato come -layout).
+    // Usa il motore nativo se abilitato, con pdftotext.exe come fallback.
+    // I documenti lunghi (Config::parallelPageThreshold) sono estratti a
+    // pagine in parallelo e ricomposti in ordine.
     // Restituisce il testo estratto o una stringa vuota in caso di errore
     static std::wstring Extract(const std::wstring& pdfPath);
 
+    // Come Extract, limitato alle pagine [firstPage, lastPage] (1-indexed,
+    // lastPage = 0: fino all'ultima). Le pagine sono separate da '\f', quindi
+    // il testo di intervalli consecutivi si concatena come quello completo
+    static std::wstring ExtractPages(const std::wstring& pdfPath, int firstPage, int lastPage);
+
     // Estrae il testo da una zona specifica di una pagina
     // Le coordinate sono in punti PDF (72 punti = 1 pollice)
     // page e' 1-indexed (1 = prima pagina)
@@ -25,10 +36,26 @@ public:
     // Estrae il testo da multiple zone
     static std::wstring ExtractZones(const std::wstring& pdfPath, const std::vector<PdfZone>& zones);
 
-    // Ottiene il numero di pagine del PDF
+    // Parole posizionate di tutto il documento con indice spaziale, per
+    // risolvere le zone dei profili senza rileggere il PDF. Motore nativo se
+    // abilitato, altrimenti pdftotext -bbox-layout. lastPage > 0 limita
+    // l'estrazione alle prime pagine (1-indexed, come ExtractPages).
+    // layoutText, se indicato, riceve dallo stesso passaggio il testo che
+    // ExtractPages darebbe per le stesse pagine; resta vuoto se le pagine
+    // sono state lette con pdftotext (il testo impaginato e' un'altra esecuzione)
+    static bool ExtractPositioned(const std::wstring& pdfPath, PositionedText& words, int lastPage = 0,
+                                  std::wstring* layoutText = nullptr);
+
+    // Come ExtractPositioned, ma aggiunge a words le pagine [firstPage, lastPage]:
+    // completa un documento di cui sono gia' state lette le prime pagine
+    static bool ExtractPositionedPages(const std::wstring& pdfPath, PositionedText& words,
+                                       int firstPage, int lastPage, std::wstring* layoutText = nullptr);
+
+    // Numero di pagine dall'indice del PDF (pdfinfo come ripiego), -1 se non determinabile
     static int GetPageCount(const std::wstring& pdfPath);
 
-    // Estrae testo usando PyMuPDF via script Python (piu' preciso per le zone)
+    // Estrae testo usando PyMuPDF via script Python (piu' preciso per le zone).
+    // Usa PythonWorkerPool se avviato, altrimenti un processo per PDF
     static std::wstring ExtractWithPython(const std::wstring& pdfPath, const std::wstring& profilePath);
 
     // Verifica se Python e PyMuPDF sono disponibili
@@ -41,6 +68,28 @@ public:
     static std::wstring GetLastError();
 
 private:
-    static std::wstring lastError;
-    static std::wstring ExecutePdftotext(const std::wstring& pdfPath, const std::wstring& additionalArgs);
+    static thread_local std::wstring lastError;  // Per thread: piu' worker estraggono in parallelo
+    static std::wstring ExecutePdftotext(const std::wstring& pdfPath, const std::vector<std::wstring>& additionalArgs);
+
+    // Percorso di pdftotext e argomenti completi per il PDF. Restituisce false
+    // se il PDF o pdftotext non esistono
+    static bool PreparePdftotext(const std::wstring& pdfPath, const std::vector<std::wstring>& additionalArgs,
+                                 std::wstring& program, std::vector<std::wstring>& args);
+
+    // Testo dall'esito di pdftotext, o stringa vuota con lastError impostato
+    static std::wstring PdftotextOutput(Subprocess::Result& run);
+
+    // pdftotext per una singola zona (-x -y -W -H)
+    static std::wstring ExecuteZonePdftotext(const std::wstring& pdfPath, const PdfZone& zone);
+
+    // Estrazione in-process (PdfDocument + PdfTextEngine), senza processi ne' file
+    // temporanei. Pagine come ExtractPages. Restituisce false se il PDF non e'
+    // gestibile dal motore nativo
+    static bool ExtractNative(const std::wstring& pdfPath, int firstPage, int lastPage, std::wstring& text);
+
+    // Tutte le zone in un solo passaggio: il PDF viene letto una volta, ogni
+    // pagina richiesta viene interpretata una volta e le zone sono ritagliate
+    // in memoria dalle stesse parole. texts[i] corrisponde a zones[i]
+    static bool ExtractZonesNative(const std::wstring& pdfPath, const std::vector<PdfZone>& zones,
+                                   std::vector<std::wstring>& texts);
 };
@@ -0,0 +1,637 @@
+#include "PdfFont.h"
+#include "PdfDocument.h"
+#include <algorithm>
+#include <cstdlib>
+
+// ============================================================================
+// Nomi dei glifi ed encoding standard (ISO 32000-1, allegato D)
+// ============================================================================
+
+static const char* const ASCII_NAMES[95] = {
+    "space", "exclam", "quotedbl", "numbersign", "dollar", "percent", "ampersand", "quotesingle",
+    "parenleft", "parenright", "asterisk", "plus", "comma", "hyphen", "period", "slash",
+    "zero", "one", "two", "three", "four", "five", "six", "seven", "eight", "nine",
+    "colon", "semicolon", "less", "equal", "greater", "question", "at",
+    "A", "B", "C", "D", "E", "F", "G", "H", "I", "J", "K", "L", "M",
+    "N", "O", "P", "Q", "R", "S", "T", "U", "V", "W", "X", "Y", "Z",
+    "bracketleft", "backslash", "bracketright", "asciicircum", "underscore", "grave",
+    "a", "b", "c", "d", "e", "f", "g", "h", "i", "j", "k", "l", "m",
+    "n", "o", "p", "q", "r", "s", "t", "u", "v", "w", "x", "y", "z",
+    "braceleft", "bar", "braceright", "asciitilde"
+};
+
+// 0xA0-0xFF (Latin-1, come WinAnsiEncoding)
+static const char* const LATIN1_NAMES[96] = {
+    "space", "exclamdown", "cent", "sterling", "currency", "yen", "brokenbar", "section",
+    "dieresis", "copyright", "ordfeminine", "guillemotleft", "logicalnot", "hyphen", "registered", "macron",
+    "degree", "plusminus", "twosuperior", "threesuperior", "acute", "mu", "paragraph", "periodcentered",
+    "cedilla", "onesuperior", "ordmasculine", "guillemotright", "onequarter", "onehalf", "threequarters", "questiondown",
+    "Agrave", "Aacute", "Acircumflex", "Atilde", "Adieresis", "Aring", "AE", "Ccedilla",
+    "Egrave", "Eacute", "Ecircumflex", "Edieresis", "Igrave", "Iacute", "Icircumflex", "Idieresis",
+    "Eth", "Ntilde", "Ograve", "Oacute", "Ocircumflex", "Otilde", "Odieresis", "multiply",
+    "Oslash", "Ugrave", "Uacute", "Ucircumflex", "Udieresis", "Yacute", "Thorn", "germandbls",
+    "agrave", "aacute", "acircumflex", "atilde", "adieresis", "aring", "ae", "ccedilla",
+    "egrave", "eacute", "ecircumflex", "edieresis", "igrave", "iacute", "icircumflex", "idieresis",
+    "eth", "ntilde", "ograve", "oacute", "ocircumflex", "otilde", "odieresis", "divide",
+    "oslash", "ugrave", "uacute", "ucircumflex", "udieresis", "yacute", "thorn", "ydieresis"
+};
+
+// 0x80-0xFF di MacRomanEncoding
+static const char* const MAC_ROMAN_HIGH[128] = {
+    "Adieresis", "Aring", "Ccedilla", "Eacute", "Ntilde", "Odieresis", "Udieresis", "aacute",
+    "agrave", "acircumflex", "adieresis", "atilde", "aring", "ccedilla", "eacute", "egrave",
+    "ecircumflex", "edieresis", "iacute", "igrave", "icircumflex", "idieresis", "ntilde", "oacute",
+    "ograve", "ocircumflex", "odieresis", "otilde", "uacute", "ugrave", "ucircumflex", "udieresis",
+    "dagger", "degree", "cent", "sterling", "section", "bullet", "paragraph", "germandbls",
+    "registered", "copyright", "trademark", "acute", "dieresis", "notequal", "AE", "Oslash",
+    "infinity", "plusminus", "lessequal", "greaterequal", "yen", "mu", "partialdiff", "summation",
+    "product", "pi", "integral", "ordfeminine", "ordmasculine", "Omega", "ae", "oslash",
+    "questiondown", "exclamdown", "logicalnot", "radical", "florin", "approxequal", "Delta", "guillemotleft",
+    "guillemotright", "ellipsis", "space", "Agrave", "Atilde", "Otilde", "OE", "oe",
+    "endash", "emdash", "quotedblleft", "quotedblright", "quoteleft", "quoteright", "divide", "lozenge",
+    "ydieresis", "Ydieresis", "fraction", "currency", "guilsinglleft", "guilsinglright", "fi", "fl",
+    "daggerdbl", "periodcentered", "quotesinglbase", "quotedblbase", "perthousand", "Acircumflex", "Ecircumflex", "Aacute",
+    "Edieresis", "Egrave", "Iacute", "Icircumflex", "Idieresis", "Igrave", "Oacute", "Ocircumflex",
+    "apple", "Ograve", "Uacute", "Ucircumflex", "Ugrave", "dotlessi", "circumflex", "tilde",
+    "macron", "breve", "dotaccent", "ring", "cedilla", "hungarumlaut", "ogonek", "caron"
+};
+
+struct CodeName {
+    int code;
+    const char* name;
+};
+
+// 0x80-0x9F di WinAnsiEncoding (cp1252)
+static const CodeName WIN_ANSI_HIGH[] = {
+    { 0x80, "Euro" }, { 0x82, "quotesinglbase" }, { 0x83, "florin" }, { 0x84, "quotedblbase" },
+    { 0x85, "ellipsis" }, { 0x86, "dagger" }, { 0x87, "daggerdbl" }, { 0x88, "circumflex" },
+    { 0x89, "perthousand" }, { 0x8A, "Scaron" }, { 0x8B, "guilsinglleft" }, { 0x8C, "OE" },
+    { 0x8E, "Zcaron" }, { 0x91, "quoteleft" }, { 0x92, "quoteright" }, { 0x93, "quotedblleft" },
+    { 0x94, "quotedblright" }, { 0x95, "bullet" }, { 0x96, "endash" }, { 0x97, "emdash" },
+    { 0x98, "tilde" }, { 0x99, "trademark" }, { 0x9A, "scaron" }, { 0x9B, "guilsinglright" },
+    { 0x9C, "oe" }, { 0x9E, "zcaron" }, { 0x9F, "Ydieresis" }
+};
+
+// 0xA1-0xFB di StandardEncoding
+static const CodeName STANDARD_HIGH[] = {
+    { 0xA1, "exclamdown" }, { 0xA2, "cent" }, { 0xA3, "sterling" }, { 0xA4, "fraction" },
+    { 0xA5, "yen" }, { 0xA6, "florin" }, { 0xA7, "section" }, { 0xA8, "currency" },
+    { 0xA9, "quotesingle" }, { 0xAA, "quotedblleft" }, { 0xAB, "guillemotleft" }, { 0xAC, "guilsinglleft" },
+    { 0xAD, "guilsinglright" }, { 0xAE, "fi" }, { 0xAF, "fl" }, { 0xB1, "endash" },
+    { 0xB2, "dagger" }, { 0xB3, "daggerdbl" }, { 0xB4, "periodcentered" }, { 0xB6, "paragraph" },
+    { 0xB7, "bullet" }, { 0xB8, "quotesinglbase" }, { 0xB9, "quotedblbase" }, { 0xBA, "quotedblright" },
+    { 0xBB, "guillemotright" }, { 0xBC, "ellipsis" }, { 0xBD, "perthousand" }, { 0xBF, "questiondown" },
+    { 0xC1, "grave" }, { 0xC2, "acute" }, { 0xC3, "circumflex" }, { 0xC4, "tilde" },
+    { 0xC5, "macron" }, { 0xC6, "breve" }, { 0xC7, "dotaccent" }, { 0xC8, "dieresis" },
+    { 0xCA, "ring" }, { 0xCB, "cedilla" }, { 0xCD, "hungarumlaut" }, { 0xCE, "ogonek" },
+    { 0xCF, "caron" }, { 0xD0, "emdash" }, { 0xE1, "AE" }, { 0xE3, "ordfeminine" },
+    { 0xE8, "Lslash" }, { 0xE9, "Oslash" }, { 0xEA, "OE" }, { 0xEB, "ordmasculine" },
+    { 0xF1, "ae" }, { 0xF5, "dotlessi" }, { 0xF8, "lslash" }, { 0xF9, "oslash" },
+    { 0xFA, "oe" }, { 0xFB, "germandbls" }
+};
+
+struct NameUnicode {
+    const char* name;
+    uint32_t unicode;
+};
+
+// Nomi fuori da ASCII e Latin-1
+static const NameUnicode EXTRA_NAMES[] = {
+    { "Euro", 0x20AC }, { "quotesinglbase", 0x201A }, { "florin", 0x0192 }, { "quotedblbase", 0x201E },
+    { "ellipsis", 0x2026 }, { "dagger", 0x2020 }, { "daggerdbl", 0x2021 }, { "circumflex", 0x02C6 },
+    { "perthousand", 0x2030 }, { "Scaron", 0x0160 }, { "guilsinglleft", 0x2039 }, { "OE", 0x0152 },
+    { "Zcaron", 0x017D }, { "quoteleft", 0x2018 }, { "quoteright", 0x2019 }, { "quotedblleft", 0x201C },
+    { "quotedblright", 0x201D }, { "bullet", 0x2022 }, { "endash", 0x2013 }, { "emdash", 0x2014 },
+    { "tilde", 0x02DC }, { "trademark", 0x2122 }, { "scaron", 0x0161 }, { "guilsinglright", 0x203A },
+    { "oe", 0x0153 }, { "zcaron", 0x017E }, { "Ydieresis", 0x0178 }, { "fi", 0xFB01 },
+    { "fl", 0xFB02 }, { "ff", 0xFB00 }, { "ffi", 0xFB03 }, { "ffl", 0xFB04 },
+    { "dotlessi", 0x0131 }, { "dotlessj", 0x0237 }, { "Lslash", 0x0141 }, { "lslash", 0x0142 },
+    { "minus", 0x2212 }, { "fraction", 0x2044 }, { "ring", 0x02DA }, { "caron", 0x02C7 },
+    { "breve", 0x02D8 }, { "dotaccent", 0x02D9 }, { "hungarumlaut", 0x02DD }, { "ogonek", 0x02DB },
+    { "nbspace", 0x00A0 }, { "sfthyphen", 0x00AD }, { "middot", 0x00B7 }, { "notequal", 0x2260 },
+    { "infinity", 0x221E }, { "lessequal", 0x2264 }, { "greaterequal", 0x2265 }, { "partialdiff", 0x2202 },
+    { "summation", 0x2211 }, { "product", 0x220F }, { "pi", 0x03C0 }, { "integral", 0x222B },
+    { "Omega", 0x03A9 }, { "radical", 0x221A }, { "approxequal", 0x2248 }, { "Delta", 0x2206 },
+    { "lozenge", 0x25CA }, { "apple", 0xF8FF }, { "micro", 0x00B5 }, { "alpha", 0x03B1 },
+    { "beta", 0x03B2 }, { "gamma", 0x03B3 }, { "mu1", 0x00B5 }, { "arrowright", 0x2192 }
+};
+
+// Tabelle costruite una sola volta (inizializzazione thread-safe)
+struct GlyphTables {
+    std::unordered_map<std::string, uint32_t> nameToUnicode;
+    const char* standard[256];
+    const char* winAnsi[256];
+    const char* macRoman[256];
+
+    GlyphTables() {
+        for (int i = 0; i < 95; i++) nameToUnicode.emplace(ASCII_NAMES[i], 0x20 + i);
+        for (int i = 0; i < 96; i++) nameToUnicode.emplace(LATIN1_NAMES[i], 0xA0 + i);
+        for (const auto& e : EXTRA_NAMES) nameToUnicode.emplace(e.name, e.unicode);
+
+        for (int i = 0; i < 256; i++) {
+            const char* ascii = (i >= 0x20 && i < 0x7F) ? ASCII_NAMES[i - 0x20] : nullptr;
+            standard[i] = ascii;
+            winAnsi[i] = ascii;
+            macRoman[i] = ascii;
+        }
+        standard[0x27] = "quoteright";
+        standard[0x60] = "quoteleft";
+        for (const auto& e : STANDARD_HIGH) standard[e.code] = e.name;
+
+        for (const auto& e : WIN_ANSI_HIGH) winAnsi[e.code] = e.name;
+        for (int i = 0; i < 96; i++) winAnsi[0xA0 + i] = LATIN1_NAMES[i];
+
+        for (int i = 0; i < 128; i++) macRoman[0x80 + i] = MAC_ROMAN_HIGH[i];
+    }
+};
+
+static const GlyphTables& Tables() {
+    static const GlyphTables tables;
+    return tables;
+}
+
+static uint32_t GlyphNameToUnicode(const std::string& fullName) {
+    // Suffissi di variante (".sc", ".alt", ...) non cambiano il carattere
+    std::string name = fullName.substr(0, fullName.find('.'));
+    if (name.empty()) {
+        return 0;
+    }
+
+    const auto& map = Tables().nameToUnicode;
+    auto it = map.find(name);
+    if (it != map.end()) {
+        return it->second;
+    }
+
+    // uniXXXX e uXXXX[XX]
+    const char* hex = nullptr;
+    if (name.size() == 7 && name.compare(0, 3, "uni") == 0) {
+        hex = name.c_str() + 3;
+    } else if (name.size() >= 5 && name.size() <= 7 && name[0] == 'u') {
+        hex = name.c_str() + 1;
+    }
+    if (hex) {
+        char* end;
+        unsigned long value = strtoul(hex, &end, 16);
+        if (*end == '\0' && value > 0 && value < 0x110000) {
+            return static_cast<uint32_t>(value);
+        }
+    }
+    return 0;
+}
+
+// ============================================================================
+// Metriche dei font standard non incorporati (caratteri 32-126)
+// ============================================================================
+
+static const short HELVETICA_WIDTHS[95] = {
+    278, 278, 355, 556, 556, 889, 667, 191, 333, 333, 389, 584, 278, 333, 278, 278,
+    556, 556, 556, 556, 556, 556, 556, 556, 556, 556, 278, 278, 584, 584, 584, 556, 1015,
+    667, 667, 722, 722, 667, 611, 778, 722, 278, 500, 667, 556, 833,
+    722, 778, 667, 778, 722, 667, 611, 722, 667, 944, 667, 667, 611,
+    278, 278, 278, 469, 556, 333,
+    556, 556, 500, 556, 556, 278, 556, 556, 222, 222, 500, 222, 833,
+    556, 556, 556, 556, 333, 500, 278, 556, 500, 722, 500, 500, 500,
+    334, 260, 334, 584
+};
+
+static const short HELVETICA_BOLD_WIDTHS[95] = {
+    278, 333, 474, 556, 556, 889, 722, 238, 333, 333, 389, 584, 278, 333, 278, 278,
+    556, 556, 556, 556, 556, 556, 556, 556, 556, 556, 333, 333, 584, 584, 584, 611, 975,
+    722, 722, 722, 722, 667, 611, 778, 722, 278, 556, 722, 611, 833,
+    722, 778, 667, 778, 722, 667, 611, 722, 667, 944, 667, 667, 611,
+    333, 278, 333, 584, 556, 333,
+    556, 611, 556, 611, 556, 333, 611, 611, 278, 278, 556, 278, 889,
+    611, 611, 611, 611, 389, 556, 333, 611, 556, 778, 556, 556, 500,
+    389, 280, 389, 584
+};
+
+static const short TIMES_WIDTHS[95] = {
+    250, 333, 408, 500, 500, 833, 778, 180, 333, 333, 500, 564, 250, 333, 250, 278,
+    500, 500, 500, 500, 500, 500, 500, 500, 500, 500, 278, 278, 564, 564, 564, 444, 921,
+    722, 667, 667, 722, 611, 556, 722, 722, 333, 389, 722, 611, 889,
+    722, 722, 556, 722, 667, 556, 611, 722, 722, 944, 722, 722, 611,
+    333, 278, 333, 469, 500, 333,
+    444, 500, 444, 500, 444, 333, 500, 500, 278, 278, 500, 278, 778,
+    500, 500, 500, 500, 333, 389, 278, 500, 500, 722, 500, 500, 444,
+    480, 200, 480, 541
+};
+
+static const short TIMES_BOLD_WIDTHS[95] = {
+    250, 333, 555, 500, 500, 1000, 833, 278, 333, 333, 500, 570, 250, 333, 250, 278,
+    500, 500, 500, 500, 500, 500, 500, 500, 500, 500, 333, 333, 570, 570, 570, 500, 930,
+    722, 667, 722, 722, 667, 611, 778, 778, 389, 500, 778, 667, 944,
+    722, 778, 611, 778, 722, 556, 667, 722, 722, 1000, 722, 722, 667,
+    333, 278, 333, 581, 500, 333,
+    500, 556, 444, 556, 444, 333, 500, 556, 278, 333, 556, 278, 833,
+    556, 500, 556, 556, 444, 389, 333, 556, 500, 722, 500, 500, 444,
+    394, 220, 394, 520
+};
+
+// ============================================================================
+// Utilita'
+// ============================================================================
+
+static void AppendCodePoint(uint32_t cp, std::wstring& out) {
+    if (cp == 0) {
+        return;
+    }
+    if (sizeof(wchar_t) == 2 && cp >= 0x10000) {
+        cp -= 0x10000;
+        out += static_cast<wchar_t>(0xD800 + (cp >> 10));
+        out += static_cast<wchar_t>(0xDC00 + (cp & 0x3FF));
+    } else {
+        out += static_cast<wchar_t>(cp);
+    }
+}
+
+// Le legature tipografiche vengono scomposte, come fa pdftotext
+static void AppendExpanded(uint32_t cp, std::wstring& out) {
+    switch (cp) {
+        case 0xFB00: out += L"ff"; break;
+        case 0xFB01: out += L"fi"; break;
+        case 0xFB02: out += L"fl"; break;
+        case 0xFB03: out += L"ffi"; break;
+        case 0xFB04: out += L"ffl"; break;
+        default: AppendCodePoint(cp, out); break;
+    }
+}
+
+static void DecodeUtf16Be(const std::string& bytes, std::wstring& out) {
+    for (size_t i = 0; i + 1 < bytes.size(); i += 2) {
+        uint32_t unit = (static_cast<unsigned char>(bytes[i]) << 8) | static_cast<unsigned char>(bytes[i + 1]);
+        if (unit >= 0xD800 && unit < 0xDC00 && i + 3 < bytes.size()) {
+            uint32_t low = (static_cast<unsigned char>(bytes[i + 2]) << 8) | static_cast<unsigned char>(bytes[i + 3]);
+            if (low >= 0xDC00 && low < 0xE000) {
+                AppendExpanded(0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00), out);
+                i += 2;
+                continue;
+            }
+        }
+        AppendExpanded(unit, out);
+    }
+    if (bytes.size() == 1) {
+        AppendExpanded(static_cast<unsigned char>(bytes[0]), out);
+    }
+}
+
+static uint32_t BytesToCode(const std::string& bytes) {
+    uint32_t code = 0;
+    for (size_t i = 0; i < bytes.size() && i < 4; i++) {
+        code = (code << 8) | static_cast<unsigned char>(bytes[i]);
+    }
+    return code;
+}
+
+// ============================================================================
+// PdfFont
+// ============================================================================
+
+PdfFont::PdfFont() : composite(false), defaultWidth(0) {
+    for (int i = 0; i < 256; i++) {
+        encoding[i] = 0;
+        widths[i] = 0;
+    }
+}
+
+void PdfFont::Load(PdfDocument& doc, const PdfObject& fontDict) {
+    const PdfObject* subtype = fontDict.Get("Subtype");
+    composite = subtype && subtype->IsName("Type0");
+
+    if (composite) {
+        LoadComposite(doc, fontDict);
+    } else {
+        LoadSimple(doc, fontDict);
+    }
+
+    const PdfObject& toUnicodeStream = doc.GetResolved(fontDict, "ToUnicode");
+    std::string cmap;
+    if (toUnicodeStream.type == PdfObject::Stream && doc.GetStreamData(toUnicodeStream, cmap)) {
+        ParseCMap(cmap, true);
+    }
+}
+
+void PdfFont::LoadSimple(PdfDocument& doc, const PdfObject& fontDict) {
+    const PdfObject* subtype = fontDict.Get("Subtype");
+    bool type3 = subtype && subtype->IsName("Type3");
+    bool trueType = subtype && subtype->IsName("TrueType");
+
+    const PdfObject& baseFont = doc.GetResolved(fontDict, "BaseFont");
+    const std::string& fontName = baseFont.text;
+    const PdfObject& descriptor = doc.GetResolved(fontDict, "FontDescriptor");
+
+    // Font simbolici (flag 3): senza encoding il codice e' gia' il carattere
+    const PdfObject& flags = descriptor.IsDict() ? doc.GetResolved(descriptor, "Flags") : descriptor;
+    bool symbolic = flags.IsNumber() && (static_cast<int>(flags.number) & 4) != 0;
+    if (fontName.find("Symbol") != std::string::npos || fontName.find("Dingbats") != std::string::npos) {
+        symbolic = true;
+    }
+
+    // Encoding di base e /Differences
+    const GlyphTables& tables = Tables();
+    const char* const* base = nullptr;
+    const PdfObject& enc = doc.GetResolved(fontDict, "Encoding");
+    const PdfObject* baseName = enc.type == PdfObject::Name ? &enc :
+                                enc.IsDict() ? &doc.GetResolved(enc, "BaseEncoding") : nullptr;
+    if (baseName && baseName->IsName("WinAnsiEncoding")) {
+        base = tables.winAnsi;
+    } else if (baseName && baseName->IsName("MacRomanEncoding")) {
+        base = tables.macRoman;
+    } else if (baseName && baseName->IsName("StandardEncoding")) {
+        base = tables.standard;
+    } else if (!symbolic || enc.IsDict()) {
+        base = trueType ? tables.winAnsi : tables.standard;
+    }
+
+    for (int c = 0; c < 256; c++) {
+        if (base) {
+            encoding[c] = base[c] ? GlyphNameToUnicode(base[c]) : 0;
+        } else {
+            encoding[c] = c >= 0x20 ? static_cast<uint32_t>(c) : 0;
+        }
+    }
+
+    if (enc.IsDict()) {
+        const PdfObject& differences = doc.GetResolved(enc, "Differences");
+        if (differences.type == PdfObject::Array) {
+            int code = 0;
+            for (const auto& item : differences.items) {
+                const PdfObject& entry = doc.Resolve(item);
+                if (entry.IsNumber()) {
+                    code = entry.AsInt();
+                } else if (entry.type == PdfObject::Name) {
+                    if (code >= 0 && code < 256) {
+                        uint32_t unicode = GlyphNameToUnicode(entry.text);
+                        if (unicode) {
+                            encoding[code] = unicode;
+                        }
+                    }
+                    code++;
+                }
+            }
+        }
+    }
+
+    // Larghezze: /Widths, altrimenti le metriche del font standard
+    double scale = 0.001;
+    if (type3) {
+        const PdfObject& matrix = doc.GetResolved(fontDict, "FontMatrix");
+        if (matrix.type == PdfObject::Array && !matrix.items.empty()) {
+            scale = doc.Resolve(matrix.items[0]).number;
+        }
+    }
+
+    double missing = 0;
+    if (descriptor.IsDict()) {
+        const PdfObject& mw = doc.GetResolved(descriptor, "MissingWidth");
+        if (mw.IsNumber()) {
+            missing = mw.number;
+        }
+    }
+
+    const PdfObject& widthArray = doc.GetResolved(fontDict, "Widths");
+    if (widthArray.type == PdfObject::Array) {
+        const PdfObject& firstChar = doc.GetResolved(fontDict, "FirstChar");
+        int first = firstChar.IsNumber() ? firstChar.AsInt() : 0;
+        for (int c = 0; c < 256; c++) {
+            widths[c] = missing * scale;
+        }
+        for (size_t i = 0; i < widthArray.items.size(); i++) {
+            int c = first + static_cast<int>(i);
+            if (c >= 0 && c < 256) {
+                widths[c] = doc.Resolve(widthArray.items[i]).number * scale;
+            }
+        }
+        return;
+    }
+
+    const short* metrics = HELVETICA_WIDTHS;
+    double fallback = 556;
+    bool bold = fontName.find("Bold") != std::string::npos;
+    if (fontName.find("Courier") != std::string::npos) {
+        metrics = nullptr;
+        fallback = 600;
+    } else if (fontName.find("Times") != std::string::npos || fontName.find("Roman") != std::string::npos) {
+        metrics = bold ? TIMES_BOLD_WIDTHS : TIMES_WIDTHS;
+        fallback = 500;
+    } else if (bold) {
+        metrics = HELVETICA_BOLD_WIDTHS;
+    }
+
+    for (int c = 0; c < 256; c++) {
+        uint32_t unicode = encoding[c];
+        double w = fallback;
+        if (metrics && unicode >= 0x20 && unicode < 0x7F) {
+            w = metrics[unicode - 0x20];
+        }
+        widths[c] = w * 0.001;
+    }
+}
+
+void PdfFont::LoadComposite(PdfDocument& doc, const PdfObject& fontDict) {
+    // Encoding: Identity-H/V (due byte, CID = codice) o CMap incorporata.
+    // Le CMap predefinite non incorporate sono trattate come Identity
+    const PdfObject& enc = doc.GetResolved(fontDict, "Encoding");
+    std::string cmap;
+    if (enc.type == PdfObject::Stream && doc.GetStreamData(enc, cmap)) {
+        ParseCMap(cmap, false);
+    }
+
+    defaultWidth = 1.0;
+    const PdfObject& descendants = doc.GetResolved(fontDict, "DescendantFonts");
+    if (descendants.type != PdfObject::Array || descendants.items.empty()) {
+        return;
+    }
+    const PdfObject& cidFont = doc.Resolve(descendants.items[0]);
+    if (!cidFont.IsDict()) {
+        return;
+    }
+
+    const PdfObject& dw = doc.GetResolved(cidFont, "DW");
+    if (dw.IsNumber()) {
+        defaultWidth = dw.number * 0.001;
+    }
+
+    // /W: "c [w1 w2 ...]" oppure "cFirst cLast w"
+    const PdfObject& w = doc.GetResolved(cidFont, "W");
+    if (w.type != PdfObject::Array) {
+        return;
+    }
+    size_t i = 0;
+    while (i < w.items.size()) {
+        const PdfObject& first = doc.Resolve(w.items[i]);
+        if (!first.IsNumber() || i + 1 >= w.items.size()) {
+            break;
+        }
+        const PdfObject& next = doc.Resolve(w.items[i + 1]);
+        if (next.type == PdfObject::Array) {
+            uint32_t cid = static_cast<uint32_t>(first.number);
+            for (const auto& width : next.items) {
+                cidWidths[cid++] = doc.Resolve(width).number * 0.001;
+            }
+            i += 2;
+        } else if (i + 2 < w.items.size()) {
+            uint32_t low = static_cast<uint32_t>(first.number);
+            uint32_t high = static_cast<uint32_t>(next.number);
+            double width = doc.Resolve(w.items[i + 2]).number * 0.001;
+            for (uint32_t cid = low; cid <= high && cid - low < 65536; cid++) {
+                cidWidths[cid] = width;
+            }
+            i += 3;
+        } else {
+            break;
+        }
+    }
+}
+
+void PdfFont::ParseCMap(const std::string& data, bool toUnicodeMap) {
+    PdfParser parser(data.data(), data.size());
+    std::vector<PdfObject> operands;
+    PdfObject obj;
+
+    while (parser.ReadObject(obj)) {
+        if (obj.type != PdfObject::Operator) {
+            if (operands.size() < 4096) {
+                operands.push_back(std::move(obj));
+            }
+            continue;
+        }
+
+        const std::string& op = obj.text;
+        if (op == "endcodespacerange" && !toUnicodeMap) {
+            for (size_t i = 0; i + 1 < operands.size(); i += 2) {
+                if (operands[i].type != PdfObject::String) continue;
+                int bytes = static_cast<int>(operands[i].text.size());
+                if (bytes < 1 || bytes > 4) continue;
+                codespace.push_back({ BytesToCode(operands[i].text), BytesToCode(operands[i + 1].text), bytes });
+            }
+        } else if (op == "endbfchar" && toUnicodeMap) {
+            for (size_t i = 0; i + 1 < operands.size(); i += 2) {
+                uint32_t code = BytesToCode(operands[i].text);
+                std::wstring text;
+                if (operands[i + 1].type == PdfObject::String) {
+                    DecodeUtf16Be(operands[i + 1].text, text);
+                } else if (operands[i + 1].type == PdfObject::Name) {
+                    AppendExpanded(GlyphNameToUnicode(operands[i + 1].text), text);
+                }
+                toUnicode[code] = text;
+            }
+        } else if (op == "endbfrange" && toUnicodeMap) {
+            for (size_t i = 0; i + 2 < operands.size(); i += 3) {
+                uint32_t low = BytesToCode(operands[i].text);
+                uint32_t high = BytesToCode(operands[i + 1].text);
+                const PdfObject& dst = operands[i + 2];
+                if (high < low || high - low > 65535) continue;
+
+                for (uint32_t code = low; code <= high; code++) {
+                    std::wstring text;
+                    if (dst.type == PdfObject::Array) {
+                        size_t k = code - low;
+                        if (k < dst.items.size()) {
+                            DecodeUtf16Be(dst.items[k].text, text);
+                        }
+                    } else if (dst.type == PdfObject::String && !dst.text.empty()) {
+                        // Incrementa l'ultima unita' UTF-16 della destinazione
+                        std::string bytes = dst.text;
+                        size_t n = bytes.size();
+                        uint32_t last = n >= 2 ? ((static_cast<unsigned char>(bytes[n - 2]) << 8) |
+                                                  static_cast<unsigned char>(bytes[n - 1]))
+                                               : static_cast<unsigned char>(bytes[n - 1]);
+                        last += code - low;
+                        if (n >= 2) {
+                            bytes[n - 2] = static_cast<char>((last >> 8) & 0xFF);
+                            bytes[n - 1] = static_cast<char>(last & 0xFF);
+                        } else {
+                            bytes[0] = static_cast<char>(last & 0xFF);
+                        }
+                        DecodeUtf16Be(bytes, text);
+                    }
+                    toUnicode[code] = text;
+                }
+            }
+        } else if (op == "endcidchar" && !toUnicodeMap) {
+            for (size_t i = 0; i + 1 < operands.size(); i += 2) {
+                codeToCid[BytesToCode(operands[i].text)] = static_cast<uint32_t>(operands[i + 1].number);
+            }
+        } else if (op == "endcidrange" && !toUnicodeMap) {
+            for (size_t i = 0; i + 2 < operands.size(); i += 3) {
+                uint32_t low = BytesToCode(operands[i].text);
+                uint32_t high = BytesToCode(operands[i + 1].text);
+                uint32_t cid = static_cast<uint32_t>(operands[i + 2].number);
+                if (high < low || high - low > 65535) continue;
+                for (uint32_t code = low; code <= high; code++) {
+                    codeToCid[code] = cid + (code - low);
+                }
+            }
+        }
+        operands.clear();
+    }
+}
+
+size_t PdfFont::NextCode(const std::string& s, size_t pos, uint32_t& code) const {
+    if (!composite) {
+        code = static_cast<unsigned char>(s[pos]);
+        return 1;
+    }
+
+    if (codespace.empty()) {
+        if (pos + 1 < s.size()) {
+            code = (static_cast<unsigned char>(s[pos]) << 8) | static_cast<unsigned char>(s[pos + 1]);
+            return 2;
+        }
+        code = static_cast<unsigned char>(s[pos]);
+        return 1;
+    }
+
+    uint32_t value = 0;
+    for (int n = 1; n <= 4 && pos + n <= s.size(); n++) {
+        value = (value << 8) | static_cast<unsigned char>(s[pos + n - 1]);
+        for (const auto& range : codespace) {
+            if (range.bytes == n && value >= range.low && value <= range.high) {
+                code = value;
+                return n;
+            }
+        }
+    }
+
+    // Codice fuori dai range: consuma la lunghezza minima dichiarata
+    int shortest = 4;
+    for (const auto& range : codespace) {
+        if (range.bytes < shortest) shortest = range.bytes;
+    }
+    size_t n = std::min(static_cast<size_t>(shortest), s.size() - pos);
+    code = 0;
+    for (size_t i = 0; i < n; i++) {
+        code = (code << 8) | static_cast<unsigned char>(s[pos + i]);
+    }
+    return n;
+}
+
+double PdfFont::GetAdvance(uint32_t code) const {
+    if (!composite) {
+        return widths[code & 0xFF];
+    }
+
+    uint32_t cid = code;
+    if (!codeToCid.empty()) {
+        auto it = codeToCid.find(code);
+        cid = it != codeToCid.end() ? it->second : 0;
+    }
+    auto it = cidWidths.find(cid);
+    return it != cidWidths.end() ? it->second : defaultWidth;
+}
+
+void PdfFont::AppendUnicode(uint32_t code, std::wstring& out) const {
+    auto it = toUnicode.find(code);
+    if (it != toUnicode.end()) {
+        out += it->second;
+        return;
+    }
+    if (!composite) {
+        AppendExpanded(encoding[code & 0xFF], out);
+    }
+}
+
+bool PdfFont::IsWordSpace(uint32_t code, size_t length) const {
+    return length == 1 && code == 32;
+}
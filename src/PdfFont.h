@@ -0,0 +1,53 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+class PdfDocument;
+struct PdfObject;
+
+// Font usato nei content stream: decodifica dei codici carattere (semplici a
+// un byte o composti Type0 con CMap), larghezze dei glifi e conversione in
+// Unicode tramite ToUnicode, encoding con /Differences e nomi dei glifi
+class PdfFont {
+public:
+    PdfFont();
+
+    // Legge il dizionario del font e le risorse collegate
+    void Load(PdfDocument& doc, const PdfObject& fontDict);
+
+    // Legge il prossimo codice da una stringa di testo.
+    // Restituisce il numero di byte consumati (almeno 1)
+    size_t NextCode(const std::string& s, size_t pos, uint32_t& code) const;
+
+    // Avanzamento orizzontale del glifo in unita' di testo per corpo 1
+    double GetAdvance(uint32_t code) const;
+
+    // Aggiunge a 'out' il testo Unicode del codice (nulla se non mappabile)
+    void AppendUnicode(uint32_t code, std::wstring& out) const;
+
+    // Tw (spaziatura tra parole) si applica solo al codice 32 a un byte
+    bool IsWordSpace(uint32_t code, size_t length) const;
+
+private:
+    struct CodeRange {
+        uint32_t low;
+        uint32_t high;
+        int bytes;
+    };
+
+    void LoadSimple(PdfDocument& doc, const PdfObject& fontDict);
+    void LoadComposite(PdfDocument& doc, const PdfObject& fontDict);
+    void ParseCMap(const std::string& data, bool toUnicodeMap);
+
+    bool composite;
+    std::vector<CodeRange> codespace;                   // Vuoto: due byte (Identity)
+    std::unordered_map<uint32_t, uint32_t> codeToCid;   // Vuoto: CID = codice
+    std::unordered_map<uint32_t, std::wstring> toUnicode;
+
+    uint32_t encoding[256];                             // Font semplici: codice -> Unicode
+    double widths[256];                                 // Font semplici, in unita' di testo
+    std::unordered_map<uint32_t, double> cidWidths;     // Font composti
+    double defaultWidth;
+};
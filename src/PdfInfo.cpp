@@ -0,0 +1,206 @@
+#include "PdfInfo.h"
+#include "PdfDocument.h"
+#include "MappedFile.h"
+#include "Subprocess.h"
+#include <cstdint>
+
+thread_local std::wstring PdfInfo::lastError;
+
+namespace {
+
+// Annidamento massimo dell'albero delle pagine e dei form XObject
+const int MAX_DEPTH = 32;
+
+// PDFDocEncoding 0x80-0x9F (gli altri caratteri coincidono con Latin-1)
+const wchar_t PDF_DOC_ENCODING_80[32] = {
+    0x2022, 0x2020, 0x2021, 0x2026, 0x2014, 0x2013, 0x0192, 0x2044,
+    0x2039, 0x203A, 0x2212, 0x2030, 0x201E, 0x201C, 0x201D, 0x2018,
+    0x2019, 0x201A, 0x2122, 0xFB01, 0xFB02, 0x0141, 0x0152, 0x0160,
+    0x0178, 0x017D, 0x0131, 0x0142, 0x0153, 0x0161, 0x017E, 0xFFFD
+};
+
+void AppendCodePoint(uint32_t cp, std::wstring& out) {
+    if (sizeof(wchar_t) == 2 && cp > 0xFFFF) {
+        cp -= 0x10000;
+        out += static_cast<wchar_t>(0xD800 + (cp >> 10));
+        out += static_cast<wchar_t>(0xDC00 + (cp & 0x3FF));
+    } else {
+        out += static_cast<wchar_t>(cp);
+    }
+}
+
+// Stringa di testo del PDF (ISO 32000-1, 7.9.2.2): UTF-16BE con BOM,
+// UTF-8 con BOM (PDF 2.0) oppure PDFDocEncoding
+std::wstring DecodeTextString(const std::string& bytes) {
+    std::wstring out;
+    const unsigned char* b = reinterpret_cast<const unsigned char*>(bytes.data());
+    size_t size = bytes.size();
+
+    if (size >= 2 && b[0] == 0xFE && b[1] == 0xFF) {
+        for (size_t i = 2; i + 1 < size; i += 2) {
+            uint32_t unit = (b[i] << 8) | b[i + 1];
+            if (unit >= 0xD800 && unit < 0xDC00 && i + 3 < size) {
+                uint32_t low = (b[i + 2] << 8) | b[i + 3];
+                if (low >= 0xDC00 && low < 0xE000) {
+                    unit = 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+                    i += 2;
+                }
+            }
+            AppendCodePoint(unit, out);
+        }
+    } else if (size >= 3 && b[0] == 0xEF && b[1] == 0xBB && b[2] == 0xBF) {
+        Subprocess::Utf8Decoder decoder;
+        decoder.Feed(bytes.data() + 3, size - 3, out);
+        decoder.Finish(out);
+    } else {
+        for (size_t i = 0; i < size; i++) {
+            if (b[i] >= 0x80 && b[i] < 0xA0) {
+                out += PDF_DOC_ENCODING_80[b[i] - 0x80];
+            } else if (b[i] == 0xA0) {
+                out += static_cast<wchar_t>(0x20AC);
+            } else {
+                out += static_cast<wchar_t>(b[i]);
+            }
+        }
+    }
+    return out;
+}
+
+// Un content stream contiene testo se usa un operatore di disegno del testo
+// (Tj, TJ, ', "). I form XObject richiamati con Do vengono esaminati a loro volta
+bool ContentHasText(PdfDocument& doc, const std::string& content, const PdfObject* resources, int depth) {
+    PdfParser parser(content.data(), content.size());
+    PdfObject token;
+    std::string lastName;
+
+    while (parser.ReadObject(token)) {
+        if (token.type == PdfObject::Name) {
+            lastName = token.text;
+            continue;
+        }
+        if (token.type != PdfObject::Operator) {
+            continue;
+        }
+
+        const std::string& op = token.text;
+        if (op == "Tj" || op == "TJ" || op == "'" || op == "\"") {
+            return true;
+        }
+        if (op == "ID") {
+            parser.SkipInlineImage();
+        } else if (op == "Do" && resources && depth < MAX_DEPTH) {
+            const PdfObject& xobjects = doc.GetResolved(*resources, "XObject");
+            if (!xobjects.IsDict()) {
+                continue;
+            }
+            const PdfObject& form = doc.GetResolved(xobjects, lastName.c_str());
+            const PdfObject* subtype = form.Get("Subtype");
+            std::string formContent;
+            if (form.type != PdfObject::Stream || !subtype || !subtype->IsName("Form") ||
+                !doc.GetStreamData(form, formContent)) {
+                continue;
+            }
+            const PdfObject& formResources = doc.GetResolved(form, "Resources");
+            if (ContentHasText(doc, formContent, formResources.IsDict() ? &formResources : resources, depth + 1)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Visita le pagine in ordine fermandosi alla prima con testo: per un
+// documento con testo basta di solito la prima pagina, per una scansione
+// ogni pagina ha un content stream di poche istruzioni
+bool PagesHaveText(PdfDocument& doc, const PdfObject& node, const PdfObject* resources, int depth) {
+    if (!node.IsDict() || depth > MAX_DEPTH) {
+        return false;
+    }
+
+    const PdfObject& res = doc.GetResolved(node, "Resources");
+    if (res.IsDict()) {
+        resources = &res;
+    }
+
+    const PdfObject& kids = doc.GetResolved(node, "Kids");
+    const PdfObject* type = node.Get("Type");
+    if (kids.type == PdfObject::Array && !(type && type->IsName("Page"))) {
+        for (const auto& kid : kids.items) {
+            if (PagesHaveText(doc, doc.Resolve(kid), resources, depth + 1)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // /Contents: uno stream oppure un array di stream da concatenare
+    std::string content;
+    const PdfObject& contents = doc.GetResolved(node, "Contents");
+    if (contents.type == PdfObject::Stream) {
+        doc.GetStreamData(contents, content);
+    } else if (contents.type == PdfObject::Array) {
+        std::string part;
+        for (const auto& item : contents.items) {
+            if (doc.GetStreamData(doc.Resolve(item), part)) {
+                content += part;
+                content += '\n';
+            }
+        }
+    }
+    return ContentHasText(doc, content, resources, 0);
+}
+
+}
+
+bool PdfInfo::Read(const std::wstring& pdfPath, Info& info) {
+    lastError.clear();
+    info = Info{ 0, std::wstring(), std::wstring(), false };
+
+    MappedFile file;
+    if (!file.OpenReadOnly(pdfPath)) {
+        lastError = file.GetLastError();
+        return false;
+    }
+
+    // Solo xref e trailer: le pagine vengono raggiunte dal catalogo
+    PdfDocument doc;
+    std::string_view bytes(file.Data(), file.Size());
+    if (!doc.LoadView(bytes, false)) {
+        lastError = doc.GetLastError();
+        return false;
+    }
+
+    const PdfObject* pageTree = &doc.GetResolved(doc.GetResolved(doc.GetTrailer(), "Root"), "Pages");
+    const PdfObject& count = doc.GetResolved(*pageTree, "Count");
+    if (count.IsNumber() && count.number > 0) {
+        info.pageCount = count.AsInt();
+    } else {
+        // /Count mancante o errato: indicizzazione completa (anche con la
+        // ricostruzione della xref) e conteggio delle foglie dell'albero
+        if (!doc.LoadView(bytes, true)) {
+            lastError = doc.GetLastError();
+            return false;
+        }
+        info.pageCount = doc.GetPageCount();
+        pageTree = &doc.GetResolved(doc.GetResolved(doc.GetTrailer(), "Root"), "Pages");
+    }
+
+    const PdfObject& metadata = doc.GetResolved(doc.GetTrailer(), "Info");
+    if (metadata.IsDict()) {
+        const PdfObject& producer = doc.GetResolved(metadata, "Producer");
+        if (producer.type == PdfObject::String) {
+            info.producer = DecodeTextString(producer.text);
+        }
+        const PdfObject& creationDate = doc.GetResolved(metadata, "CreationDate");
+        if (creationDate.type == PdfObject::String) {
+            info.creationDate = DecodeTextString(creationDate.text);
+        }
+    }
+
+    info.hasText = PagesHaveText(doc, *pageTree, nullptr, 0);
+    return true;
+}
+
+std::wstring PdfInfo::GetLastError() {
+    return lastError;
+}
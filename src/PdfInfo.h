@@ -0,0 +1,26 @@
+#pragma once
+#include <string>
+
+// Informazioni essenziali di un PDF senza estrarne il testo e senza pdfinfo:
+// il file viene mappato in memoria e vengono letti solo la tabella xref
+// (classica o stream, con gli aggiornamenti incrementali), il trailer,
+// /Root -> /Pages -> /Count e il dizionario /Info.
+class PdfInfo {
+public:
+    struct Info {
+        int pageCount;              // /Count dell'albero delle pagine
+        std::wstring producer;      // /Producer (vuoto se assente)
+        std::wstring creationDate;  // /CreationDate nel formato PDF (D:AAAAMMGGhhmmss...)
+        bool hasText;               // Almeno una pagina con operatori di testo
+    };
+
+    // Legge le informazioni del PDF. Restituisce false se il file non e'
+    // leggibile, e' cifrato o la struttura non e' recuperabile
+    static bool Read(const std::wstring& pdfPath, Info& info);
+
+    // Restituisce l'ultimo errore
+    static std::wstring GetLastError();
+
+private:
+    static thread_local std::wstring lastError;
+};
@@ -0,0 +1,464 @@
+#include "PdfTextEngine.h"
+#include <algorithm>
+#include <cmath>
+
+static const int MAX_FORM_DEPTH = 16;
+static const size_t MAX_OPERANDS = 64;
+
+PdfTextEngine::Matrix PdfTextEngine::Matrix::Multiply(const Matrix& m) const {
+    return Matrix{
+        a * m.a + b * m.c,
+        a * m.b + b * m.d,
+        c * m.a + d * m.c,
+        c * m.b + d * m.d,
+        e * m.a + f * m.c + m.e,
+        e * m.b + f * m.d + m.f
+    };
+}
+
+PdfTextEngine::PdfTextEngine(PdfDocument& document)
+    : doc(document), output(nullptr) {
+    textMatrix = lineMatrix = pageMatrix = Matrix{ 1, 0, 0, 1, 0, 0 };
+    state = GraphicsState{ Matrix{ 1, 0, 0, 1, 0, 0 }, nullptr, 0, 0, 0, 1, 0, 0 };
+}
+
+bool PdfTextEngine::ExtractPage(int pageIndex, PdfPageText& page) {
+    lastError.clear();
+
+    const auto& pages = doc.GetPages();
+    if (pageIndex < 0 || pageIndex >= static_cast<int>(pages.size())) {
+        lastError = L"Pagina non valida: " + std::to_wstring(pageIndex + 1);
+        return false;
+    }
+    const PdfPage& info = pages[pageIndex];
+
+    // Dallo spazio utente alla pagina visualizzata (origine in alto a sinistra,
+    // rotazione /Rotate in senso orario)
+    double x0 = info.mediaBox[0], y0 = info.mediaBox[1];
+    double x1 = info.mediaBox[2], y1 = info.mediaBox[3];
+    switch (info.rotate) {
+        case 90:
+            pageMatrix = Matrix{ 0, 1, 1, 0, -y0, -x0 };
+            page.width = y1 - y0;
+            page.height = x1 - x0;
+            break;
+        case 180:
+            pageMatrix = Matrix{ -1, 0, 0, 1, x1, -y0 };
+            page.width = x1 - x0;
+            page.height = y1 - y0;
+            break;
+        case 270:
+            pageMatrix = Matrix{ 0, -1, -1, 0, y1, x1 };
+            page.width = y1 - y0;
+            page.height = x1 - x0;
+            break;
+        default:
+            pageMatrix = Matrix{ 1, 0, 0, -1, -x0, y1 };
+            page.width = x1 - x0;
+            page.height = y1 - y0;
+            break;
+    }
+
+    page.glyphs.clear();
+    output = &page;
+
+    state = GraphicsState{ Matrix{ 1, 0, 0, 1, 0, 0 }, nullptr, 0, 0, 0, 1, 0, 0 };
+    stateStack.clear();
+
+    // /Contents: uno stream o un array di stream concatenati
+    std::string content;
+    const PdfObject& contents = doc.GetResolved(*info.dict, "Contents");
+    std::vector<const PdfObject*> streams;
+    if (contents.type == PdfObject::Stream) {
+        streams.push_back(&contents);
+    } else if (contents.type == PdfObject::Array) {
+        for (const auto& item : contents.items) {
+            streams.push_back(&doc.Resolve(item));
+        }
+    }
+    for (const PdfObject* stream : streams) {
+        std::string part;
+        if (doc.GetStreamData(*stream, part)) {
+            content += part;
+            content += '\n';
+        }
+    }
+
+    RunContent(content, info.resources, 0);
+    output = nullptr;
+    return true;
+}
+
+PdfFont* PdfTextEngine::GetFont(const PdfObject* resources, const std::string& name) {
+    if (!resources) {
+        return nullptr;
+    }
+    const PdfObject& fontDir = doc.GetResolved(*resources, "Font");
+    if (!fontDir.IsDict()) {
+        return nullptr;
+    }
+    const PdfObject& fontDict = doc.GetResolved(fontDir, name.c_str());
+    if (!fontDict.IsDict()) {
+        return nullptr;
+    }
+
+    // Gli oggetti risolti restano alla stessa posizione: l'indirizzo identifica il font
+    auto it = fonts.find(&fontDict);
+    if (it != fonts.end()) {
+        return it->second.get();
+    }
+
+    std::unique_ptr<PdfFont> font(new PdfFont());
+    font->Load(doc, fontDict);
+    PdfFont* result = font.get();
+    fonts.emplace(&fontDict, std::move(font));
+    return result;
+}
+
+void PdfTextEngine::AddGlyph(const Matrix& trm, double advance, const std::wstring& text) {
+    Matrix device = trm.Multiply(pageMatrix);
+
+    PdfGlyph glyph;
+    glyph.x = device.e;
+    glyph.y = device.f;
+    glyph.width = advance * std::sqrt(device.a * device.a + device.b * device.b);
+    glyph.fontSize = std::sqrt(device.c * device.c + device.d * device.d);
+    glyph.text = text;
+
+    // Testo con avanzamento verso sinistra (matrici speculari): normalizza
+    if (device.a < 0) {
+        glyph.x -= glyph.width;
+    }
+
+    output->glyphs.push_back(std::move(glyph));
+}
+
+void PdfTextEngine::ShowText(const std::string& bytes) {
+    PdfFont* font = state.font;
+    if (!font || !output) {
+        return;
+    }
+
+    double size = state.fontSize;
+    double scale = state.horizontalScale;
+    Matrix base = Matrix{ size * scale, 0, 0, size, 0, state.rise };
+
+    size_t pos = 0;
+    std::wstring text;
+    while (pos < bytes.size()) {
+        uint32_t code;
+        size_t length = font->NextCode(bytes, pos, code);
+        pos += length;
+
+        double w0 = font->GetAdvance(code);
+        double tx = (w0 * size + state.charSpacing +
+                     (font->IsWordSpace(code, length) ? state.wordSpacing : 0)) * scale;
+
+        text.clear();
+        font->AppendUnicode(code, text);
+        if (!text.empty()) {
+            Matrix trm = base.Multiply(textMatrix).Multiply(state.ctm);
+            // Avanzamento in unita' del glifo: la matrice trm applica gia' corpo e scala
+            double advance = size * scale != 0 ? tx / (size * scale) : 0;
+            AddGlyph(trm, advance, text);
+        }
+
+        textMatrix = Matrix{ 1, 0, 0, 1, tx, 0 }.Multiply(textMatrix);
+    }
+}
+
+void PdfTextEngine::RunContent(const std::string& content, const PdfObject* resources, int depth) {
+    PdfParser parser(content.data(), content.size());
+    std::vector<PdfObject> operands;
+    PdfObject obj;
+
+    auto num = [&operands](size_t i) -> double {
+        return i < operands.size() && operands[i].IsNumber() ? operands[i].number : 0;
+    };
+
+    while (parser.ReadObject(obj)) {
+        if (obj.type != PdfObject::Operator) {
+            if (operands.size() < MAX_OPERANDS) {
+                operands.push_back(std::move(obj));
+            }
+            continue;
+        }
+
+        const std::string& op = obj.text;
+        size_t n = operands.size();
+
+        if (op == "q") {
+            stateStack.push_back(state);
+        } else if (op == "Q") {
+            if (!stateStack.empty()) {
+                state = stateStack.back();
+                stateStack.pop_back();
+            }
+        } else if (op == "cm" && n >= 6) {
+            Matrix m{ num(0), num(1), num(2), num(3), num(4), num(5) };
+            state.ctm = m.Multiply(state.ctm);
+        } else if (op == "BT") {
+            textMatrix = lineMatrix = Matrix{ 1, 0, 0, 1, 0, 0 };
+        } else if (op == "Tf" && n >= 2) {
+            if (operands[0].type == PdfObject::Name) {
+                state.font = GetFont(resources, operands[0].text);
+            }
+            state.fontSize = num(1);
+        } else if (op == "Tc" && n >= 1) {
+            state.charSpacing = num(0);
+        } else if (op == "Tw" && n >= 1) {
+            state.wordSpacing = num(0);
+        } else if (op == "Tz" && n >= 1) {
+            state.horizontalScale = num(0) / 100.0;
+        } else if (op == "TL" && n >= 1) {
+            state.leading = num(0);
+        } else if (op == "Ts" && n >= 1) {
+            state.rise = num(0);
+        } else if ((op == "Td" || op == "TD") && n >= 2) {
+            if (op == "TD") {
+                state.leading = -num(1);
+            }
+            lineMatrix = Matrix{ 1, 0, 0, 1, num(0), num(1) }.Multiply(lineMatrix);
+            textMatrix = lineMatrix;
+        } else if (op == "Tm" && n >= 6) {
+            lineMatrix = Matrix{ num(0), num(1), num(2), num(3), num(4), num(5) };
+            textMatrix = lineMatrix;
+        } else if (op == "T*") {
+            lineMatrix = Matrix{ 1, 0, 0, 1, 0, -state.leading }.Multiply(lineMatrix);
+            textMatrix = lineMatrix;
+        } else if (op == "Tj" && n >= 1) {
+            ShowText(operands[0].text);
+        } else if (op == "'" && n >= 1) {
+            lineMatrix = Matrix{ 1, 0, 0, 1, 0, -state.leading }.Multiply(lineMatrix);
+            textMatrix = lineMatrix;
+            ShowText(operands[0].text);
+        } else if (op == "\"" && n >= 3) {
+            state.wordSpacing = num(0);
+            state.charSpacing = num(1);
+            lineMatrix = Matrix{ 1, 0, 0, 1, 0, -state.leading }.Multiply(lineMatrix);
+            textMatrix = lineMatrix;
+            ShowText(operands[2].text);
+        } else if (op == "TJ" && n >= 1 && operands[0].type == PdfObject::Array) {
+            for (const auto& item : operands[0].items) {
+                if (item.type == PdfObject::String) {
+                    ShowText(item.text);
+                } else if (item.IsNumber()) {
+                    double tx = -item.number / 1000.0 * state.fontSize * state.horizontalScale;
+                    textMatrix = Matrix{ 1, 0, 0, 1, tx, 0 }.Multiply(textMatrix);
+                }
+            }
+        } else if (op == "Do" && n >= 1 && operands[0].type == PdfObject::Name &&
+                   resources && depth < MAX_FORM_DEPTH) {
+            const PdfObject& xobjects = doc.GetResolved(*resources, "XObject");
+            const PdfObject& form = xobjects.IsDict() ? doc.GetResolved(xobjects, operands[0].text.c_str()) : xobjects;
+            const PdfObject* subtype = form.type == PdfObject::Stream ? form.Get("Subtype") : nullptr;
+            std::string formContent;
+            if (subtype && subtype->IsName("Form") && doc.GetStreamData(form, formContent)) {
+                GraphicsState saved = state;
+                Matrix savedText = textMatrix, savedLine = lineMatrix;
+
+                const PdfObject& matrix = doc.GetResolved(form, "Matrix");
+                if (matrix.type == PdfObject::Array && matrix.items.size() >= 6) {
+                    Matrix m{ doc.Resolve(matrix.items[0]).number, doc.Resolve(matrix.items[1]).number,
+                              doc.Resolve(matrix.items[2]).number, doc.Resolve(matrix.items[3]).number,
+                              doc.Resolve(matrix.items[4]).number, doc.Resolve(matrix.items[5]).number };
+                    state.ctm = m.Multiply(state.ctm);
+                }
+
+                const PdfObject& formResources = doc.GetResolved(form, "Resources");
+                size_t stackDepth = stateStack.size();
+                RunContent(formContent, formResources.IsDict() ? &formResources : resources, depth + 1);
+                stateStack.resize(std::min(stackDepth, stateStack.size()));
+
+                state = saved;
+                textMatrix = savedText;
+                lineMatrix = savedLine;
+            }
+        } else if (op == "BI") {
+            // Immagine inline: il dizionario arriva come operandi fino a ID
+            PdfObject token;
+            while (parser.ReadObject(token)) {
+                if (token.type == PdfObject::Operator && token.text == "ID") {
+                    parser.SkipInlineImage();
+                    break;
+                }
+            }
+        }
+
+        operands.clear();
+    }
+}
+
+// ============================================================================
+// Ricostruzione del layout
+// ============================================================================
+
+namespace {
+
+struct Line {
+    double baseline;
+    double fontSize;
+    std::vector<const PdfWord*> words;
+};
+
+bool IsBlank(const std::wstring& text) {
+    for (wchar_t c : text) {
+        if (c != L' ' && c != L'\t' && c != 0xA0 && c != L'\r' && c != L'\n') {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+std::vector<PdfWord> PdfTextEngine::BuildWords(const PdfPageText& page) {
+    std::vector<PdfWord> words;
+    PdfWord current;
+    bool open = false;
+
+    for (const auto& g : page.glyphs) {
+        if (g.fontSize <= 0) {
+            continue;
+        }
+
+        // Caratteri fuori dalla pagina visibile
+        double cx = g.x + g.width / 2;
+        double cy = g.y - g.fontSize / 3;
+        if (cx < 0 || cx > page.width || cy < 0 || cy > page.height) {
+            continue;
+        }
+
+        if (IsBlank(g.text)) {
+            if (open) {
+                words.push_back(std::move(current));
+                open = false;
+            }
+            continue;
+        }
+
+        if (open) {
+            double size = std::max(current.fontSize, g.fontSize);
+            double gap = g.x - current.x1;
+            bool sameLine = std::fabs(g.y - current.baseline) < 0.5 * size;
+            bool sameSize = std::fabs(g.fontSize - current.fontSize) < 0.4 * size;
+            if (!sameLine || !sameSize || gap > 0.1 * size || gap < -0.5 * size) {
+                words.push_back(std::move(current));
+                open = false;
+            }
+        }
+
+        if (!open) {
+            current = PdfWord{ g.x, g.x + g.width, g.y, g.fontSize, 0, std::wstring() };
+            open = true;
+        }
+        current.text += g.text;
+        current.chars += g.text.size();
+        current.x1 = std::max(current.x1, g.x + g.width);
+    }
+    if (open) {
+        words.push_back(std::move(current));
+    }
+
+    return words;
+}
+
+std::wstring PdfTextEngine::Layout(const PdfPageText& page, const PdfCropBox* crop) {
+    return Layout(BuildWords(page), crop);
+}
+
+std::wstring PdfTextEngine::Layout(const std::vector<PdfWord>& words, const PdfCropBox* crop) {
+    // 1. Parole nell'area richiesta
+    std::vector<const PdfWord*> selected;
+    selected.reserve(words.size());
+    for (const auto& word : words) {
+        if (crop) {
+            double cx = (word.x0 + word.x1) / 2;
+            double cy = word.baseline - word.fontSize / 3;
+            if (cx < crop->x || cx > crop->x + crop->width ||
+                cy < crop->y || cy > crop->y + crop->height) {
+                continue;
+            }
+        }
+        selected.push_back(&word);
+    }
+
+    if (selected.empty()) {
+        return L"";
+    }
+
+    // 2. Righe: parole con linea di base vicina, ordinate da sinistra a destra
+    std::stable_sort(selected.begin(), selected.end(),
+                     [](const PdfWord* a, const PdfWord* b) { return a->baseline < b->baseline; });
+
+    std::vector<Line> lines;
+    for (const PdfWord* word : selected) {
+        if (!lines.empty()) {
+            Line& last = lines.back();
+            double size = std::min(last.fontSize, word->fontSize);
+            if (word->baseline - last.baseline < 0.4 * size) {
+                last.words.push_back(word);
+                last.fontSize = std::max(last.fontSize, word->fontSize);
+                continue;
+            }
+        }
+        lines.push_back(Line{ word->baseline, word->fontSize, { word } });
+    }
+
+    // 3. Passo dei caratteri: larghezza media, per convertire le X in colonne
+    double totalWidth = 0;
+    size_t totalChars = 0;
+    double minX = selected[0]->x0;
+    for (auto& line : lines) {
+        std::stable_sort(line.words.begin(), line.words.end(),
+                         [](const PdfWord* a, const PdfWord* b) { return a->x0 < b->x0; });
+        for (const PdfWord* word : line.words) {
+            totalWidth += word->x1 - word->x0;
+            totalChars += word->chars;
+            minX = std::min(minX, word->x0);
+        }
+    }
+    double pitch = totalChars > 0 ? totalWidth / totalChars : 1;
+    if (pitch < 1) {
+        pitch = 1;
+    }
+
+    // 4. Composizione: ogni parola alla sua colonna, almeno uno spazio di
+    //    distanza; le spaziature verticali ampie diventano righe vuote
+    std::wstring result;
+    const Line* previous = nullptr;
+    for (const auto& line : lines) {
+        if (previous) {
+            double lineHeight = 1.2 * std::max(previous->fontSize, line.fontSize);
+            int blanks = static_cast<int>((line.baseline - previous->baseline) / lineHeight) - 1;
+            for (int i = 0; i < std::min(blanks, 2); i++) {
+                result += L'\n';
+            }
+        }
+
+        std::wstring text;
+        const PdfWord* last = nullptr;
+        for (const PdfWord* word : line.words) {
+            // Testo ripetuto sovrapposto (grassetto simulato): una sola copia
+            if (last && word->text == last->text && std::fabs(word->x0 - last->x0) < 0.2 * word->fontSize) {
+                continue;
+            }
+            // Parole ravvicinate: un solo spazio, le altre alla propria colonna
+            size_t column = static_cast<size_t>((word->x0 - minX) / pitch + 0.5);
+            if (last && (column <= text.size() || word->x0 - last->x1 < 1.5 * pitch)) {
+                column = text.size() + 1;
+            }
+            if (column > text.size()) {
+                text.append(column - text.size(), L' ');
+            }
+            text += word->text;
+            last = word;
+        }
+
+        result += text;
+        result += L'\n';
+        previous = &line;
+    }
+
+    return result;
+}
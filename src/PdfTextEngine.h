@@ -0,0 +1,97 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include "PdfDocument.h"
+#include "PdfFont.h"
+
+// Carattere posizionato sulla pagina (punti PDF, origine in alto a sinistra
+// della pagina visualizzata, come le coordinate di pdftotext)
+struct PdfGlyph {
+    double x;           // Bordo sinistro
+    double y;           // Linea di base
+    double width;       // Avanzamento
+    double fontSize;    // Corpo effettivo dopo le trasformazioni
+    std::wstring text;  // Testo Unicode (piu' caratteri per le legature)
+};
+
+struct PdfPageText {
+    double width;
+    double height;
+    std::vector<PdfGlyph> glyphs;   // In ordine di disegno
+};
+
+// Parola posizionata: caratteri consecutivi sulla stessa linea di base
+struct PdfWord {
+    double x0;          // Bordo sinistro
+    double x1;          // Bordo destro
+    double baseline;    // Linea di base
+    double fontSize;
+    size_t chars;       // Numero di caratteri (per il passo delle colonne)
+    std::wstring text;
+};
+
+// Area di ritaglio in punti, origine in alto a sinistra (-x -y -W -H di pdftotext)
+struct PdfCropBox {
+    double x;
+    double y;
+    double width;
+    double height;
+};
+
+// Interprete dei content stream: esegue gli operatori di testo e di stato
+// grafico (inclusi i Form XObject) e raccoglie i caratteri posizionati.
+// BuildWords() li raggruppa in parole una sola volta per pagina; Layout()
+// ricompone il testo impaginato in modo analogo a pdftotext -layout, anche
+// ritagliando piu' zone dalle stesse parole senza rileggere il PDF.
+class PdfTextEngine {
+public:
+    explicit PdfTextEngine(PdfDocument& document);
+
+    // Estrae i caratteri di una pagina (0-indexed)
+    bool ExtractPage(int pageIndex, PdfPageText& page);
+
+    // Raggruppa i caratteri visibili della pagina in parole
+    static std::vector<PdfWord> BuildWords(const PdfPageText& page);
+
+    // Ricostruisce righe e colonne. Con crop vengono tenute solo le parole
+    // il cui centro cade nell'area
+    static std::wstring Layout(const std::vector<PdfWord>& words, const PdfCropBox* crop = nullptr);
+    static std::wstring Layout(const PdfPageText& page, const PdfCropBox* crop = nullptr);
+
+    std::wstring GetLastError() const { return lastError; }
+
+private:
+    struct Matrix {
+        double a, b, c, d, e, f;
+        Matrix Multiply(const Matrix& m) const;
+    };
+
+    struct GraphicsState {
+        Matrix ctm;
+        PdfFont* font;
+        double fontSize;
+        double charSpacing;
+        double wordSpacing;
+        double horizontalScale;
+        double leading;
+        double rise;
+    };
+
+    void RunContent(const std::string& content, const PdfObject* resources, int depth);
+    void ShowText(const std::string& bytes);
+    PdfFont* GetFont(const PdfObject* resources, const std::string& name);
+    void AddGlyph(const Matrix& trm, double advance, const std::wstring& text);
+
+    PdfDocument& doc;
+    std::unordered_map<const PdfObject*, std::unique_ptr<PdfFont>> fonts;
+
+    GraphicsState state;
+    std::vector<GraphicsState> stateStack;
+    Matrix textMatrix;
+    Matrix lineMatrix;
+    Matrix pageMatrix;      // Spazio utente -> pagina visualizzata
+    PdfPageText* output;
+    std::wstring lastError;
+};
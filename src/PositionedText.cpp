@@ -0,0 +1,332 @@
+#include "PositionedText.h"
+#include "Subprocess.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Lato delle celle della griglia in punti: poche parole per cella con i
+// corpi tipici dei referti (9-12 pt)
+const double CELL_SIZE = 24.0;
+
+std::string ToUtf8(const std::wstring& text) {
+    std::string result;
+    result.reserve(text.size());
+    for (size_t i = 0; i < text.size(); i++) {
+        char32_t c = static_cast<char32_t>(text[i]);
+        // wchar_t a 16 bit: ricompone le coppie surrogate
+        if (sizeof(wchar_t) == 2 && c >= 0xD800 && c <= 0xDBFF && i + 1 < text.size()) {
+            c = 0x10000 + ((c - 0xD800) << 10) + (static_cast<char32_t>(text[++i]) - 0xDC00);
+        }
+        if (c < 0x80) {
+            result += static_cast<char>(c);
+        } else if (c < 0x800) {
+            result += static_cast<char>(0xC0 | (c >> 6));
+            result += static_cast<char>(0x80 | (c & 0x3F));
+        } else if (c < 0x10000) {
+            result += static_cast<char>(0xE0 | (c >> 12));
+            result += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            result += static_cast<char>(0x80 | (c & 0x3F));
+        } else {
+            result += static_cast<char>(0xF0 | (c >> 18));
+            result += static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+            result += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            result += static_cast<char>(0x80 | (c & 0x3F));
+        }
+    }
+    return result;
+}
+
+std::wstring FromUtf8(const std::string& utf8) {
+    std::wstring result;
+    result.reserve(utf8.size());
+    Subprocess::Utf8Decoder decoder;
+    decoder.Feed(utf8.data(), utf8.size(), result);
+    decoder.Finish(result);
+    return result;
+}
+
+// Valore numerico di un attributo XML nel tag [begin, end)
+double FindAttribute(const std::wstring& xml, size_t begin, size_t end, const wchar_t* name) {
+    std::wstring key = std::wstring(L" ") + name + L"=\"";
+    size_t pos = xml.find(key, begin);
+    if (pos == std::wstring::npos || pos >= end) {
+        return 0.0;
+    }
+    return wcstod(xml.c_str() + pos + key.size(), nullptr);
+}
+
+// Decodifica le entita' XML emesse da pdftotext
+std::wstring DecodeEntities(const std::wstring& text) {
+    if (text.find(L'&') == std::wstring::npos) {
+        return text;
+    }
+
+    static const struct { const wchar_t* entity; wchar_t value; } entities[] = {
+        { L"&amp;", L'&' }, { L"&lt;", L'<' }, { L"&gt;", L'>' },
+        { L"&quot;", L'"' }, { L"&apos;", L'\'' }
+    };
+
+    std::wstring result;
+    for (size_t i = 0; i < text.size(); i++) {
+        bool decoded = false;
+        if (text[i] == L'&') {
+            for (const auto& e : entities) {
+                size_t length = wcslen(e.entity);
+                if (text.compare(i, length, e.entity) == 0) {
+                    result += e.value;
+                    i += length - 1;
+                    decoded = true;
+                    break;
+                }
+            }
+        }
+        if (!decoded) {
+            result += text[i];
+        }
+    }
+    return result;
+}
+
+}
+
+PositionedText::PositionedText() {
+    textStart.push_back(0);
+}
+
+void PositionedText::Clear() {
+    x0.clear();
+    y0.clear();
+    x1.clear();
+    y1.clear();
+    page.clear();
+    textStart.assign(1, 0);
+    arena.clear();
+    pages.clear();
+}
+
+void PositionedText::AddPage(double width, double height) {
+    PageIndex index;
+    index.width = width;
+    index.height = height;
+    index.firstWord = static_cast<uint32_t>(x0.size());
+    index.endWord = index.firstWord;
+    index.columns = 0;
+    index.rows = 0;
+    pages.push_back(std::move(index));
+}
+
+void PositionedText::AddWord(double wx0, double wy0, double wx1, double wy1, const std::wstring& text) {
+    if (pages.empty() || text.empty()) {
+        return;
+    }
+
+    x0.push_back(static_cast<float>(wx0));
+    y0.push_back(static_cast<float>(wy0));
+    x1.push_back(static_cast<float>(wx1));
+    y1.push_back(static_cast<float>(wy1));
+    page.push_back(static_cast<uint32_t>(pages.size() - 1));
+
+    arena += ToUtf8(text);
+    textStart.push_back(static_cast<uint32_t>(arena.size()));
+
+    pages.back().endWord = static_cast<uint32_t>(x0.size());
+}
+
+int PositionedText::CellColumn(const PageIndex& index, double x) const {
+    int column = static_cast<int>(std::floor(x / CELL_SIZE));
+    return std::clamp(column, 0, index.columns - 1);
+}
+
+int PositionedText::CellRow(const PageIndex& index, double y) const {
+    int row = static_cast<int>(std::floor(y / CELL_SIZE));
+    return std::clamp(row, 0, index.rows - 1);
+}
+
+void PositionedText::BuildIndex() {
+    for (auto& index : pages) {
+        index.columns = std::max(1, static_cast<int>(std::ceil(index.width / CELL_SIZE)));
+        index.rows = std::max(1, static_cast<int>(std::ceil(index.height / CELL_SIZE)));
+        size_t cells = static_cast<size_t>(index.columns) * index.rows;
+
+        // Ogni parola va nella cella del suo centro (fuori pagina: cella di bordo).
+        // Due passate: conteggio per cella, poi riempimento (layout compatto)
+        std::vector<uint32_t> cellOf(index.endWord - index.firstWord);
+        index.cellStart.assign(cells + 1, 0);
+        for (uint32_t i = index.firstWord; i < index.endWord; i++) {
+            double cx = (x0[i] + x1[i]) / 2;
+            double cy = (y0[i] + y1[i]) / 2;
+            uint32_t cell = static_cast<uint32_t>(CellRow(index, cy) * index.columns + CellColumn(index, cx));
+            cellOf[i - index.firstWord] = cell;
+            index.cellStart[cell + 1]++;
+        }
+        for (size_t c = 0; c < cells; c++) {
+            index.cellStart[c + 1] += index.cellStart[c];
+        }
+
+        std::vector<uint32_t> fill(index.cellStart.begin(), index.cellStart.end() - 1);
+        index.cellWords.resize(index.endWord - index.firstWord);
+        for (uint32_t i = index.firstWord; i < index.endWord; i++) {
+            index.cellWords[fill[cellOf[i - index.firstWord]]++] = i;
+        }
+    }
+}
+
+std::string_view PositionedText::GetWordText(size_t index) const {
+    return std::string_view(arena.data() + textStart[index], textStart[index + 1] - textStart[index]);
+}
+
+std::vector<uint32_t> PositionedText::FindWords(int pageIndex, double x, double y, double width, double height) const {
+    std::vector<uint32_t> found;
+    if (pageIndex < 0 || pageIndex >= GetPageCount()) {
+        return found;
+    }
+
+    const PageIndex& index = pages[pageIndex];
+    if (index.cellStart.empty() || index.firstWord == index.endWord) {
+        return found;
+    }
+
+    double right = x + width;
+    double bottom = y + height;
+    int firstColumn = CellColumn(index, x);
+    int lastColumn = CellColumn(index, right);
+    int firstRow = CellRow(index, y);
+    int lastRow = CellRow(index, bottom);
+
+    for (int row = firstRow; row <= lastRow; row++) {
+        for (int column = firstColumn; column <= lastColumn; column++) {
+            size_t cell = static_cast<size_t>(row) * index.columns + column;
+            for (uint32_t k = index.cellStart[cell]; k < index.cellStart[cell + 1]; k++) {
+                uint32_t i = index.cellWords[k];
+                double cx = (x0[i] + x1[i]) / 2;
+                double cy = (y0[i] + y1[i]) / 2;
+                if (cx >= x && cx <= right && cy >= y && cy <= bottom) {
+                    found.push_back(i);
+                }
+            }
+        }
+    }
+
+    // Ordine di lettura: righe per centro verticale, poi da sinistra a destra
+    std::sort(found.begin(), found.end(), [this](uint32_t a, uint32_t b) {
+        return y0[a] + y1[a] < y0[b] + y1[b];
+    });
+
+    size_t lineStart = 0;
+    for (size_t k = 1; k <= found.size(); k++) {
+        bool lineEnd = k == found.size();
+        if (!lineEnd) {
+            uint32_t first = found[lineStart];
+            uint32_t current = found[k];
+            double tolerance = std::min(y1[first] - y0[first], y1[current] - y0[current]) / 2;
+            lineEnd = (y0[current] + y1[current]) / 2 - (y0[first] + y1[first]) / 2 > tolerance;
+        }
+        if (lineEnd) {
+            std::sort(found.begin() + lineStart, found.begin() + k,
+                      [this](uint32_t a, uint32_t b) { return x0[a] < x0[b]; });
+            lineStart = k;
+        }
+    }
+
+    return found;
+}
+
+std::wstring PositionedText::QueryText(int pageIndex, double x, double y, double width, double height) const {
+    std::vector<uint32_t> found = FindWords(pageIndex, x, y, width, height);
+
+    // Stesso criterio di riga di FindWords: a capo quando il centro verticale
+    // si allontana dalla prima parola della riga
+    std::string text;
+    uint32_t lineFirst = 0;
+    for (size_t k = 0; k < found.size(); k++) {
+        uint32_t i = found[k];
+        if (k > 0) {
+            double tolerance = std::min(y1[lineFirst] - y0[lineFirst], y1[i] - y0[i]) / 2;
+            if ((y0[i] + y1[i]) / 2 - (y0[lineFirst] + y1[lineFirst]) / 2 > tolerance) {
+                text += '\n';
+                lineFirst = i;
+            } else {
+                text += ' ';
+            }
+        } else {
+            lineFirst = i;
+        }
+        text.append(GetWordText(i));
+    }
+
+    return FromUtf8(text);
+}
+
+std::wstring PositionedText::ResolveZones(const std::vector<ExtractionZone>& zones) const {
+    std::wstring result;
+
+    for (int p = 0; p < GetPageCount(); p++) {
+        for (const auto& zone : zones) {
+            if (!zone.pages.empty() &&
+                std::find(zone.pages.begin(), zone.pages.end(), p) == zone.pages.end()) {
+                continue;
+            }
+
+            std::wstring text = QueryText(p, zone.x, zone.y, zone.width, zone.height);
+            if (!text.empty()) {
+                if (!result.empty()) {
+                    result += L'\n';
+                }
+                result += text;
+            }
+        }
+    }
+
+    return result;
+}
+
+LayoutFingerprint PositionedText::GetLayout(int pageIndex) const {
+    LayoutFingerprint layout;
+    if (pageIndex < 0 || pageIndex >= GetPageCount()) {
+        return layout;
+    }
+
+    const PageIndex& index = pages[pageIndex];
+    layout.SetPageSize(index.width, index.height);
+    for (uint32_t w = index.firstWord; w < index.endWord; w++) {
+        layout.AddBox(x0[w], y0[w], x1[w], y1[w]);
+    }
+    return layout;
+}
+
+bool PositionedText::ParseBBoxLayout(const std::wstring& xhtml) {
+    size_t pageCount = pages.size();
+
+    size_t pos = 0;
+    while (true) {
+        size_t pageTag = xhtml.find(L"<page ", pos);
+        size_t wordTag = xhtml.find(L"<word ", pos);
+        if (pageTag == std::wstring::npos && wordTag == std::wstring::npos) {
+            break;
+        }
+
+        if (pageTag < wordTag) {
+            size_t tagEnd = xhtml.find(L'>', pageTag);
+            if (tagEnd == std::wstring::npos) break;
+            AddPage(FindAttribute(xhtml, pageTag, tagEnd, L"width"),
+                    FindAttribute(xhtml, pageTag, tagEnd, L"height"));
+            pos = tagEnd + 1;
+        } else {
+            size_t tagEnd = xhtml.find(L'>', wordTag);
+            if (tagEnd == std::wstring::npos) break;
+            size_t close = xhtml.find(L"</word>", tagEnd);
+            if (close == std::wstring::npos) break;
+
+            AddWord(FindAttribute(xhtml, wordTag, tagEnd, L"xMin"),
+                    FindAttribute(xhtml, wordTag, tagEnd, L"yMin"),
+                    FindAttribute(xhtml, wordTag, tagEnd, L"xMax"),
+                    FindAttribute(xhtml, wordTag, tagEnd, L"yMax"),
+                    DecodeEntities(xhtml.substr(tagEnd + 1, close - tagEnd - 1)));
+            pos = close + 7;
+        }
+    }
+
+    BuildIndex();
+    return pages.size() > pageCount;
+}
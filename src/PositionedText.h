@@ -0,0 +1,78 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include "ZoneProfile.h"
+#include "LayoutFingerprint.h"
+
+// Parole posizionate di un intero documento, memorizzate per colonne
+// (x0, y0, x1, y1, pagina, offset nel testo) con il testo UTF-8 in un'unica
+// arena. Per ogni pagina una griglia uniforme indicizza le parole per centro:
+// una zona si risolve visitando solo le celle che interseca, senza rileggere
+// il PDF. Coordinate in punti, origine in alto a sinistra (come PyMuPDF).
+class PositionedText {
+public:
+    PositionedText();
+
+    void Clear();
+
+    // Inizia una nuova pagina: le parole successive appartengono a questa
+    void AddPage(double width, double height);
+
+    // Aggiunge una parola all'ultima pagina (ignorata se non ci sono pagine)
+    void AddWord(double x0, double y0, double x1, double y1, const std::wstring& text);
+
+    // Costruisce le griglie di tutte le pagine. Va chiamato dopo l'ultima
+    // AddWord e prima delle ricerche
+    void BuildIndex();
+
+    // Impronta dell'impaginazione di una pagina (0-indexed), vuota se la
+    // pagina non esiste o non ha testo
+    LayoutFingerprint GetLayout(int page) const;
+
+    // Legge l'output di pdftotext -bbox-layout (pagine e parole con bbox) e
+    // lo aggiunge dopo le pagine gia' presenti; false se non contiene pagine
+    bool ParseBBoxLayout(const std::wstring& xhtml);
+
+    int GetPageCount() const { return static_cast<int>(pages.size()); }
+    size_t GetWordCount() const { return x0.size(); }
+    std::string_view GetWordText(size_t index) const;
+
+    // Indici delle parole il cui centro cade nel rettangolo, in ordine di
+    // lettura (righe dall'alto, parole da sinistra). page e' 0-indexed
+    std::vector<uint32_t> FindWords(int page, double x, double y, double width, double height) const;
+
+    // Testo del rettangolo: parole separate da spazio, righe da '\n'
+    std::wstring QueryText(int page, double x, double y, double width, double height) const;
+
+    // Testo delle zone di un profilo, come extract_zones.py: pagina per pagina,
+    // zona per zona, testi non vuoti separati da '\n'. pages vuoto = tutte
+    std::wstring ResolveZones(const std::vector<ExtractionZone>& zones) const;
+
+private:
+    struct PageIndex {
+        double width;
+        double height;
+        uint32_t firstWord;             // Parole della pagina: [firstWord, endWord)
+        uint32_t endWord;
+        int columns;
+        int rows;
+        std::vector<uint32_t> cellStart;    // columns * rows + 1 offset in cellWords
+        std::vector<uint32_t> cellWords;    // Indici delle parole, raggruppati per cella
+    };
+
+    int CellColumn(const PageIndex& page, double x) const;
+    int CellRow(const PageIndex& page, double y) const;
+
+    // Colonne delle parole
+    std::vector<float> x0;
+    std::vector<float> y0;
+    std::vector<float> x1;
+    std::vector<float> y1;
+    std::vector<uint32_t> page;
+    std::vector<uint32_t> textStart;    // GetWordCount() + 1 offset nell'arena
+
+    std::string arena;                  // Testo UTF-8 di tutte le parole
+    std::vector<PageIndex> pages;
+};
@@ -0,0 +1,231 @@
+#include "ProcessExecutor.h"
+#include <algorithm>
+
+std::deque<std::unique_ptr<ProcessExecutor::Job>> ProcessExecutor::pending;
+std::list<std::unique_ptr<ProcessExecutor::Job>> ProcessExecutor::active;
+unsigned ProcessExecutor::limit = 1;
+uint64_t ProcessExecutor::nextId = 1;
+std::thread ProcessExecutor::ioThread;
+std::mutex ProcessExecutor::mutex;
+bool ProcessExecutor::running = false;
+bool ProcessExecutor::stopping = false;
+std::atomic<uint64_t> ProcessExecutor::runningCount(0);
+std::atomic<uint64_t> ProcessExecutor::completedCount(0);
+std::atomic<uint64_t> ProcessExecutor::timedOutCount(0);
+thread_local std::wstring ProcessExecutor::lastError;
+
+namespace {
+
+// Attesa massima del loop senza eventi ne' scadenze
+const std::chrono::milliseconds IDLE_WAIT(1000);
+
+// Intervallo di verifica della terminazione dei processi durante l'arresto
+const std::chrono::milliseconds STOP_POLL(10);
+
+std::wstring TimeoutMessage(const std::wstring& program, std::chrono::milliseconds timeout) {
+    return L"Timeout di " + program + L" (" + std::to_wstring(timeout.count() / 1000) + L"s)";
+}
+
+}
+
+bool ProcessExecutor::Start(unsigned maxProcesses) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return StartLocked(maxProcesses);
+}
+
+bool ProcessExecutor::StartLocked(unsigned maxProcesses) {
+    lastError.clear();
+    limit = maxProcesses > 0 ? maxProcesses : std::max(1u, std::thread::hardware_concurrency());
+    if (running) {
+        return true;
+    }
+    if (stopping) {
+        lastError = L"Esecutore dei processi in arresto";
+        return false;
+    }
+
+    if (!OpenLoop()) {
+        return false;
+    }
+    running = true;
+    ioThread = std::thread(&ProcessExecutor::IoThread);
+    return true;
+}
+
+void ProcessExecutor::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) {
+            return;
+        }
+        running = false;
+        stopping = true;
+    }
+    Wake();
+
+    if (ioThread.joinable()) {
+        ioThread.join();
+    }
+    CloseLoop();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = false;
+}
+
+void ProcessExecutor::Submit(const std::wstring& program, const std::vector<std::wstring>& args,
+                             const std::string& input, std::chrono::milliseconds timeout,
+                             Completion completion, size_t outputReserve) {
+    auto job = std::make_unique<Job>();
+    job->program = program;
+    job->args = args;
+    job->input = input;
+    job->timeout = timeout;
+    job->outputReserve = outputReserve;
+    job->completion = std::move(completion);
+    job->result = { false, false, -1, std::wstring(), std::wstring() };
+    job->written = 0;
+    job->exited = false;
+    job->outputClosed = false;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        // Primo job senza Start esplicito: valori predefiniti
+        if (running || StartLocked(0)) {
+            job->id = nextId++;
+            pending.push_back(std::move(job));
+        }
+    }
+
+    if (job) {
+        job->result.error = L"Esecutore dei processi non disponibile: " + lastError;
+        Complete(*job);
+        return;
+    }
+    Wake();
+}
+
+std::future<Subprocess::Result> ProcessExecutor::RunAsync(const std::wstring& program,
+                                                          const std::vector<std::wstring>& args,
+                                                          const std::string& input,
+                                                          std::chrono::milliseconds timeout,
+                                                          size_t outputReserve) {
+    auto promise = std::make_shared<std::promise<Subprocess::Result>>();
+    std::future<Subprocess::Result> future = promise->get_future();
+    Submit(program, args, input, timeout, [promise](Subprocess::Result&& result) {
+        promise->set_value(std::move(result));
+    }, outputReserve);
+    return future;
+}
+
+ProcessExecutor::Stats ProcessExecutor::GetStats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return { pending.size(), runningCount.load(), completedCount.load(), timedOutCount.load() };
+}
+
+std::wstring ProcessExecutor::GetLastError() {
+    return lastError;
+}
+
+void ProcessExecutor::Complete(Job& job) {
+    job.decoder.Finish(job.result.output);
+    if (job.result.timedOut) {
+        job.result.exitCode = -1;
+    }
+    completedCount++;
+
+    // Un'eccezione nella callback non deve fermare il thread di I/O
+    try {
+        job.completion(std::move(job.result));
+    } catch (...) {
+    }
+}
+
+void ProcessExecutor::IoThread() {
+    std::vector<std::unique_ptr<Job>> finished;
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (running || !pending.empty() || !active.empty()) {
+        // Avvio dei job in coda fino al limite; in arresto vengono scartati
+        while (!pending.empty() && (!running || active.size() < limit)) {
+            std::unique_ptr<Job> job = std::move(pending.front());
+            pending.pop_front();
+
+            if (!running) {
+                job->result.error = L"Esecutore dei processi arrestato";
+                finished.push_back(std::move(job));
+                continue;
+            }
+
+            lock.unlock();
+            job->deadline = std::chrono::steady_clock::now() + job->timeout;
+            bool launched = Launch(*job);
+            lock.lock();
+
+            if (launched) {
+                runningCount++;
+                active.push_back(std::move(job));
+            } else {
+                finished.push_back(std::move(job));
+            }
+        }
+        bool stopRequested = !running;
+        lock.unlock();
+
+        // Attesa degli eventi fino alla prima scadenza (senza attesa se ci
+        // sono job da consegnare)
+        auto now = std::chrono::steady_clock::now();
+        std::chrono::milliseconds wait = IDLE_WAIT;
+        for (const auto& job : active) {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(job->deadline - now);
+            wait = std::min(wait, std::max(std::chrono::milliseconds(0), remaining + std::chrono::milliseconds(1)));
+        }
+        if (stopRequested) {
+            wait = std::min(wait, STOP_POLL);
+        }
+        if (!finished.empty()) {
+            wait = std::chrono::milliseconds(0);
+        }
+        WaitEvents(wait);
+
+        // Scadenze, arresto e job conclusi
+        now = std::chrono::steady_clock::now();
+        for (auto it = active.begin(); it != active.end();) {
+            Job& job = **it;
+            bool expired = stopRequested || now >= job.deadline;
+
+            if (expired && !job.exited) {
+                Kill(job);
+                if (!job.result.timedOut) {
+                    job.result.timedOut = true;
+                    job.result.error = stopRequested ? L"Esecutore dei processi arrestato"
+                                                     : TimeoutMessage(job.program, job.timeout);
+                    timedOutCount++;
+                }
+            } else if (expired && !IsFinished(job)) {
+                // Processo terminato ma pipe ancora aperte da un discendente
+                AbandonOutput(job);
+                if (!job.result.timedOut) {
+                    job.result.timedOut = true;
+                    job.result.error = TimeoutMessage(job.program, job.timeout);
+                    timedOutCount++;
+                }
+            }
+
+            if (IsFinished(job)) {
+                Release(job);
+                runningCount--;
+                finished.push_back(std::move(*it));
+                it = active.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        for (auto& job : finished) {
+            Complete(*job);
+        }
+        finished.clear();
+
+        lock.lock();
+    }
+}
@@ -0,0 +1,154 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <list>
+#include <memory>
+#include <functional>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include "Subprocess.h"
+
+// Esecutore asincrono dei processi esterni (pdftotext, pdfinfo, python,
+// claude). Un solo thread di I/O avvia i figli, scrive l'input, legge
+// l'output e rileva la terminazione di tutti i processi in corso: nessun
+// thread resta bloccato su un singolo processo.
+// Il backend dipende dalla piattaforma:
+//   - Windows: pipe con nome overlapped e job object su una I/O completion
+//     port (ProcessExecutorWin32.cpp)
+//   - Linux:   pipe non bloccanti e pidfd in un epoll (ProcessExecutorPosix.cpp)
+// Ogni job ha una scadenza che decorre dall'avvio del processo: allo scadere
+// il processo viene terminato (su Windows con i suoi discendenti). Oltre il
+// limite di processi contemporanei i job attendono in coda, in ordine di arrivo.
+class ProcessExecutor {
+public:
+    // Chiamata sul thread di I/O a processo concluso: deve essere breve
+    using Completion = std::function<void(Subprocess::Result&&)>;
+
+    struct Stats {
+        uint64_t queued;        // Job in attesa di un posto
+        uint64_t running;       // Processi in corso
+        uint64_t completed;     // Job conclusi (anche con errore)
+        uint64_t timedOut;      // Processi terminati per timeout
+    };
+
+    // Avvia il thread di I/O. maxProcesses = 0: numero di core.
+    // Senza Start esplicito l'esecutore parte al primo job
+    static bool Start(unsigned maxProcesses);
+
+    // Termina i processi in corso e completa i job in coda come non avviati
+    static void Stop();
+
+    // Accoda un processo; completion riceve il risultato
+    static void Submit(const std::wstring& program, const std::vector<std::wstring>& args,
+                       const std::string& input, std::chrono::milliseconds timeout,
+                       Completion completion, size_t outputReserve = 64 * 1024);
+
+    // Come Submit, con il risultato consegnato tramite future
+    static std::future<Subprocess::Result> RunAsync(const std::wstring& program,
+                                                    const std::vector<std::wstring>& args,
+                                                    const std::string& input,
+                                                    std::chrono::milliseconds timeout,
+                                                    size_t outputReserve = 64 * 1024);
+
+    static Stats GetStats();
+
+    // Restituisce l'ultimo errore
+    static std::wstring GetLastError();
+
+private:
+    struct Job;
+
+#ifdef _WIN32
+    // Operazione overlapped in corso su una delle pipe del job
+    struct IoRequest {
+        OVERLAPPED overlapped;
+        Job* job;
+        bool pending;
+    };
+#else
+    // Descrittore registrato nell'epoll
+    struct Watch {
+        Job* job;
+        int kind;
+    };
+#endif
+
+    struct Job {
+        uint64_t id;
+        std::wstring program;
+        std::vector<std::wstring> args;
+        std::string input;
+        std::chrono::milliseconds timeout;
+        std::chrono::steady_clock::time_point deadline;
+        size_t outputReserve;
+        Completion completion;
+        Subprocess::Result result;
+        Subprocess::Utf8Decoder decoder;
+        size_t written;             // Byte di input gia' scritti
+        bool exited;                // Processo terminato
+        bool outputClosed;          // Fine di stdout (o lettura abbandonata)
+#ifdef _WIN32
+        HANDLE process;
+        DWORD processId;
+        HANDLE jobObject;           // Include i discendenti: terminati insieme allo scadere
+        HANDLE inWrite;
+        HANDLE outRead;
+        IoRequest readRequest;
+        IoRequest writeRequest;
+        char buffer[16384];
+#else
+        int pid;
+        int pidFd;                  // -1 se pidfd non e' supportato dal kernel
+        int inFd;
+        int outFd;
+        Watch inWatch;
+        Watch outWatch;
+        Watch exitWatch;
+#endif
+    };
+
+    static bool StartLocked(unsigned maxProcesses);
+    static void IoThread();
+    static void Complete(Job& job);
+
+    // Primitive implementate dal backend di piattaforma
+    static bool OpenLoop();
+    static void CloseLoop();
+    static void Wake();
+    static bool Launch(Job& job);
+    static void WaitEvents(std::chrono::milliseconds maxWait);
+    static void Kill(Job& job);
+    static void AbandonOutput(Job& job);    // Rinuncia a stdin/stdout tenuti aperti da discendenti
+    static void Release(Job& job);
+
+    // Job concluso: processo terminato, output chiuso e nessuna I/O in corso
+    static bool IsFinished(const Job& job);
+
+#ifdef _WIN32
+    static void IssueRead(Job& job);
+    static void IssueWrite(Job& job);
+    static void MarkExited(Job& job);
+#else
+    static void ReadOutput(Job& job);
+    static void WriteInput(Job& job);
+    static void Reap(Job& job);
+#endif
+
+    static std::deque<std::unique_ptr<Job>> pending;    // Protetta da mutex
+    static std::list<std::unique_ptr<Job>> active;      // Solo thread di I/O
+    static unsigned limit;
+    static uint64_t nextId;
+    static std::thread ioThread;
+    static std::mutex mutex;
+    static bool running;
+    static bool stopping;                               // Stop in corso: niente riavvii
+    static std::atomic<uint64_t> runningCount;
+    static std::atomic<uint64_t> completedCount;
+    static std::atomic<uint64_t> timedOutCount;
+    static thread_local std::wstring lastError;
+};
@@ -0,0 +1,230 @@
+// Backend Linux di ProcessExecutor: un epoll raccoglie stdin e stdout di
+// tutti i figli e un pidfd per processo ne segnala la terminazione; un
+// eventfd sveglia il loop per i nuovi job e per lo stop. Senza pidfd
+// (kernel precedenti alla 5.3) la terminazione viene verificata con
+// waitpid a intervalli brevi.
+#include "ProcessExecutor.h"
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+namespace {
+
+int epollFd = -1;
+int wakeFd = -1;
+
+enum WatchKind { WATCH_INPUT, WATCH_OUTPUT, WATCH_EXIT };
+
+// Verifica della terminazione dei processi senza pidfd
+const std::chrono::milliseconds REAP_INTERVAL(10);
+
+void Register(int fd, uint32_t events, void* watch) {
+    epoll_event event = {};
+    event.events = events;
+    event.data.ptr = watch;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+}
+
+// Il descrittore viene tolto dall'epoll prima della chiusura: un figlio in
+// fase di fork/exec puo' tenerne aperta una copia per qualche istante
+void CloseWatched(int& fd) {
+    if (fd >= 0) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+        fd = -1;
+    }
+}
+
+}
+
+bool ProcessExecutor::OpenLoop() {
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (epollFd < 0 || wakeFd < 0) {
+        lastError = L"Impossibile creare l'epoll: " + std::to_wstring(errno);
+        CloseLoop();
+        return false;
+    }
+    Register(wakeFd, EPOLLIN, nullptr);
+    return true;
+}
+
+void ProcessExecutor::CloseLoop() {
+    if (wakeFd >= 0) {
+        close(wakeFd);
+        wakeFd = -1;
+    }
+    if (epollFd >= 0) {
+        close(epollFd);
+        epollFd = -1;
+    }
+}
+
+void ProcessExecutor::Wake() {
+    uint64_t one = 1;
+    if (write(wakeFd, &one, sizeof(one)) < 0) {
+        // Contatore gia' pieno: il loop e' comunque da svegliare
+    }
+}
+
+bool ProcessExecutor::Launch(Job& job) {
+    job.inFd = -1;
+    job.outFd = -1;
+    job.pidFd = -1;
+    job.pid = Subprocess::Spawn(job.program, job.args, job.inFd, job.outFd, job.result.error);
+    if (job.pid < 0) {
+        return false;
+    }
+
+    job.result.started = true;
+    job.result.output.reserve(job.outputReserve);
+
+#ifdef SYS_pidfd_open
+    job.pidFd = static_cast<int>(syscall(SYS_pidfd_open, job.pid, 0));
+#endif
+
+    job.inWatch = { &job, WATCH_INPUT };
+    job.outWatch = { &job, WATCH_OUTPUT };
+    job.exitWatch = { &job, WATCH_EXIT };
+
+    if (job.input.empty()) {
+        close(job.inFd);
+        job.inFd = -1;
+    } else {
+        Register(job.inFd, EPOLLOUT, &job.inWatch);
+    }
+    Register(job.outFd, EPOLLIN, &job.outWatch);
+    if (job.pidFd >= 0) {
+        Register(job.pidFd, EPOLLIN, &job.exitWatch);
+    }
+    return true;
+}
+
+void ProcessExecutor::WaitEvents(std::chrono::milliseconds maxWait) {
+    bool polling = false;
+    for (const auto& job : active) {
+        if (job->pidFd < 0 && !job->exited) {
+            polling = true;
+        }
+    }
+    if (polling) {
+        maxWait = std::min(maxWait, REAP_INTERVAL);
+    }
+
+    epoll_event events[64];
+    int count = epoll_wait(epollFd, events, 64, static_cast<int>(maxWait.count()));
+
+    for (int i = 0; i < count; i++) {
+        Watch* watch = static_cast<Watch*>(events[i].data.ptr);
+        if (watch == nullptr) {
+            uint64_t value;
+            while (read(wakeFd, &value, sizeof(value)) > 0) {
+            }
+            continue;
+        }
+
+        switch (watch->kind) {
+        case WATCH_INPUT:
+            WriteInput(*watch->job);
+            break;
+        case WATCH_OUTPUT:
+            ReadOutput(*watch->job);
+            break;
+        case WATCH_EXIT:
+            Reap(*watch->job);
+            break;
+        }
+    }
+
+    if (polling) {
+        for (auto& job : active) {
+            if (job->pidFd < 0) {
+                Reap(*job);
+            }
+        }
+    }
+}
+
+void ProcessExecutor::ReadOutput(Job& job) {
+    char buffer[16384];
+    while (job.outFd >= 0) {
+        ssize_t n = read(job.outFd, buffer, sizeof(buffer));
+        if (n > 0) {
+            job.decoder.Feed(buffer, static_cast<size_t>(n), job.result.output);
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            if (n == 0 || errno != EAGAIN) {
+                CloseWatched(job.outFd);
+                job.outputClosed = true;
+            }
+            return;
+        }
+    }
+}
+
+void ProcessExecutor::WriteInput(Job& job) {
+    while (job.inFd >= 0 && job.written < job.input.size()) {
+        ssize_t n = write(job.inFd, job.input.data() + job.written, job.input.size() - job.written);
+        if (n > 0) {
+            job.written += static_cast<size_t>(n);
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            if (n < 0 && errno == EAGAIN) {
+                return;
+            }
+            break;
+        }
+    }
+    // Input completo o figlio che non legge piu' (EPIPE)
+    CloseWatched(job.inFd);
+}
+
+void ProcessExecutor::Reap(Job& job) {
+    if (job.exited) {
+        return;
+    }
+
+    int status = 0;
+    pid_t done = waitpid(job.pid, &status, WNOHANG);
+    if (done == 0 || (done < 0 && errno == EINTR)) {
+        return;
+    }
+
+    job.exited = true;
+    CloseWatched(job.pidFd);
+    if (done == job.pid && WIFEXITED(status)) {
+        job.result.exitCode = WEXITSTATUS(status);
+        if (job.result.exitCode == 127) {
+            job.result.error = L"Impossibile avviare " + job.program;
+        }
+    }
+}
+
+void ProcessExecutor::Kill(Job& job) {
+    if (!job.exited) {
+        kill(job.pid, SIGKILL);
+    }
+}
+
+void ProcessExecutor::AbandonOutput(Job& job) {
+    CloseWatched(job.inFd);
+    CloseWatched(job.outFd);
+    job.outputClosed = true;
+}
+
+void ProcessExecutor::Release(Job& job) {
+    CloseWatched(job.inFd);
+    CloseWatched(job.outFd);
+    CloseWatched(job.pidFd);
+}
+
+bool ProcessExecutor::IsFinished(const Job& job) {
+    return job.exited && job.outputClosed;
+}
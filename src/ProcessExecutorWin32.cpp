@@ -0,0 +1,249 @@
+// Backend Windows di ProcessExecutor: le letture e scritture overlapped sulle
+// pipe di tutti i figli si completano su un'unica I/O completion port, alla
+// quale e' associato anche il job object di ogni processo (notifica di
+// terminazione). Allo scadere TerminateJobObject chiude anche i discendenti.
+// Le notifiche dei job object non sono garantite: a output chiuso lo stato
+// del processo viene comunque verificato direttamente.
+#include "ProcessExecutor.h"
+#include <Windows.h>
+#include <algorithm>
+
+namespace {
+
+HANDLE port = NULL;
+
+// Chiavi di completamento: I/O sulle pipe, risveglio del loop, job object
+// (chiave = JOB_KEY_BASE + id del job, mai riutilizzata)
+const ULONG_PTR KEY_IO = 1;
+const ULONG_PTR KEY_WAKE = 2;
+const ULONG_PTR JOB_KEY_BASE = 16;
+
+// Verifica diretta della terminazione (job object non disponibile)
+const std::chrono::milliseconds EXIT_POLL_INTERVAL(10);
+
+void CloseHandleSafe(HANDLE& handle) {
+    if (handle != NULL && handle != INVALID_HANDLE_VALUE) {
+        CloseHandle(handle);
+    }
+    handle = NULL;
+}
+
+}
+
+bool ProcessExecutor::OpenLoop() {
+    port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1);
+    if (port == NULL) {
+        lastError = L"Impossibile creare la completion port: " + std::to_wstring(::GetLastError());
+        return false;
+    }
+    return true;
+}
+
+void ProcessExecutor::CloseLoop() {
+    CloseHandleSafe(port);
+}
+
+void ProcessExecutor::Wake() {
+    PostQueuedCompletionStatus(port, 0, KEY_WAKE, NULL);
+}
+
+bool ProcessExecutor::Launch(Job& job) {
+    job.process = NULL;
+    job.jobObject = NULL;
+    job.inWrite = NULL;
+    job.outRead = NULL;
+    job.readRequest = {};
+    job.readRequest.job = &job;
+    job.writeRequest = {};
+    job.writeRequest.job = &job;
+
+    PROCESS_INFORMATION pi;
+    if (!Subprocess::Spawn(job.program, job.args, true, pi, job.inWrite, job.outRead, job.result.error)) {
+        return false;
+    }
+    job.process = pi.hProcess;
+    job.processId = pi.dwProcessId;
+
+    if (CreateIoCompletionPort(job.outRead, port, KEY_IO, 0) == NULL ||
+        CreateIoCompletionPort(job.inWrite, port, KEY_IO, 0) == NULL) {
+        job.result.error = L"Impossibile collegare le pipe di " + job.program + L": " +
+                           std::to_wstring(::GetLastError());
+        TerminateProcess(job.process, 1);
+        CloseHandle(pi.hThread);
+        Release(job);
+        return false;
+    }
+
+    // Il processo e' ancora sospeso: assegnato al job object prima di partire,
+    // ne faranno parte anche i suoi discendenti. Senza job object (es. job
+    // annidati non consentiti) la terminazione viene verificata a intervalli
+    job.jobObject = CreateJobObjectW(NULL, NULL);
+    if (job.jobObject != NULL) {
+        JOBOBJECT_ASSOCIATE_COMPLETION_PORT association = {};
+        association.CompletionKey = reinterpret_cast<PVOID>(JOB_KEY_BASE + job.id);
+        association.CompletionPort = port;
+        if (!SetInformationJobObject(job.jobObject, JobObjectAssociateCompletionPortInformation,
+                                     &association, sizeof(association)) ||
+            !AssignProcessToJobObject(job.jobObject, job.process)) {
+            CloseHandleSafe(job.jobObject);
+        }
+    }
+
+    ResumeThread(pi.hThread);
+    CloseHandle(pi.hThread);
+
+    job.result.started = true;
+    job.result.output.reserve(job.outputReserve);
+
+    IssueRead(job);
+    if (job.input.empty()) {
+        CloseHandleSafe(job.inWrite);
+    } else {
+        IssueWrite(job);
+    }
+    return true;
+}
+
+void ProcessExecutor::IssueRead(Job& job) {
+    job.readRequest.overlapped = {};
+    if (ReadFile(job.outRead, job.buffer, sizeof(job.buffer), NULL, &job.readRequest.overlapped) ||
+        ::GetLastError() == ERROR_IO_PENDING) {
+        // Anche il completamento immediato arriva sulla completion port
+        job.readRequest.pending = true;
+    } else {
+        // ERROR_BROKEN_PIPE: il figlio (e i discendenti) hanno chiuso stdout
+        job.outputClosed = true;
+    }
+}
+
+void ProcessExecutor::IssueWrite(Job& job) {
+    DWORD chunk = static_cast<DWORD>(std::min<size_t>(job.input.size() - job.written, 65536));
+    job.writeRequest.overlapped = {};
+    if (WriteFile(job.inWrite, job.input.data() + job.written, chunk, NULL, &job.writeRequest.overlapped) ||
+        ::GetLastError() == ERROR_IO_PENDING) {
+        job.writeRequest.pending = true;
+    } else {
+        CloseHandleSafe(job.inWrite);
+    }
+}
+
+void ProcessExecutor::MarkExited(Job& job) {
+    if (job.exited) {
+        return;
+    }
+    job.exited = true;
+    DWORD exitCode = 0;
+    if (GetExitCodeProcess(job.process, &exitCode)) {
+        job.result.exitCode = static_cast<int>(exitCode);
+    }
+}
+
+void ProcessExecutor::WaitEvents(std::chrono::milliseconds maxWait) {
+    bool polling = false;
+    for (const auto& job : active) {
+        if (!job->exited && (job->jobObject == NULL || job->outputClosed)) {
+            polling = true;
+        }
+    }
+    if (polling) {
+        maxWait = std::min(maxWait, EXIT_POLL_INTERVAL);
+    }
+
+    OVERLAPPED_ENTRY entries[64];
+    ULONG count = 0;
+    if (!GetQueuedCompletionStatusEx(port, entries, 64, &count, static_cast<DWORD>(maxWait.count()), FALSE)) {
+        count = 0;
+    }
+
+    for (ULONG i = 0; i < count; i++) {
+        const OVERLAPPED_ENTRY& entry = entries[i];
+
+        if (entry.lpCompletionKey == KEY_WAKE) {
+            continue;
+        }
+
+        if (entry.lpCompletionKey == KEY_IO) {
+            IoRequest* request = CONTAINING_RECORD(entry.lpOverlapped, IoRequest, overlapped);
+            Job& job = *request->job;
+            request->pending = false;
+            DWORD transferred = 0;
+
+            if (request == &job.readRequest) {
+                if (GetOverlappedResult(job.outRead, &request->overlapped, &transferred, FALSE) && transferred > 0) {
+                    job.decoder.Feed(job.buffer, transferred, job.result.output);
+                    IssueRead(job);
+                } else {
+                    // Fine dei dati, pipe rotta o lettura annullata
+                    job.outputClosed = true;
+                }
+            } else {
+                if (GetOverlappedResult(job.inWrite, &request->overlapped, &transferred, FALSE)) {
+                    job.written += transferred;
+                }
+                if (transferred > 0 && job.written < job.input.size()) {
+                    IssueWrite(job);
+                } else {
+                    CloseHandleSafe(job.inWrite);
+                }
+            }
+            continue;
+        }
+
+        // Notifica di un job object: interessa solo l'uscita del processo principale
+        DWORD message = entry.dwNumberOfBytesTransferred;
+        DWORD processId = static_cast<DWORD>(reinterpret_cast<ULONG_PTR>(entry.lpOverlapped));
+        if (message != JOB_OBJECT_MSG_EXIT_PROCESS && message != JOB_OBJECT_MSG_ABNORMAL_EXIT_PROCESS) {
+            continue;
+        }
+        for (auto& job : active) {
+            if (JOB_KEY_BASE + job->id == entry.lpCompletionKey && job->processId == processId) {
+                MarkExited(*job);
+                break;
+            }
+        }
+    }
+
+    if (polling) {
+        for (auto& job : active) {
+            if (!job->exited && WaitForSingleObject(job->process, 0) == WAIT_OBJECT_0) {
+                MarkExited(*job);
+            }
+        }
+    }
+}
+
+void ProcessExecutor::Kill(Job& job) {
+    if (job.exited) {
+        return;
+    }
+    if (job.jobObject != NULL) {
+        TerminateJobObject(job.jobObject, 1);
+    } else {
+        TerminateProcess(job.process, 1);
+    }
+}
+
+void ProcessExecutor::AbandonOutput(Job& job) {
+    // Le operazioni annullate si completano comunque sulla porta
+    if (job.readRequest.pending) {
+        CancelIoEx(job.outRead, &job.readRequest.overlapped);
+    } else {
+        job.outputClosed = true;
+    }
+    if (job.writeRequest.pending) {
+        CancelIoEx(job.inWrite, &job.writeRequest.overlapped);
+    } else {
+        CloseHandleSafe(job.inWrite);
+    }
+}
+
+void ProcessExecutor::Release(Job& job) {
+    CloseHandleSafe(job.inWrite);
+    CloseHandleSafe(job.outRead);
+    CloseHandleSafe(job.process);
+    CloseHandleSafe(job.jobObject);
+}
+
+bool ProcessExecutor::IsFinished(const Job& job) {
+    return job.exited && job.outputClosed && !job.readRequest.pending && !job.writeRequest.pending;
+}
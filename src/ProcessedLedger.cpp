@@ -0,0 +1,198 @@
+#include "ProcessedLedger.h"
+#include <filesystem>
+#include <chrono>
+#include <cstring>
+
+std::unordered_map<uint64_t, int64_t> ProcessedLedger::index;
+std::deque<ProcessedLedger::Bucket> ProcessedLedger::buckets;
+std::unordered_set<uint64_t> ProcessedLedger::claimed;
+unsigned ProcessedLedger::retention = 24;
+std::ofstream ProcessedLedger::journal;
+std::mutex ProcessedLedger::mutex;
+std::wstring ProcessedLedger::lastError;
+
+// Formato su disco: intestazione di 8 byte seguita da record (hash, istante)
+static const char LEDGER_MAGIC[8] = { 'M', 'R', 'M', 'L', 'E', 'D', 'G', '1' };
+static const size_t RECORD_SIZE = 16;
+
+static void EncodeRecord(unsigned char* out, uint64_t hash, int64_t unixTime) {
+    uint64_t t = static_cast<uint64_t>(unixTime);
+    for (int i = 0; i < 8; i++) {
+        out[i] = static_cast<unsigned char>(hash >> (i * 8));
+        out[8 + i] = static_cast<unsigned char>(t >> (i * 8));
+    }
+}
+
+static void DecodeRecord(const unsigned char* in, uint64_t& hash, int64_t& unixTime) {
+    uint64_t h = 0, t = 0;
+    for (int i = 7; i >= 0; i--) {
+        h = (h << 8) | in[i];
+        t = (t << 8) | in[8 + i];
+    }
+    hash = h;
+    unixTime = static_cast<int64_t>(t);
+}
+
+int64_t ProcessedLedger::Now() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void ProcessedLedger::InsertLocked(uint64_t hash, int64_t unixTime) {
+    int64_t hour = unixTime / 3600;
+
+    // I record arrivano in ordine cronologico: di norma si usa l'ultimo bucket
+    if (buckets.empty() || buckets.back().hour < hour) {
+        buckets.push_back({ hour, {} });
+    }
+
+    Bucket* bucket = &buckets.back();
+    if (bucket->hour > hour) {
+        // Record fuori ordine (orologio spostato): usa il primo bucket non piu' vecchio
+        bucket = nullptr;
+        for (auto& b : buckets) {
+            if (b.hour >= hour) {
+                bucket = &b;
+                break;
+            }
+        }
+    }
+
+    bucket->hashes.push_back(hash);
+    index[hash] = bucket->hour;
+}
+
+void ProcessedLedger::ExpireLocked(int64_t nowHour) {
+    while (!buckets.empty() && buckets.front().hour + static_cast<int64_t>(retention) <= nowHour) {
+        for (uint64_t hash : buckets.front().hashes) {
+            auto it = index.find(hash);
+            if (it != index.end() && it->second == buckets.front().hour) {
+                index.erase(it);
+            }
+        }
+        buckets.pop_front();
+    }
+}
+
+bool ProcessedLedger::Open(const std::wstring& ledgerPath, unsigned retentionHours) {
+    std::lock_guard<std::mutex> lock(mutex);
+    lastError.clear();
+
+    if (journal.is_open()) {
+        journal.close();
+    }
+
+    index.clear();
+    buckets.clear();
+    claimed.clear();
+    retention = retentionHours > 0 ? retentionHours : 1;
+
+    std::filesystem::path path(ledgerPath);
+    int64_t now = Now();
+    int64_t oldest = (now / 3600 - retention + 1) * 3600;
+
+    // Carica i record ancora validi
+    std::vector<unsigned char> live;
+    {
+        std::ifstream in(path, std::ios::binary);
+        char magic[sizeof(LEDGER_MAGIC)];
+        if (in.is_open() && in.read(magic, sizeof(magic)) &&
+            memcmp(magic, LEDGER_MAGIC, sizeof(magic)) == 0) {
+            unsigned char record[RECORD_SIZE];
+            while (in.read(reinterpret_cast<char*>(record), RECORD_SIZE)) {
+                uint64_t hash;
+                int64_t unixTime;
+                DecodeRecord(record, hash, unixTime);
+                if (unixTime < oldest || index.count(hash)) {
+                    continue;
+                }
+                InsertLocked(hash, unixTime);
+                live.insert(live.end(), record, record + RECORD_SIZE);
+            }
+        }
+    }
+
+    // Compatta: riscrive solo i record validi e sostituisce il file
+    std::filesystem::path tempPath = path;
+    tempPath += L".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            lastError = L"Impossibile scrivere il registro: " + tempPath.wstring();
+            return false;
+        }
+        out.write(LEDGER_MAGIC, sizeof(LEDGER_MAGIC));
+        out.write(reinterpret_cast<const char*>(live.data()), live.size());
+        if (!out) {
+            lastError = L"Errore di scrittura del registro: " + tempPath.wstring();
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec) {
+        lastError = L"Impossibile sostituire il registro: " + path.wstring();
+        return false;
+    }
+
+    journal.open(path, std::ios::binary | std::ios::app);
+    if (!journal.is_open()) {
+        lastError = L"Impossibile aprire il registro: " + path.wstring();
+        return false;
+    }
+
+    return true;
+}
+
+void ProcessedLedger::Close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (journal.is_open()) {
+        journal.close();
+    }
+}
+
+bool ProcessedLedger::TryClaim(uint64_t hash) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ExpireLocked(Now() / 3600);
+
+    if (index.count(hash)) {
+        return false;
+    }
+    return claimed.insert(hash).second;
+}
+
+void ProcessedLedger::Release(uint64_t hash, bool processed) {
+    std::lock_guard<std::mutex> lock(mutex);
+    claimed.erase(hash);
+
+    if (processed && !index.count(hash)) {
+        RecordLocked(hash, Now());
+    }
+}
+
+void ProcessedLedger::RecordLocked(uint64_t hash, int64_t unixTime) {
+    InsertLocked(hash, unixTime);
+
+    if (journal.is_open()) {
+        unsigned char record[RECORD_SIZE];
+        EncodeRecord(record, hash, unixTime);
+        journal.write(reinterpret_cast<const char*>(record), RECORD_SIZE);
+        journal.flush();
+    }
+}
+
+bool ProcessedLedger::Contains(uint64_t hash) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ExpireLocked(Now() / 3600);
+    return index.count(hash) != 0;
+}
+
+size_t ProcessedLedger::GetCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return index.size();
+}
+
+std::wstring ProcessedLedger::GetLastError() {
+    return lastError;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <fstream>
+#include <mutex>
+#include <cstdint>
+
+// Registro dei PDF gia' elaborati, indicizzato per hash del contenuto.
+// In memoria le voci sono raggruppate in bucket orari: inserimento, ricerca e
+// scadenza sono O(1) ammortizzato (scade un bucket intero alla volta).
+// Su disco il registro e' un file append-only di record a 16 byte
+// (hash, istante UNIX), compattato all'apertura: dopo un riavvio i referti
+// del periodo di ritenzione non vengono rielaborati.
+// Un hash si registra solo a elaborazione riuscita: nel frattempo e'
+// prenotato in memoria (TryClaim/Release), cosi' le notifiche ripetute dello
+// stesso contenuto vengono scartate ma un PDF non elaborato (scartato dalla
+// coda, estrazione fallita, arresto del programma) resta da elaborare.
+class ProcessedLedger {
+public:
+    // Apre (o crea) il registro su disco e carica le voci non scadute
+    static bool Open(const std::wstring& ledgerPath, unsigned retentionHours);
+
+    // Chiude il file del registro (le voci in memoria restano valide)
+    static void Close();
+
+    // Prenota l'hash per l'elaborazione. Restituisce false se e' gia'
+    // registrato o prenotato da un altro worker
+    static bool TryClaim(uint64_t hash);
+
+    // Chiude la prenotazione: con processed l'hash viene registrato,
+    // altrimenti torna disponibile per un nuovo tentativo
+    static void Release(uint64_t hash, bool processed);
+
+    // Verifica se l'hash e' gia' registrato
+    static bool Contains(uint64_t hash);
+
+    // Numero di voci attive
+    static size_t GetCount();
+
+    // Restituisce l'ultimo errore
+    static std::wstring GetLastError();
+
+private:
+    struct Bucket {
+        int64_t hour;                   // Ora UNIX (secondi / 3600) del bucket
+        std::vector<uint64_t> hashes;
+    };
+
+    static void InsertLocked(uint64_t hash, int64_t unixTime);
+    static void RecordLocked(uint64_t hash, int64_t unixTime);
+    static void ExpireLocked(int64_t nowHour);
+    static int64_t Now();
+
+    static std::unordered_map<uint64_t, int64_t> index;    // hash -> ora del bucket
+    static std::deque<Bucket> buckets;                     // Ordinati per ora crescente
+    static std::unordered_set<uint64_t> claimed;           // In elaborazione, non ancora registrati
+    static unsigned retention;
+    static std::ofstream journal;
+    static std::mutex mutex;
+    static std::wstring lastError;
+};
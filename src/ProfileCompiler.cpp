@@ -0,0 +1,371 @@
+#include "ProfileCompiler.h"
+#include "ProfileRegex.h"
+#include "ContentHash.h"
+#include "MappedFile.h"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cstring>
+#include <locale>
+#include <codecvt>
+#include <cwctype>
+
+thread_local std::wstring ProfileCompiler::lastError;
+
+namespace {
+
+// Formato del file compilato: intestazione (magic, versione del formato,
+// dimensione di wchar_t, impronta delle sorgenti, numero di parole,
+// checksum delle parole)
+// seguita da parole a 32 bit nell'ordine dei byte della macchina (il file
+// e' locale e si rigenera da solo):
+//   numero di profili, profili, profilo di default, indice (ProfileIndex::Save)
+// Un profilo e' il nome seguito dalle cinque liste di pattern; una stringa
+// e' la lunghezza seguita dai caratteri, una lista il numero di stringhe
+const char COMPILED_MAGIC[8] = { 'M', 'R', 'M', 'P', 'R', 'O', 'F', '1' };
+const uint32_t FORMAT_VERSION = 1;
+const size_t HEADER_SIZE = 40;
+
+const wchar_t* SOURCE_EXTENSION = L".profile";
+
+void PutString(std::vector<uint32_t>& out, const std::wstring& text) {
+    out.push_back(static_cast<uint32_t>(text.size()));
+    for (wchar_t c : text) {
+        out.push_back(static_cast<uint32_t>(c));
+    }
+}
+
+void PutList(std::vector<uint32_t>& out, const std::vector<std::wstring>& list) {
+    out.push_back(static_cast<uint32_t>(list.size()));
+    for (const auto& text : list) {
+        PutString(out, text);
+    }
+}
+
+void PutProfile(std::vector<uint32_t>& out, const ReportProfile& profile) {
+    PutString(out, profile.name);
+    PutList(out, profile.identifierPatterns);
+    PutList(out, profile.patientNamePatterns);
+    PutList(out, profile.excludePatterns);
+    PutList(out, profile.keepPatterns);
+    PutList(out, profile.newlineBeforePatterns);
+}
+
+// Lettura con controllo dei limiti sulle parole mappate
+struct WordReader {
+    const uint32_t* data;
+    size_t count;
+    size_t pos;
+
+    bool Read(uint32_t& value) {
+        if (pos >= count) {
+            return false;
+        }
+        value = data[pos++];
+        return true;
+    }
+
+    bool ReadString(std::wstring& text) {
+        uint32_t length;
+        if (!Read(length) || length > count - pos) {
+            return false;
+        }
+        text.resize(length);
+        for (auto& c : text) {
+            c = static_cast<wchar_t>(data[pos++]);
+        }
+        return true;
+    }
+
+    bool ReadList(std::vector<std::wstring>& list) {
+        uint32_t size;
+        if (!Read(size) || size > count - pos) {
+            return false;
+        }
+        list.resize(size);
+        for (auto& text : list) {
+            if (!ReadString(text)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool ReadProfile(ReportProfile& profile) {
+        return ReadString(profile.name) &&
+               ReadList(profile.identifierPatterns) &&
+               ReadList(profile.patientNamePatterns) &&
+               ReadList(profile.excludePatterns) &&
+               ReadList(profile.keepPatterns) &&
+               ReadList(profile.newlineBeforePatterns);
+    }
+};
+
+void Put32(char* out, uint32_t value) {
+    memcpy(out, &value, sizeof(value));
+}
+
+void Put64(char* out, uint64_t value) {
+    memcpy(out, &value, sizeof(value));
+}
+
+uint32_t Get32(const char* in) {
+    uint32_t value;
+    memcpy(&value, in, sizeof(value));
+    return value;
+}
+
+uint64_t Get64(const char* in) {
+    uint64_t value;
+    memcpy(&value, in, sizeof(value));
+    return value;
+}
+
+std::wstring Trim(const std::wstring& text) {
+    size_t start = text.find_first_not_of(L" \t\r");
+    if (start == std::wstring::npos) {
+        return std::wstring();
+    }
+    size_t end = text.find_last_not_of(L" \t\r");
+    return text.substr(start, end - start + 1);
+}
+
+}
+
+std::vector<std::wstring> ProfileCompiler::ListSources(const std::wstring& directory) {
+    std::vector<std::wstring> sources;
+    std::error_code ec;
+    for (std::filesystem::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)) {
+        if (!it->is_regular_file(ec)) {
+            continue;
+        }
+        std::wstring extension = it->path().extension().wstring();
+        std::transform(extension.begin(), extension.end(), extension.begin(), ::towlower);
+        if (extension == SOURCE_EXTENSION) {
+            sources.push_back(it->path().wstring());
+        }
+    }
+    std::sort(sources.begin(), sources.end());
+    return sources;
+}
+
+uint64_t ProfileCompiler::Fingerprint(const std::vector<std::wstring>& sources,
+                                      const std::vector<ReportProfile>& builtIn) {
+    ContentHash::Hasher hasher;
+    uint32_t format[2] = { FORMAT_VERSION, static_cast<uint32_t>(sizeof(wchar_t)) };
+    hasher.Update(format, sizeof(format));
+
+    // I profili integrati cambiano solo con una nuova versione del programma
+    std::vector<uint32_t> words;
+    for (const auto& profile : builtIn) {
+        PutProfile(words, profile);
+    }
+    hasher.Update(words.data(), words.size() * sizeof(uint32_t));
+
+    // Nome e contenuto delle sorgenti: un file illeggibile conta come assente
+    for (const auto& source : sources) {
+        std::wstring name = std::filesystem::path(source).filename().wstring();
+        hasher.Update(name.data(), name.size() * sizeof(wchar_t));
+        uint64_t hash = 0;
+        ContentHash::HashFile(source, hash);
+        hasher.Update(&hash, sizeof(hash));
+    }
+    return hasher.Digest();
+}
+
+bool ProfileCompiler::ParseSource(const std::wstring& path, ReportProfile& profile) {
+    lastError.clear();
+    profile = ReportProfile();
+
+    std::ifstream file(std::filesystem::path(path), std::ios::binary);
+    if (!file.is_open()) {
+        lastError = L"Impossibile aprire " + path;
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string bytes = buffer.str();
+    if (bytes.compare(0, 3, "\xEF\xBB\xBF") == 0) {
+        bytes.erase(0, 3);  // BOM di Blocco note
+    }
+
+    std::wstring text;
+    try {
+        std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
+        text = converter.from_bytes(bytes);
+    } catch (const std::range_error&) {
+        lastError = path + L": il file non e' UTF-8 valido";
+        return false;
+    }
+
+    size_t lineNumber = 0;
+    size_t lineStart = 0;
+    while (lineStart < text.size()) {
+        size_t lineEnd = text.find(L'\n', lineStart);
+        if (lineEnd == std::wstring::npos) {
+            lineEnd = text.size();
+        }
+        std::wstring line = Trim(text.substr(lineStart, lineEnd - lineStart));
+        lineStart = lineEnd + 1;
+        lineNumber++;
+
+        if (line.empty() || line[0] == L'#' || line[0] == L';') {
+            continue;
+        }
+
+        std::wstring where = path + L" riga " + std::to_wstring(lineNumber);
+        size_t pos = line.find(L'=');
+        if (pos == std::wstring::npos) {
+            lastError = where + L": manca '='";
+            return false;
+        }
+        std::wstring key = Trim(line.substr(0, pos));
+        std::wstring value = Trim(line.substr(pos + 1));
+        if (value.empty()) {
+            lastError = where + L": valore vuoto";
+            return false;
+        }
+
+        if (key == L"name") {
+            profile.name = value;
+            continue;
+        }
+        if (key == L"identifier") {
+            // Sottostringa, non regex
+            profile.identifierPatterns.push_back(value);
+            continue;
+        }
+
+        std::vector<std::wstring>* list = nullptr;
+        if (key == L"patient_name") {
+            list = &profile.patientNamePatterns;
+        } else if (key == L"exclude") {
+            list = &profile.excludePatterns;
+        } else if (key == L"keep") {
+            list = &profile.keepPatterns;
+        } else if (key == L"newline_before") {
+            list = &profile.newlineBeforePatterns;
+        } else {
+            lastError = where + L": chiave sconosciuta '" + key + L"'";
+            return false;
+        }
+
+        // Una regex errata scartata in silenzio farebbe sparire una regola
+        ProfileRegex re;
+        if (!re.Compile(value)) {
+            lastError = where + L": " + re.GetError();
+            return false;
+        }
+        list->push_back(value);
+    }
+
+    if (profile.name.empty()) {
+        profile.name = std::filesystem::path(path).stem().wstring();
+    }
+    return true;
+}
+
+bool ProfileCompiler::Write(const std::wstring& path, uint64_t fingerprint,
+                            const std::vector<ReportProfile>& profiles,
+                            const ReportProfile& defaultProfile, const ProfileIndex& index) {
+    lastError.clear();
+
+    std::vector<uint32_t> words;
+    words.push_back(static_cast<uint32_t>(profiles.size()));
+    for (const auto& profile : profiles) {
+        PutProfile(words, profile);
+    }
+    PutProfile(words, defaultProfile);
+    index.Save(words);
+
+    std::string content(HEADER_SIZE, '\0');
+    memcpy(&content[0], COMPILED_MAGIC, sizeof(COMPILED_MAGIC));
+    Put32(&content[8], FORMAT_VERSION);
+    Put32(&content[12], static_cast<uint32_t>(sizeof(wchar_t)));
+    Put64(&content[16], fingerprint);
+    Put64(&content[24], words.size());
+    Put64(&content[32], ContentHash::Compute(words.data(), words.size() * sizeof(uint32_t)));
+    content.append(reinterpret_cast<const char*>(words.data()), words.size() * sizeof(uint32_t));
+
+    // Sostituzione atomica: un processo che sta caricando vede il file
+    // vecchio o quello nuovo, mai uno scritto a meta'
+    std::filesystem::path target(path);
+    std::filesystem::path tempPath = target;
+    tempPath += L".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        out.write(content.data(), content.size());
+        if (!out) {
+            lastError = L"Errore di scrittura dei profili compilati: " + tempPath.wstring();
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, target, ec);
+    if (ec) {
+        lastError = L"Impossibile sostituire i profili compilati: " + path;
+        return false;
+    }
+    return true;
+}
+
+bool ProfileCompiler::Read(const std::wstring& path, uint64_t fingerprint,
+                           std::vector<ReportProfile>& profiles,
+                           ReportProfile& defaultProfile, ProfileIndex& index) {
+    lastError.clear();
+
+    // File assente (primo avvio): nessun errore, si compila dalle sorgenti
+    std::error_code ec;
+    if (!std::filesystem::exists(path, ec)) {
+        return false;
+    }
+
+    MappedFile file;
+    if (!file.OpenReadOnly(path)) {
+        lastError = file.GetLastError();
+        return false;
+    }
+
+    // Impronta diversa: le sorgenti sono cambiate, il file va rigenerato
+    const char* data = file.Data();
+    if (file.Size() < HEADER_SIZE || memcmp(data, COMPILED_MAGIC, sizeof(COMPILED_MAGIC)) != 0 ||
+        Get32(data + 8) != FORMAT_VERSION || Get32(data + 12) != sizeof(wchar_t) ||
+        Get64(data + 16) != fingerprint ||
+        Get64(data + 24) != (file.Size() - HEADER_SIZE) / sizeof(uint32_t) ||
+        (file.Size() - HEADER_SIZE) % sizeof(uint32_t) != 0) {
+        return false;
+    }
+    if (Get64(data + 32) != ContentHash::Compute(data + HEADER_SIZE, file.Size() - HEADER_SIZE)) {
+        lastError = L"Profili compilati danneggiati, verranno rigenerati: " + path;
+        return false;
+    }
+
+    // La mappa parte da un confine di pagina: le parole sono allineate
+    WordReader reader = { reinterpret_cast<const uint32_t*>(data + HEADER_SIZE),
+                          (file.Size() - HEADER_SIZE) / sizeof(uint32_t), 0 };
+
+    uint32_t profileCount;
+    bool valid = reader.Read(profileCount) && profileCount <= reader.count;
+    if (valid) {
+        profiles.assign(profileCount, ReportProfile());
+        for (auto& profile : profiles) {
+            valid = valid && reader.ReadProfile(profile);
+        }
+        valid = valid && reader.ReadProfile(defaultProfile) &&
+                index.Load(reader.data, reader.count, reader.pos) &&
+                index.GetProfileCount() == profiles.size();
+    }
+    if (!valid) {
+        profiles.clear();
+        index.Clear();
+        lastError = L"Profili compilati non validi, verranno rigenerati: " + path;
+        return false;
+    }
+    return true;
+}
+
+std::wstring ProfileCompiler::GetLastError() {
+    return lastError;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "ReportProfile.h"
+#include "ProfileIndex.h"
+
+// Profili di parsing definiti in file di testo (*.profile, UTF-8), uno per
+// file, con righe chiave=valore come config.ini:
+//
+//   # Ecografia addome
+//   name=eco_addome
+//   identifier=ECOGRAFIA ADDOME COMPLETO
+//   patient_name=Paziente:\s+([A-Z]+\s+[A-Z]+)\s+Anni:
+//   exclude=Codice\s+Fiscale:
+//   keep=Medico\s+Radiologo:
+//   newline_before=CONCLUSIONI
+//
+// Le chiavi di lista si ripetono, una riga per pattern; spazi ai bordi del
+// valore ignorati (nei pattern si usa \s). Senza name vale il nome del file.
+// I profili validi sono compilati in un file binario (profilo per profilo i
+// pattern e, gia' costruito, l'indice di identificazione) che all'avvio
+// viene mappato in memoria al posto di rileggere e ricostruire tutto.
+// Il file compilato porta l'impronta delle sorgenti da cui deriva: se non
+// corrisponde viene ignorato e riscritto.
+class ProfileCompiler {
+public:
+    // Sorgenti *.profile della directory, in ordine di nome
+    static std::vector<std::wstring> ListSources(const std::wstring& directory);
+
+    // Impronta di contenuto delle sorgenti e dei profili integrati
+    static uint64_t Fingerprint(const std::vector<std::wstring>& sources,
+                                const std::vector<ReportProfile>& builtIn);
+
+    // Legge una sorgente; false se non valida (chiave sconosciuta, regex errata)
+    static bool ParseSource(const std::wstring& path, ReportProfile& profile);
+
+    // Scrive il file compilato (temporaneo e rinomina)
+    static bool Write(const std::wstring& path, uint64_t fingerprint,
+                      const std::vector<ReportProfile>& profiles,
+                      const ReportProfile& defaultProfile, const ProfileIndex& index);
+
+    // Carica il file compilato se esiste e corrisponde all'impronta
+    static bool Read(const std::wstring& path, uint64_t fingerprint,
+                     std::vector<ReportProfile>& profiles,
+                     ReportProfile& defaultProfile, ProfileIndex& index);
+
+    // Restituisce l'ultimo errore
+    static std::wstring GetLastError();
+
+private:
+    static thread_local std::wstring lastError;
+};
@@ -0,0 +1,328 @@
+#include "ProfileIndex.h"
+#include <algorithm>
+#include <deque>
+#include <cwctype>
+
+ProfileIndex::ProfileIndex() {
+    Clear();
+}
+
+void ProfileIndex::Clear() {
+    states.assign(1, State{ {}, 0, -1, -1 });
+    patterns.clear();
+    patternProfiles.clear();
+    required.clear();
+    built = false;
+}
+
+wchar_t ProfileIndex::Fold(wchar_t c) {
+    return static_cast<wchar_t>(std::towlower(c));
+}
+
+size_t ProfileIndex::AddProfile(const std::vector<std::wstring>& profilePatterns) {
+    uint32_t profile = static_cast<uint32_t>(required.size());
+    required.push_back(0);
+    built = false;
+
+    for (const auto& pattern : profilePatterns) {
+        if (pattern.empty()) {
+            continue;
+        }
+
+        // Percorso del pattern nel trie: lo stato finale identifica il
+        // pattern, per cui lo stesso pattern in piu' profili viene cercato una volta
+        int32_t state = 0;
+        for (wchar_t c : pattern) {
+            wchar_t folded = Fold(c);
+            auto& next = states[state].next;
+            auto it = std::lower_bound(next.begin(), next.end(), std::make_pair(folded, INT32_MIN));
+            if (it != next.end() && it->first == folded) {
+                state = it->second;
+                continue;
+            }
+            int32_t created = static_cast<int32_t>(states.size());
+            next.insert(it, std::make_pair(folded, created));
+            states.push_back(State{ {}, 0, -1, -1 });
+            state = created;
+        }
+
+        if (states[state].output < 0) {
+            states[state].output = static_cast<int32_t>(patterns.size());
+            patterns.push_back(pattern);
+            patternProfiles.emplace_back();
+        }
+        auto& profiles = patternProfiles[states[state].output];
+        if (profiles.empty() || profiles.back() != profile) {
+            profiles.push_back(profile);
+            required[profile]++;
+        }
+    }
+    return profile;
+}
+
+void ProfileIndex::Build() {
+    // Collegamenti fail in ampiezza: lo stato di un suffisso e' sempre meno profondo
+    std::deque<int32_t> queue;
+    for (const auto& edge : states[0].next) {
+        states[edge.second].fail = 0;
+        states[edge.second].dictionary = -1;
+        queue.push_back(edge.second);
+    }
+
+    while (!queue.empty()) {
+        int32_t state = queue.front();
+        queue.pop_front();
+
+        for (const auto& edge : states[state].next) {
+            int32_t child = edge.second;
+            int32_t fail = Next(states[state].fail, edge.first);
+            states[child].fail = fail;
+            states[child].dictionary = states[fail].output >= 0 ? fail : states[fail].dictionary;
+            queue.push_back(child);
+        }
+    }
+    built = true;
+}
+
+int32_t ProfileIndex::Next(int32_t state, wchar_t c) const {
+    for (;;) {
+        const auto& next = states[state].next;
+        auto it = std::lower_bound(next.begin(), next.end(), std::make_pair(c, INT32_MIN));
+        if (it != next.end() && it->first == c) {
+            return it->second;
+        }
+        if (state == 0) {
+            return 0;
+        }
+        state = states[state].fail;
+    }
+}
+
+std::vector<size_t> ProfileIndex::MatchAll(std::wstring_view text) const {
+    std::vector<size_t> matched;
+    if (!built) {
+        return matched;
+    }
+
+    std::vector<uint32_t> found(required.size(), 0);
+    std::vector<bool> seen(patterns.size(), false);
+    size_t remaining = patterns.size();
+
+    int32_t state = 0;
+    for (size_t i = 0; i < text.size() && remaining > 0; i++) {
+        state = Next(state, Fold(text[i]));
+
+        // Tutti i pattern che terminano in questa posizione
+        int32_t hit = states[state].output >= 0 ? state : states[state].dictionary;
+        for (; hit >= 0; hit = states[hit].dictionary) {
+            int32_t pattern = states[hit].output;
+            if (seen[pattern]) {
+                continue;
+            }
+            seen[pattern] = true;
+            remaining--;
+            for (uint32_t profile : patternProfiles[pattern]) {
+                found[profile]++;
+            }
+        }
+    }
+
+    for (size_t profile = 0; profile < required.size(); profile++) {
+        if (found[profile] == required[profile]) {
+            matched.push_back(profile);
+        }
+    }
+    return matched;
+}
+
+int ProfileIndex::MatchFirst(std::wstring_view text) const {
+    std::vector<size_t> matched = MatchAll(text);
+    return matched.empty() ? -1 : static_cast<int>(matched.front());
+}
+
+void ProfileIndex::FindAll(std::wstring_view text, std::vector<Occurrence>& occurrences) const {
+    occurrences.clear();
+    if (!built) {
+        return;
+    }
+
+    int32_t state = 0;
+    for (size_t i = 0; i < text.size(); i++) {
+        state = Next(state, Fold(text[i]));
+
+        int32_t hit = states[state].output >= 0 ? state : states[state].dictionary;
+        for (; hit >= 0; hit = states[hit].dictionary) {
+            int32_t pattern = states[hit].output;
+            size_t length = patterns[pattern].size();
+            for (uint32_t profile : patternProfiles[pattern]) {
+                occurrences.push_back(Occurrence{ profile, i + 1 - length, length });
+            }
+        }
+    }
+}
+
+// Formato: stati (fail, output, dictionary, numero di transizioni, coppie
+// carattere/stato), pattern (lunghezza, caratteri), profili di ciascun
+// pattern, pattern richiesti per profilo. -1 e' scritto come 0xFFFFFFFF
+void ProfileIndex::Save(std::vector<uint32_t>& out) const {
+    out.push_back(static_cast<uint32_t>(states.size()));
+    for (const auto& state : states) {
+        out.push_back(static_cast<uint32_t>(state.fail));
+        out.push_back(static_cast<uint32_t>(state.output));
+        out.push_back(static_cast<uint32_t>(state.dictionary));
+        out.push_back(static_cast<uint32_t>(state.next.size()));
+        for (const auto& edge : state.next) {
+            out.push_back(static_cast<uint32_t>(edge.first));
+            out.push_back(static_cast<uint32_t>(edge.second));
+        }
+    }
+
+    out.push_back(static_cast<uint32_t>(patterns.size()));
+    for (size_t i = 0; i < patterns.size(); i++) {
+        out.push_back(static_cast<uint32_t>(patterns[i].size()));
+        for (wchar_t c : patterns[i]) {
+            out.push_back(static_cast<uint32_t>(c));
+        }
+        out.push_back(static_cast<uint32_t>(patternProfiles[i].size()));
+        out.insert(out.end(), patternProfiles[i].begin(), patternProfiles[i].end());
+    }
+
+    out.push_back(static_cast<uint32_t>(required.size()));
+    out.insert(out.end(), required.begin(), required.end());
+}
+
+bool ProfileIndex::Load(const uint32_t* data, size_t count, size_t& pos) {
+    Clear();
+    if (!ReadTables(data, count, pos) || !CheckTables()) {
+        Clear();
+        return false;
+    }
+    built = true;
+    return true;
+}
+
+bool ProfileIndex::ReadTables(const uint32_t* data, size_t count, size_t& pos) {
+    auto read = [&](uint32_t& value) {
+        if (pos >= count) {
+            return false;
+        }
+        value = data[pos++];
+        return true;
+    };
+    // Un conteggio non puo' superare le parole rimaste: evita allocazioni enormi
+    auto readCount = [&](uint32_t& value, size_t wordsEach) {
+        return read(value) && static_cast<uint64_t>(value) * wordsEach <= count - pos;
+    };
+
+    uint32_t stateCount = 0;
+    if (!readCount(stateCount, 4) || stateCount == 0) {
+        return false;
+    }
+    states.assign(stateCount, State{ {}, 0, -1, -1 });
+    for (auto& state : states) {
+        uint32_t fail, output, dictionary, edgeCount;
+        if (!read(fail) || !read(output) || !read(dictionary) || !readCount(edgeCount, 2)) {
+            return false;
+        }
+        state.fail = static_cast<int32_t>(fail);
+        state.output = static_cast<int32_t>(output);
+        state.dictionary = static_cast<int32_t>(dictionary);
+        state.next.resize(edgeCount);
+        for (auto& edge : state.next) {
+            uint32_t c, target;
+            read(c);
+            read(target);
+            edge = std::make_pair(static_cast<wchar_t>(c), static_cast<int32_t>(target));
+        }
+    }
+
+    uint32_t patternCount = 0;
+    if (!readCount(patternCount, 2)) {
+        return false;
+    }
+    patterns.resize(patternCount);
+    patternProfiles.resize(patternCount);
+    for (uint32_t i = 0; i < patternCount; i++) {
+        uint32_t length, profileCount;
+        if (!readCount(length, 1)) {
+            return false;
+        }
+        patterns[i].resize(length);
+        for (auto& c : patterns[i]) {
+            uint32_t value;
+            read(value);
+            c = static_cast<wchar_t>(value);
+        }
+        if (!readCount(profileCount, 1)) {
+            return false;
+        }
+        patternProfiles[i].assign(data + pos, data + pos + profileCount);
+        pos += profileCount;
+    }
+
+    uint32_t profileCount = 0;
+    if (!readCount(profileCount, 1)) {
+        return false;
+    }
+    required.assign(data + pos, data + pos + profileCount);
+    pos += profileCount;
+    return true;
+}
+
+// Riferimenti fuori dalle tabelle o transizioni non ordinate: file non valido
+bool ProfileIndex::CheckTables() const {
+    uint32_t stateCount = static_cast<uint32_t>(states.size());
+    int32_t patternCount = static_cast<int32_t>(patterns.size());
+    auto validState = [&](int32_t state, bool optional) {
+        return (optional && state == -1) || (state >= 0 && static_cast<uint32_t>(state) < stateCount);
+    };
+    for (const auto& state : states) {
+        if (!validState(state.fail, false) || !validState(state.dictionary, true) ||
+            state.output < -1 || state.output >= patternCount) {
+            return false;
+        }
+        for (size_t k = 0; k < state.next.size(); k++) {
+            if (!validState(state.next[k].second, false) ||
+                (k > 0 && state.next[k - 1].first >= state.next[k].first)) {
+                return false;
+            }
+        }
+    }
+
+    // Le catene fail e dictionary devono scendere verso la radice, altrimenti
+    // Next non terminerebbe: profondita' dal trie, ogni stato raggiunto una volta
+    std::vector<int32_t> depth(stateCount, -1);
+    std::deque<int32_t> queue(1, 0);
+    depth[0] = 0;
+    while (!queue.empty()) {
+        int32_t state = queue.front();
+        queue.pop_front();
+        for (const auto& edge : states[state].next) {
+            if (edge.second == 0 || depth[edge.second] >= 0) {
+                return false;
+            }
+            depth[edge.second] = depth[state] + 1;
+            queue.push_back(edge.second);
+        }
+    }
+    if (states[0].output != -1 || states[0].dictionary != -1) {
+        return false;
+    }
+    for (uint32_t state = 1; state < stateCount; state++) {
+        int32_t dictionary = states[state].dictionary;
+        if (depth[state] < 0 || depth[states[state].fail] >= depth[state] ||
+            (dictionary >= 0 && (depth[dictionary] >= depth[state] || states[dictionary].output < 0))) {
+            return false;
+        }
+    }
+
+    for (const auto& profiles : patternProfiles) {
+        for (uint32_t profile : profiles) {
+            if (profile >= required.size()) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
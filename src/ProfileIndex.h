@@ -0,0 +1,72 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+// Indice di identificazione dei profili: i pattern identificativi di tutti
+// i profili (sottostringhe, senza distinzione tra maiuscole e minuscole)
+// formano un unico automa di Aho-Corasick. Una sola passata sul testo
+// trova ogni pattern presente, qualunque sia il numero di profili; un
+// profilo e' soddisfatto quando sono presenti tutti i suoi pattern.
+// I profili sono restituiti nell'ordine di inserimento, che decide a parita'.
+// Dopo Build l'indice e' immutabile e condivisibile tra thread.
+class ProfileIndex {
+public:
+    ProfileIndex();
+
+    // Svuota l'indice
+    void Clear();
+
+    // Aggiunge un profilo con i pattern richiesti; restituisce il suo
+    // indice (ordine di inserimento). Un profilo senza pattern (o con soli
+    // pattern vuoti) e' soddisfatto da qualunque testo
+    size_t AddProfile(const std::vector<std::wstring>& patterns);
+
+    // Costruisce l'automa: da chiamare dopo l'ultimo AddProfile
+    void Build();
+
+    // Profili soddisfatti dal testo, in ordine di inserimento
+    std::vector<size_t> MatchAll(std::wstring_view text) const;
+
+    // Primo profilo soddisfatto, -1 se nessuno
+    int MatchFirst(std::wstring_view text) const;
+
+    // Occorrenza di un pattern nel testo, per ciascun profilo che lo richiede
+    struct Occurrence {
+        size_t profile;
+        size_t position;
+        size_t length;
+    };
+
+    // Tutte le occorrenze di tutti i pattern in una sola passata, anche
+    // sovrapposte, in ordine di posizione finale
+    void FindAll(std::wstring_view text, std::vector<Occurrence>& occurrences) const;
+
+    size_t GetProfileCount() const { return required.size(); }
+
+    // Automa costruito in forma piatta (parole a 32 bit), per il file
+    // compilato dei profili: Load lo ripristina senza ricostruirlo.
+    // Load verifica la coerenza delle tabelle e avanza pos; false se non valide
+    void Save(std::vector<uint32_t>& out) const;
+    bool Load(const uint32_t* data, size_t count, size_t& pos);
+
+private:
+    struct State {
+        std::vector<std::pair<wchar_t, int32_t>> next;  // Transizioni ordinate per carattere
+        int32_t fail;           // Stato del suffisso proprio piu' lungo
+        int32_t output;         // Pattern che termina qui (-1 se nessuno)
+        int32_t dictionary;     // Stato piu' vicino sulla catena fail con un output (-1)
+    };
+
+    static wchar_t Fold(wchar_t c);
+    int32_t Next(int32_t state, wchar_t c) const;
+    bool ReadTables(const uint32_t* data, size_t count, size_t& pos);
+    bool CheckTables() const;
+
+    std::vector<State> states;                          // 0 = radice
+    std::vector<std::wstring> patterns;                 // Pattern distinti, gia' convertiti
+    std::vector<std::vector<uint32_t>> patternProfiles; // Pattern -> profili che lo richiedono
+    std::vector<uint32_t> required;                     // Profilo -> numero di pattern distinti
+    bool built;
+};
@@ -0,0 +1,979 @@
+#include "ProfileRegex.h"
+#include <algorithm>
+
+namespace {
+
+// Limiti del programma: le ripetizioni {n,m} sono espanse
+const size_t MAX_PROGRAM = 50000;
+const int MAX_REPEAT = 1000;
+const int MAX_DEPTH = 200;
+
+// Insiemi predefiniti nelle classi
+const uint8_t SET_DIGIT = 1;
+const uint8_t SET_WORD = 2;
+const uint8_t SET_SPACE = 4;
+const uint8_t SET_NOT_DIGIT = 8;
+const uint8_t SET_NOT_WORD = 16;
+const uint8_t SET_NOT_SPACE = 32;
+
+enum Assertion {
+    ASSERT_BEGIN,
+    ASSERT_END,
+    ASSERT_WORD_BOUNDARY,
+    ASSERT_NOT_WORD_BOUNDARY
+};
+
+const size_t NO_POSITION = std::wstring::npos;
+
+wchar_t Fold(wchar_t c) {
+    return static_cast<wchar_t>(std::towlower(c));
+}
+
+bool IsWordChar(wchar_t c) {
+    return c == L'_' || std::iswalnum(c);
+}
+
+bool IsLineTerminator(wchar_t c) {
+    return c == L'\n' || c == L'\r' || c == 0x2028 || c == 0x2029;
+}
+
+int HexValue(wchar_t c) {
+    if (c >= L'0' && c <= L'9') return c - L'0';
+    if (c >= L'a' && c <= L'f') return c - L'a' + 10;
+    if (c >= L'A' && c <= L'F') return c - L'A' + 10;
+    return -1;
+}
+
+// Stato della ricerca riusato tra le chiamate dello stesso thread: nessuna
+// allocazione per riga una volta raggiunta la dimensione dei programmi
+struct ThreadList {
+    std::vector<int32_t> pcs;       // Thread in ordine di priorita'
+    std::vector<size_t> caps;       // Slot per istruzione: pc * slotCount
+};
+
+struct StackEntry {
+    int32_t pc;                     // -1: ripristina slot
+    int32_t slot;
+    size_t value;
+};
+
+struct Scratch {
+    ThreadList lists[2];
+    std::vector<uint32_t> marks;
+    uint32_t generation = 0;
+    std::vector<size_t> caps;
+    std::vector<size_t> best;
+    std::vector<StackEntry> stack;
+};
+
+thread_local Scratch scratch;
+
+}
+
+// ============================================================================
+// ALBERO SINTATTICO E PARSER
+// ============================================================================
+struct ProfileRegex::Node {
+    enum Type { EMPTY, CHAR, CLASS, ANY, CONCAT, ALTERNATE, REPEAT, GROUP, ASSERT };
+
+    explicit Node(Type t) : type(t) {}
+
+    Type type;
+    wchar_t c = 0;
+    int value = -1;         // CLASS: classe; GROUP: gruppo (-1 senza cattura); ASSERT: tipo
+    int min = 0;            // REPEAT
+    int max = 0;            // REPEAT, -1 = illimitato
+    bool greedy = true;
+    std::vector<std::unique_ptr<Node>> children;
+};
+
+class ProfileRegex::Parser {
+public:
+    Parser(const std::wstring& pattern, std::vector<CharClass>& classes, bool capture, size_t& groupCount)
+        : pattern(pattern), classes(classes), capture(capture), groupCount(groupCount) {}
+
+    // nullptr se il pattern non e' valido o usa costrutti non supportati
+    std::unique_ptr<Node> Parse() {
+        std::unique_ptr<Node> root = ParseAlternation(0);
+        if (root && pos < pattern.size()) {
+            return Fail(L"parentesi chiusa senza apertura");
+        }
+        return root;
+    }
+
+    std::wstring error;
+
+private:
+    std::unique_ptr<Node> Fail(const wchar_t* message) {
+        if (error.empty()) {
+            error = std::wstring(message) + L" (posizione " + std::to_wstring(pos) + L")";
+        }
+        return nullptr;
+    }
+
+    bool AtEnd() const { return pos >= pattern.size(); }
+
+    std::unique_ptr<Node> ParseAlternation(int depth) {
+        if (depth > MAX_DEPTH) {
+            return Fail(L"annidamento eccessivo");
+        }
+        std::unique_ptr<Node> first = ParseConcat(depth);
+        if (!first || AtEnd() || pattern[pos] != L'|') {
+            return first;
+        }
+
+        auto alternate = std::make_unique<Node>(Node::ALTERNATE);
+        alternate->children.push_back(std::move(first));
+        while (!AtEnd() && pattern[pos] == L'|') {
+            pos++;
+            std::unique_ptr<Node> next = ParseConcat(depth);
+            if (!next) {
+                return nullptr;
+            }
+            alternate->children.push_back(std::move(next));
+        }
+        return alternate;
+    }
+
+    std::unique_ptr<Node> ParseConcat(int depth) {
+        auto concat = std::make_unique<Node>(Node::CONCAT);
+        while (!AtEnd() && pattern[pos] != L'|' && pattern[pos] != L')') {
+            std::unique_ptr<Node> item = ParseRepeat(depth);
+            if (!item) {
+                return nullptr;
+            }
+            concat->children.push_back(std::move(item));
+        }
+        return concat;
+    }
+
+    bool ParseNumber(int& value) {
+        size_t begin = pos;
+        value = 0;
+        while (!AtEnd() && pattern[pos] >= L'0' && pattern[pos] <= L'9') {
+            value = value * 10 + (pattern[pos] - L'0');
+            if (value > MAX_REPEAT) {
+                return false;
+            }
+            pos++;
+        }
+        return pos > begin;
+    }
+
+    std::unique_ptr<Node> ParseRepeat(int depth) {
+        std::unique_ptr<Node> atom = ParseAtom(depth);
+        if (!atom || AtEnd()) {
+            return atom;
+        }
+
+        int min = 0;
+        int max = 0;
+        switch (pattern[pos]) {
+        case L'*': min = 0; max = -1; pos++; break;
+        case L'+': min = 1; max = -1; pos++; break;
+        case L'?': min = 0; max = 1; pos++; break;
+        case L'{':
+            pos++;
+            if (!ParseNumber(min)) {
+                return Fail(L"ripetizione {n,m} non valida");
+            }
+            max = min;
+            if (!AtEnd() && pattern[pos] == L',') {
+                pos++;
+                max = -1;
+                if (!AtEnd() && pattern[pos] != L'}' && !ParseNumber(max)) {
+                    return Fail(L"ripetizione {n,m} non valida");
+                }
+            }
+            if (AtEnd() || pattern[pos] != L'}' || (max >= 0 && max < min)) {
+                return Fail(L"ripetizione {n,m} non valida");
+            }
+            pos++;
+            break;
+        default:
+            return atom;
+        }
+
+        if (atom->type == Node::ASSERT) {
+            return Fail(L"quantificatore su un'asserzione");
+        }
+        auto repeat = std::make_unique<Node>(Node::REPEAT);
+        repeat->min = min;
+        repeat->max = max;
+        if (!AtEnd() && pattern[pos] == L'?') {
+            repeat->greedy = false;
+            pos++;
+        }
+        if (!AtEnd() && (pattern[pos] == L'*' || pattern[pos] == L'+' ||
+                         pattern[pos] == L'?' || pattern[pos] == L'{')) {
+            return Fail(L"quantificatore ripetuto");
+        }
+        repeat->children.push_back(std::move(atom));
+        return repeat;
+    }
+
+    std::unique_ptr<Node> MakeChar(wchar_t c) {
+        auto node = std::make_unique<Node>(Node::CHAR);
+        node->c = c;
+        return node;
+    }
+
+    std::unique_ptr<Node> MakeSet(uint8_t set) {
+        CharClass cls;
+        cls.sets = set;
+        cls.Prepare();
+        classes.push_back(cls);
+        auto node = std::make_unique<Node>(Node::CLASS);
+        node->value = static_cast<int>(classes.size() - 1);
+        return node;
+    }
+
+    std::unique_ptr<Node> MakeAssert(int assertion) {
+        auto node = std::make_unique<Node>(Node::ASSERT);
+        node->value = assertion;
+        return node;
+    }
+
+    std::unique_ptr<Node> ParseAtom(int depth) {
+        wchar_t c = pattern[pos];
+        switch (c) {
+        case L'(': {
+            pos++;
+            int group = -1;
+            if (!AtEnd() && pattern[pos] == L'?') {
+                if (pos + 1 >= pattern.size() || pattern[pos + 1] != L':') {
+                    return Fail(L"lookahead non supportato");
+                }
+                pos += 2;
+            } else if (capture) {
+                group = static_cast<int>(++groupCount);
+            }
+            std::unique_ptr<Node> inner = ParseAlternation(depth + 1);
+            if (!inner) {
+                return nullptr;
+            }
+            if (AtEnd() || pattern[pos] != L')') {
+                return Fail(L"parentesi non chiusa");
+            }
+            pos++;
+            auto node = std::make_unique<Node>(Node::GROUP);
+            node->value = group;
+            node->children.push_back(std::move(inner));
+            return node;
+        }
+        case L'[':
+            return ParseClass();
+        case L'.':
+            pos++;
+            return std::make_unique<Node>(Node::ANY);
+        case L'^':
+            pos++;
+            return MakeAssert(ASSERT_BEGIN);
+        case L'$':
+            pos++;
+            return MakeAssert(ASSERT_END);
+        case L'*':
+        case L'+':
+        case L'?':
+        case L'{':
+            return Fail(L"quantificatore senza operando");
+        case L'\\':
+            return ParseEscape();
+        default:
+            pos++;
+            return MakeChar(c);
+        }
+    }
+
+    // Carattere di un escape comune a classi e pattern: \n \t \xHH \uHHHH ...
+    // false se l'escape non e' un singolo carattere
+    bool ParseCharEscape(wchar_t e, wchar_t& out) {
+        switch (e) {
+        case L'n': out = L'\n'; return true;
+        case L't': out = L'\t'; return true;
+        case L'r': out = L'\r'; return true;
+        case L'f': out = L'\f'; return true;
+        case L'v': out = L'\v'; return true;
+        case L'0': out = L'\0'; return true;
+        case L'x':
+        case L'u': {
+            size_t digits = e == L'x' ? 2 : 4;
+            if (pos + digits > pattern.size()) {
+                return false;
+            }
+            unsigned value = 0;
+            for (size_t i = 0; i < digits; i++) {
+                int h = HexValue(pattern[pos + i]);
+                if (h < 0) {
+                    return false;
+                }
+                value = value * 16 + h;
+            }
+            pos += digits;
+            out = static_cast<wchar_t>(value);
+            return true;
+        }
+        default:
+            if (std::iswalnum(e)) {
+                return false;
+            }
+            out = e;
+            return true;
+        }
+    }
+
+    static uint8_t SetOf(wchar_t e) {
+        switch (e) {
+        case L'd': return SET_DIGIT;
+        case L'w': return SET_WORD;
+        case L's': return SET_SPACE;
+        case L'D': return SET_NOT_DIGIT;
+        case L'W': return SET_NOT_WORD;
+        case L'S': return SET_NOT_SPACE;
+        default: return 0;
+        }
+    }
+
+    std::unique_ptr<Node> ParseEscape() {
+        pos++;
+        if (AtEnd()) {
+            return Fail(L"escape incompleto");
+        }
+        wchar_t e = pattern[pos++];
+        if (uint8_t set = SetOf(e)) {
+            return MakeSet(set);
+        }
+        if (e == L'b') return MakeAssert(ASSERT_WORD_BOUNDARY);
+        if (e == L'B') return MakeAssert(ASSERT_NOT_WORD_BOUNDARY);
+        if (e >= L'1' && e <= L'9') {
+            return Fail(L"riferimento all'indietro non supportato");
+        }
+        wchar_t c;
+        if (!ParseCharEscape(e, c)) {
+            return Fail(L"escape non supportato");
+        }
+        return MakeChar(c);
+    }
+
+    std::unique_ptr<Node> ParseClass() {
+        pos++;
+        CharClass cls;
+        if (!AtEnd() && pattern[pos] == L'^') {
+            cls.negated = true;
+            pos++;
+        }
+
+        for (;;) {
+            if (AtEnd()) {
+                return Fail(L"classe non chiusa");
+            }
+            wchar_t c = pattern[pos];
+            if (c == L']') {
+                pos++;
+                break;
+            }
+            if (c == L'[' && pos + 1 < pattern.size() &&
+                (pattern[pos + 1] == L':' || pattern[pos + 1] == L'.' || pattern[pos + 1] == L'=')) {
+                return Fail(L"classe POSIX non supportata");
+            }
+
+            wchar_t low;
+            uint8_t set = 0;
+            if (!ParseClassAtom(low, set)) {
+                return nullptr;
+            }
+            if (set) {
+                cls.sets |= set;
+                continue;
+            }
+
+            wchar_t high = low;
+            if (pos + 1 < pattern.size() && pattern[pos] == L'-' && pattern[pos + 1] != L']') {
+                pos++;
+                if (!ParseClassAtom(high, set)) {
+                    return nullptr;
+                }
+                if (set || high < low) {
+                    Fail(L"intervallo non valido nella classe");
+                    return nullptr;
+                }
+            }
+            cls.ranges.emplace_back(low, high);
+        }
+
+        cls.Prepare();
+        classes.push_back(cls);
+        auto node = std::make_unique<Node>(Node::CLASS);
+        node->value = static_cast<int>(classes.size() - 1);
+        return node;
+    }
+
+    bool ParseClassAtom(wchar_t& c, uint8_t& set) {
+        set = 0;
+        c = pattern[pos++];
+        if (c != L'\\') {
+            return true;
+        }
+        if (AtEnd()) {
+            Fail(L"escape incompleto");
+            return false;
+        }
+        wchar_t e = pattern[pos++];
+        if ((set = SetOf(e)) != 0) {
+            return true;
+        }
+        if (e == L'b') {
+            c = L'\b';
+            return true;
+        }
+        if (!ParseCharEscape(e, c)) {
+            Fail(L"escape non supportato nella classe");
+            return false;
+        }
+        return true;
+    }
+
+    const std::wstring& pattern;
+    std::vector<CharClass>& classes;
+    bool capture;
+    size_t& groupCount;
+    size_t pos = 0;
+};
+
+// ============================================================================
+// CLASSI DI CARATTERI
+// ============================================================================
+bool ProfileRegex::CharClass::ContainsExact(wchar_t c) const {
+    for (const auto& range : ranges) {
+        if (c >= range.first && c <= range.second) {
+            return true;
+        }
+    }
+    if (sets) {
+        if ((sets & SET_DIGIT) && std::iswdigit(c)) return true;
+        if ((sets & SET_WORD) && IsWordChar(c)) return true;
+        if ((sets & SET_SPACE) && std::iswspace(c)) return true;
+        if ((sets & SET_NOT_DIGIT) && !std::iswdigit(c)) return true;
+        if ((sets & SET_NOT_WORD) && !IsWordChar(c)) return true;
+        if ((sets & SET_NOT_SPACE) && !std::iswspace(c)) return true;
+    }
+    return false;
+}
+
+void ProfileRegex::CharClass::Prepare() {
+    ascii[0] = ascii[1] = 0;
+    for (wchar_t c = 0; c < 128; c++) {
+        bool in = ContainsExact(c) || ContainsExact(Fold(c)) ||
+                  ContainsExact(static_cast<wchar_t>(std::towupper(c)));
+        if (in != negated) {
+            ascii[c >> 6] |= uint64_t(1) << (c & 63);
+        }
+    }
+}
+
+// ============================================================================
+// COMPILAZIONE
+// ============================================================================
+ProfileRegex::ProfileRegex() {
+    Reset();
+}
+
+void ProfileRegex::Reset() {
+    program.clear();
+    classes.clear();
+    firstInsts.clear();
+    firstAscii[0] = firstAscii[1] = 0;
+    hasPrefilter = false;
+    groupCount = 0;
+    slotCount = 2;
+    fallback.reset();
+    valid = false;
+    error.clear();
+}
+
+int32_t ProfileRegex::Append(Opcode op, wchar_t c, int32_t x, int32_t y) {
+    program.push_back(Inst{ op, c, x, y });
+    return static_cast<int32_t>(program.size() - 1);
+}
+
+bool ProfileRegex::Emit(const Node& node) {
+    if (program.size() > MAX_PROGRAM) {
+        return false;
+    }
+
+    switch (node.type) {
+    case Node::EMPTY:
+        break;
+    case Node::CHAR:
+        Append(OP_CHAR, Fold(node.c));
+        break;
+    case Node::CLASS:
+        Append(OP_CLASS, 0, node.value);
+        break;
+    case Node::ANY:
+        Append(OP_ANY);
+        break;
+    case Node::ASSERT:
+        Append(OP_ASSERT, 0, node.value);
+        break;
+    case Node::CONCAT:
+        for (const auto& child : node.children) {
+            if (!Emit(*child)) {
+                return false;
+            }
+        }
+        break;
+    case Node::GROUP:
+        if (node.value >= 0) {
+            Append(OP_SAVE, 0, node.value * 2);
+        }
+        if (!Emit(*node.children[0])) {
+            return false;
+        }
+        if (node.value >= 0) {
+            Append(OP_SAVE, 0, node.value * 2 + 1);
+        }
+        break;
+    case Node::ALTERNATE: {
+        // split L1, L2; L1: a; jmp fine; L2: split ... ; ultima alternativa
+        std::vector<int32_t> exits;
+        for (size_t i = 0; i + 1 < node.children.size(); i++) {
+            int32_t split = Append(OP_SPLIT);
+            program[split].x = split + 1;
+            if (!Emit(*node.children[i])) {
+                return false;
+            }
+            exits.push_back(Append(OP_JMP));
+            program[split].y = static_cast<int32_t>(program.size());
+        }
+        if (!Emit(*node.children.back())) {
+            return false;
+        }
+        for (int32_t exit : exits) {
+            program[exit].x = static_cast<int32_t>(program.size());
+        }
+        break;
+    }
+    case Node::REPEAT: {
+        const Node& child = *node.children[0];
+        for (int i = 0; i < node.min; i++) {
+            if (!Emit(child)) {
+                return false;
+            }
+        }
+
+        // Con greedy il ramo che ripete ha priorita', con lazy quello che esce
+        auto setSplit = [&](int32_t split, int32_t repeat, int32_t exit) {
+            program[split].x = node.greedy ? repeat : exit;
+            program[split].y = node.greedy ? exit : repeat;
+        };
+
+        if (node.max < 0) {
+            int32_t split = Append(OP_SPLIT);
+            if (!Emit(child)) {
+                return false;
+            }
+            Append(OP_LOOP, 0, split, static_cast<int32_t>(program.size() + 1));
+            setSplit(split, split + 1, static_cast<int32_t>(program.size()));
+        } else {
+            std::vector<int32_t> splits;
+            for (int i = node.min; i < node.max; i++) {
+                splits.push_back(Append(OP_SPLIT));
+                if (!Emit(child)) {
+                    return false;
+                }
+            }
+            int32_t exit = static_cast<int32_t>(program.size());
+            for (int32_t split : splits) {
+                setSplit(split, split + 1, exit);
+            }
+        }
+        break;
+    }
+    }
+    return program.size() <= MAX_PROGRAM;
+}
+
+bool ProfileRegex::Compile(const std::wstring& pattern) {
+    Reset();
+
+    Parser parser(pattern, classes, true, groupCount);
+    std::unique_ptr<Node> root = parser.Parse();
+    if (root) {
+        Append(OP_SAVE, 0, 0);
+        if (Emit(*root)) {
+            Append(OP_SAVE, 0, 1);
+            Append(OP_MATCH, 0, 0);
+            slotCount = (groupCount + 1) * 2;
+            BuildPrefilter();
+            valid = true;
+            return true;
+        }
+        parser.error = L"pattern troppo grande";
+    }
+
+    // Costrutti fuori dal sottoinsieme lineare: std::wregex, se lo accetta
+    Reset();
+    try {
+        fallback = std::make_unique<std::wregex>(pattern, std::regex::icase | std::regex::optimize);
+        groupCount = fallback->mark_count();
+        valid = true;
+        return true;
+    } catch (const std::regex_error&) {
+        fallback.reset();
+        error = parser.error;
+        return false;
+    }
+}
+
+bool ProfileRegex::CompileSet(const std::vector<std::wstring>& patterns) {
+    Reset();
+    if (patterns.empty()) {
+        error = L"insieme vuoto";
+        return false;
+    }
+
+    // SAVE 0; split A0, L1; A0: p0; SAVE 1; MATCH 0; L1: split A1, L2 ...
+    Append(OP_SAVE, 0, 0);
+    for (size_t i = 0; i < patterns.size(); i++) {
+        size_t unusedGroups = 0;
+        Parser parser(patterns[i], classes, false, unusedGroups);
+        std::unique_ptr<Node> root = parser.Parse();
+        if (!root) {
+            std::wstring message = L"pattern " + std::to_wstring(i) + L": " + parser.error;
+            Reset();
+            error = message;
+            return false;
+        }
+
+        int32_t split = -1;
+        if (i + 1 < patterns.size()) {
+            split = Append(OP_SPLIT);
+            program[split].x = split + 1;
+        }
+        if (!Emit(*root)) {
+            Reset();
+            error = L"insieme troppo grande";
+            return false;
+        }
+        Append(OP_SAVE, 0, 1);
+        Append(OP_MATCH, 0, static_cast<int32_t>(i));
+        if (split >= 0) {
+            program[split].y = static_cast<int32_t>(program.size());
+        }
+    }
+
+    slotCount = 2;
+    BuildPrefilter();
+    valid = true;
+    return true;
+}
+
+// Istruzioni raggiungibili dall'inizio senza consumare caratteri: se sono
+// tutte su caratteri o classi, le posizioni dove nessuna accetta il
+// carattere non possono iniziare un match e vengono saltate senza thread
+void ProfileRegex::BuildPrefilter() {
+    std::vector<bool> seen(program.size(), false);
+    std::vector<int32_t> pending = { 0 };
+    while (!pending.empty()) {
+        int32_t pc = pending.back();
+        pending.pop_back();
+        if (seen[pc]) {
+            continue;
+        }
+        seen[pc] = true;
+
+        const Inst& inst = program[pc];
+        switch (inst.op) {
+        case OP_JMP:
+            pending.push_back(inst.x);
+            break;
+        case OP_SPLIT:
+        case OP_LOOP:
+            pending.push_back(inst.x);
+            pending.push_back(inst.y);
+            break;
+        case OP_SAVE:
+        case OP_ASSERT:
+            pending.push_back(pc + 1);
+            break;
+        case OP_CHAR:
+        case OP_CLASS:
+            firstInsts.push_back(pc);
+            break;
+        case OP_ANY:
+        case OP_MATCH:
+            // '.' o match vuoto: qualunque posizione puo' iniziare
+            firstInsts.clear();
+            return;
+        }
+    }
+
+    for (wchar_t c = 0; c < 128; c++) {
+        wchar_t folded = Fold(c);
+        for (int32_t pc : firstInsts) {
+            const Inst& inst = program[pc];
+            if (inst.op == OP_CHAR ? inst.c == folded : classes[inst.x].Contains(c)) {
+                firstAscii[c >> 6] |= uint64_t(1) << (c & 63);
+                break;
+            }
+        }
+    }
+    hasPrefilter = !firstInsts.empty();
+}
+
+bool ProfileRegex::CanStart(wchar_t c) const {
+    if (static_cast<uint32_t>(c) < 128) {
+        return (firstAscii[c >> 6] >> (c & 63)) & 1;
+    }
+    wchar_t folded = Fold(c);
+    for (int32_t pc : firstInsts) {
+        const Inst& inst = program[pc];
+        if (inst.op == OP_CHAR ? inst.c == folded : classes[inst.x].Contains(c)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// ============================================================================
+// RICERCA (Pike VM)
+// ============================================================================
+bool ProfileRegex::Check(int32_t assertion, std::wstring_view text, size_t pos) const {
+    switch (assertion) {
+    case ASSERT_BEGIN:
+        return pos == 0;
+    case ASSERT_END:
+        return pos == text.size();
+    default: {
+        bool before = pos > 0 && IsWordChar(text[pos - 1]);
+        bool after = pos < text.size() && IsWordChar(text[pos]);
+        return (before != after) == (assertion == ASSERT_WORD_BOUNDARY);
+    }
+    }
+}
+
+bool ProfileRegex::Run(std::wstring_view text, size_t start, Match* match) const {
+    Scratch& s = scratch;
+    const size_t count = program.size();
+    if (s.marks.size() < count) {
+        s.marks.resize(count);
+    }
+    // Generazione nuova per ogni lista (al piu' due per posizione): a
+    // contatore esaurito si azzera tutto
+    if (s.generation > UINT32_MAX - 2 * text.size() - 4) {
+        std::fill(s.marks.begin(), s.marks.end(), 0);
+        s.generation = 0;
+    }
+    for (auto& list : s.lists) {
+        list.pcs.clear();
+        if (list.caps.size() < count * slotCount) {
+            list.caps.resize(count * slotCount);
+        }
+    }
+    s.caps.assign(slotCount, NO_POSITION);
+
+    // Aggiunge alla lista il thread in pc con gli slot di s.caps, seguendo
+    // salti, split, salvataggi e asserzioni in ordine di priorita'
+    auto addThread = [&](ThreadList& list, uint32_t generation, int32_t pc0, size_t pos) {
+        s.stack.clear();
+        s.stack.push_back(StackEntry{ pc0, 0, 0 });
+        while (!s.stack.empty()) {
+            StackEntry entry = s.stack.back();
+            s.stack.pop_back();
+            if (entry.pc < 0) {
+                s.caps[entry.slot] = entry.value;
+                continue;
+            }
+
+            int32_t pc = entry.pc;
+            while (s.marks[pc] != generation) {
+                s.marks[pc] = generation;
+                const Inst& inst = program[pc];
+                if (inst.op == OP_JMP) {
+                    pc = inst.x;
+                } else if (inst.op == OP_LOOP) {
+                    // Split gia' visitato in questa posizione: l'iterazione non
+                    // ha consumato caratteri e, come in ECMAScript, il ciclo esce
+                    pc = s.marks[inst.x] == generation ? inst.y : inst.x;
+                } else if (inst.op == OP_SPLIT) {
+                    s.stack.push_back(StackEntry{ inst.y, 0, 0 });
+                    pc = inst.x;
+                } else if (inst.op == OP_SAVE) {
+                    if (static_cast<size_t>(inst.x) < slotCount) {
+                        s.stack.push_back(StackEntry{ -1, inst.x, s.caps[inst.x] });
+                        s.caps[inst.x] = pos;
+                    }
+                    pc++;
+                } else if (inst.op == OP_ASSERT) {
+                    if (!Check(inst.x, text, pos)) {
+                        break;
+                    }
+                    pc++;
+                } else {
+                    list.pcs.push_back(pc);
+                    std::copy(s.caps.begin(), s.caps.end(), list.caps.begin() + pc * slotCount);
+                    break;
+                }
+            }
+        }
+    };
+
+    ThreadList* current = &s.lists[0];
+    ThreadList* next = &s.lists[1];
+    uint32_t currentGeneration = ++s.generation;
+    bool matched = false;
+    int matchedPattern = -1;
+    std::vector<size_t>& best = s.best;
+    const size_t n = text.size();
+
+    for (size_t pos = start; ; pos++) {
+        if (!matched) {
+            if (current->pcs.empty() && hasPrefilter) {
+                while (pos < n && !CanStart(text[pos])) {
+                    pos++;
+                }
+                if (pos >= n) {
+                    break;
+                }
+                // I segni lasciati da thread morti su asserzioni in posizioni
+                // precedenti non valgono per la nuova posizione
+                currentGeneration = ++s.generation;
+            }
+            // Un nuovo inizio ha priorita' minore dei thread gia' partiti
+            std::fill(s.caps.begin(), s.caps.end(), NO_POSITION);
+            addThread(*current, currentGeneration, 0, pos);
+        }
+        if (current->pcs.empty()) {
+            if (matched || pos >= n) {
+                break;
+            }
+            currentGeneration = ++s.generation;
+            continue;
+        }
+
+        uint32_t nextGeneration = ++s.generation;
+        next->pcs.clear();
+        wchar_t c = pos < n ? text[pos] : 0;
+        wchar_t folded = Fold(c);
+
+        for (size_t i = 0; i < current->pcs.size(); i++) {
+            int32_t pc = current->pcs[i];
+            const Inst& inst = program[pc];
+            const size_t* caps = current->caps.data() + pc * slotCount;
+
+            bool accepted = false;
+            switch (inst.op) {
+            case OP_CHAR:
+                accepted = pos < n && inst.c == folded;
+                break;
+            case OP_CLASS:
+                accepted = pos < n && classes[inst.x].Contains(c);
+                break;
+            case OP_ANY:
+                accepted = pos < n && !IsLineTerminator(c);
+                break;
+            case OP_MATCH:
+                // I thread dopo questo hanno priorita' minore: scartati
+                matched = true;
+                matchedPattern = inst.x;
+                best.assign(caps, caps + slotCount);
+                i = current->pcs.size();
+                continue;
+            default:
+                break;
+            }
+            if (accepted) {
+                std::copy(caps, caps + slotCount, s.caps.begin());
+                addThread(*next, nextGeneration, pc + 1, pos + 1);
+            }
+        }
+
+        std::swap(current, next);
+        currentGeneration = nextGeneration;
+        if (pos >= n) {
+            break;
+        }
+    }
+
+    if (!matched) {
+        return false;
+    }
+    if (match) {
+        match->position = best[0];
+        match->length = best[1] - best[0];
+        match->pattern = matchedPattern;
+        match->groups.assign(groupCount + 1, std::make_pair(NO_POSITION, NO_POSITION));
+        for (size_t g = 0; g <= groupCount && g * 2 + 1 < slotCount; g++) {
+            if (best[g * 2] != NO_POSITION && best[g * 2 + 1] != NO_POSITION) {
+                match->groups[g] = std::make_pair(best[g * 2], best[g * 2 + 1]);
+            }
+        }
+    }
+    return true;
+}
+
+bool ProfileRegex::Search(std::wstring_view text, Match& match, size_t start) const {
+    if (!valid || start > text.size()) {
+        return false;
+    }
+    if (!fallback) {
+        return Run(text, start, &match);
+    }
+
+    try {
+        std::wcmatch result;
+        auto flags = start > 0 ? std::regex_constants::match_prev_avail : std::regex_constants::match_default;
+        if (!std::regex_search(text.data() + start, text.data() + text.size(), result, *fallback, flags)) {
+            return false;
+        }
+        match.position = start + result.position(0);
+        match.length = result.length(0);
+        match.pattern = 0;
+        match.groups.assign(result.size(), std::make_pair(NO_POSITION, NO_POSITION));
+        for (size_t g = 0; g < result.size(); g++) {
+            if (result[g].matched) {
+                size_t begin = start + result.position(g);
+                match.groups[g] = std::make_pair(begin, begin + result.length(g));
+            }
+        }
+        return true;
+    } catch (const std::regex_error&) {
+        // Es. error_stack su righe molto lunghe
+        return false;
+    }
+}
+
+bool ProfileRegex::Search(std::wstring_view text, size_t start) const {
+    if (!fallback) {
+        return valid && start <= text.size() && Run(text, start, nullptr);
+    }
+    Match match;
+    return Search(text, match, start);
+}
+
+bool ProfileRegex::GetLiteral(std::wstring& literal) const {
+    // SAVE 0, CHAR..., SAVE 1, MATCH
+    if (!IsLinear() || program.size() < 4 || groupCount != 0) {
+        return false;
+    }
+    literal.clear();
+    for (size_t pc = 1; pc + 2 < program.size(); pc++) {
+        if (program[pc].op != OP_CHAR) {
+            return false;
+        }
+        literal += program[pc].c;
+    }
+    return true;
+}
+
+bool ProfileRegex::Match::Matched(size_t group) const {
+    return group < groups.size() && groups[group].first != NO_POSITION;
+}
+
+std::wstring ProfileRegex::Match::Str(std::wstring_view text, size_t group) const {
+    if (!Matched(group)) {
+        return L"";
+    }
+    return std::wstring(text.substr(groups[group].first, groups[group].second - groups[group].first));
+}
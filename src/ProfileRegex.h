@@ -0,0 +1,117 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <regex>
+#include <memory>
+#include <cstdint>
+#include <cwctype>
+
+// Regex dei profili su un motore a tempo lineare: il pattern e' compilato
+// in un programma NFA (Thompson) ed eseguito simulando tutti i thread in
+// parallelo (Pike VM), con i gruppi di cattura. Il costo e' proporzionale
+// a lunghezza del testo per dimensione del programma qualunque sia l'input:
+// nessun backtracking, per cui una riga malformata non blocca il parsing.
+// La semantica e' quella ECMAScript di std::regex (vince la prima
+// alternativa, quantificatori greedy e lazy), sempre senza distinzione tra
+// maiuscole e minuscole come i pattern dei profili.
+// Sottoinsieme supportato: letterali, '.', classi [...] con intervalli,
+// \d \w \s \D \W \S, gruppi con e senza cattura, alternative, * + ? {n}
+// {n,} {n,m} anche lazy, ^ $ \b \B. I pattern con altri costrutti
+// (riferimenti all'indietro, lookahead, classi POSIX) restano su std::wregex.
+// Un'istanza compilata e' immutabile e condivisibile tra thread.
+class ProfileRegex {
+public:
+    struct Match {
+        size_t position = 0;
+        size_t length = 0;
+        int pattern = -1;       // Pattern dell'insieme che ha prodotto il match
+        std::vector<std::pair<size_t, size_t>> groups;  // [inizio, fine) per gruppo, 0 = intero match
+
+        bool Matched(size_t group) const;
+        std::wstring Str(std::wstring_view text, size_t group) const;
+    };
+
+    ProfileRegex();
+
+    // Compila un pattern; false se non valido (errore in GetError)
+    bool Compile(const std::wstring& pattern);
+
+    // Compila un insieme di pattern in un unico programma: la ricerca trova
+    // il match piu' a sinistra e, a parita', il primo pattern (Match::pattern).
+    // I gruppi interni non sono catturati. Richiede pattern tutti supportati
+    // dal motore lineare
+    bool CompileSet(const std::vector<std::wstring>& patterns);
+
+    // Cerca il primo match a partire da start (le asserzioni vedono tutto il testo)
+    bool Search(std::wstring_view text, Match& match, size_t start = 0) const;
+    bool Search(std::wstring_view text, size_t start = 0) const;
+
+    // Se il pattern e' una semplice sequenza di caratteri restituisce il
+    // testo (in minuscolo): la ricerca equivale a quella della sottostringa
+    bool GetLiteral(std::wstring& literal) const;
+
+    bool IsValid() const { return valid; }
+    bool IsLinear() const { return valid && !fallback; }    // false: std::wregex
+    size_t GetGroupCount() const { return groupCount; }     // Escluso il gruppo 0
+    const std::wstring& GetError() const { return error; }
+
+private:
+    enum Opcode : uint8_t {
+        OP_CHAR,        // Carattere (gia' minuscolo)
+        OP_CLASS,       // Classe di caratteri
+        OP_ANY,         // '.': tutto tranne i terminatori di riga
+        OP_SPLIT,       // Due continuazioni, x prioritaria
+        OP_JMP,
+        OP_LOOP,        // Ritorno allo split x di un ciclo, uscita in y
+        OP_SAVE,        // Posizione nello slot x
+        OP_ASSERT,      // ^ $ \b \B
+        OP_MATCH        // Fine del pattern x
+    };
+
+    struct Inst {
+        Opcode op;
+        wchar_t c;
+        int32_t x;
+        int32_t y;
+    };
+
+    struct CharClass {
+        std::vector<std::pair<wchar_t, wchar_t>> ranges;
+        uint8_t sets = 0;           // \d \w \s e negazioni, vedi ProfileRegex.cpp
+        bool negated = false;
+        uint64_t ascii[2] = {};     // Esito precalcolato per i caratteri ASCII
+
+        bool ContainsExact(wchar_t c) const;
+        void Prepare();
+        bool Contains(wchar_t c) const {
+            if (static_cast<uint32_t>(c) < 128) {
+                return (ascii[c >> 6] >> (c & 63)) & 1;
+            }
+            return (ContainsExact(c) || ContainsExact(static_cast<wchar_t>(std::towlower(c))) ||
+                    ContainsExact(static_cast<wchar_t>(std::towupper(c)))) != negated;
+        }
+    };
+
+    struct Node;
+    class Parser;
+
+    void Reset();
+    bool Emit(const Node& node);
+    int32_t Append(Opcode op, wchar_t c = 0, int32_t x = 0, int32_t y = 0);
+    void BuildPrefilter();
+    bool CanStart(wchar_t c) const;
+    bool Check(int32_t assertion, std::wstring_view text, size_t pos) const;
+    bool Run(std::wstring_view text, size_t start, Match* match) const;
+
+    std::vector<Inst> program;
+    std::vector<CharClass> classes;
+    std::vector<int32_t> firstInsts;    // Istruzioni con cui puo' iniziare un match
+    uint64_t firstAscii[2];
+    bool hasPrefilter;
+    size_t groupCount;
+    size_t slotCount;
+    std::unique_ptr<std::wregex> fallback;
+    bool valid;
+    std::wstring error;
+};
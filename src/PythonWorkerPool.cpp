@@ -0,0 +1,256 @@
+#include "PythonWorkerPool.h"
+#include <algorithm>
+#include <cstdint>
+
+std::wstring PythonWorkerPool::script;
+unsigned PythonWorkerPool::recycleLimit = 0;
+std::vector<std::unique_ptr<PythonWorkerPool::Worker>> PythonWorkerPool::workers;
+std::thread PythonWorkerPool::supervisor;
+std::chrono::steady_clock::time_point PythonWorkerPool::retryAt;
+std::mutex PythonWorkerPool::mutex;
+std::condition_variable PythonWorkerPool::changed;
+bool PythonWorkerPool::running = false;
+thread_local std::wstring PythonWorkerPool::lastError;
+
+namespace {
+
+// Attesa prima di riprovare l'avvio di un worker fallito
+const std::chrono::seconds RESTART_BACKOFF(5);
+
+// Dimensione massima di una risposta: oltre, il frame e' considerato
+// corrotto e il worker viene riavviato
+const uint32_t MAX_RESPONSE_BYTES = 64 * 1024 * 1024;
+
+// Codifica UTF-8 dei percorsi per la richiesta
+std::string ToUtf8(const std::wstring& text) {
+    std::string result;
+    for (size_t i = 0; i < text.size(); i++) {
+        char32_t c = static_cast<char32_t>(text[i]);
+        // wchar_t a 16 bit: ricompone le coppie surrogate
+        if (sizeof(wchar_t) == 2 && c >= 0xD800 && c <= 0xDBFF && i + 1 < text.size()) {
+            c = 0x10000 + ((c - 0xD800) << 10) + (static_cast<char32_t>(text[++i]) - 0xDC00);
+        }
+        if (c < 0x80) {
+            result += static_cast<char>(c);
+        } else if (c < 0x800) {
+            result += static_cast<char>(0xC0 | (c >> 6));
+            result += static_cast<char>(0x80 | (c & 0x3F));
+        } else if (c < 0x10000) {
+            result += static_cast<char>(0xE0 | (c >> 12));
+            result += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            result += static_cast<char>(0x80 | (c & 0x3F));
+        } else {
+            result += static_cast<char>(0xF0 | (c >> 18));
+            result += static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+            result += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            result += static_cast<char>(0x80 | (c & 0x3F));
+        }
+    }
+    return result;
+}
+
+// Frame del protocollo: lunghezza a 32 bit little-endian + contenuto
+std::string MakeFrame(const std::string& payload) {
+    uint32_t length = static_cast<uint32_t>(payload.size());
+    std::string frame;
+    frame.reserve(4 + payload.size());
+    for (int i = 0; i < 4; i++) {
+        frame += static_cast<char>((length >> (8 * i)) & 0xFF);
+    }
+    frame += payload;
+    return frame;
+}
+
+}
+
+bool PythonWorkerPool::Start(const std::wstring& scriptPath, unsigned count, unsigned recycleAfter) {
+    Stop();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    script = scriptPath;
+    recycleLimit = recycleAfter;
+    for (unsigned i = 0; i < std::max(1u, count); i++) {
+        auto worker = std::make_unique<Worker>();
+        worker->state = State::Stopped;
+        worker->served = 0;
+        workers.push_back(std::move(worker));
+    }
+
+    running = true;
+    retryAt = std::chrono::steady_clock::time_point::min();
+    supervisor = std::thread(&PythonWorkerPool::SupervisorThread);
+    return true;
+}
+
+void PythonWorkerPool::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) {
+            return;
+        }
+        running = false;
+    }
+    changed.notify_all();
+
+    if (supervisor.joinable()) {
+        supervisor.join();
+    }
+
+    // Attende le richieste in corso, poi termina i processi
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [] {
+        for (const auto& worker : workers) {
+            if (worker->state == State::Busy) return false;
+        }
+        return true;
+    });
+    for (auto& worker : workers) {
+        worker->channel.Kill();
+    }
+    workers.clear();
+}
+
+bool PythonWorkerPool::IsRunning() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return running;
+}
+
+std::wstring PythonWorkerPool::GetLastError() {
+    return lastError;
+}
+
+void PythonWorkerPool::SupervisorThread() {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (running) {
+        // Primo worker da avviare, rispettando la pausa dopo un avvio fallito
+        Worker* pending = nullptr;
+        if (std::chrono::steady_clock::now() >= retryAt) {
+            for (auto& worker : workers) {
+                if (worker->state == State::Stopped) {
+                    pending = worker.get();
+                    break;
+                }
+            }
+        }
+
+        if (!pending) {
+            if (retryAt > std::chrono::steady_clock::now()) {
+                changed.wait_until(lock, retryAt);
+            } else {
+                changed.wait(lock);
+            }
+            continue;
+        }
+
+        // Avvio fuori dal lock: l'interprete puo' richiedere secondi
+        pending->state = State::Starting;
+        lock.unlock();
+        pending->channel.Kill();
+        bool started = pending->channel.Start(L"python", { script, L"--server" });
+        lock.lock();
+
+        pending->served = 0;
+        if (started) {
+            pending->state = State::Idle;
+            retryAt = std::chrono::steady_clock::time_point::min();
+        } else {
+            pending->state = State::Stopped;
+            retryAt = std::chrono::steady_clock::now() + RESTART_BACKOFF;
+        }
+        changed.notify_all();
+    }
+}
+
+bool PythonWorkerPool::Extract(const std::wstring& pdfPath, const std::wstring& profilePath,
+                               std::chrono::milliseconds timeout, std::wstring& text) {
+    lastError.clear();
+    text.clear();
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    // Attende un worker libero. Se sono tutti fermi dopo un avvio fallito
+    // nessuno si liberera' prima del prossimo tentativo: inutile attendere
+    Worker* worker = nullptr;
+    bool startFailed = false;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        bool ready = changed.wait_until(lock, deadline, [&worker, &startFailed] {
+            if (!running) return true;
+            bool allStopped = true;
+            for (auto& w : workers) {
+                if (w->state == State::Idle) {
+                    worker = w.get();
+                    return true;
+                }
+                if (w->state != State::Stopped) {
+                    allStopped = false;
+                }
+            }
+            startFailed = allStopped && std::chrono::steady_clock::now() < retryAt;
+            return startFailed;
+        });
+
+        if (!running) {
+            lastError = L"Pool Python non attivo";
+            return false;
+        }
+        if (startFailed) {
+            lastError = L"Impossibile avviare i worker Python";
+            return false;
+        }
+        if (!ready || !worker) {
+            lastError = L"Nessun worker Python disponibile";
+            return false;
+        }
+        worker->state = State::Busy;
+    }
+
+    // Scambio richiesta/risposta
+    std::string response;
+    std::wstring failure = L"Worker Python non ha risposto";
+    bool success = worker->channel.Write(MakeFrame(ToUtf8(pdfPath) + '\0' + ToUtf8(profilePath)));
+    if (success) {
+        char header[4];
+        success = worker->channel.Read(header, 4, deadline);
+        if (success) {
+            uint32_t length = 0;
+            for (int i = 0; i < 4; i++) {
+                length |= static_cast<uint32_t>(static_cast<unsigned char>(header[i])) << (8 * i);
+            }
+            if (length > MAX_RESPONSE_BYTES) {
+                failure = L"Risposta del worker Python non valida (" + std::to_wstring(length) + L" byte)";
+                success = false;
+            } else {
+                response.resize(length);
+                success = length > 0 && worker->channel.Read(&response[0], length, deadline);
+            }
+        }
+    }
+
+    if (success) {
+        Subprocess::Utf8Decoder decoder;
+        decoder.Feed(response.data() + 1, response.size() - 1, text);
+        decoder.Finish(text);
+        if (response[0] != 'O') {
+            lastError = L"Script Python: " + text;
+            text.clear();
+        }
+    } else {
+        // Worker terminato, bloccato o fuori protocollo: il supervisore lo riavvia
+        lastError = failure;
+        worker->channel.Kill();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        worker->served++;
+        if (!success || (recycleLimit > 0 && worker->served >= recycleLimit)) {
+            worker->state = State::Stopped;
+        } else {
+            worker->state = State::Idle;
+        }
+    }
+    changed.notify_all();
+
+    return success && lastError.empty();
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include "Subprocess.h"
+
+// Pool di processi extract_zones.py --server sempre attivi: l'avvio
+// dell'interprete e l'import di PyMuPDF si pagano una volta per worker e
+// non a ogni PDF. Le richieste dei thread di elaborazione vengono
+// distribuite sui worker liberi (uno scambio alla volta per worker).
+// Un thread supervisore riavvia in background i worker terminati, quelli
+// che non hanno risposto e quelli che hanno raggiunto il numero massimo di
+// documenti (riciclo contro perdite di memoria nelle librerie native).
+class PythonWorkerPool {
+public:
+    // Avvia workers processi server dello script. recycleAfter = 0: nessun riciclo
+    static bool Start(const std::wstring& scriptPath, unsigned workers, unsigned recycleAfter);
+
+    // Termina i worker e il supervisore
+    static void Stop();
+
+    static bool IsRunning();
+
+    // Estrae il testo delle zone del profilo. Restituisce false se nessun
+    // worker e' disponibile entro il timeout o se l'estrazione fallisce;
+    // subito se l'interprete non si avvia (tutti i worker fermi in attesa
+    // di un nuovo tentativo)
+    static bool Extract(const std::wstring& pdfPath, const std::wstring& profilePath,
+                        std::chrono::milliseconds timeout, std::wstring& text);
+
+    // Restituisce l'ultimo errore
+    static std::wstring GetLastError();
+
+private:
+    enum class State {
+        Stopped,    // Da avviare (mai avviato, terminato o da riciclare)
+        Starting,   // Avvio in corso nel supervisore
+        Idle,       // Pronto per una richiesta
+        Busy        // Richiesta in corso
+    };
+
+    struct Worker {
+        Subprocess::Channel channel;
+        State state;
+        unsigned served;        // Documenti elaborati dall'ultimo avvio
+    };
+
+    static void SupervisorThread();
+
+    static std::wstring script;
+    static unsigned recycleLimit;
+    static std::vector<std::unique_ptr<Worker>> workers;
+    static std::thread supervisor;
+    static std::chrono::steady_clock::time_point retryAt;  // Prossimo avvio dopo un fallimento
+    static std::mutex mutex;
+    static std::condition_variable changed;
+    static bool running;
+    static thread_local std::wstring lastError;
+};
@@ -1,56 +1,143 @@
 #include "ReportProfile.h"
-#include <regex>
+#include "CompiledProfile.h"
+#include "ProfileCompiler.h"
 #include <algorithm>
 
-std::vector<ReportProfile> ProfileManager::profiles;
-ReportProfile ProfileManager::defaultProfile;
-bool ProfileManager::initialized = false;
+std::shared_ptr<const ReportProfileSet> ProfileManager::current;
+std::mutex ProfileManager::mutex;
+std::wstring ProfileManager::directory;
+std::wstring ProfileManager::compiledPath;
+std::wstring ProfileManager::lastError;
+
+const ReportProfile* ReportProfileSet::FindProfile(std::wstring_view text) const {
+    // Una sola passata sul testo per tutti i profili
+    int match = index.MatchFirst(text);
+    return match >= 0 ? &profiles[match] : nullptr;
+}
+
+const ReportProfile* ReportProfileSet::FindProfileOrDefault(std::wstring_view text) const {
+    const ReportProfile* profile = FindProfile(text);
+    return profile ? profile : &defaultProfile;
+}
 
 void ProfileManager::Initialize() {
-    if (initialized) return;
-    
-    RegisterProfiles();
-    defaultProfile = CreateDefaultProfile();
-    initialized = true;
+    if (std::atomic_load(&current)) return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (std::atomic_load(&current)) return;
+    std::atomic_store(&current, std::shared_ptr<const ReportProfileSet>(Load()));
 }
 
-void ProfileManager::RegisterProfiles() {
-    profiles.clear();
-    profiles.push_back(CreateProfile_RX_Maugeri());
-    profiles.push_back(CreateProfile_TSA_Maugeri());
+void ProfileManager::SetProfileDirectory(const std::wstring& profileDirectory, const std::wstring& compiledFile) {
+    std::lock_guard<std::mutex> lock(mutex);
+    directory = profileDirectory;
+    compiledPath = compiledFile;
 }
 
-const ReportProfile* ProfileManager::FindProfile(const std::wstring& text) {
-    if (!initialized) Initialize();
-    
-    for (const auto& profile : profiles) {
-        bool allMatch = true;
-        for (const auto& pattern : profile.identifierPatterns) {
-            std::wstring lowerText = text;
-            std::wstring lowerPattern = pattern;
-            std::transform(lowerText.begin(), lowerText.end(), lowerText.begin(), ::towlower);
-            std::transform(lowerPattern.begin(), lowerPattern.end(), lowerPattern.begin(), ::towlower);
-            
-            if (lowerText.find(lowerPattern) == std::wstring::npos) {
-                allMatch = false;
-                break;
+bool ProfileManager::Refresh() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::shared_ptr<const ReportProfileSet> set = std::atomic_load(&current);
+    if (directory.empty() || !set) {
+        return false;
+    }
+
+    // Solo l'impronta delle sorgenti: nessuna ricompilazione se non cambiano
+    uint64_t fingerprint = ProfileCompiler::Fingerprint(ProfileCompiler::ListSources(directory), BuiltInProfiles());
+    if (fingerprint == set->fingerprint) {
+        return false;
+    }
+
+    // Costruzione fuori dai lettori, poi un solo scambio del puntatore
+    std::atomic_store(&current, std::shared_ptr<const ReportProfileSet>(Load()));
+    return true;
+}
+
+std::shared_ptr<const ReportProfileSet> ProfileManager::GetSnapshot() {
+    Initialize();
+    return std::atomic_load(&current);
+}
+
+std::wstring ProfileManager::GetLastError() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return lastError;
+}
+
+// Profili integrati (default in coda) seguiti da quelli della directory:
+// dal file compilato se corrisponde alle sorgenti, altrimenti dalle
+// sorgenti, ricompilando il file. Chiamata con il mutex acquisito
+std::shared_ptr<ReportProfileSet> ProfileManager::Load() {
+    lastError.clear();
+    auto set = std::make_shared<ReportProfileSet>();
+    std::vector<ReportProfile> builtIn = BuiltInProfiles();
+
+    if (!directory.empty()) {
+        set->sources = ProfileCompiler::ListSources(directory);
+        set->fingerprint = ProfileCompiler::Fingerprint(set->sources, builtIn);
+    }
+
+    bool compiledValid = !compiledPath.empty() && !directory.empty() &&
+        ProfileCompiler::Read(compiledPath, set->fingerprint, set->profiles, set->defaultProfile, set->index);
+    if (compiledValid) {
+        set->fromCompiled = true;
+    } else {
+        // File compilato illeggibile: segnalato, poi riscritto
+        lastError = ProfileCompiler::GetLastError();
+        std::vector<std::wstring> errors;
+
+        set->defaultProfile = builtIn.back();
+        builtIn.pop_back();
+        set->profiles = builtIn;
+
+        // Un profilo con il nome di uno integrato lo sostituisce nella sua
+        // posizione; "default" sostituisce il profilo di default
+        for (const auto& source : set->sources) {
+            ReportProfile profile;
+            if (!ProfileCompiler::ParseSource(source, profile)) {
+                errors.push_back(ProfileCompiler::GetLastError());
+                continue;
+            }
+            if (profile.name == set->defaultProfile.name) {
+                profile.identifierPatterns.clear();
+                set->defaultProfile = profile;
+                continue;
+            }
+            auto existing = std::find_if(set->profiles.begin(), set->profiles.end(),
+                [&profile](const ReportProfile& p) { return p.name == profile.name; });
+            if (existing != set->profiles.end()) {
+                *existing = profile;
+            } else {
+                set->profiles.push_back(profile);
             }
         }
-        if (allMatch) {
-            return &profile;
+
+        set->index.Clear();
+        for (const auto& profile : set->profiles) {
+            set->index.AddProfile(profile.identifierPatterns);
+        }
+        set->index.Build();
+
+        // Con sorgenti scartate il file non viene scritto: l'errore si
+        // ripresenta al prossimo avvio invece di sparire nel file compilato
+        if (!compiledPath.empty() && !directory.empty() && errors.empty() &&
+            !ProfileCompiler::Write(compiledPath, set->fingerprint, set->profiles, set->defaultProfile, set->index)) {
+            errors.push_back(ProfileCompiler::GetLastError());
+        }
+
+        for (const auto& error : errors) {
+            lastError += (lastError.empty() ? L"" : L"; ") + error;
         }
     }
-    return nullptr;
-}
 
-const ReportProfile* ProfileManager::GetDefaultProfile() {
-    if (!initialized) Initialize();
-    return &defaultProfile;
+    // Le regex si compilano in ogni caso: il programma dipende dalla versione del motore
+    for (auto& profile : set->profiles) {
+        profile.compiled = std::make_shared<CompiledProfile>(profile);
+    }
+    set->defaultProfile.compiled = std::make_shared<CompiledProfile>(set->defaultProfile);
+    return set;
 }
 
-const std::vector<ReportProfile>& ProfileManager::GetProfiles() {
-    if (!initialized) Initialize();
-    return profiles;
+std::vector<ReportProfile> ProfileManager::BuiltInProfiles() {
+    return { CreateProfile_RX_Maugeri(), CreateProfile_TSA_Maugeri(), CreateDefaultProfile() };
 }
 
 // ============================================================================
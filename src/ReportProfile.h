@@ -1,7 +1,13 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <vector>
 #include <memory>
+#include <mutex>
+#include <cstdint>
+#include "ProfileIndex.h"
+
+class CompiledProfile;
 
 // Struttura per definire un profilo di parsing
 struct ReportProfile {
@@ -11,29 +17,62 @@ struct ReportProfile {
     std::vector<std::wstring> excludePatterns;     // Pattern per righe da escludere
     std::vector<std::wstring> keepPatterns;        // Pattern per righe da mantenere sempre (es. firma medico)
     std::vector<std::wstring> newlineBeforePatterns; // Pattern prima dei quali inserire newline
+
+    // Pattern compilati, costruiti da ProfileManager::Initialize
+    std::shared_ptr<const CompiledProfile> compiled;
+};
+
+// Insieme di profili pubblicato da ProfileManager. Immutabile: chi lo
+// tiene (un riferimento per documento) usa profili che restano validi anche
+// se nel frattempo viene pubblicato un insieme nuovo
+struct ReportProfileSet {
+    std::vector<ReportProfile> profiles;
+    ReportProfile defaultProfile;
+    ProfileIndex index;                 // Pattern identificativi di tutti i profili
+    std::vector<std::wstring> sources;  // Sorgenti caricate dalla directory
+    uint64_t fingerprint = 0;
+    bool fromCompiled = false;          // Caricato dal file compilato
+
+    // Trova il profilo corretto per un testo: il primo, in ordine di
+    // registrazione, di cui sono presenti tutti i pattern identificativi
+    const ReportProfile* FindProfile(std::wstring_view text) const;
+
+    // Profilo trovato o, se nessuno corrisponde, quello di default
+    const ReportProfile* FindProfileOrDefault(std::wstring_view text) const;
 };
 
 class ProfileManager {
 public:
-    // Inizializza i profili disponibili
+    // Inizializza i profili disponibili e ne compila i pattern
     static void Initialize();
-    
-    // Trova il profilo corretto per un testo
-    static const ReportProfile* FindProfile(const std::wstring& text);
-    
-    // Restituisce il profilo di default
-    static const ReportProfile* GetDefaultProfile();
-    
-    // Lista dei profili disponibili
-    static const std::vector<ReportProfile>& GetProfiles();
+
+    // Directory dei profili in formato testo (*.profile, vedi
+    // ProfileCompiler.h) e percorso del file compilato. Da chiamare prima
+    // di Initialize; senza directory restano i soli profili integrati
+    static void SetProfileDirectory(const std::wstring& directory, const std::wstring& compiledPath);
+
+    // Ricarica i profili se le sorgenti della directory sono cambiate
+    // (aggiunte, modificate, rimosse). Il nuovo insieme viene costruito a
+    // parte e poi pubblicato: i worker non attendono; true se ricaricati
+    static bool Refresh();
+
+    // Insieme corrente, senza lock: da prendere una volta per documento
+    static std::shared_ptr<const ReportProfileSet> GetSnapshot();
+
+    // Restituisce l'ultimo errore (sorgenti scartate, file compilato non scrivibile)
+    static std::wstring GetLastError();
     
 private:
-    static std::vector<ReportProfile> profiles;
-    static ReportProfile defaultProfile;
-    static bool initialized;
-    
-    // Registra i profili specifici
-    static void RegisterProfiles();
+    static std::shared_ptr<ReportProfileSet> Load();
+    static std::vector<ReportProfile> BuiltInProfiles();
+
+    // Insieme in uso, letto e sostituito solo con std::atomic_load/atomic_store.
+    // Un insieme sostituito viene liberato quando l'ultimo lettore lo rilascia
+    static std::shared_ptr<const ReportProfileSet> current;
+    static std::mutex mutex;            // Serializza i caricamenti
+    static std::wstring directory;
+    static std::wstring compiledPath;
+    static std::wstring lastError;
     
     // Profili specifici
     static ReportProfile CreateProfile_RX_Maugeri();
@@ -0,0 +1,213 @@
+#include "StabilityScheduler.h"
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+StabilityScheduler::StabilityScheduler()
+    : quietPeriod(1000), wheel(WHEEL_SLOTS), currentTick(0), running(false) {
+}
+
+StabilityScheduler::~StabilityScheduler() {
+    Stop();
+}
+
+void StabilityScheduler::SetCallback(ReadyCallback cb) {
+    callback = cb;
+}
+
+void StabilityScheduler::SetQuietPeriod(std::chrono::milliseconds quiet) {
+    std::lock_guard<std::mutex> lock(mutex);
+    quietPeriod = quiet;
+}
+
+bool StabilityScheduler::Start() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (running) {
+        return true;
+    }
+
+    running = true;
+    timerThread = std::thread(&StabilityScheduler::TimerThread, this);
+    return true;
+}
+
+void StabilityScheduler::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) {
+            return;
+        }
+        running = false;
+    }
+    wakeup.notify_all();
+
+    if (timerThread.joinable()) {
+        timerThread.join();
+    }
+
+    // I file ancora in attesa vengono scartati
+    std::lock_guard<std::mutex> lock(mutex);
+    pending.clear();
+    for (auto& slot : wheel) {
+        slot.clear();
+    }
+}
+
+size_t StabilityScheduler::GetPendingCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return pending.size();
+}
+
+uint64_t StabilityScheduler::QuietTicks() const {
+    uint64_t ticks = (quietPeriod.count() + TICK_MS - 1) / TICK_MS;
+    return ticks > 0 ? ticks : 1;
+}
+
+void StabilityScheduler::ScheduleLocked(const std::wstring& path, uint64_t delayTicks) {
+    uint64_t due = currentTick + delayTicks;
+    wheel[due % WHEEL_SLOTS].push_back({ path, (delayTicks - 1) / WHEEL_SLOTS });
+}
+
+void StabilityScheduler::Touch(const std::wstring& path) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) {
+            return;
+        }
+
+        auto it = pending.find(path);
+        if (it != pending.end()) {
+            // Gia' in attesa: accorpa l'evento, la scadenza viene rinviata alla verifica
+            it->second.touched = true;
+            return;
+        }
+
+        // Nuovo file: primo campionamento di size/mtime al prossimo tick
+        pending.emplace(path, Entry());
+        ScheduleLocked(path, 1);
+    }
+    wakeup.notify_one();
+}
+
+bool StabilityScheduler::IsReadable(const std::wstring& path) {
+#ifdef _WIN32
+    HANDLE hFile = CreateFileW(
+        path.c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        NULL,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        NULL
+    );
+
+    if (hFile == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    CloseHandle(hFile);
+    return true;
+#else
+    std::error_code ec;
+    return std::filesystem::is_regular_file(path, ec);
+#endif
+}
+
+void StabilityScheduler::TimerThread() {
+    auto nextTick = std::chrono::steady_clock::now() + std::chrono::milliseconds(TICK_MS);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (running) {
+        if (pending.empty()) {
+            // Nessun file in attesa: dormi fino al prossimo Touch()
+            wakeup.wait(lock, [this] { return !running || !pending.empty(); });
+            nextTick = std::chrono::steady_clock::now() + std::chrono::milliseconds(TICK_MS);
+            continue;
+        }
+
+        if (wakeup.wait_until(lock, nextTick, [this] { return !running; })) {
+            break;
+        }
+        nextTick += std::chrono::milliseconds(TICK_MS);
+
+        // Avanza di un tick e raccogli le voci scadute
+        currentTick++;
+        std::vector<std::wstring> due;
+        auto& slot = wheel[currentTick % WHEEL_SLOTS];
+        for (size_t i = 0; i < slot.size(); ) {
+            if (slot[i].rounds > 0) {
+                slot[i].rounds--;
+                i++;
+            } else {
+                due.push_back(std::move(slot[i].path));
+                slot[i] = std::move(slot.back());
+                slot.pop_back();
+            }
+        }
+
+        if (due.empty()) {
+            continue;
+        }
+
+        // Campiona i file fuori dal lock: Touch() resta libero di procedere
+        struct Sample {
+            bool exists;
+            bool readable;
+            std::uintmax_t size;
+            std::filesystem::file_time_type mtime;
+        };
+        std::vector<Sample> samples(due.size());
+
+        lock.unlock();
+        for (size_t i = 0; i < due.size(); i++) {
+            std::error_code ec;
+            Sample& s = samples[i];
+            s.size = std::filesystem::file_size(due[i], ec);
+            s.exists = !ec;
+            if (s.exists) {
+                s.mtime = std::filesystem::last_write_time(due[i], ec);
+                s.exists = !ec;
+            }
+            s.readable = s.exists && IsReadable(due[i]);
+        }
+        lock.lock();
+
+        std::vector<std::wstring> ready;
+        for (size_t i = 0; i < due.size(); i++) {
+            auto it = pending.find(due[i]);
+            if (it == pending.end()) {
+                continue;
+            }
+
+            Entry& entry = it->second;
+            const Sample& s = samples[i];
+
+            if (!s.exists) {
+                // File rimosso o rinominato prima di stabilizzarsi
+                pending.erase(it);
+                continue;
+            }
+
+            bool stable = entry.sampled && !entry.touched &&
+                          entry.size == s.size && entry.mtime == s.mtime && s.readable;
+
+            if (stable) {
+                ready.push_back(due[i]);
+                pending.erase(it);
+            } else {
+                entry.sampled = true;
+                entry.touched = false;
+                entry.size = s.size;
+                entry.mtime = s.mtime;
+                ScheduleLocked(due[i], QuietTicks());
+            }
+        }
+
+        if (!ready.empty() && callback) {
+            lock.unlock();
+            for (const auto& path : ready) {
+                callback(path);
+            }
+            lock.lock();
+        }
+    }
+}
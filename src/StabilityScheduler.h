@@ -0,0 +1,77 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include <filesystem>
+#include <chrono>
+#include <cstdint>
+
+// Scheduler di stabilita' per i file in scrittura.
+// Un path diventa "pronto" quando dimensione e data di modifica restano invariate
+// per il periodo di quiete configurato. Le scadenze sono gestite da una timer
+// wheel servita da un thread dedicato: Touch() e' O(1), non esegue I/O e non
+// blocca mai il chiamante (il loop di notifica del FileWatcher).
+// Eventi ripetuti sullo stesso path vengono accorpati in un'unica voce.
+class StabilityScheduler {
+public:
+    using ReadyCallback = std::function<void(const std::wstring&)>;
+
+    StabilityScheduler();
+    ~StabilityScheduler();
+
+    // Callback invocata (sul thread dello scheduler) quando un file e' stabile
+    void SetCallback(ReadyCallback callback);
+
+    // Periodo durante il quale dimensione/mtime non devono cambiare
+    void SetQuietPeriod(std::chrono::milliseconds quiet);
+
+    // Avvia/ferma il thread della timer wheel
+    bool Start();
+    void Stop();
+
+    // Segnala attivita' su un file (nuovo o modificato)
+    void Touch(const std::wstring& path);
+
+    // Numero di file in attesa di stabilizzarsi
+    size_t GetPendingCount() const;
+
+private:
+    // Risoluzione della wheel e numero di slot (512 x 100 ms = ~51 s per giro)
+    static constexpr int TICK_MS = 100;
+    static constexpr size_t WHEEL_SLOTS = 512;
+
+    struct Entry {
+        bool sampled = false;       // Prima lettura di size/mtime gia' effettuata
+        bool touched = false;       // Nuovi eventi arrivati dall'ultima verifica
+        std::uintmax_t size = 0;
+        std::filesystem::file_time_type mtime;
+    };
+
+    struct Slot {
+        std::wstring path;
+        uint64_t rounds;            // Giri completi della wheel prima della scadenza
+    };
+
+    void TimerThread();
+    void ScheduleLocked(const std::wstring& path, uint64_t delayTicks);
+    uint64_t QuietTicks() const;
+
+    // Verifica che il file sia leggibile (nessuno scrittore con lock esclusivo)
+    static bool IsReadable(const std::wstring& path);
+
+    ReadyCallback callback;
+    std::chrono::milliseconds quietPeriod;
+
+    std::vector<std::vector<Slot>> wheel;
+    std::unordered_map<std::wstring, Entry> pending;
+    uint64_t currentTick;
+
+    mutable std::mutex mutex;
+    std::condition_variable wakeup;
+    std::thread timerThread;
+    bool running;
+};
@@ -0,0 +1,81 @@
+#include "Subprocess.h"
+#include "ProcessExecutor.h"
+
+thread_local std::wstring Subprocess::lastError;
+
+std::wstring Subprocess::GetLastError() {
+    return lastError;
+}
+
+Subprocess::Result Subprocess::Run(const std::wstring& program,
+                                   const std::vector<std::wstring>& args,
+                                   const std::string& input,
+                                   std::chrono::milliseconds timeout,
+                                   size_t outputReserve) {
+    Result result = ProcessExecutor::RunAsync(program, args, input, timeout, outputReserve).get();
+    lastError = result.error;
+    return result;
+}
+
+Subprocess::Utf8Decoder::Utf8Decoder() : codepoint(0), pending(0), length(0) {
+}
+
+void Subprocess::Utf8Decoder::Append(char32_t cp, std::wstring& out) {
+    // wchar_t a 16 bit (Windows): coppia surrogata sopra il piano base
+    if (sizeof(wchar_t) == 2 && cp > 0xFFFF) {
+        cp -= 0x10000;
+        out += static_cast<wchar_t>(0xD800 + (cp >> 10));
+        out += static_cast<wchar_t>(0xDC00 + (cp & 0x3FF));
+    } else {
+        out += static_cast<wchar_t>(cp);
+    }
+}
+
+void Subprocess::Utf8Decoder::Feed(const char* data, size_t size, std::wstring& out) {
+    for (size_t i = 0; i < size; i++) {
+        unsigned char c = static_cast<unsigned char>(data[i]);
+
+        if (pending > 0) {
+            if ((c & 0xC0) == 0x80) {
+                codepoint = (codepoint << 6) | (c & 0x3F);
+                if (--pending == 0) {
+                    // Forme troppo lunghe, surrogati e valori oltre U+10FFFF
+                    bool overlong = (length == 2 && codepoint < 0x80) ||
+                                    (length == 3 && codepoint < 0x800) ||
+                                    (length == 4 && codepoint < 0x10000);
+                    bool invalid = codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint <= 0xDFFF);
+                    Append(overlong || invalid ? 0xFFFD : codepoint, out);
+                }
+                continue;
+            }
+            // Sequenza interrotta: il byte corrente viene riletto come inizio
+            pending = 0;
+            Append(0xFFFD, out);
+        }
+
+        if (c < 0x80) {
+            out += static_cast<wchar_t>(c);
+        } else if ((c & 0xE0) == 0xC0) {
+            codepoint = c & 0x1F;
+            length = 2;
+            pending = 1;
+        } else if ((c & 0xF0) == 0xE0) {
+            codepoint = c & 0x0F;
+            length = 3;
+            pending = 2;
+        } else if ((c & 0xF8) == 0xF0) {
+            codepoint = c & 0x07;
+            length = 4;
+            pending = 3;
+        } else {
+            Append(0xFFFD, out);
+        }
+    }
+}
+
+void Subprocess::Utf8Decoder::Finish(std::wstring& out) {
+    if (pending > 0) {
+        pending = 0;
+        Append(0xFFFD, out);
+    }
+}
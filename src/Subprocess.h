@@ -0,0 +1,113 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstddef>
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+// Esecuzione di un processo figlio con stdin e stdout collegati a pipe:
+// niente cmd.exe, niente file temporanei. L'input viene scritto mentre
+// l'output viene letto (nessun deadlock con pipe piene) e l'output e'
+// decodificato da UTF-8 man mano che arriva, in un buffer gia' riservato.
+// Allo scadere del timeout il processo viene terminato. Run e' un'attesa
+// sincrona su ProcessExecutor, che esegue tutti i figli da un solo thread.
+// Channel mantiene invece un figlio in vita per piu' scambi
+// richiesta/risposta sulle stesse pipe (server di estrazione).
+// Il backend dipende dalla piattaforma:
+//   - Windows: CreateProcessW + CreatePipe (SubprocessWin32.cpp)
+//   - POSIX:   fork/execvp + pipe + poll (SubprocessPosix.cpp)
+class Subprocess {
+public:
+    struct Result {
+        bool started;           // Il processo e' stato avviato
+        bool timedOut;          // Terminato per timeout
+        int exitCode;           // Codice di uscita (-1 se non disponibile)
+        std::wstring output;    // stdout decodificato da UTF-8
+        std::wstring error;     // Errore di avvio o timeout (vuoto se nessuno)
+    };
+
+    // Decodifica UTF-8 incrementale: una sequenza spezzata tra due blocchi
+    // viene completata al blocco successivo. Sequenze non valide -> U+FFFD
+    class Utf8Decoder {
+    public:
+        Utf8Decoder();
+        void Feed(const char* data, size_t length, std::wstring& out);
+        void Finish(std::wstring& out);
+
+    private:
+        void Append(char32_t codepoint, std::wstring& out);
+
+        char32_t codepoint;
+        int pending;            // Byte di continuazione mancanti
+        int length;             // Lunghezza della sequenza in corso
+    };
+
+    // Processo figlio persistente: stdin e stdout restano aperti tra una
+    // richiesta e l'altra, stderr viene scartato. Un solo utilizzatore alla volta
+    class Channel {
+    public:
+        Channel();
+        ~Channel();
+
+        bool Start(const std::wstring& program, const std::vector<std::wstring>& args);
+
+        // Scrive tutti i byte su stdin del figlio
+        bool Write(const std::string& data);
+
+        // Legge esattamente length byte da stdout entro la scadenza.
+        // Restituisce false per timeout, fine dei dati o processo terminato
+        bool Read(char* data, size_t length, std::chrono::steady_clock::time_point deadline);
+
+        // Termina il processo e chiude le pipe
+        void Kill();
+
+        bool IsRunning() const;
+
+    private:
+        Channel(const Channel&) = delete;
+        Channel& operator=(const Channel&) = delete;
+
+#ifdef _WIN32
+        HANDLE process;
+        HANDLE inWrite;
+        HANDLE outRead;
+#else
+        int pid;
+        int inFd;
+        int outFd;
+#endif
+    };
+
+    // Esegue program (cercato nel PATH se senza percorso) con gli argomenti
+    // dati, scrive input su stdin e raccoglie stdout. stderr viene scartato.
+    // Il timeout decorre dall'avvio del processo (non dall'attesa in coda).
+    // outputReserve: capacita' iniziale del buffer di output (caratteri)
+    static Result Run(const std::wstring& program,
+                      const std::vector<std::wstring>& args,
+                      const std::string& input,
+                      std::chrono::milliseconds timeout,
+                      size_t outputReserve = 64 * 1024);
+
+    // Restituisce l'ultimo errore
+    static std::wstring GetLastError();
+
+private:
+    friend class ProcessExecutor;
+
+    // Avvia program con stdin e stdout su pipe e stderr scartato.
+    // Restituisce le estremita' del padre (non ereditabili)
+#ifdef _WIN32
+    // overlapped: estremita' del padre su pipe con nome in modalita'
+    // overlapped (per le completion port) e processo creato sospeso
+    static bool Spawn(const std::wstring& program, const std::vector<std::wstring>& args, bool overlapped,
+                      PROCESS_INFORMATION& pi, HANDLE& inWrite, HANDLE& outRead, std::wstring& error);
+#else
+    // Estremita' del padre non bloccanti. Restituisce il pid o -1
+    static int Spawn(const std::wstring& program, const std::vector<std::wstring>& args,
+                     int& inFd, int& outFd, std::wstring& error);
+#endif
+
+    static thread_local std::wstring lastError;
+};
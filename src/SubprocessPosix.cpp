@@ -0,0 +1,215 @@
+// Backend POSIX di Subprocess: fork/execvp con stdin e stdout su pipe non
+// bloccanti. Un execvp fallito viene riportato al padre su una pipe di stato
+// (chiusa dall'exec riuscito), cosi' Spawn fallisce come CreateProcess su
+// Windows invece di restituire un figlio gia' uscito. Le esecuzioni singole sono servite dal loop epoll di
+// ProcessExecutor, i Channel usano poll() sulle proprie pipe.
+#include "Subprocess.h"
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <mutex>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+namespace {
+
+// Gli argomenti di execvp sono byte: wstring -> UTF-8
+std::string ToUtf8(const std::wstring& text) {
+    std::string result;
+    for (wchar_t wc : text) {
+        char32_t c = static_cast<char32_t>(wc);
+        if (c < 0x80) {
+            result += static_cast<char>(c);
+        } else if (c < 0x800) {
+            result += static_cast<char>(0xC0 | (c >> 6));
+            result += static_cast<char>(0x80 | (c & 0x3F));
+        } else if (c < 0x10000) {
+            result += static_cast<char>(0xE0 | (c >> 12));
+            result += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            result += static_cast<char>(0x80 | (c & 0x3F));
+        } else {
+            result += static_cast<char>(0xF0 | (c >> 18));
+            result += static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+            result += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            result += static_cast<char>(0x80 | (c & 0x3F));
+        }
+    }
+    return result;
+}
+
+void CloseFd(int& fd) {
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+}
+
+// Un figlio che esce senza leggere lo stdin non deve terminare anche noi:
+// la scrittura fallisce con EPIPE invece di generare SIGPIPE
+void IgnoreSigpipe() {
+    static std::once_flag once;
+    std::call_once(once, []() { signal(SIGPIPE, SIG_IGN); });
+}
+
+}
+
+int Subprocess::Spawn(const std::wstring& program, const std::vector<std::wstring>& args,
+                      int& inFd, int& outFd, std::wstring& error) {
+    std::vector<std::string> argStrings;
+    argStrings.push_back(ToUtf8(program));
+    for (const auto& arg : args) {
+        argStrings.push_back(ToUtf8(arg));
+    }
+    std::vector<char*> argv;
+    for (auto& arg : argStrings) {
+        argv.push_back(&arg[0]);
+    }
+    argv.push_back(nullptr);
+
+    int inPipe[2] = { -1, -1 };
+    int outPipe[2] = { -1, -1 };
+    int statusPipe[2] = { -1, -1 };
+    if (pipe2(inPipe, O_CLOEXEC) != 0 || pipe2(outPipe, O_CLOEXEC) != 0 || pipe2(statusPipe, O_CLOEXEC) != 0) {
+        error = L"Impossibile creare le pipe: " + std::to_wstring(errno);
+        CloseFd(inPipe[0]);
+        CloseFd(inPipe[1]);
+        CloseFd(outPipe[0]);
+        CloseFd(outPipe[1]);
+        return -1;
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        error = L"Impossibile avviare " + program + L": " + std::to_wstring(errno);
+        CloseFd(inPipe[0]);
+        CloseFd(inPipe[1]);
+        CloseFd(outPipe[0]);
+        CloseFd(outPipe[1]);
+        CloseFd(statusPipe[0]);
+        CloseFd(statusPipe[1]);
+        return -1;
+    }
+
+    if (pid == 0) {
+        // Figlio: solo chiamate async-signal-safe fino a execvp
+        int devNull = open("/dev/null", O_WRONLY);
+        dup2(inPipe[0], STDIN_FILENO);
+        dup2(outPipe[1], STDOUT_FILENO);
+        if (devNull >= 0) {
+            dup2(devNull, STDERR_FILENO);
+        }
+        execvp(argv[0], argv.data());
+        int execError = errno;
+        ssize_t ignored = write(statusPipe[1], &execError, sizeof(execError));
+        (void)ignored;
+        _exit(127);
+    }
+
+    CloseFd(inPipe[0]);
+    CloseFd(outPipe[1]);
+    CloseFd(statusPipe[1]);
+
+    // Fine file: exec riuscito. Un errno: il figlio e' uscito senza avviare
+    // il programma, si raccoglie subito
+    int execError = 0;
+    ssize_t n;
+    while ((n = read(statusPipe[0], &execError, sizeof(execError))) < 0 && errno == EINTR) {
+    }
+    CloseFd(statusPipe[0]);
+    if (n == static_cast<ssize_t>(sizeof(execError))) {
+        while (waitpid(pid, nullptr, 0) < 0 && errno == EINTR) {
+        }
+        CloseFd(inPipe[1]);
+        CloseFd(outPipe[0]);
+        error = L"Impossibile avviare " + program + L": " + std::to_wstring(execError);
+        return -1;
+    }
+    inFd = inPipe[1];
+    outFd = outPipe[0];
+    fcntl(inFd, F_SETFL, fcntl(inFd, F_GETFL) | O_NONBLOCK);
+    fcntl(outFd, F_SETFL, fcntl(outFd, F_GETFL) | O_NONBLOCK);
+
+    IgnoreSigpipe();
+    return pid;
+}
+
+Subprocess::Channel::Channel() : pid(-1), inFd(-1), outFd(-1) {
+}
+
+Subprocess::Channel::~Channel() {
+    Kill();
+}
+
+bool Subprocess::Channel::Start(const std::wstring& program, const std::vector<std::wstring>& args) {
+    Kill();
+    lastError.clear();
+    pid = Spawn(program, args, inFd, outFd, lastError);
+    return pid > 0;
+}
+
+bool Subprocess::Channel::Write(const std::string& data) {
+    size_t written = 0;
+    while (inFd >= 0 && written < data.size()) {
+        ssize_t n = write(inFd, data.data() + written, data.size() - written);
+        if (n > 0) {
+            written += static_cast<size_t>(n);
+        } else if (n < 0 && errno == EAGAIN) {
+            pollfd fd = { inFd, POLLOUT, 0 };
+            poll(&fd, 1, 1000);
+        } else if (n < 0 && errno != EINTR) {
+            return false;
+        }
+    }
+    return inFd >= 0;
+}
+
+bool Subprocess::Channel::Read(char* data, size_t length, std::chrono::steady_clock::time_point deadline) {
+    size_t received = 0;
+    while (outFd >= 0 && received < length) {
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        if (remaining <= 0) {
+            return false;
+        }
+
+        pollfd fd = { outFd, POLLIN, 0 };
+        int ready = poll(&fd, 1, static_cast<int>(remaining));
+        if (ready < 0 && errno != EINTR) {
+            return false;
+        }
+        if (ready <= 0) {
+            continue;
+        }
+
+        ssize_t n = read(outFd, data + received, length - received);
+        if (n > 0) {
+            received += static_cast<size_t>(n);
+        } else if (n == 0 || (errno != EAGAIN && errno != EINTR)) {
+            return false;
+        }
+    }
+    return received == length;
+}
+
+void Subprocess::Channel::Kill() {
+    CloseFd(inFd);
+    CloseFd(outFd);
+    if (pid > 0) {
+        kill(pid, SIGKILL);
+        while (waitpid(pid, nullptr, 0) < 0 && errno == EINTR) {
+        }
+        pid = -1;
+    }
+}
+
+bool Subprocess::Channel::IsRunning() const {
+    if (pid <= 0) {
+        return false;
+    }
+    // WNOWAIT: il processo terminato resta da raccogliere in Kill()
+    siginfo_t info = {};
+    return waitid(P_PID, pid, &info, WEXITED | WNOHANG | WNOWAIT) == 0 && info.si_pid == 0;
+}
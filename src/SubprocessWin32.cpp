@@ -0,0 +1,214 @@
+// Backend Windows di Subprocess: CreateProcessW con stdin e stdout su pipe.
+// I Channel usano pipe anonime sincrone; le esecuzioni singole passano da
+// ProcessExecutor, che richiede pipe con nome in modalita' overlapped (le
+// pipe anonime non supportano le completion port).
+#include "Subprocess.h"
+#include <Windows.h>
+#include <algorithm>
+#include <atomic>
+#include <cwchar>
+
+namespace {
+
+// Quoting di un argomento secondo le regole di CommandLineToArgvW
+std::wstring QuoteArgument(const std::wstring& arg) {
+    if (!arg.empty() && arg.find_first_of(L" \t\n\v\"") == std::wstring::npos) {
+        return arg;
+    }
+
+    std::wstring quoted = L"\"";
+    size_t backslashes = 0;
+    for (wchar_t c : arg) {
+        if (c == L'\\') {
+            backslashes++;
+            continue;
+        }
+        if (c == L'"') {
+            quoted.append(backslashes * 2 + 1, L'\\');
+        } else {
+            quoted.append(backslashes, L'\\');
+        }
+        backslashes = 0;
+        quoted += c;
+    }
+    quoted.append(backslashes * 2, L'\\');
+    quoted += L'"';
+    return quoted;
+}
+
+void CloseHandleSafe(HANDLE& handle) {
+    if (handle != NULL && handle != INVALID_HANDLE_VALUE) {
+        CloseHandle(handle);
+    }
+    handle = NULL;
+}
+
+// Pipe con nome con l'estremita' del padre overlapped e quella del figlio
+// sincrona ed ereditabile
+bool CreateOverlappedPipe(bool parentReads, SECURITY_ATTRIBUTES* childAttributes,
+                          HANDLE& parentEnd, HANDLE& childEnd) {
+    static std::atomic<unsigned long> counter(0);
+    wchar_t name[96];
+    swprintf(name, 96, L"\\\\.\\pipe\\MedicalReportMonitor.%lu.%lu",
+             GetCurrentProcessId(), counter++);
+
+    parentEnd = CreateNamedPipeW(name,
+        (parentReads ? PIPE_ACCESS_INBOUND : PIPE_ACCESS_OUTBOUND) | FILE_FLAG_OVERLAPPED | FILE_FLAG_FIRST_PIPE_INSTANCE,
+        PIPE_TYPE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS, 1, 65536, 65536, 0, NULL);
+    if (parentEnd == INVALID_HANDLE_VALUE) {
+        parentEnd = NULL;
+        return false;
+    }
+
+    childEnd = CreateFileW(name, parentReads ? GENERIC_WRITE : GENERIC_READ, 0, childAttributes,
+                           OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (childEnd == INVALID_HANDLE_VALUE) {
+        childEnd = NULL;
+        CloseHandleSafe(parentEnd);
+        return false;
+    }
+    return true;
+}
+
+}
+
+bool Subprocess::Spawn(const std::wstring& program, const std::vector<std::wstring>& args, bool overlapped,
+                       PROCESS_INFORMATION& pi, HANDLE& inWrite, HANDLE& outRead, std::wstring& error) {
+    std::wstring cmdLine = QuoteArgument(program);
+    for (const auto& arg : args) {
+        cmdLine += L" " + QuoteArgument(arg);
+    }
+
+    // Pipe ereditabili solo dal lato del figlio
+    SECURITY_ATTRIBUTES sa = { sizeof(sa), NULL, TRUE };
+    HANDLE inRead = NULL, outWrite = NULL;
+    inWrite = NULL;
+    outRead = NULL;
+    bool piped = overlapped
+        ? CreateOverlappedPipe(false, &sa, inWrite, inRead) && CreateOverlappedPipe(true, &sa, outRead, outWrite)
+        : CreatePipe(&inRead, &inWrite, &sa, 0) && CreatePipe(&outRead, &outWrite, &sa, 0);
+    if (!piped) {
+        error = L"Impossibile creare le pipe: " + std::to_wstring(::GetLastError());
+        CloseHandleSafe(inRead);
+        CloseHandleSafe(inWrite);
+        CloseHandleSafe(outRead);
+        CloseHandleSafe(outWrite);
+        return false;
+    }
+    SetHandleInformation(inWrite, HANDLE_FLAG_INHERIT, 0);
+    SetHandleInformation(outRead, HANDLE_FLAG_INHERIT, 0);
+
+    HANDLE nul = CreateFileW(L"NUL", GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                             &sa, OPEN_EXISTING, 0, NULL);
+
+    STARTUPINFOW si = { sizeof(si) };
+    si.dwFlags = STARTF_USESHOWWINDOW | STARTF_USESTDHANDLES;
+    si.wShowWindow = SW_HIDE;
+    si.hStdInput = inRead;
+    si.hStdOutput = outWrite;
+    si.hStdError = nul;
+
+    std::vector<wchar_t> cmdBuffer(cmdLine.begin(), cmdLine.end());
+    cmdBuffer.push_back(0);
+
+    BOOL success = CreateProcessW(
+        NULL, cmdBuffer.data(), NULL, NULL, TRUE,
+        CREATE_NO_WINDOW | (overlapped ? CREATE_SUSPENDED : 0), NULL, NULL, &si, &pi
+    );
+
+    // Le estremita' del figlio vanno chiuse subito: la fine dell'output e'
+    // segnalata solo quando nessuno tiene piu' aperto outWrite
+    CloseHandleSafe(inRead);
+    CloseHandleSafe(outWrite);
+    CloseHandleSafe(nul);
+
+    if (!success) {
+        error = L"Impossibile avviare " + program;
+        CloseHandleSafe(inWrite);
+        CloseHandleSafe(outRead);
+        return false;
+    }
+
+    return true;
+}
+
+Subprocess::Channel::Channel() : process(NULL), inWrite(NULL), outRead(NULL) {
+}
+
+Subprocess::Channel::~Channel() {
+    Kill();
+}
+
+bool Subprocess::Channel::Start(const std::wstring& program, const std::vector<std::wstring>& args) {
+    Kill();
+    lastError.clear();
+
+    PROCESS_INFORMATION pi;
+    if (!Spawn(program, args, false, pi, inWrite, outRead, lastError)) {
+        return false;
+    }
+    CloseHandle(pi.hThread);
+    process = pi.hProcess;
+    return true;
+}
+
+bool Subprocess::Channel::Write(const std::string& data) {
+    size_t written = 0;
+    while (inWrite != NULL && written < data.size()) {
+        DWORD chunk = static_cast<DWORD>(std::min<size_t>(data.size() - written, 65536));
+        DWORD n = 0;
+        if (!WriteFile(inWrite, data.data() + written, chunk, &n, NULL)) {
+            return false;
+        }
+        written += n;
+    }
+    return inWrite != NULL;
+}
+
+bool Subprocess::Channel::Read(char* data, size_t length, std::chrono::steady_clock::time_point deadline) {
+    // Le pipe anonime non supportano I/O overlapped: si legge solo cio' che
+    // e' gia' disponibile e nel frattempo si attende il processo (1 ms), che
+    // segnala anche la sua terminazione
+    size_t received = 0;
+    while (outRead != NULL && received < length) {
+        DWORD available = 0;
+        if (!PeekNamedPipe(outRead, NULL, 0, NULL, &available, NULL)) {
+            return false;
+        }
+
+        if (available > 0) {
+            DWORD n = 0;
+            DWORD chunk = static_cast<DWORD>(std::min<size_t>(length - received, available));
+            if (!ReadFile(outRead, data + received, chunk, &n, NULL) || n == 0) {
+                return false;
+            }
+            received += n;
+            continue;
+        }
+
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        if (WaitForSingleObject(process, 1) == WAIT_OBJECT_0) {
+            // Processo terminato: restano solo i dati gia' in pipe
+            if (!PeekNamedPipe(outRead, NULL, 0, NULL, &available, NULL) || available == 0) {
+                return false;
+            }
+        }
+    }
+    return received == length;
+}
+
+void Subprocess::Channel::Kill() {
+    CloseHandleSafe(inWrite);
+    CloseHandleSafe(outRead);
+    if (process != NULL) {
+        TerminateProcess(process, 1);
+        WaitForSingleObject(process, 5000);
+        CloseHandleSafe(process);
+    }
+}
+
+bool Subprocess::Channel::IsRunning() const {
+    return process != NULL && WaitForSingleObject(process, 0) == WAIT_TIMEOUT;
+}
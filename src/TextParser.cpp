@@ -1,28 +1,22 @@
 #include "TextParser.h"
 #include "ReportProfile.h"
+#include "CompiledProfile.h"
 #include <algorithm>
-#include <sstream>
+#include <string_view>
 #include <cwctype>
-#include <regex>
 #include <vector>
 
-std::wstring TextParser::ExtractPatientName(const std::wstring& text, 
-                                            const std::vector<std::wstring>& patterns) {
-    for (const auto& pattern : patterns) {
-        try {
-            std::wregex re(pattern, std::regex::icase);
-            std::wsmatch match;
-            if (std::regex_search(text, match, re) && match.size() > 1) {
-                std::wstring name = match[1].str();
-                // Trim
-                size_t start = name.find_first_not_of(L" \t\r\n");
-                size_t end = name.find_last_not_of(L" \t\r\n");
-                if (start != std::wstring::npos && end != std::wstring::npos) {
-                    return name.substr(start, end - start + 1);
-                }
+std::wstring TextParser::ExtractPatientName(const std::wstring& text, const CompiledProfile& profile) {
+    ProfileRegex::Match match;
+    for (const auto& re : profile.GetPatientNamePatterns()) {
+        if (re.Search(text, match) && match.groups.size() > 1) {
+            std::wstring name = match.Str(text, 1);
+            // Trim
+            size_t start = name.find_first_not_of(L" \t\r\n");
+            size_t end = name.find_last_not_of(L" \t\r\n");
+            if (start != std::wstring::npos && end != std::wstring::npos) {
+                return name.substr(start, end - start + 1);
             }
-        } catch (...) {
-            continue;
         }
     }
     return L"PAZIENTE_SCONOSCIUTO";
@@ -52,36 +46,6 @@ std::wstring TextParser::NormalizeFilename(const std::wstring& name) {
     return result;
 }
 
-bool TextParser::ShouldExcludeLine(const std::wstring& line,
-                                   const std::vector<std::wstring>& excludePatterns,
-                                   const std::vector<std::wstring>& keepPatterns) {
-    // Prima controlla se la riga deve essere MANTENUTA (priorità alta)
-    for (const auto& pattern : keepPatterns) {
-        try {
-            std::wregex re(pattern, std::regex::icase);
-            if (std::regex_search(line, re)) {
-                return false; // NON escludere
-            }
-        } catch (...) {
-            continue;
-        }
-    }
-    
-    // Poi controlla se deve essere esclusa
-    for (const auto& pattern : excludePatterns) {
-        try {
-            std::wregex re(pattern, std::regex::icase);
-            if (std::regex_search(line, re)) {
-                return true; // Escludere
-            }
-        } catch (...) {
-            continue;
-        }
-    }
-    
-    return false; // Default: non escludere
-}
-
 ParsedReport TextParser::Parse(const std::wstring& rawText) {
     ParsedReport result;
     result.success = false;
@@ -91,75 +55,75 @@ ParsedReport TextParser::Parse(const std::wstring& rawText) {
         return result;
     }
     
-    // Inizializza il profile manager
-    ProfileManager::Initialize();
+    // Profili correnti per tutto il referto, anche se nel frattempo
+    // ne viene pubblicato un insieme nuovo
+    std::shared_ptr<const ReportProfileSet> profiles = ProfileManager::GetSnapshot();
     
     // Trova il profilo corretto per questo referto
-    const ReportProfile* profile = ProfileManager::FindProfile(rawText);
-    if (!profile) {
-        profile = ProfileManager::GetDefaultProfile();
-    }
+    const ReportProfile* profile = profiles->FindProfileOrDefault(rawText);
     result.profileUsed = profile->name;
     
     // Estrai il nome del paziente
-    std::wstring patientName = ExtractPatientName(rawText, profile->patientNamePatterns);
+    const CompiledProfile& compiled = *profile->compiled;
+    std::wstring patientName = ExtractPatientName(rawText, compiled);
     result.patientName = NormalizeFilename(patientName);
     
-    // Dividi in righe e filtra
-    std::wistringstream stream(rawText);
-    std::wstring line;
-    std::vector<std::wstring> outputLines;
-    
-    while (std::getline(stream, line)) {
+    // Righe del testo grezzo come viste, senza copie: quelle che restano
+    // vengono scritte direttamente nel corpo, separate da uno spazio
+    std::wstring_view text(rawText);
+    std::wstring body;
+    body.reserve(text.size());
+
+    size_t lineStart = 0;
+    while (lineStart < text.size()) {
+        size_t lineEnd = text.find(L'\n', lineStart);
+        if (lineEnd == std::wstring_view::npos) {
+            lineEnd = text.size();
+        }
+        std::wstring_view line = text.substr(lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 1;
+
         // Trim
         size_t start = line.find_first_not_of(L" \t\r\n");
-        if (start == std::wstring::npos) {
+        if (start == std::wstring_view::npos) {
             continue; // Riga vuota
         }
         size_t end = line.find_last_not_of(L" \t\r\n");
-        std::wstring trimmed = line.substr(start, end - start + 1);
-        
-        if (trimmed.empty()) {
-            continue;
-        }
-        
-        // Verifica se escludere (passa la riga originale per il match)
-        if (!ShouldExcludeLine(line, profile->excludePatterns, profile->keepPatterns)) {
-            outputLines.push_back(trimmed);
-        }
-    }
-    
-    // Unisci le righe
-    std::wstring body;
-    for (size_t i = 0; i < outputLines.size(); i++) {
-        if (i > 0) {
-            body += L" ";
-        }
-        body += outputLines[i];
-    }
 
-    // Inserisci newline prima dei pattern specificati
-    for (const auto& pattern : profile->newlineBeforePatterns) {
-        try {
-            std::wregex re(pattern, std::regex::icase);
-            body = std::regex_replace(body, re, L"\n$&");
-        } catch (...) {
-            continue;
+        // Verifica se escludere (passa la riga originale per il match):
+        // regole keep e exclude in una sola ricerca per insieme
+        if (!compiled.ShouldExcludeLine(line)) {
+            if (!body.empty()) {
+                body += L' ';
+            }
+            body.append(line, start, end - start + 1);
         }
     }
 
-    // Normalizza spazi multipli (preserva newline)
-    std::wstring normalized;
+    // Punti del corpo prima dei quali inserire un newline
+    std::vector<size_t> newlines;
+    compiled.FindNewlineOffsets(body, newlines);
+
+    // Un solo passaggio sul corpo: newline inseriti (senza spazi prima) e
+    // spazi multipli compressi, direttamente nel risultato
+    std::wstring& normalized = result.reportBody;
+    normalized.reserve(body.size() + newlines.size());
     bool lastWasSpace = false;
-    for (wchar_t c : body) {
-        if (c == L'\n') {
-            // Preserva i newline, rimuovi spazi prima
-            while (!normalized.empty() && normalized.back() == L' ') {
-                normalized.pop_back();
-            }
-            normalized += L'\n';
-            lastWasSpace = true;
-        } else if (iswspace(c)) {
+    size_t nextNewline = 0;
+    auto insertNewline = [&]() {
+        while (!normalized.empty() && normalized.back() == L' ') {
+            normalized.pop_back();
+        }
+        normalized += L'\n';
+        lastWasSpace = true;
+    };
+
+    for (size_t i = 0; i < body.size(); i++) {
+        for (; nextNewline < newlines.size() && newlines[nextNewline] == i; nextNewline++) {
+            insertNewline();
+        }
+        wchar_t c = body[i];
+        if (iswspace(c)) {
             if (!lastWasSpace) {
                 normalized += L' ';
                 lastWasSpace = true;
@@ -169,15 +133,18 @@ ParsedReport TextParser::Parse(const std::wstring& rawText) {
             lastWasSpace = false;
         }
     }
-    
+    for (; nextNewline < newlines.size(); nextNewline++) {
+        insertNewline();
+    }
+
     // Trim finale
     size_t s = normalized.find_first_not_of(L" ");
     size_t e = normalized.find_last_not_of(L" ");
     if (s != std::wstring::npos && e != std::wstring::npos) {
-        normalized = normalized.substr(s, e - s + 1);
+        normalized.erase(e + 1);
+        normalized.erase(0, s);
     }
-    
-    result.reportBody = normalized;
+
     result.success = true;
     
     return result;
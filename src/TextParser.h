@@ -2,6 +2,8 @@
 #include <string>
 #include <vector>
 
+class CompiledProfile;
+
 struct ParsedReport {
     std::wstring patientName;      // Nome paziente per il filename
     std::wstring reportBody;       // Corpo del referto estratto
@@ -17,14 +19,8 @@ public:
     
 private:
     // Estrae il nome del paziente usando i pattern del profilo
-    static std::wstring ExtractPatientName(const std::wstring& text, 
-                                           const std::vector<std::wstring>& patterns);
+    static std::wstring ExtractPatientName(const std::wstring& text, const CompiledProfile& profile);
     
     // Normalizza il nome paziente per uso come filename
     static std::wstring NormalizeFilename(const std::wstring& name);
-    
-    // Verifica se una riga deve essere esclusa
-    static bool ShouldExcludeLine(const std::wstring& line,
-                                  const std::vector<std::wstring>& excludePatterns,
-                                  const std::vector<std::wstring>& keepPatterns);
 };
@@ -1,11 +1,16 @@
 #include "ZoneProfile.h"
+#include "PdfExtractor.h"
+#include "PositionedText.h"
 #include <fstream>
 #include <sstream>
 #include <filesystem>
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <Windows.h>
 
-std::vector<ZoneProfile> ZoneProfileManager::profiles;
+std::shared_ptr<const ZoneProfileSet> ZoneProfileManager::current = std::make_shared<ZoneProfileSet>();
+std::mutex ZoneProfileManager::mutex;
 std::wstring ZoneProfileManager::lastError;
 
 // Converte UTF-8 in wstring
@@ -127,6 +132,29 @@ static std::vector<int> ParseIntArray(const std::string& arrayStr) {
     return result;
 }
 
+// Parse array di stringhe (sequenze \" e \\ comprese)
+static std::vector<std::wstring> ParseStringArray(const std::string& arrayStr) {
+    std::vector<std::wstring> result;
+    size_t pos = 0;
+    while ((pos = arrayStr.find('"', pos)) != std::string::npos) {
+        std::string value;
+        pos++;
+        while (pos < arrayStr.length() && arrayStr[pos] != '"') {
+            if (arrayStr[pos] == '\\' && pos + 1 < arrayStr.length()) {
+                pos++;
+            }
+            value += arrayStr[pos++];
+        }
+        if (pos >= arrayStr.length()) break;
+        pos++;
+
+        if (!value.empty()) {
+            result.push_back(Utf8ToWstring(value));
+        }
+    }
+    return result;
+}
+
 // Parse array di oggetti zone
 static std::vector<ExtractionZone> ParseZonesArray(const std::string& arrayStr) {
     std::vector<ExtractionZone> zones;
@@ -192,8 +220,22 @@ bool ZoneProfileManager::ParseJsonProfile(const std::string& jsonContent, ZonePr
             profile.zones = ParseZonesArray(zonesStr);
         }
 
-        // Identifier patterns (opzionale, per ora li cerchiamo nel primo testo estratto)
-        // Possono essere aggiunti successivamente al JSON se necessario
+        // Identifier patterns (opzionale): cercati nel testo della prima
+        // pagina, prima del confronto per impaginazione
+        std::string patternsStr = FindJsonArray(jsonContent, "identifier_patterns");
+        if (!patternsStr.empty()) {
+            profile.identifierPatterns = ParseStringArray(patternsStr);
+        }
+
+        // Impronta dell'impaginazione (scritta da pdf_calibrator.py). Una
+        // griglia di dimensioni diverse da quella attuale viene ignorata
+        std::string layoutStr = FindJsonObject(jsonContent, "layout");
+        if (!layoutStr.empty() &&
+            FindJsonInt(layoutStr, "columns") == LayoutFingerprint::COLUMNS &&
+            FindJsonInt(layoutStr, "rows") == LayoutFingerprint::ROWS &&
+            profile.layout.FromHex(FindJsonString(layoutStr, "cells"))) {
+            profile.layout.SetPageSize(profile.pageSize.width, profile.pageSize.height);
+        }
 
         return !profile.profileName.empty() && !profile.zones.empty();
     }
@@ -203,28 +245,34 @@ bool ZoneProfileManager::ParseJsonProfile(const std::string& jsonContent, ZonePr
 }
 
 bool ZoneProfileManager::LoadProfiles(const std::wstring& profilesDir) {
-    profiles.clear();
+    std::lock_guard<std::mutex> lock(mutex);
     lastError.clear();
 
+    // Il nuovo insieme si costruisce a parte e sostituisce il precedente in
+    // un solo passo: i documenti in corso finiscono con quello che hanno
+    auto set = std::make_shared<ZoneProfileSet>();
     if (!std::filesystem::exists(profilesDir)) {
+        std::atomic_store(&current, std::shared_ptr<const ZoneProfileSet>(set));
         lastError = L"Directory profili non trovata: " + profilesDir;
         return false;
     }
 
-    int loadedCount = 0;
     for (const auto& entry : std::filesystem::directory_iterator(profilesDir)) {
         if (entry.is_regular_file() && entry.path().extension() == L".json") {
             std::wstring filename = entry.path().filename().wstring();
             // Carica solo file che iniziano con "profile_"
             if (filename.find(L"profile_") == 0) {
-                if (LoadProfile(entry.path().wstring())) {
-                    loadedCount++;
+                ZoneProfile profile;
+                if (ReadProfile(entry.path().wstring(), profile)) {
+                    set->profiles.push_back(profile);
                 }
             }
         }
     }
+    set->BuildIndex();
+    std::atomic_store(&current, std::shared_ptr<const ZoneProfileSet>(set));
 
-    if (loadedCount == 0) {
+    if (set->profiles.empty()) {
         lastError = L"Nessun profilo JSON valido trovato in: " + profilesDir;
         return false;
     }
@@ -233,6 +281,22 @@ bool ZoneProfileManager::LoadProfiles(const std::wstring& profilesDir) {
 }
 
 bool ZoneProfileManager::LoadProfile(const std::wstring& jsonPath) {
+    std::lock_guard<std::mutex> lock(mutex);
+    lastError.clear();
+
+    ZoneProfile profile;
+    if (!ReadProfile(jsonPath, profile)) {
+        return false;
+    }
+
+    auto set = std::make_shared<ZoneProfileSet>(*std::atomic_load(&current));
+    set->profiles.push_back(profile);
+    set->BuildIndex();
+    std::atomic_store(&current, std::shared_ptr<const ZoneProfileSet>(set));
+    return true;
+}
+
+bool ZoneProfileManager::ReadProfile(const std::wstring& jsonPath, ZoneProfile& profile) {
     std::ifstream file(jsonPath, std::ios::binary);
     if (!file.is_open()) {
         lastError = L"Impossibile aprire: " + jsonPath;
@@ -245,57 +309,105 @@ bool ZoneProfileManager::LoadProfile(const std::wstring& jsonPath) {
 
     std::string jsonContent = buffer.str();
 
-    ZoneProfile profile;
     if (!ParseJsonProfile(jsonContent, profile)) {
         lastError = L"Errore parsing JSON: " + jsonPath;
         return false;
     }
 
-    profiles.push_back(profile);
+    profile.sourcePath = jsonPath;
+
+    // Profili senza impronta: si ricava dal PDF di riferimento, se si trova
+    // accanto al JSON
+    if (profile.layout.IsEmpty() && !profile.pdfFile.empty()) {
+        std::filesystem::path referencePath = std::filesystem::path(jsonPath).parent_path() / profile.pdfFile;
+        PositionedText words;
+        if (std::filesystem::exists(referencePath) &&
+            PdfExtractor::ExtractPositioned(referencePath.wstring(), words, 1)) {
+            profile.layout = words.GetLayout(0);
+        }
+    }
     return true;
 }
 
-const ZoneProfile* ZoneProfileManager::FindProfile(const std::wstring& identificationText) {
-    if (profiles.empty()) return nullptr;
-
-    std::wstring lowerText = identificationText;
-    std::transform(lowerText.begin(), lowerText.end(), lowerText.begin(), ::towlower);
-
-    for (const auto& profile : profiles) {
-        // Se il profilo ha pattern di identificazione, usali
-        if (!profile.identifierPatterns.empty()) {
-            bool allMatch = true;
-            for (const auto& pattern : profile.identifierPatterns) {
-                std::wstring lowerPattern = pattern;
-                std::transform(lowerPattern.begin(), lowerPattern.end(), lowerPattern.begin(), ::towlower);
-                if (lowerText.find(lowerPattern) == std::wstring::npos) {
-                    allMatch = false;
-                    break;
-                }
-            }
-            if (allMatch) return &profile;
+void ZoneProfileSet::BuildIndex() {
+    index.Clear();
+    indexedProfiles.clear();
+    for (size_t i = 0; i < profiles.size(); i++) {
+        if (!profiles[i].identifierPatterns.empty()) {
+            index.AddProfile(profiles[i].identifierPatterns);
+            indexedProfiles.push_back(i);
         }
-        // Altrimenti cerca il nome del profilo nel testo
-        else {
-            std::wstring lowerName = profile.profileName;
-            std::transform(lowerName.begin(), lowerName.end(), lowerName.begin(), ::towlower);
-            // Cerca parole chiave dal nome del profilo
-            // Per ora restituisci il primo profilo (l'utente dovra' specificare i pattern)
+    }
+    index.Build();
+
+    layoutOrder.clear();
+    for (size_t i = 0; i < profiles.size(); i++) {
+        if (!profiles[i].layout.IsEmpty()) {
+            layoutOrder.emplace_back(profiles[i].layout.GetCellCount(), i);
+        }
+    }
+    std::sort(layoutOrder.begin(), layoutOrder.end());
+}
+
+const ZoneProfile* ZoneProfileSet::FindProfile(std::wstring_view identificationText) const {
+    if (indexedProfiles.empty()) return nullptr;
+
+    // Primo profilo (in ordine di caricamento) con tutti i pattern presenti,
+    // in una sola passata sul testo. I profili senza pattern si riconoscono
+    // solo dall'impaginazione
+    int match = index.MatchFirst(identificationText);
+    if (match >= 0) {
+        return &profiles[indexedProfiles[match]];
+    }
+    return nullptr;
+}
+
+ZoneMatch ZoneProfileSet::FindByLayout(const LayoutFingerprint& layout, double threshold) const {
+    ZoneMatch best;
+    if (layout.IsEmpty() || layoutOrder.empty()) {
+        return best;
+    }
+
+    // Con a e b celle occupate la somiglianza non supera min(a, b) / max(a, b):
+    // bastano i profili con b in [a * soglia, a / soglia], un intervallo
+    // contiguo di layoutOrder
+    size_t cells = layout.GetCellCount();
+    const double maxCells = LayoutFingerprint::COLUMNS * LayoutFingerprint::ROWS;
+    size_t lowest = 0;
+    size_t highest = static_cast<size_t>(maxCells);
+    if (threshold > 0.0) {
+        lowest = static_cast<size_t>(std::ceil(cells * threshold - 1e-9));
+        highest = static_cast<size_t>(std::min(maxCells, std::floor(cells / threshold + 1e-9)));
+    }
+
+    auto first = std::lower_bound(layoutOrder.begin(), layoutOrder.end(),
+                                  std::make_pair(lowest, size_t(0)));
+    size_t bestIndex = SIZE_MAX;
+    for (auto it = first; it != layoutOrder.end() && it->first <= highest; ++it) {
+        double similarity = layout.Similarity(profiles[it->second].layout);
+        // A parita' vince il profilo caricato per primo
+        if (similarity > best.confidence || (similarity == best.confidence && it->second < bestIndex)) {
+            best.confidence = similarity;
+            bestIndex = it->second;
         }
     }
 
-    // Se non trova corrispondenza, restituisci il primo profilo come fallback
-    return profiles.empty() ? nullptr : &profiles[0];
+    // Sotto soglia resta la somiglianza migliore, per la diagnostica
+    if (bestIndex != SIZE_MAX && best.confidence > 0.0 && best.confidence >= threshold) {
+        best.profile = &profiles[bestIndex];
+    }
+    return best;
 }
 
-const std::vector<ZoneProfile>& ZoneProfileManager::GetProfiles() {
-    return profiles;
+std::shared_ptr<const ZoneProfileSet> ZoneProfileManager::GetSnapshot() {
+    return std::atomic_load(&current);
 }
 
 bool ZoneProfileManager::HasProfiles() {
-    return !profiles.empty();
+    return !GetSnapshot()->profiles.empty();
 }
 
 std::wstring ZoneProfileManager::GetLastError() {
+    std::lock_guard<std::mutex> lock(mutex);
     return lastError;
 }
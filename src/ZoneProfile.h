@@ -1,12 +1,18 @@
 #pragma once
 #include <string>
+#include <string_view>
+#include <memory>
+#include <mutex>
 #include <vector>
+#include <utility>
 #include <variant>
+#include "ProfileIndex.h"
+#include "LayoutFingerprint.h"
 
 // Struttura per una zona di estrazione
 struct ExtractionZone {
     std::wstring label;         // Nome identificativo della zona
-    double x;                   // Coordinata X (punti PDF, origine in basso-sinistra)
+    double x;                   // Coordinata X (punti PDF, origine in alto-sinistra come PyMuPDF)
     double y;                   // Coordinata Y
     double width;               // Larghezza zona
     double height;              // Altezza zona
@@ -15,34 +21,67 @@ struct ExtractionZone {
 
 // Struttura per le dimensioni della pagina
 struct PageSize {
-    double width;
-    double height;
+    double width = 0.0;     // 0 = non indicata nel profilo
+    double height = 0.0;
 };
 
 // Profilo completo per l'estrazione da zone
 struct ZoneProfile {
     std::wstring profileName;               // Nome del profilo
     std::wstring pdfFile;                   // File PDF di riferimento (opzionale)
+    std::wstring sourcePath;                // File JSON da cui e' stato caricato
     int totalPages;                         // Numero totale di pagine (opzionale)
     PageSize pageSize;                      // Dimensioni pagina
     std::vector<ExtractionZone> zones;      // Zone di estrazione
     std::vector<std::wstring> identifierPatterns;  // Pattern per identificare questo profilo
+    LayoutFingerprint layout;               // Impaginazione della prima pagina (vuota = non identificabile)
+};
+
+// Esito dell'identificazione per impaginazione
+struct ZoneMatch {
+    const ZoneProfile* profile = nullptr;   // nullptr se nessun profilo supera la soglia
+    double confidence = 0.0;                // Somiglianza dell'impronta, 0..1
+};
+
+// Insieme di profili zone pubblicato da ZoneProfileManager. Immutabile:
+// chi lo tiene per un documento usa profili che restano validi anche se nel
+// frattempo viene caricato un insieme nuovo
+struct ZoneProfileSet {
+    std::vector<ZoneProfile> profiles;
+
+    // Indice dei pattern identificativi: solo i profili che ne hanno
+    ProfileIndex index;
+    std::vector<size_t> indexedProfiles;    // Profilo dell'indice -> posizione in profiles
+
+    // Profili con impronta ordinati per numero di celle occupate:
+    // (celle, posizione in profiles)
+    std::vector<std::pair<size_t, size_t>> layoutOrder;
+
+    // Trova il profilo i cui pattern identificativi sono tutti nel testo
+    // (nullptr se nessuno corrisponde)
+    const ZoneProfile* FindProfile(std::wstring_view identificationText) const;
+
+    // Profilo con l'impaginazione piu' simile a quella della prima pagina
+    // del documento, se la somiglianza raggiunge threshold (0..1). Confronta
+    // solo i profili il cui numero di celle rende possibile la soglia
+    ZoneMatch FindByLayout(const LayoutFingerprint& layout, double threshold) const;
+
+    // Ricostruisce gli indici dopo aver modificato profiles
+    void BuildIndex();
 };
 
 // Manager per i profili basati su zone
 class ZoneProfileManager {
 public:
-    // Carica tutti i profili JSON dalla directory specificata
+    // Carica tutti i profili JSON dalla directory specificata in un nuovo
+    // insieme, che sostituisce il precedente
     static bool LoadProfiles(const std::wstring& profilesDir);
 
-    // Carica un singolo profilo da file
+    // Aggiunge un singolo profilo da file (in un nuovo insieme)
     static bool LoadProfile(const std::wstring& jsonPath);
 
-    // Trova il profilo corretto basandosi sul testo di identificazione
-    static const ZoneProfile* FindProfile(const std::wstring& identificationText);
-
-    // Restituisce tutti i profili caricati
-    static const std::vector<ZoneProfile>& GetProfiles();
+    // Insieme corrente, senza lock: da prendere una volta per documento
+    static std::shared_ptr<const ZoneProfileSet> GetSnapshot();
 
     // Verifica se ci sono profili caricati
     static bool HasProfiles();
@@ -51,9 +90,14 @@ public:
     static std::wstring GetLastError();
 
 private:
-    static std::vector<ZoneProfile> profiles;
+    // Insieme in uso, letto e sostituito solo con std::atomic_load/atomic_store
+    static std::shared_ptr<const ZoneProfileSet> current;
+    static std::mutex mutex;            // Serializza i caricamenti
     static std::wstring lastError;
 
+    // Legge e interpreta un file di profilo
+    static bool ReadProfile(const std::wstring& jsonPath, ZoneProfile& profile);
+
     // Parser JSON minimale per questa struttura specifica
     static bool ParseJsonProfile(const std::string& jsonContent, ZoneProfile& profile);
 };
@@ -12,12 +12,23 @@
 #include "Config.h"
 #include "FileWatcher.h"
 #include "PdfExtractor.h"
+#include "PositionedText.h"
+#include "PythonWorkerPool.h"
+#include "ProcessExecutor.h"
 #include "TextParser.h"
 #include "ClipboardHelper.h"
 #include "ZoneProfile.h"
 #include "ReportProfile.h"
+#include "CompiledProfile.h"
 #include "ClaudeAnalyzer.h"
-#include <regex>
+#include "IngestPool.h"
+#include "ProcessedLedger.h"
+#include "BacklogScanner.h"
+#include "ContentHash.h"
+#include "ExtractionCache.h"
+#include "OcrEngine.h"
+#include <mutex>
+#include <atomic>
 
 // Flag globale per disponibilita' Python
 static bool g_pythonAvailable = false;
@@ -25,6 +36,20 @@ static bool g_pythonAvailable = false;
 // Flag globale per disponibilita' Claude CLI
 static bool g_claudeAvailable = false;
 
+// Flag globale per disponibilita' dell'OCR (pdftoppm + Tesseract)
+static bool g_ocrAvailable = false;
+
+// Parte della chiave della cache: backend di estrazione attivi e versione
+// dei profili (calcolati all'avvio e di nuovo a ogni ricarica)
+static std::atomic<uint32_t> g_cacheBackend{ 0 };
+static std::atomic<uint64_t> g_profileVersion{ 0 };
+
+// Serializza l'output su console tra i worker del pool
+static std::mutex g_consoleMutex;
+
+// Serializza clipboard e scelta del nome del file di output tra i worker
+static std::mutex g_outputMutex;
+
 // Colori per la console
 void SetConsoleColor(WORD color) {
     HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
@@ -32,29 +57,40 @@ void SetConsoleColor(WORD color) {
 }
 
 void PrintSuccess(const std::wstring& msg) {
+    std::lock_guard<std::mutex> lock(g_consoleMutex);
     SetConsoleColor(FOREGROUND_GREEN | FOREGROUND_INTENSITY);
     std::wcout << L"[OK] " << msg << std::endl;
     SetConsoleColor(FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE);
 }
 
 void PrintError(const std::wstring& msg) {
+    std::lock_guard<std::mutex> lock(g_consoleMutex);
     SetConsoleColor(FOREGROUND_RED | FOREGROUND_INTENSITY);
     std::wcout << L"[ERRORE] " << msg << std::endl;
     SetConsoleColor(FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE);
 }
 
 void PrintInfo(const std::wstring& msg) {
+    std::lock_guard<std::mutex> lock(g_consoleMutex);
     SetConsoleColor(FOREGROUND_BLUE | FOREGROUND_GREEN | FOREGROUND_INTENSITY);
     std::wcout << L"[INFO] " << msg << std::endl;
     SetConsoleColor(FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE);
 }
 
 void PrintWarning(const std::wstring& msg) {
+    std::lock_guard<std::mutex> lock(g_consoleMutex);
     SetConsoleColor(FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_INTENSITY);
     std::wcout << L"[AVVISO] " << msg << std::endl;
     SetConsoleColor(FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE);
 }
 
+// Riga vuota tra i messaggi di due PDF, sotto lo stesso lock delle altre
+// stampe (i worker scrivono in parallelo)
+void PrintSeparator() {
+    std::lock_guard<std::mutex> lock(g_consoleMutex);
+    std::wcout << std::endl;
+}
+
 // Mostra notifica Windows
 void ShowNotification(const std::wstring& title, const std::wstring& message) {
     // Usa MessageBox per la notifica
@@ -84,21 +120,59 @@ bool SaveToFile(const std::wstring& text, const std::wstring& filePath) {
     return true;
 }
 
-// Trova il profilo zone corretto per un PDF e restituisce il percorso del file JSON
-std::wstring FindZoneProfilePath(const std::wstring& pdfPath, const ZoneProfile** outProfile) {
+// Trova il profilo zone corretto per un PDF e restituisce il percorso del file JSON.
+// L'identificazione usa solo la prima pagina: prima i pattern identificativi
+// sul testo, poi l'impronta dell'impaginazione. La pagina viene convertita
+// una volta sola e resta in firstPageWords / firstPageText (se estratti),
+// da cui si riparte per le zone o per il testo completo.
+// Il profilo restituito appartiene a zoneProfiles
+std::wstring FindZoneProfilePath(const std::wstring& pdfPath, const ZoneProfileSet& zoneProfiles,
+                                 const ZoneProfile** outProfile, PositionedText& firstPageWords,
+                                 std::wstring& firstPageText) {
     *outProfile = nullptr;
 
-    if (!ZoneProfileManager::HasProfiles()) {
+    if (zoneProfiles.profiles.empty()) {
         return L"";
     }
 
-    // Estrai il testo per identificare il profilo
-    std::wstring identText = PdfExtractor::Extract(pdfPath);
-    if (identText.empty()) {
-        return L"";
+    // Col motore nativo parole posizionate (per l'impronta) e testo (per i
+    // pattern) escono dallo stesso passaggio sulla pagina; con pdftotext sono
+    // due esecuzioni e le parole si estraggono solo se servono
+    bool attempted = false;
+    bool positioned = false;
+    if (!zoneProfiles.layoutOrder.empty() && Config::Get()->nativePdfEngine) {
+        positioned = PdfExtractor::ExtractPositioned(pdfPath, firstPageWords, 1, &firstPageText);
+        attempted = true;
+    }
+
+    // Testo della prima pagina per i profili con pattern
+    if (!zoneProfiles.indexedProfiles.empty()) {
+        if (firstPageText.empty()) {
+            firstPageText = PdfExtractor::ExtractPages(pdfPath, 1, 1);
+        }
+        *outProfile = zoneProfiles.FindProfile(firstPageText);
+    }
+
+    // Altrimenti il profilo con l'impaginazione piu' simile, se abbastanza simile
+    if (!*outProfile && !zoneProfiles.layoutOrder.empty()) {
+        if (!attempted) {
+            positioned = PdfExtractor::ExtractPositioned(pdfPath, firstPageWords, 1);
+        }
+        if (!positioned) {
+            return L"";
+        }
+
+        double threshold = Config::Get()->zoneLayoutThreshold / 100.0;
+        ZoneMatch match = zoneProfiles.FindByLayout(firstPageWords.GetLayout(0), threshold);
+        std::wstring similarity = std::to_wstring(static_cast<int>(match.confidence * 100.0 + 0.5)) + L"%";
+        if (!match.profile) {
+            PrintInfo(L"Nessun profilo zone con impaginazione simile (massima somiglianza " + similarity + L")");
+            return L"";
+        }
+        PrintInfo(L"Impaginazione del profilo " + match.profile->profileName + L" (somiglianza " + similarity + L")");
+        *outProfile = match.profile;
     }
 
-    *outProfile = ZoneProfileManager::FindProfile(identText);
     if (!*outProfile) {
         return L"";
     }
@@ -114,21 +188,26 @@ std::wstring FindZoneProfilePath(const std::wstring& pdfPath, const ZoneProfile*
     return L"";
 }
 
-// Callback quando viene rilevato un nuovo PDF
-void OnNewPdf(const std::wstring& pdfPath) {
-    std::wcout << std::endl;
-    PrintInfo(L"Nuovo PDF rilevato: " + pdfPath);
-
-    std::wstring rawText;
+// Estrae il testo del PDF e lo analizza. Restituisce false (dopo aver
+// segnalato l'errore) se l'estrazione o l'analisi falliscono
+bool ExtractReport(const std::wstring& pdfPath, std::wstring& rawText, ParsedReport& report) {
+    std::wstring firstPageText;     // Prima pagina, gia' estratta per l'identificazione
+    PositionedText words;           // Parole posizionate, almeno della prima pagina se estratte
     std::wstring profileUsed = L"default";
     bool usedZoneProfile = false;
 
-    // Prima prova con Python + profili zone se disponibili
-    if (g_pythonAvailable && ZoneProfileManager::HasProfiles()) {
+    // PDF da scansione (nessun operatore di testo): si passa subito all'OCR
+    bool scanned = g_ocrAvailable && OcrEngine::IsScanned(pdfPath);
+
+    // Prima prova con i profili zone: Python se disponibile, altrimenti
+    // (o se fallisce) indice spaziale delle parole posizionate. L'insieme
+    // dei profili resta lo stesso per tutto il documento
+    std::shared_ptr<const ZoneProfileSet> zoneProfiles = ZoneProfileManager::GetSnapshot();
+    if (!scanned && !zoneProfiles->profiles.empty()) {
         const ZoneProfile* zoneProfile = nullptr;
-        std::wstring profilePath = FindZoneProfilePath(pdfPath, &zoneProfile);
+        std::wstring profilePath = FindZoneProfilePath(pdfPath, *zoneProfiles, &zoneProfile, words, firstPageText);
 
-        if (zoneProfile && !profilePath.empty()) {
+        if (g_pythonAvailable && zoneProfile && !profilePath.empty()) {
             PrintInfo(L"Profilo zone trovato: " + zoneProfile->profileName);
             PrintInfo(L"Estrazione con PyMuPDF...");
             rawText = PdfExtractor::ExtractWithPython(pdfPath, profilePath);
@@ -141,21 +220,63 @@ void OnNewPdf(const std::wstring& pdfPath) {
                 PrintWarning(L"Estrazione Python fallita: " + PdfExtractor::GetLastError());
             }
         }
+
+        if (rawText.empty() && zoneProfile) {
+            PrintInfo(L"Estrazione zone del profilo " + zoneProfile->profileName + L"...");
+            // Prima pagina gia' estratta per l'identificazione: si aggiungono le altre
+            bool extracted = words.GetPageCount() > 0
+                ? PdfExtractor::ExtractPositionedPages(pdfPath, words, 2, 0)
+                : PdfExtractor::ExtractPositioned(pdfPath, words);
+            if (!extracted) {
+                PrintWarning(L"Estrazione zone fallita: " + PdfExtractor::GetLastError());
+            } else {
+                rawText = words.ResolveZones(zoneProfile->zones);
+                if (!rawText.empty()) {
+                    profileUsed = L"zone:" + zoneProfile->profileName;
+                    PrintSuccess(L"Estrazione completata");
+                } else {
+                    PrintWarning(L"Nessun testo nelle zone del profilo");
+                }
+            }
+        }
     }
 
-    // Se non c'e' Python/profilo o l'estrazione e' fallita, usa pdftotext
-    if (rawText.empty()) {
-        PrintInfo(L"Estrazione testo completo con pdftotext...");
-        rawText = PdfExtractor::Extract(pdfPath);
+    // Se non c'e' Python/profilo o l'estrazione e' fallita, estrai il testo completo
+    if (rawText.empty() && !scanned) {
+        PrintInfo(L"Estrazione testo completo...");
+        if (!firstPageText.empty()) {
+            // Si estraggono solo le pagine successive alla prima
+            std::wstring otherPages = PdfExtractor::ExtractPages(pdfPath, 2, 0);
+            if (PdfExtractor::GetLastError().empty()) {
+                rawText = firstPageText + otherPages;
+            }
+        }
+        if (rawText.empty()) {
+            rawText = PdfExtractor::Extract(pdfPath);
+        }
+    }
+
+    // Scansione o testo quasi assente (es. solo intestazione vettoriale su
+    // una pagina scansionata): OCR delle pagine
+    std::wstring extractError = PdfExtractor::GetLastError();
+    if (g_ocrAvailable && (scanned || (!usedZoneProfile && OcrEngine::IsTextTooShort(rawText)))) {
+        PrintInfo(L"PDF da scansione: OCR delle pagine...");
+        std::wstring ocrText = OcrEngine::ExtractText(pdfPath);
+        if (!ocrText.empty()) {
+            rawText = ocrText;
+            PrintSuccess(L"OCR completato");
+        } else {
+            extractError = OcrEngine::GetLastError();
+            PrintWarning(L"OCR fallito: " + extractError);
+        }
     }
 
     if (rawText.empty()) {
-        PrintError(L"Estrazione fallita: " + PdfExtractor::GetLastError());
-        return;
+        PrintError(L"Estrazione fallita: " + extractError);
+        return false;
     }
 
     // Se abbiamo usato Python, il testo e' gia' pulito - salta il parsing pesante
-    ParsedReport report;
     if (usedZoneProfile) {
         // Il testo da Python e' gia' formattato correttamente
         report.reportBody = rawText;
@@ -165,38 +286,34 @@ void OnNewPdf(const std::wstring& pdfPath) {
         report.patientName = L"REFERTO";
 
         // Prova a estrarre il nome con i pattern del parser
-        ProfileManager::Initialize();
-        const ReportProfile* textProfile = ProfileManager::FindProfile(rawText);
-        if (!textProfile) textProfile = ProfileManager::GetDefaultProfile();
-
-        // Cerca pattern nome paziente
-        for (const auto& pattern : textProfile->patientNamePatterns) {
-            try {
-                std::wregex re(pattern, std::regex::icase);
-                std::wsmatch match;
-                if (std::regex_search(rawText, match, re) && match.size() > 1) {
-                    std::wstring name = match[1].str();
-                    // Normalizza
-                    std::wstring normalized;
-                    bool lastWasSpace = false;
-                    for (wchar_t c : name) {
-                        if (iswalpha(c)) {
-                            normalized += towupper(c);
-                            lastWasSpace = false;
-                        } else if (iswspace(c)) {
-                            if (!lastWasSpace && !normalized.empty()) {
-                                normalized += L'_';
-                                lastWasSpace = true;
-                            }
+        std::shared_ptr<const ReportProfileSet> textProfiles = ProfileManager::GetSnapshot();
+        const ReportProfile* textProfile = textProfiles->FindProfileOrDefault(rawText);
+
+        // Cerca pattern nome paziente (compilati all'inizializzazione dei profili)
+        ProfileRegex::Match match;
+        for (const auto& re : textProfile->compiled->GetPatientNamePatterns()) {
+            if (re.Search(rawText, match) && match.groups.size() > 1) {
+                std::wstring name = match.Str(rawText, 1);
+                // Normalizza
+                std::wstring normalized;
+                bool lastWasSpace = false;
+                for (wchar_t c : name) {
+                    if (iswalpha(c)) {
+                        normalized += towupper(c);
+                        lastWasSpace = false;
+                    } else if (iswspace(c)) {
+                        if (!lastWasSpace && !normalized.empty()) {
+                            normalized += L'_';
+                            lastWasSpace = true;
                         }
                     }
-                    if (!normalized.empty() && normalized.back() == L'_') normalized.pop_back();
-                    if (!normalized.empty()) {
-                        report.patientName = normalized;
-                        break;
-                    }
                 }
-            } catch (...) {}
+                if (!normalized.empty() && normalized.back() == L'_') normalized.pop_back();
+                if (!normalized.empty()) {
+                    report.patientName = normalized;
+                    break;
+                }
+            }
         }
     } else {
         // Usa il parser completo per pdftotext
@@ -205,18 +322,51 @@ void OnNewPdf(const std::wstring& pdfPath) {
 
         if (!report.success) {
             PrintError(L"Analisi fallita: " + report.errorMessage);
-            return;
+            return false;
         }
     }
 
-    PrintSuccess(L"Profilo utilizzato: " + report.profileUsed);
+    return true;
+}
 
-    // Analisi AI con Claude CLI (se abilitata e disponibile)
-    if (g_claudeAvailable && Config::claudeEnabled && !report.reportBody.empty()) {
+// Elabora un nuovo PDF (contentHash: hash del contenuto). notify mostra la
+// finestra di notifica, non usata per l'arretrato. Restituisce false se il
+// referto non e' stato estratto o salvato
+bool OnNewPdf(const std::wstring& pdfPath, uint64_t contentHash, bool notify) {
+    // Stesse impostazioni per tutto il documento anche se config.ini viene ricaricato
+    Config::Pin configPin;
+    std::shared_ptr<const Config::Settings> config = Config::Get();
+
+    PrintSeparator();
+    PrintInfo(L"Nuovo PDF rilevato: " + pdfPath);
+
+    // Stesso contenuto, backend e profili di un PDF gia' estratto: si riusa
+    // il risultato senza ripassare dalla pipeline di estrazione
+    ExtractionCache::Key cacheKey = { contentHash, g_profileVersion, g_cacheBackend };
+    bool cacheable = ExtractionCache::IsOpen();
+
+    ExtractionCache::Entry entry;
+    bool cacheHit = cacheable && ExtractionCache::Lookup(cacheKey, entry);
+    bool cacheDirty = false;
+    if (cacheHit) {
+        PrintSuccess(L"Referto gia' estratto (cache " + ContentHash::ToHex(cacheKey.contentHash) + L")");
+    } else {
+        if (!ExtractReport(pdfPath, entry.rawText, entry.report)) {
+            return false;
+        }
+        cacheDirty = true;
+    }
+
+    PrintSuccess(L"Profilo utilizzato: " + entry.report.profileUsed);
+
+    // Analisi AI con Claude CLI (se abilitata e disponibile). Il testo
+    // arricchito viene conservato nella cache accanto all'originale
+    bool useAi = g_claudeAvailable && config->claudeEnabled && !entry.report.reportBody.empty();
+    if (useAi && entry.enrichment.empty()) {
         PrintInfo(L"Analisi AI con Claude in corso...");
-        std::wstring enriched = ClaudeAnalyzer::Analyze(report.reportBody);
-        if (!enriched.empty()) {
-            report.reportBody = enriched;
+        entry.enrichment = ClaudeAnalyzer::Analyze(entry.report.reportBody);
+        if (!entry.enrichment.empty()) {
+            cacheDirty = true;
             PrintSuccess(L"Analisi AI completata");
         } else {
             PrintWarning(L"Analisi AI fallita: " + ClaudeAnalyzer::GetLastError());
@@ -224,41 +374,149 @@ void OnNewPdf(const std::wstring& pdfPath) {
         }
     }
 
-    // Copia nella clipboard
-    if (ClipboardHelper::CopyToClipboard(report.reportBody)) {
-        PrintSuccess(L"Testo copiato nella clipboard");
-    } else {
-        PrintError(L"Impossibile copiare nella clipboard: " + ClipboardHelper::GetLastError());
+    if (cacheable && cacheDirty && !ExtractionCache::Store(cacheKey, entry)) {
+        PrintWarning(L"Risultato non salvato nella cache: " + ExtractionCache::GetLastError());
     }
-    
-    // Salva il file di backup
-    std::wstring outputDir = Config::outputDirectory;
-    if (outputDir.empty()) {
-        outputDir = Config::watchDirectory;
-    }
-    
-    std::wstring outputFile = outputDir + L"\\" + report.patientName + L".txt";
-    
-    // Se il file esiste già, aggiungi un numero
-    int counter = 1;
-    while (std::filesystem::exists(outputFile)) {
-        outputFile = outputDir + L"\\" + report.patientName + L"_" + std::to_wstring(counter++) + L".txt";
+
+    ParsedReport& report = entry.report;
+    if (useAi && !entry.enrichment.empty()) {
+        report.reportBody = entry.enrichment;
     }
-    
-    if (SaveToFile(report.reportBody, outputFile)) {
-        PrintSuccess(L"File salvato: " + outputFile);
-    } else {
-        PrintError(L"Impossibile salvare il file: " + outputFile);
+
+    std::wstring outputFile;
+    bool saved;
+    {
+        std::lock_guard<std::mutex> lock(g_outputMutex);
+
+        // Copia nella clipboard
+        if (ClipboardHelper::CopyToClipboard(report.reportBody)) {
+            PrintSuccess(L"Testo copiato nella clipboard");
+        } else {
+            PrintError(L"Impossibile copiare nella clipboard: " + ClipboardHelper::GetLastError());
+        }
+
+        // Salva il file di backup
+        std::wstring outputDir = config->outputDirectory;
+        if (outputDir.empty()) {
+            outputDir = config->watchDirectory;
+        }
+
+        outputFile = outputDir + L"\\" + report.patientName + L".txt";
+
+        // Se il file esiste già, aggiungi un numero
+        int counter = 1;
+        while (std::filesystem::exists(outputFile)) {
+            outputFile = outputDir + L"\\" + report.patientName + L"_" + std::to_wstring(counter++) + L".txt";
+        }
+
+        saved = SaveToFile(report.reportBody, outputFile);
+        if (saved) {
+            PrintSuccess(L"File salvato: " + outputFile);
+        } else {
+            PrintError(L"Impossibile salvare il file: " + outputFile);
+        }
     }
-    
+
     // Mostra notifica
-    std::wstring notifyMsg = L"Paziente: " + report.patientName + L"\n\n" +
-                            L"Testo copiato nella clipboard.\n" +
-                            L"File salvato: " + outputFile;
-    ShowNotification(L"Medical Report Monitor", notifyMsg);
+    if (notify) {
+        std::wstring notifyMsg = L"Paziente: " + report.patientName + L"\n\n" +
+                                L"Testo copiato nella clipboard.\n" +
+                                L"File salvato: " + outputFile;
+        ShowNotification(L"Medical Report Monitor", notifyMsg);
+    }
     
-    std::wcout << std::endl;
+    PrintSeparator();
     PrintInfo(L"In attesa di nuovi PDF... (premi Q per uscire)");
+    return saved;
+}
+
+// Handler dei worker: ogni contenuto viene elaborato una volta. L'hash e'
+// prenotato durante l'elaborazione (notifiche ripetute e copie dello stesso
+// file vengono scartate) e registrato nel ProcessedLedger solo se riesce:
+// un PDF fallito o rimasto in coda all'arresto verra' ritentato
+void ProcessPdf(const std::wstring& pdfPath, bool notify) {
+    uint64_t contentHash;
+    if (!ContentHash::HashFile(pdfPath, contentHash)) {
+        PrintWarning(L"PDF non leggibile, ignorato: " + pdfPath);
+        return;
+    }
+    if (!ProcessedLedger::TryClaim(contentHash)) {
+        return;
+    }
+
+    bool processed = false;
+    try {
+        processed = OnNewPdf(pdfPath, contentHash, notify);
+    } catch (...) {
+        ProcessedLedger::Release(contentHash, false);
+        throw;
+    }
+    ProcessedLedger::Release(contentHash, processed);
+}
+
+// Backend di estrazione attivi per la chiave della cache
+uint32_t ComputeCacheBackend(const Config::Settings& config) {
+    return (config.nativePdfEngine ? ExtractionCache::BACKEND_NATIVE : 0) |
+           (g_pythonAvailable ? ExtractionCache::BACKEND_PYTHON : 0) |
+           (g_ocrAvailable ? ExtractionCache::BACKEND_OCR : 0);
+}
+
+// Versione dei profili per la chiave della cache: file dei profili zone e
+// sorgenti dei profili di parsing, impronte dell'impaginazione dei profili
+// zone (possono venire dal PDF di riferimento) e impostazioni che cambiano
+// il testo prodotto. Da ricalcolare a ogni ricarica di profili o configurazione
+uint64_t ComputeProfileVersion() {
+    std::shared_ptr<const Config::Settings> config = Config::Get();
+    ContentHash::Hasher extra;
+    extra.Update(&config->ocrMinTextChars, sizeof(config->ocrMinTextChars));
+    extra.Update(&config->ocrDpi, sizeof(config->ocrDpi));
+    extra.Update(config->ocrLanguages.data(), config->ocrLanguages.size() * sizeof(wchar_t));
+    extra.Update(&config->zoneLayoutThreshold, sizeof(config->zoneLayoutThreshold));
+
+    std::vector<std::wstring> profileFiles = ProfileManager::GetSnapshot()->sources;
+    for (const auto& profile : ZoneProfileManager::GetSnapshot()->profiles) {
+        profileFiles.push_back(profile.sourcePath);
+        std::string layout = profile.layout.ToHex();
+        double pageSize[2] = { profile.layout.GetPageWidth(), profile.layout.GetPageHeight() };
+        extra.Update(layout.data(), layout.size());
+        extra.Update(pageSize, sizeof(pageSize));
+    }
+    return ExtractionCache::ComputeProfileVersion(profileFiles, extra.Digest());
+}
+
+// Profili di parsing attivi ed eventuali sorgenti scartate
+void PrintTextProfiles() {
+    std::shared_ptr<const ReportProfileSet> profiles = ProfileManager::GetSnapshot();
+    std::wstring origin = profiles->fromCompiled ? L" (compilati)" : L"";
+    PrintSuccess(L"Profili di parsing: " + std::to_wstring(profiles->profiles.size()) +
+                 L" + default, " + std::to_wstring(profiles->sources.size()) +
+                 L" da file" + origin);
+    std::wstring error = ProfileManager::GetLastError();
+    if (!error.empty()) {
+        PrintWarning(L"Profili di parsing: " + error);
+    }
+}
+
+// Stampa i contatori del watcher, del pool di elaborazione e dei processi esterni
+void PrintStatistics(const FileWatcher& watcher, const IngestPool& pool) {
+    FileWatcher::Stats ws = watcher.GetStats();
+    IngestPool::Stats ps = pool.GetStats();
+
+    PrintInfo(L"Notifiche PDF: " + std::to_wstring(ws.events) +
+              L" | Overflow: " + std::to_wstring(ws.overflows) +
+              L" | Riscansioni: " + std::to_wstring(ws.rescans) +
+              L" | Recuperati: " + std::to_wstring(ws.recovered) +
+              L" | Buffer: " + std::to_wstring(ws.bufferSize / 1024) + L" KB");
+    PrintInfo(L"Coda: " + std::to_wstring(ps.queued) +
+              L" | In elaborazione: " + std::to_wstring(ps.active) +
+              L" | Completati: " + std::to_wstring(ps.completed) +
+              L" | Scartati: " + std::to_wstring(ps.dropped));
+
+    ProcessExecutor::Stats es = ProcessExecutor::GetStats();
+    PrintInfo(L"Processi esterni in corso: " + std::to_wstring(es.running) +
+              L" | In attesa: " + std::to_wstring(es.queued) +
+              L" | Conclusi: " + std::to_wstring(es.completed) +
+              L" | Timeout: " + std::to_wstring(es.timedOut));
 }
 
 // Configurazione iniziale
@@ -285,7 +543,9 @@ bool RunSetup() {
         return false;
     }
     
-    Config::watchDirectory = watchDir;
+    // Le scelte si raccolgono in una copia delle impostazioni, pubblicata alla fine
+    Config::Settings settings = *Config::Get();
+    settings.watchDirectory = watchDir;
     
     // Directory output (opzionale)
     std::wcout << L"\nInserisci la directory per salvare i file .txt" << std::endl;
@@ -295,12 +555,12 @@ bool RunSetup() {
     std::getline(std::wcin, outDir);
     
     if (outDir.empty()) {
-        Config::outputDirectory = watchDir;
+        settings.outputDirectory = watchDir;
     } else if (std::filesystem::exists(outDir)) {
-        Config::outputDirectory = outDir;
+        settings.outputDirectory = outDir;
     } else {
         PrintWarning(L"Directory non trovata, uso la directory dei PDF");
-        Config::outputDirectory = watchDir;
+        settings.outputDirectory = watchDir;
     }
     
     // Autostart
@@ -325,14 +585,15 @@ bool RunSetup() {
     std::getline(std::wcin, claudeChoice);
 
     if (claudeChoice == L"S" || claudeChoice == L"s") {
-        Config::claudeEnabled = true;
+        settings.claudeEnabled = true;
         PrintSuccess(L"Analisi AI Claude abilitata");
     } else {
-        Config::claudeEnabled = false;
+        settings.claudeEnabled = false;
         PrintInfo(L"Analisi AI Claude disabilitata");
     }
 
     // Salva configurazione
+    Config::Publish(settings);
     if (Config::SaveConfig()) {
         PrintSuccess(L"Configurazione salvata");
         return true;
@@ -365,28 +626,49 @@ int wmain(int argc, wchar_t* argv[]) {
         }
     }
     
-    // Verifica pdftotext
+    // Impostazioni di avvio: directory, worker e processi restano quelle
+    // lette qui anche se config.ini viene ricaricato
+    std::shared_ptr<const Config::Settings> config = Config::Get();
+
+    // Esecutore dei processi esterni: limite di processi contemporanei
+    ProcessExecutor::Start(config->maxProcesses);
+
+    // Verifica pdftotext (indispensabile solo senza il motore nativo)
     if (!PdfExtractor::IsAvailable()) {
-        PrintError(L"pdftotext.exe non trovato!");
-        std::wcout << L"\nScarica Xpdf tools da: https://www.xpdfreader.com/download.html" << std::endl;
-        std::wcout << L"Estrai pdftotext.exe nella cartella: " << Config::GetExecutableDir() << std::endl;
-        std::wcout << L"\nPremi un tasto per uscire..." << std::endl;
-        _getch();
-        return 1;
+        if (config->nativePdfEngine) {
+            PrintWarning(L"pdftotext.exe non trovato: nessun fallback per i PDF non gestiti dal motore interno");
+        } else {
+            PrintError(L"pdftotext.exe non trovato!");
+            std::wcout << L"\nScarica Xpdf tools da: https://www.xpdfreader.com/download.html" << std::endl;
+            std::wcout << L"Estrai pdftotext.exe nella cartella: " << Config::GetExecutableDir() << std::endl;
+            std::wcout << L"\nPremi un tasto per uscire..." << std::endl;
+            _getch();
+            return 1;
+        }
+    } else {
+        PrintSuccess(L"pdftotext.exe trovato");
     }
 
-    PrintSuccess(L"pdftotext.exe trovato");
+    if (config->nativePdfEngine) {
+        PrintSuccess(L"Motore PDF interno attivo");
+    }
 
     // Verifica Python + PyMuPDF
     g_pythonAvailable = PdfExtractor::IsPythonAvailable();
     if (g_pythonAvailable) {
         PrintSuccess(L"Python disponibile (estrazione precisione con PyMuPDF)");
+
+        std::wstring scriptPath = Config::GetExecutableDir() + L"\\extract_zones.py";
+        if (config->pythonWorkers > 0 && std::filesystem::exists(scriptPath)) {
+            PythonWorkerPool::Start(scriptPath, config->pythonWorkers, config->pythonRecycleAfter);
+            PrintInfo(L"Server di estrazione Python: " + std::to_wstring(config->pythonWorkers) + L" processi");
+        }
     } else {
-        PrintWarning(L"Python non disponibile (usando solo pdftotext)");
+        PrintWarning(L"Python non disponibile (solo estrazione del testo completo)");
     }
 
     // Verifica Claude CLI
-    if (Config::claudeEnabled) {
+    if (config->claudeEnabled) {
         g_claudeAvailable = ClaudeAnalyzer::IsAvailable();
         if (g_claudeAvailable) {
             PrintSuccess(L"Claude CLI disponibile (analisi AI attiva)");
@@ -397,12 +679,39 @@ int wmain(int argc, wchar_t* argv[]) {
         PrintInfo(L"Analisi AI Claude: disabilitata (ClaudeEnabled=0)");
     }
 
+    // OCR per i PDF da scansione. Tesseract usa OpenMP: con piu' pagine in
+    // parallelo un thread per processo evita di sovraccaricare i core
+    g_ocrAvailable = OcrEngine::IsAvailable();
+    if (g_ocrAvailable) {
+        PrintSuccess(L"OCR disponibile (Tesseract, lingue " + config->ocrLanguages + L")");
+        if (GetEnvironmentVariableW(L"OMP_THREAD_LIMIT", NULL, 0) == 0) {
+            SetEnvironmentVariableW(L"OMP_THREAD_LIMIT", L"1");
+        }
+    } else {
+        PrintWarning(L"OCR non disponibile (pdftoppm.exe o tesseract.exe non trovati): PDF da scansione non gestiti");
+    }
+
+    // Profili di parsing: integrati piu' quelli in formato testo della
+    // directory dei profili, compilati in profiles.bin. I profili vanno
+    // inizializzati prima che i worker li usino in parallelo
+    std::wstring textProfilesDir = config->textProfilesDirectory.empty()
+        ? Config::GetExecutableDir() + L"\\profiles" : config->textProfilesDirectory;
+    ProfileManager::SetProfileDirectory(textProfilesDir,
+        Config::GetExecutableDir() + L"\\" + Config::PROFILES_COMPILED_FILE);
+    ProfileManager::Initialize();
+    PrintTextProfiles();
+
     // Carica i profili zone dalla directory dell'eseguibile
     std::wstring profilesDir = Config::GetExecutableDir();
     if (ZoneProfileManager::LoadProfiles(profilesDir)) {
-        PrintSuccess(L"Profili zone caricati: " + std::to_wstring(ZoneProfileManager::GetProfiles().size()));
-        for (const auto& profile : ZoneProfileManager::GetProfiles()) {
+        std::shared_ptr<const ZoneProfileSet> zoneProfiles = ZoneProfileManager::GetSnapshot();
+        PrintSuccess(L"Profili zone caricati: " + std::to_wstring(zoneProfiles->profiles.size()));
+        for (const auto& profile : zoneProfiles->profiles) {
             PrintInfo(L"  - " + profile.profileName + L" (" + std::to_wstring(profile.zones.size()) + L" zone)");
+            if (profile.layout.IsEmpty() && profile.identifierPatterns.empty()) {
+                PrintWarning(L"Profilo " + profile.profileName + L" senza impronta dell'impaginazione: non verra' "
+                             L"riconosciuto (risalvarlo con pdf_calibrator.py o mettere il PDF di riferimento accanto al JSON)");
+            }
         }
     } else {
         PrintWarning(L"Nessun profilo zone trovato (estrazione completa)");
@@ -410,42 +719,143 @@ int wmain(int argc, wchar_t* argv[]) {
 
     PrintSuccess(L"Parser locale attivo");
     
-    PrintInfo(L"Directory monitorata: " + Config::watchDirectory);
-    PrintInfo(L"Directory output: " + Config::outputDirectory);
+    PrintInfo(L"Directory monitorata: " + config->watchDirectory);
+    PrintInfo(L"Directory output: " + config->outputDirectory);
     
     if (Config::IsAutoStartEnabled()) {
         PrintInfo(L"Autostart: abilitato");
     }
     
+    // Registro dei PDF gia' elaborati: sopravvive ai riavvii
+    std::wstring ledgerPath = Config::GetExecutableDir() + L"\\" + Config::LEDGER_FILE;
+    if (ProcessedLedger::Open(ledgerPath, config->ledgerRetentionHours)) {
+        PrintSuccess(L"Registro PDF elaborati: " + std::to_wstring(ProcessedLedger::GetCount()) +
+                     L" voci (ultime " + std::to_wstring(config->ledgerRetentionHours) + L" ore)");
+    } else {
+        PrintWarning(L"Registro PDF non persistente: " + ProcessedLedger::GetLastError());
+    }
+
+    // Cache dei risultati: la chiave dipende da backend attivi e profili caricati
+    if (config->cacheMaxMB > 0) {
+        g_cacheBackend = ComputeCacheBackend(*config);
+        g_profileVersion = ComputeProfileVersion();
+
+        std::wstring cachePath = Config::GetExecutableDir() + L"\\" + Config::CACHE_FILE;
+        if (ExtractionCache::Open(cachePath, static_cast<size_t>(config->cacheMaxMB) * 1024 * 1024)) {
+            PrintSuccess(L"Cache estrazioni: " + std::to_wstring(ExtractionCache::GetCount()) +
+                         L" voci (max " + std::to_wstring(config->cacheMaxMB) + L" MB)");
+        } else {
+            PrintWarning(L"Cache estrazioni non disponibile: " + ExtractionCache::GetLastError());
+        }
+    }
+
+    // Pool di elaborazione: il watcher accoda, i worker eseguono ProcessPdf
+    IngestPool pool;
+    pool.SetHandler([](const std::wstring& path) { ProcessPdf(path, true); });
+    pool.SetDropHandler([](const std::wstring& path) {
+        PrintWarning(L"Coda piena, PDF scartato: " + path);
+    });
+    pool.Start(config->workerThreads, config->ingestQueueCapacity,
+               IngestPool::ParsePolicy(config->ingestOverflowPolicy));
+    PrintInfo(L"Worker di elaborazione: " + std::to_wstring(pool.GetWorkerCount()) +
+              L" (coda max " + std::to_wstring(config->ingestQueueCapacity) + L")");
+
     // Avvia il file watcher
     FileWatcher watcher;
-    watcher.SetCallback(OnNewPdf);
+    watcher.SetCallback([&pool](const std::wstring& path) {
+        // Con drop-oldest l'elemento scartato e' gia' segnalato dal drop handler
+        switch (pool.Submit(path)) {
+        case SubmitResult::Dropped:
+            PrintWarning(L"Coda piena, PDF scartato: " + path);
+            break;
+        case SubmitResult::Stopped:
+            PrintInfo(L"Arresto in corso, PDF non accodato: " + path);
+            break;
+        case SubmitResult::Accepted:
+            break;
+        }
+    });
+    watcher.SetQuietPeriod(std::chrono::milliseconds(config->settleQuietMs));
     
-    if (!watcher.Start(Config::watchDirectory)) {
+    if (!watcher.Start(config->watchDirectory)) {
         PrintError(L"Impossibile avviare il monitoraggio: " + watcher.GetLastError());
+        PythonWorkerPool::Stop();
+        ProcessExecutor::Stop();
         std::wcout << L"\nPremi un tasto per uscire..." << std::endl;
         _getch();
         return 1;
     }
     
     PrintSuccess(L"Monitoraggio avviato");
-    std::wcout << std::endl;
-    PrintInfo(L"In attesa di nuovi PDF... (premi Q per uscire)");
-    std::wcout << std::endl;
+
+    // Recupero dei PDF arrivati mentre il monitor era spento, in parallelo
+    // alle notifiche live
+    BacklogScanner backlog;
+    backlog.SetHandler([](const std::wstring& path) { ProcessPdf(path, false); });
+    backlog.SetQuietPeriod(std::chrono::milliseconds(config->settleQuietMs));
+    backlog.SetProgressCallback([](const BacklogScanner::Progress& p) {
+        wchar_t rate[32];
+        swprintf(rate, 32, L"%.1f", p.perMinute);
+
+        if (p.finished && p.queued == 0) {
+            PrintInfo(L"Nessun PDF arretrato (" + std::to_wstring(p.skipped) + L" gia' elaborati)");
+        } else if (p.finished) {
+            PrintSuccess(L"Arretrato completato: " + std::to_wstring(p.completed) + L" PDF in " +
+                         std::to_wstring(static_cast<long>(p.elapsedSeconds)) + L" s (" + rate + L" PDF/min)");
+        } else {
+            PrintInfo(L"Arretrato: " + std::to_wstring(p.completed) + L"/" + std::to_wstring(p.queued) +
+                      L" elaborati" + (p.scanDone ? L"" : L" (scansione in corso)") +
+                      L" - " + rate + L" PDF/min");
+        }
+    }, std::chrono::seconds(5));
+    backlog.Start(config->watchDirectory, pool, config->backlogWorkers);
+    PrintSeparator();
+    PrintInfo(L"In attesa di nuovi PDF... (premi Q per uscire, S per le statistiche)");
+    PrintSeparator();
     
-    // Loop principale - attendi Q per uscire
+    // Loop principale - attendi Q per uscire. config.ini e i profili di
+    // parsing della directory vengono ricontrollati periodicamente: una
+    // modifica vale dal PDF successivo, senza riavvio
+    DWORD ticks = 0;
     while (true) {
         if (_kbhit()) {
             int ch = _getch();
             if (ch == 'q' || ch == 'Q') {
                 break;
             }
+            if (ch == 's' || ch == 'S') {
+                PrintStatistics(watcher, pool);
+            }
+        }
+        DWORD refreshTicks = Config::Get()->profileRefreshSeconds * 10;
+        if (refreshTicks > 0 && ++ticks >= refreshTicks) {
+            ticks = 0;
+            if (Config::ReloadConfigIfChanged()) {
+                PrintInfo(L"Configurazione ricaricata (directory, worker, processi e cache richiedono il riavvio)");
+                g_cacheBackend = ComputeCacheBackend(*Config::Get());
+                if (ExtractionCache::IsOpen()) {
+                    g_profileVersion = ComputeProfileVersion();
+                }
+            }
+            if (ProfileManager::Refresh()) {
+                PrintInfo(L"Profili di parsing ricaricati");
+                PrintTextProfiles();
+                if (ExtractionCache::IsOpen()) {
+                    g_profileVersion = ComputeProfileVersion();
+                }
+            }
         }
         Sleep(100);
     }
     
     PrintInfo(L"Arresto in corso...");
     watcher.Stop();
+    backlog.Stop();
+    pool.Stop();
+    PythonWorkerPool::Stop();
+    ProcessExecutor::Stop();
+    ProcessedLedger::Close();
+    ExtractionCache::Close();
     PrintSuccess(L"Programma terminato");
     
     return 0;